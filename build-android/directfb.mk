@@ -210,8 +210,10 @@ DIRECTFB_SOURCES = \
 	$(DFB_SOURCE)/src/core/fonts.c				\
 	$(DFB_SOURCE)/src/core/gfxcard.c				\
 	$(DFB_SOURCE)/src/core/graphics_state.c			\
+	$(DFB_SOURCE)/src/core/image_cache.c			\
 	$(DFB_SOURCE)/src/core/input.c				\
 	$(DFB_SOURCE)/src/core/input_hub.c				\
+	$(DFB_SOURCE)/src/core/input_resampler.c			\
 	$(DFB_SOURCE)/src/core/layer_context.c			\
 	$(DFB_SOURCE)/src/core/layer_control.c			\
 	$(DFB_SOURCE)/src/core/layer_region.c			\
@@ -221,6 +223,7 @@ DIRECTFB_SOURCES = \
 	$(DFB_SOURCE)/src/core/screens.c				\
 	$(DFB_SOURCE)/src/core/state.c				\
 	$(DFB_SOURCE)/src/core/system.c				\
+	$(DFB_SOURCE)/src/core/window_event_ring.c		\
 	$(DFB_SOURCE)/src/core/windows.c				\
 	$(DFB_SOURCE)/src/core/windowstack.c			\
 	$(DFB_SOURCE)/src/core/wm.c				\
@@ -256,6 +259,7 @@ DIRECTFB_SOURCES = \
 	$(DFB_SOURCE)/src/media/idirectfbdatabuffer_streamed.c	\
 	$(DFB_SOURCE)/src/media/idirectfbfont.c			\
 	$(DFB_SOURCE)/src/media/idirectfbimageprovider.c		\
+	$(DFB_SOURCE)/src/media/idirectfbimageprovider_async.c	\
 	$(DFB_SOURCE)/src/media/idirectfbimageprovider_client.c	\
 	$(DFB_SOURCE)/src/media/idirectfbvideoprovider.c		\
 	$(DFB_SOURCE)/src/media/ImageProvider.cpp			\
@@ -856,8 +856,9 @@ typedef enum {
      DLTF_VIDEO          = 0x00000002,  /* Can be used for live video output.*/
      DLTF_STILL_PICTURE  = 0x00000004,  /* Can be used for single frames. */
      DLTF_BACKGROUND     = 0x00000008,  /* Can be used as a background layer.*/
+     DLTF_CURSOR         = 0x00000010,  /* Dedicated to a small hardware cursor. */
 
-     DLTF_ALL            = 0x0000000F   /* All type flags set. */
+     DLTF_ALL            = 0x0000001F   /* All type flags set. */
 } DFBDisplayLayerTypeFlags;
 
 /*
@@ -1645,6 +1646,44 @@ typedef struct {
      DFBGraphicsDriverInfo    driver;
 } DFBGraphicsDeviceDescription;
 
+/*
+ * Stages of input latency tracing, see IDirectFB::GetLatencyStats().
+ *
+ * Each stage measures the time from the timestamp of the input event,
+ * usually given by the kernel, until the event or its effect reached the stage.
+ */
+typedef enum {
+     DLTS_INPUT          = 0,  /* Dispatched by the input core. */
+     DLTS_WM             = 1,  /* Posted to a window by the window manager. */
+     DLTS_WINDOW         = 2,  /* Received by the event buffer of the client. */
+     DLTS_FLIP           = 3,  /* Next Flip() of the window surface by the client. */
+     DLTS_DISPLAY        = 4,  /* Frame containing that Flip() shown on the display. */
+
+     DLTS_NUM            = 5
+} DFBLatencyStage;
+
+#define DFB_LATENCY_BUCKETS  16
+
+/*
+ * Histogram of one latency stage.
+ *
+ * Bucket n counts latencies below 128us << n, the last bucket counts all others.
+ */
+typedef struct {
+     unsigned int             count;                      /* Number of traced events */
+     long long                total;                      /* Sum of latencies in microseconds */
+     long long                max;                        /* Highest latency in microseconds */
+
+     unsigned int             buckets[DFB_LATENCY_BUCKETS];
+} DFBLatencyHistogram;
+
+/*
+ * Latency statistics of all stages.
+ */
+typedef struct {
+     DFBLatencyHistogram      stages[DLTS_NUM];
+} DFBLatencyStats;
+
 /*
  * Description of the window that is to be created.
  */
@@ -2261,6 +2300,23 @@ D_DEFINE_INTERFACE(   IDirectFB,
           DFBSurfaceAllocationID        allocation_id,
           IDirectFBSurfaceAllocation  **ret_interface
      );
+
+
+   /** Statistics **/
+
+     /*
+      * Get the input latency histograms of all stages.
+      *
+      * Latencies are only traced with the "latency-trace" option,
+      * otherwise DFB_UNSUPPORTED is returned. The statistics are
+      * shared by all processes of a session and cleared if
+      * <b>reset</b> is true.
+      */
+     DFBResult (*GetLatencyStats) (
+          IDirectFB                    *thiz,
+          DFBLatencyStats              *ret_stats,
+          DFBBoolean                    reset
+     );
 )
 
 /* predefined layer ids */
@@ -3567,6 +3623,9 @@ typedef enum {
 
      DSFLIP_NOWAIT       = 0x00001000,
 
+     DSFLIP_MAILBOX      = 0x00002000,  /* Never wait for the display: with three buffers the newest frame replaces
+                                           one that is still waiting to be shown, which is then skipped. */
+
      DSFLIP_WAITFORSYNC  = DSFLIP_WAIT | DSFLIP_ONSYNC
 } DFBSurfaceFlipFlags;
 
@@ -5026,6 +5085,29 @@ D_DEFINE_INTERFACE(   IDirectFBSurface,
           IDirectFBSurface         *thiz,
           DFBSurfaceFlushFlags      flags
      );
+
+
+   /** Text functions **/
+
+     /*
+      * Draw a number of strings at once using the current font.
+      *
+      * Each string is drawn at its entry in <b>points</b>, using the
+      * same <b>flags</b> as DrawString(). The glyphs of all strings are
+      * blitted with one batch per glyph cache surface, which is much
+      * cheaper than drawing each string on its own.
+      *
+      * An entry of -1 in <b>bytes</b> means the string is zero terminated,
+      * <b>bytes</b> may also be NULL if all strings are zero terminated.
+      */
+     DFBResult (*DrawStrings) (
+          IDirectFBSurface         *thiz,
+          const char * const       *texts,
+          const int                *bytes,
+          const DFBPoint           *points,
+          unsigned int              num,
+          DFBSurfaceTextFlags       flags
+     );
 )
 
 /**************************
@@ -6110,6 +6192,23 @@ D_DEFINE_INTERFACE(   IDirectFBEventBuffer,
           IDirectFBEventBuffer     *thiz,
           DFBEventBufferStats      *ret_stats
      );
+
+
+   /** Readiness **/
+
+     /*
+      * Get a file descriptor signalling queued events.
+      *
+      * The descriptor is readable in select() or poll() while events are queued.
+      * Events are still retrieved via IDirectFBEventBuffer::GetEvent(), so unlike
+      * IDirectFBEventBuffer::CreateFileDescriptor() all methods keep working.
+      *
+      * The descriptor belongs to the event buffer and must not be read or closed.
+      */
+     DFBResult (*GetNotifyDescriptor) (
+          IDirectFBEventBuffer     *thiz,
+          int                      *ret_fd
+     );
 )
 
 /*
@@ -6818,6 +6917,22 @@ D_DEFINE_INTERFACE(   IDirectFBWindow,
           const DFBWindowGeometry       *src,
           const DFBWindowGeometry       *dst
      );
+
+
+   /** Updates **/
+
+     /*
+      * Limit the rate at which updates of the window are shown.
+      *
+      * Updates coming in faster are merged and shown together,
+      * and flipping the window surface waits for them.
+      *
+      * The default of 0 limits updates to the screen refresh rate.
+      */
+     DFBResult (*SetMaxUpdateRate) (
+          IDirectFBWindow               *thiz,
+          unsigned int                   rate
+     );
 )
 
 
@@ -7101,6 +7216,25 @@ D_DEFINE_INTERFACE(   IDirectFBFont,
           IDirectFBFont            *thiz,
           DFBFontDescription       *ret_description
      );
+
+
+   /** Glyph cache **/
+
+     /*
+      * Load the glyphs of all characters in a string into the glyph cache.
+      *
+      * Use this to pre-warm the font with a sample text or a character set
+      * before the text is actually drawn. The string is given in the current
+      * encoding, with <b>bytes</b> being -1 if it is zero terminated.
+      *
+      * Glyphs are rasterized by worker threads if supported by the font
+      * implementation, without stalling other threads drawing with this font.
+      */
+     DFBResult (*PrefetchGlyphs) (
+          IDirectFBFont            *thiz,
+          const char               *text,
+          int                       bytes
+     );
 )
 
 /*
@@ -7138,6 +7272,46 @@ typedef enum {
  */
 typedef DIRenderCallbackResult (*DIRenderCallback)(DFBRectangle *rect, void *ctx);
 
+/*
+ * Called when rendering started with IDirectFBImageProvider::RenderToAsync() is done,
+ * with the result of the rendering or DFB_INTERRUPTED if it has been cancelled.
+ *
+ * The function is called from a decoder thread.
+ */
+typedef void (*DIRenderAsyncCallback)( DFBResult result, void *ctx );
+
+/*
+ * Flags defining which fields of a DIRenderAsyncDescription are valid.
+ */
+typedef enum {
+     DIRAF_NONE          = 0x00000000,  /* None of these. */
+
+     DIRAF_PRIORITY      = 0x00000001,  /* priority is set */
+     DIRAF_CALLBACK      = 0x00000002,  /* callback and callback_ctx are set */
+     DIRAF_EVENT         = 0x00000004,  /* buffer, event_type and event_data are set */
+
+     DIRAF_ALL           = 0x00000007   /* All of these. */
+} DIRenderAsyncFlags;
+
+/*
+ * Description of an asynchronous rendering.
+ *
+ * Completion is signalled by calling the callback and/or posting a DFBUserEvent
+ * with the given type and data to the event buffer, in that order.
+ */
+typedef struct {
+     DIRenderAsyncFlags       flags;          /* field validation */
+
+     int                      priority;       /* renderings with higher priority start first, default 0 */
+
+     DIRenderAsyncCallback    callback;       /* called with the result */
+     void                    *callback_ctx;
+
+     IDirectFBEventBuffer    *buffer;         /* receives a DFBUserEvent */
+     unsigned int             event_type;     /* type of the user event */
+     void                    *event_data;     /* data of the user event */
+} DIRenderAsyncDescription;
+
 /**************************
  * IDirectFBImageProvider *
  **************************/
@@ -7228,6 +7402,38 @@ D_DEFINE_INTERFACE(   IDirectFBImageProvider,
           const DFBRectangle       *src_rect,
           const char               *filename
      );
+
+
+   /** Asynchronous rendering **/
+
+     /*
+      * Render like RenderTo(), but in a decoder thread, returning immediately.
+      *
+      * Renderings of different image providers run in parallel, see the
+      * 'image-decode-threads' option, while those of one provider are done
+      * one after another. The provider and the destination are referenced
+      * until completion, which is signalled as given by the description.
+      * Don't render into the destination otherwise meanwhile.
+      *
+      * A description of NULL renders with default priority and without
+      * signalling completion.
+      */
+     DFBResult (*RenderToAsync) (
+          IDirectFBImageProvider         *thiz,
+          IDirectFBSurface               *destination,
+          const DFBRectangle             *destination_rect,
+          const DIRenderAsyncDescription *desc
+     );
+
+     /*
+      * Cancel asynchronous renderings of this provider that have not
+      * started yet and wait for the one in progress to finish.
+      *
+      * Completion of cancelled renderings is signalled with DFB_INTERRUPTED.
+      */
+     DFBResult (*CancelRenderAsync) (
+          IDirectFBImageProvider   *thiz
+     );
 )
 
 /*
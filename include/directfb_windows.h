@@ -80,7 +80,9 @@ typedef enum {
 
      DWCONF_APPLICATION_ID         = 0x00080000,
 
-     DWCONF_ALL                    = 0x000F7F7F
+     DWCONF_MAX_UPDATE_RATE        = 0x00100000,
+
+     DWCONF_ALL                    = 0x001F7F7F
 } DFBWindowConfigFlags;
 
 typedef struct {
@@ -109,6 +109,7 @@ typedef unsigned long kernel_ulong_t;
 #include <misc/conf.h>
 #include <misc/util.h>
 
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 
@@ -150,6 +151,25 @@ typedef struct input_absinfo Input_AbsInfo;
 #endif
 
 
+/*
+ * Touchpads related stuff
+ */
+enum {
+     TOUCHPAD_FSM_START,
+     TOUCHPAD_FSM_MAIN,
+     TOUCHPAD_FSM_DRAG_START,
+     TOUCHPAD_FSM_DRAG_MAIN,
+};
+struct touchpad_axis {
+     int old, min, max;
+};
+struct touchpad_fsm_state {
+     int fsm_state;
+     struct touchpad_axis x;
+     struct touchpad_axis y;
+     struct timeval timeout;
+};
+
 /*
  * declaration of private data
  */
@@ -170,7 +190,11 @@ typedef struct {
      int                      dx;
      int                      dy;
 
+     DFBInputEvent            frame[CORE_INPUT_FRAME_MAX];   /* events up to the next SYN_REPORT */
+     int                      frame_num;
+
      bool                     touchpad;
+     struct touchpad_fsm_state fsm_state;
 
      /* Indice of the associated device_nums and device_names array entry.
       * Used as the second parameter of the driver_open_device function.
@@ -201,6 +225,26 @@ static pthread_mutex_t   driver_suspended_lock;
 /* Flag that indicates if the driver is suspended when true. */
 static bool              driver_suspended = false;
 
+/* The epoll descriptor serving all devices in one thread, see linux-input-epoll option. */
+static int               epoll_fd = -1;
+/* Pipe file descriptor for terminating the epoll thread. */
+static int               epoll_quitpipe[2];
+/* The thread waiting on epoll_fd. */
+static DirectThread     *epoll_thread = NULL;
+/* Number of devices and hotplug detection using the epoll thread. */
+static int               epoll_users = 0;
+/* Devices served by the epoll thread, same indices as device_names. */
+static LinuxInputData   *epoll_devices[MAX_LINUX_INPUT_DEVICES];
+/* Held while the epoll thread handles events, so that no device is closed meanwhile. */
+static pthread_mutex_t   epoll_lock;
+/* Core and driver for creating and removing hotplugged devices in the epoll thread. */
+static CoreDFB          *epoll_hotplug_core;
+static void             *epoll_hotplug_driver;
+
+/* Values of epoll_data.u32 besides device indices. */
+#define EPOLL_ID_QUIT        0xffffffff
+#define EPOLL_ID_HOTPLUG     0xfffffffe
+
 
 static const
 int basic_keycodes [] = {
@@ -366,25 +410,6 @@ int ext_keycodes [] = {
      DIKS_PREVIOUS, DIKS_NEXT, DIKS_DIGITS, DIKS_TEEN, DIKS_TWEN, DIKS_BREAK
 };
 
-/*
- * Touchpads related stuff
- */
-enum {
-     TOUCHPAD_FSM_START,
-     TOUCHPAD_FSM_MAIN,
-     TOUCHPAD_FSM_DRAG_START,
-     TOUCHPAD_FSM_DRAG_MAIN,
-};
-struct touchpad_axis {
-     int old, min, max;
-};
-struct touchpad_fsm_state {
-     int fsm_state;
-     struct touchpad_axis x;
-     struct touchpad_axis y;
-     struct timeval timeout;
-};
-
 static void
 touchpad_fsm_init( struct touchpad_fsm_state *state );
 static int
@@ -788,6 +813,40 @@ set_led( const LinuxInputData *data, int led, int state )
      (void)res;
 }
 
+static void
+frame_flush( LinuxInputData *data )
+{
+     int i;
+
+     if (!data->frame_num)
+          return;
+
+     dfb_input_dispatch_frame( data->device, data->frame, data->frame_num );
+
+     /* Locks have been filled in by the input core. */
+     for (i=0; i<data->frame_num; i++) {
+          const DFBInputEvent *devt = &data->frame[i];
+
+          if (data->has_leds && (devt->locks != data->locks)) {
+               set_led( data, LED_SCROLLL, devt->locks & DILS_SCROLL );
+               set_led( data, LED_NUML, devt->locks & DILS_NUM );
+               set_led( data, LED_CAPSL, devt->locks & DILS_CAPS );
+               data->locks = devt->locks;
+          }
+     }
+
+     data->frame_num = 0;
+}
+
+static void
+frame_add( LinuxInputData *data, const DFBInputEvent *devt )
+{
+     if (data->frame_num == CORE_INPUT_FRAME_MAX)
+          frame_flush( data );
+
+     data->frame[data->frame_num++] = *devt;
+}
+
 static void
 flush_xy( LinuxInputData *data, bool last )
 {
@@ -803,7 +862,7 @@ flush_xy( LinuxInputData *data, bool last )
           if (!last || data->dy)
                evt.flags |= DIEF_FOLLOW;
 
-          dfb_input_dispatch( data->device, &evt );
+          frame_add( data, &evt );
 
           data->dx = 0;
      }
@@ -818,44 +877,31 @@ flush_xy( LinuxInputData *data, bool last )
           if (!last)
                evt.flags |= DIEF_FOLLOW;
 
-          dfb_input_dispatch( data->device, &evt );
+          frame_add( data, &evt );
 
           data->dy = 0;
      }
 }
 
 /*
- * Input thread reading from device.
- * Generates events on incoming data.
+ * Queries touchpad ranges and synthesizes events for the current key states.
  */
-static void*
-linux_input_EventThread( DirectThread *thread, void *driver_data )
+static void
+device_init_state( LinuxInputData *data )
 {
-     LinuxInputData    *data = (LinuxInputData*) driver_data;
-     int                readlen, status;
-     unsigned int       i;
-     int                fdmax;
-     struct input_event levt[64];
-     fd_set             set;
-     struct touchpad_fsm_state fsm_state;
-
-     D_DEBUG_AT( Debug_LinuxInput, "%s()\n", __FUNCTION__ );
-
-     fdmax = MAX( data->fd, data->quitpipe[0] );
-
      /* Query min/max coordinates. */
      if (data->touchpad) {
           Input_AbsInfo absinfo;
 
-          touchpad_fsm_init( &fsm_state );
+          touchpad_fsm_init( &data->fsm_state );
 
           ioctl( data->fd, EVIOCGABS(ABS_X), &absinfo );
-          fsm_state.x.min = absinfo.minimum;
-          fsm_state.x.max = absinfo.maximum;
+          data->fsm_state.x.min = absinfo.minimum;
+          data->fsm_state.x.max = absinfo.maximum;
 
           ioctl( data->fd, EVIOCGABS(ABS_Y), &absinfo );
-          fsm_state.y.min = absinfo.minimum;
-          fsm_state.y.max = absinfo.maximum;
+          data->fsm_state.y.min = absinfo.minimum;
+          data->fsm_state.y.max = absinfo.maximum;
      }
 
      /* Query key states. */
@@ -890,94 +936,75 @@ linux_input_EventThread( DirectThread *thread, void *driver_data )
                }
           }
      }
+}
 
-     while (1) {
-          DFBInputEvent devt = { .type = DIET_UNKNOWN };
-
-          FD_ZERO( &set );
-          FD_SET( data->fd, &set );
-          FD_SET( data->quitpipe[0], &set );
-
-          if (data->touchpad && timeout_is_set( &fsm_state.timeout )) {
-               struct timeval time;
-               gettimeofday( &time, NULL );
-
-               if (!timeout_passed( &fsm_state.timeout, &time )) {
-                    struct timeval timeout = fsm_state.timeout;
-                    timeout_sub( &timeout, &time );
-                    status = select( fdmax + 1, &set, NULL, NULL, &timeout );
-               } else {
-                    status = 0;
-               }
-          }
-          else {
-               status = select( fdmax + 1, &set, NULL, NULL, NULL );
-          }
-
-          if (status < 0 && errno != EINTR)
-               break;
-
-          if (status > 0 && FD_ISSET( data->quitpipe[0], &set ))
-               break;
-
-          direct_thread_testcancel( thread );
+/*
+ * Translates a single event, returns false if nothing is to be dispatched for it.
+ */
+static bool
+device_translate( LinuxInputData           *data,
+                  const struct input_event *levt,
+                  DFBInputEvent            *devt )
+{
+     if (data->touchpad) {
+          int status = touchpad_fsm( &data->fsm_state, levt, devt );
 
+          /* Not handled. Try the direct approach. */
           if (status < 0)
-               continue;
+               return translate_event( data, levt, devt );
 
-          /* timeout? */
-          if (status == 0) {
-               if (data->touchpad && touchpad_fsm( &fsm_state, NULL, &devt ) > 0)
-                    dfb_input_dispatch( data->device, &devt );
+          /* Handled but no further processing is necessary if 0. */
+          return status > 0;
+     }
 
-               continue;
-          }
+     return translate_event( data, levt, devt );
+}
 
-          readlen = read( data->fd, levt, sizeof(levt) );
+/*
+ * Completes the current frame, the last event is dispatched without DIEF_FOLLOW.
+ */
+static void
+device_finish_frame( LinuxInputData *data,
+                     DFBInputEvent  *devt )
+{
+     if (devt->type != DIET_UNKNOWN) {
+          flush_xy( data, false );
 
-          if (readlen < 0 && errno != EINTR)
-               break;
+          frame_add( data, devt );
 
-          direct_thread_testcancel( thread );
+          devt->type  = DIET_UNKNOWN;
+          devt->flags = DIEF_NONE;
+     }
+     else
+          flush_xy( data, true );
 
-          if (readlen <= 0)
-               continue;
+     frame_flush( data );
+}
 
-          for (i=0; i<readlen / sizeof(levt[0]); i++) {
-               DFBInputEvent temp = { .type = DIET_UNKNOWN };
+/*
+ * Translates a batch of events read from the device and dispatches them,
+ * each report (up to SYN_REPORT) as one frame of the input core.
+ */
+static void
+device_handle_events( LinuxInputData           *data,
+                      const struct input_event *levt,
+                      unsigned int              num )
+{
+     unsigned int  i;
+     DFBInputEvent devt = { .type = DIET_UNKNOWN };
 
-               if (data->touchpad) {
-                    status = touchpad_fsm( &fsm_state, &levt[i], &temp );
-                    if (status < 0) {
-                         /* Not handled. Try the direct approach. */
-                         if (!translate_event( data, &levt[i], &temp ))
-                              continue;
-                    }
-                    else if (status == 0) {
-                         /* Handled but no further processing is necessary. */
-                         continue;
-                    }
-               }
-               else {
-                    if (!translate_event( data, &levt[i], &temp ))
-                         continue;
-               }
+     for (i=0; i<num; i++) {
+          DFBInputEvent temp = { .type = DIET_UNKNOWN };
 
-               /* Flush previous event with DIEF_FOLLOW? */
+          if (device_translate( data, &levt[i], &temp )) {
+               /* Queue previous event with DIEF_FOLLOW? */
                if (devt.type != DIET_UNKNOWN) {
                     flush_xy( data, false );
 
                     /* Signal immediately following event. */
                     devt.flags |= DIEF_FOLLOW;
 
-                    dfb_input_dispatch( data->device, &devt );
-
-                    if (data->has_leds && (devt.locks != data->locks)) {
-                         set_led( data, LED_SCROLLL, devt.locks & DILS_SCROLL );
-                         set_led( data, LED_NUML, devt.locks & DILS_NUM );
-                         set_led( data, LED_CAPSL, devt.locks & DILS_CAPS );
-                         data->locks = devt.locks;
-                    }
+                    frame_add( data, &devt );
 
                     devt.type  = DIET_UNKNOWN;
                     devt.flags = DIEF_NONE;
@@ -991,35 +1018,130 @@ linux_input_EventThread( DirectThread *thread, void *driver_data )
                     switch (devt.axis) {
                          case DIAI_X:
                               data->dx += devt.axisrel;
-                              continue;
+                              break;
 
                          case DIAI_Y:
                               data->dy += devt.axisrel;
-                              continue;
+                              break;
 
                          default:
                               break;
                     }
                }
 
-               /* Event is dispatched in next round of loop. */
+               /* Event is queued in next round of loop. */
           }
 
-          /* Flush last event without DIEF_FOLLOW. */
-          if (devt.type != DIET_UNKNOWN) {
-               flush_xy( data, false );
+          if (levt[i].type == EV_SYN && levt[i].code == SYN_REPORT)
+               device_finish_frame( data, &devt );
+     }
 
-               dfb_input_dispatch( data->device, &devt );
+     /* Dispatch what is left, the rest of the report will follow with the next read. */
+     device_finish_frame( data, &devt );
+}
+
+/*
+ * Reads what is available from the device. Returns false if the device is gone.
+ */
+static bool
+device_read( LinuxInputData *data )
+{
+     int                readlen;
+     struct input_event levt[64];
+
+     readlen = read( data->fd, levt, sizeof(levt) );
+
+     if (readlen < 0 && errno != EINTR && errno != EAGAIN)
+          return false;
+
+     if (readlen > 0)
+          device_handle_events( data, levt, readlen / sizeof(levt[0]) );
+
+     return true;
+}
 
-               if (data->has_leds && (devt.locks != data->locks)) {
-                    set_led( data, LED_SCROLLL, devt.locks & DILS_SCROLL );
-                    set_led( data, LED_NUML, devt.locks & DILS_NUM );
-                    set_led( data, LED_CAPSL, devt.locks & DILS_CAPS );
-                    data->locks = devt.locks;
+/*
+ * Runs the touchpad state machine if its timeout has passed.
+ */
+static void
+device_check_timeout( LinuxInputData *data, const struct timeval *now )
+{
+     DFBInputEvent devt = { .type = DIET_UNKNOWN };
+
+     if (!data->touchpad || !timeout_is_set( &data->fsm_state.timeout ))
+          return;
+
+     if (timeout_passed( &data->fsm_state.timeout, now ) &&
+         touchpad_fsm( &data->fsm_state, NULL, &devt ) > 0)
+          dfb_input_dispatch( data->device, &devt );
+}
+
+/*
+ * Input thread reading from device.
+ * Generates events on incoming data.
+ */
+static void*
+linux_input_EventThread( DirectThread *thread, void *driver_data )
+{
+     LinuxInputData    *data = (LinuxInputData*) driver_data;
+     int                status;
+     int                fdmax;
+     fd_set             set;
+
+     D_DEBUG_AT( Debug_LinuxInput, "%s()\n", __FUNCTION__ );
+
+     fdmax = MAX( data->fd, data->quitpipe[0] );
+
+     device_init_state( data );
+
+     while (1) {
+          FD_ZERO( &set );
+          FD_SET( data->fd, &set );
+          FD_SET( data->quitpipe[0], &set );
+
+          if (data->touchpad && timeout_is_set( &data->fsm_state.timeout )) {
+               struct timeval time;
+               gettimeofday( &time, NULL );
+
+               if (!timeout_passed( &data->fsm_state.timeout, &time )) {
+                    struct timeval timeout = data->fsm_state.timeout;
+                    timeout_sub( &timeout, &time );
+                    status = select( fdmax + 1, &set, NULL, NULL, &timeout );
+               } else {
+                    status = 0;
                }
           }
-          else
-               flush_xy( data, true );
+          else {
+               status = select( fdmax + 1, &set, NULL, NULL, NULL );
+          }
+
+          if (status < 0 && errno != EINTR)
+               break;
+
+          if (status > 0 && FD_ISSET( data->quitpipe[0], &set ))
+               break;
+
+          direct_thread_testcancel( thread );
+
+          if (status < 0)
+               continue;
+
+          /* timeout? */
+          if (status == 0) {
+               DFBInputEvent devt = { .type = DIET_UNKNOWN };
+
+               if (data->touchpad && touchpad_fsm( &data->fsm_state, NULL, &devt ) > 0)
+                    dfb_input_dispatch( data->device, &devt );
+
+               continue;
+          }
+
+          if (!device_read( data )) {
+               status = -1;
+               break;
+          }
+
+          direct_thread_testcancel( thread );
      }
 
      if (status <= 0)
@@ -1499,6 +1621,140 @@ exit:
      return capabilities;
 }
 
+/*
+ * Open and bind the socket /org/kernel/udev/monitor, returns -1 on failure.
+ */
+static int
+udev_hotplug_open( void )
+{
+     int                fd;
+     int                rt;
+     struct sockaddr_un sock_addr;
+
+     fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+     if (fd == -1) {
+          D_PERROR( "DirectFB/linux_input: socket() failed: %s\n",
+                    strerror(errno) );
+          return -1;
+     }
+
+     memset(&sock_addr, 0, sizeof(sock_addr));
+     sock_addr.sun_family = AF_UNIX;
+     strncpy(&sock_addr.sun_path[1],
+             "/org/kernel/udev/monitor",
+             sizeof(sock_addr.sun_path) - 1);
+
+     rt = bind(fd, &sock_addr,
+               sizeof(sock_addr.sun_family)+1+strlen(&sock_addr.sun_path[1]));
+     if (rt < 0) {
+          D_PERROR( "DirectFB/linux_input: bind() failed: %s\n",
+                    strerror(errno) );
+          close(fd);
+          return -1;
+     }
+
+     return fd;
+}
+
+/*
+ * Receive one udev event from socket_fd and create or remove the device.
+ */
+static void
+udev_hotplug_handle( CoreDFB *core,
+                     void    *driver )
+{
+     char      udev_event[MAX_LENGTH_OF_EVENT_STRING];
+     char     *pos;
+     char     *event_cont; //udev event content
+     int       device_num, recv_len, index;
+     DFBResult ret;
+
+     recv_len = recv(socket_fd, udev_event, sizeof(udev_event) - 1, 0);
+     if (recv_len <= 0) {
+          D_DEBUG_AT( Debug_LinuxInput,
+                      "error receiving uevent message: %s\n",
+                      strerror(errno) );
+          return;
+     }
+
+     udev_event[recv_len] = '\0';
+
+     /* analysize udev event */
+
+     pos = strchr(udev_event, '@');
+     if (pos == NULL)
+          return;
+
+     /* replace '@' with '\0' to separate event type and event content */
+     *pos = '\0';
+
+     event_cont = pos + 1;
+
+     pos = strstr(event_cont, "/event");
+     if (pos == NULL)
+          return;
+
+     /* get event device number */
+     device_num = atoi(pos + 6);
+
+     /* Attempt to lock the driver suspended mutex. */
+     pthread_mutex_lock(&driver_suspended_lock);
+     if (driver_suspended)
+     {
+          /* Release the lock and quit handling hotplug events. */
+          D_DEBUG_AT( Debug_LinuxInput, "Driver is suspended\n" );
+          pthread_mutex_unlock(&driver_suspended_lock);
+          return;
+     }
+
+     /* Handle hotplug events since the driver is not suspended. */
+     if (!strcmp(udev_event, "add")) {
+          D_DEBUG_AT( Debug_LinuxInput,
+                      "Device node /dev/input/event%d is created by udev\n",
+                      device_num);
+
+          ret = register_device_node( device_num, &index);
+          if ( DFB_OK == ret) {
+               /* Handle the event that the input device node is created */
+               ret = dfb_input_create_device(index, core, driver);
+
+               /* If cannot create the device within Linux Input
+                * provider, inform the user.
+                */
+               if ( DFB_OK != ret) {
+                    D_DEBUG_AT( Debug_LinuxInput,
+                                "Linux/Input: Failed to create the "
+                                "device for /dev/input/event%d\n",
+                                device_num );
+               }
+          }
+     }
+     else if (!strcmp(udev_event, "remove")) {
+          D_DEBUG_AT( Debug_LinuxInput,
+                      "Device node /dev/input/event%d is removed by udev\n",
+                      device_num );
+          ret = unregister_device_node( device_num, &index );
+
+          if ( DFB_OK == ret) {
+               /* Handle the event that the input device node is removed */
+               ret = dfb_input_remove_device( index, driver );
+
+               /* If unable to remove the device within the Linux Input
+                * provider, just print the info.
+                */
+               if ( DFB_OK != ret) {
+                    D_DEBUG_AT( Debug_LinuxInput,
+                                "Linux/Input: Failed to remove the "
+                                "device for /dev/input/event%d\n",
+                                device_num );
+               }
+          }
+     }
+
+     /* Hotplug event handling is complete so release the lock. */
+     pthread_mutex_unlock(&driver_suspended_lock);
+}
+
 /*
  * Detect udev hotplug events from socket /org/kernel/udev/monitor and act
  * according to hotplug events received.
@@ -1511,8 +1767,6 @@ udev_hotplug_EventThread(DirectThread *thread, void * hotplug_data)
      CoreDFB           *core;
      void              *driver;
      HotplugThreadData *data = (HotplugThreadData *)hotplug_data;
-     int                rt;
-     struct sockaddr_un sock_addr;
      int                fdmax;
 
      D_ASSERT( data != NULL );
@@ -1525,38 +1779,18 @@ udev_hotplug_EventThread(DirectThread *thread, void * hotplug_data)
      /* Free no needed data packet */
      D_FREE(data);
 
-     /* Open and bind the socket /org/kernel/udev/monitor */
-
-     socket_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+     socket_fd = udev_hotplug_open();
      if (socket_fd == -1) {
-          D_PERROR( "DirectFB/linux_input: socket() failed: %s\n",
-                    strerror(errno) );
-          goto errorExit;
+          D_INFO( "Linux/Input: Fail to open udev socket, disable detecting "
+                  "hotplug with Linux Input provider\n" );
+          return NULL;
      }
 
      fdmax = MAX( socket_fd, hotplug_quitpipe[0] );
 
-     memset(&sock_addr, 0, sizeof(sock_addr));
-     sock_addr.sun_family = AF_UNIX;
-     strncpy(&sock_addr.sun_path[1],
-             "/org/kernel/udev/monitor",
-             sizeof(sock_addr.sun_path) - 1);
-
-     rt = bind(socket_fd, &sock_addr,
-               sizeof(sock_addr.sun_family)+1+strlen(&sock_addr.sun_path[1]));
-     if (rt < 0) {
-          D_PERROR( "DirectFB/linux_input: bind() failed: %s\n",
-                    strerror(errno) );
-          goto errorExit;
-     }
-
      while(1) {
-          char      udev_event[MAX_LENGTH_OF_EVENT_STRING];
-          char     *pos;
-          char     *event_cont; //udev event content
-          int       device_num, number_file, recv_len, index;
-          DFBResult ret;
-          fd_set    rset;
+          int    number_file;
+          fd_set rset;
 
           /* get udev event */
           FD_ZERO(&rset);
@@ -1574,109 +1808,214 @@ udev_hotplug_EventThread(DirectThread *thread, void * hotplug_data)
           /* check cancel thread */
           direct_thread_testcancel( thread );
 
-          if (FD_ISSET(socket_fd, &rset)) {
-               recv_len = recv(socket_fd, udev_event, sizeof(udev_event), 0);
-               if (recv_len <= 0) {
-                    D_DEBUG_AT( Debug_LinuxInput,
-                                "error receiving uevent message: %s\n",
-                                strerror(errno) );
-                    continue;
-               }
-               /* check cancel thread */
-               direct_thread_testcancel( thread );
-          }
-          /* analysize udev event */
+          if (number_file > 0 && FD_ISSET(socket_fd, &rset))
+               udev_hotplug_handle( core, driver );
+     }
 
-          pos = strchr(udev_event, '@');
-          if (pos == NULL)
-               continue;
+     D_DEBUG_AT( Debug_LinuxInput,
+                 "Finished hotplug detection thread within Linux Input "
+                 "provider.\n" );
+     return NULL;
+}
 
-          /* replace '@' with '\0' to separate event type and event content */
-          *pos = '\0';
+/**********************************************************************************************************************/
 
-          event_cont = pos + 1;
+/*
+ * Single thread serving all devices and hotplug detection via epoll.
+ */
+static void *
+linux_input_EpollThread( DirectThread *thread, void *arg )
+{
+     int                i, num;
+     struct epoll_event events[MAX_LINUX_INPUT_DEVICES + 2];
 
-          pos = strstr(event_cont, "/event");
-          if (pos == NULL)
-               continue;
+     D_DEBUG_AT( Debug_LinuxInput, "%s()\n", __FUNCTION__ );
 
-          /* get event device number */
-          device_num = atoi(pos + 6);
+     while (1) {
+          int            timeout = -1;
+          bool           hotplug = false;
+          struct timeval now;
 
-          /* Attempt to lock the driver suspended mutex. */
-          pthread_mutex_lock(&driver_suspended_lock);
-          if (driver_suspended)
-          {
-               /* Release the lock and quit handling hotplug events. */
-               D_DEBUG_AT( Debug_LinuxInput, "Driver is suspended\n" );
-               pthread_mutex_unlock(&driver_suspended_lock);
-               continue;
-          }
+          /* Wake up for the nearest touchpad timeout. */
+          gettimeofday( &now, NULL );
+
+          pthread_mutex_lock( &epoll_lock );
+
+          for (i=0; i<MAX_LINUX_INPUT_DEVICES; i++) {
+               LinuxInputData *data = epoll_devices[i];
+
+               if (data && data->touchpad && timeout_is_set( &data->fsm_state.timeout )) {
+                    int ms = 0;
+
+                    if (!timeout_passed( &data->fsm_state.timeout, &now )) {
+                         struct timeval left = data->fsm_state.timeout;
 
-          /* Handle hotplug events since the driver is not suspended. */
-          if (!strcmp(udev_event, "add")) {
-               D_DEBUG_AT( Debug_LinuxInput,
-                           "Device node /dev/input/event%d is created by udev\n",
-                           device_num);
-
-               ret = register_device_node( device_num, &index);
-               if ( DFB_OK == ret) {
-                    /* Handle the event that the input device node is created */
-                    ret = dfb_input_create_device(index, core, driver);
-
-                    /* If cannot create the device within Linux Input
-                     * provider, inform the user.
-                     */
-                    if ( DFB_OK != ret) {
-                         D_DEBUG_AT( Debug_LinuxInput,
-                                     "Linux/Input: Failed to create the "
-                                     "device for /dev/input/event%d\n",
-                                     device_num );
+                         timeout_sub( &left, &now );
+
+                         ms = left.tv_sec * 1000 + (left.tv_usec + 999) / 1000;
                     }
+
+                    if (timeout < 0 || ms < timeout)
+                         timeout = ms;
                }
           }
-          else if (!strcmp(udev_event, "remove")) {
-               D_DEBUG_AT( Debug_LinuxInput,
-                           "Device node /dev/input/event%d is removed by udev\n",
-                           device_num );
-               ret = unregister_device_node( device_num, &index );
-
-               if ( DFB_OK == ret) {
-                    /* Handle the event that the input device node is removed */
-                    ret = dfb_input_remove_device( index, driver );
-
-                    /* If unable to remove the device within the Linux Input
-                     * provider, just print the info.
-                     */
-                    if ( DFB_OK != ret) {
-                         D_DEBUG_AT( Debug_LinuxInput,
-                                     "Linux/Input: Failed to remove the "
-                                     "device for /dev/input/event%d\n",
-                                     device_num );
-                    }
+
+          pthread_mutex_unlock( &epoll_lock );
+
+          num = epoll_wait( epoll_fd, events, D_ARRAY_SIZE(events), timeout );
+          if (num < 0) {
+               if (errno == EINTR)
+                    continue;
+
+               D_PERROR( "DirectFB/linux_input: epoll_wait() failed!\n" );
+               break;
+          }
+
+          direct_thread_testcancel( thread );
+
+          pthread_mutex_lock( &epoll_lock );
+
+          for (i=0; i<num; i++) {
+               LinuxInputData *data;
+               u32             id = events[i].data.u32;
+
+               if (id == EPOLL_ID_QUIT) {
+                    pthread_mutex_unlock( &epoll_lock );
+                    goto out;
+               }
+
+               /* Handle hotplug last, it may close devices of this batch. */
+               if (id == EPOLL_ID_HOTPLUG) {
+                    hotplug = true;
+                    continue;
+               }
+
+               data = epoll_devices[id];
+               if (!data)
+                    continue;
+
+               if (!device_read( data )) {
+                    D_PERROR( "DirectFB/linux_input: reading from device %s failed!\n", device_names[id] );
+
+                    /* Stop polling, the device is closed via hotplug or on shutdown. */
+                    epoll_ctl( epoll_fd, EPOLL_CTL_DEL, data->fd, NULL );
                }
           }
 
-          /* Hotplug event handling is complete so release the lock. */
-          pthread_mutex_unlock(&driver_suspended_lock);
+          gettimeofday( &now, NULL );
+
+          for (i=0; i<MAX_LINUX_INPUT_DEVICES; i++) {
+               if (epoll_devices[i])
+                    device_check_timeout( epoll_devices[i], &now );
+          }
+
+          if (hotplug)
+               udev_hotplug_handle( epoll_hotplug_core, epoll_hotplug_driver );
+
+          pthread_mutex_unlock( &epoll_lock );
      }
 
-     D_DEBUG_AT( Debug_LinuxInput,
-                 "Finished hotplug detection thread within Linux Input "
-                 "provider.\n" );
+out:
+     D_DEBUG_AT( Debug_LinuxInput, "%s() finished\n", __FUNCTION__ );
+
      return NULL;
+}
 
-errorExit:
-     D_INFO( "Linux/Input: Fail to open udev socket, disable detecting "
-             "hotplug with Linux Input provider\n" );
+static DFBResult
+epoll_ref( void )
+{
+     struct epoll_event event;
+     pthread_mutexattr_t attr;
 
-     if (socket_fd != -1) {
-          close(socket_fd);
+     if (epoll_users++)
+          return DFB_OK;
+
+     epoll_fd = epoll_create( MAX_LINUX_INPUT_DEVICES + 2 );
+     if (epoll_fd < 0) {
+          D_PERROR( "DirectFB/linux_input: epoll_create() failed!\n" );
+          goto error;
      }
 
-     return NULL;
+     if (pipe( epoll_quitpipe ) < 0) {
+          D_PERROR( "DirectFB/linux_input: could not open quitpipe for epoll" );
+          goto error_pipe;
+     }
+
+     memset( &event, 0, sizeof(event) );
+
+     event.events   = EPOLLIN;
+     event.data.u32 = EPOLL_ID_QUIT;
+
+     epoll_ctl( epoll_fd, EPOLL_CTL_ADD, epoll_quitpipe[0], &event );
+
+     /* Devices may be closed from the epoll thread itself while handling hotplug events. */
+     pthread_mutexattr_init( &attr );
+     pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+     pthread_mutex_init( &epoll_lock, &attr );
+     pthread_mutexattr_destroy( &attr );
+
+     epoll_thread = direct_thread_create( DTT_INPUT, linux_input_EpollThread, NULL, "Linux Input" );
+
+     D_INFO( "DirectFB/linux_input: Serving all devices from one thread\n" );
+
+     return DFB_OK;
+
+error_pipe:
+     close( epoll_fd );
+     epoll_fd = -1;
+
+error:
+     epoll_users--;
+
+     return DFB_INIT;
 }
 
+static void
+epoll_unref( void )
+{
+     int res;
+
+     D_ASSERT( epoll_users > 0 );
+
+     if (--epoll_users)
+          return;
+
+     /* stop epoll thread */
+     res = write( epoll_quitpipe[1], " ", 1 );
+     (void)res;
+     direct_thread_join( epoll_thread );
+     direct_thread_destroy( epoll_thread );
+     close( epoll_quitpipe[0] );
+     close( epoll_quitpipe[1] );
+
+     epoll_thread = NULL;
+
+     pthread_mutex_destroy( &epoll_lock );
+
+     close( epoll_fd );
+     epoll_fd = -1;
+}
+
+static DFBResult
+epoll_add( int fd, u32 id )
+{
+     struct epoll_event event;
+
+     memset( &event, 0, sizeof(event) );
+
+     event.events   = EPOLLIN;
+     event.data.u32 = id;
+
+     if (epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &event )) {
+          D_PERROR( "DirectFB/linux_input: epoll_ctl( ADD ) failed!\n" );
+          return DFB_INIT;
+     }
+
+     return DFB_OK;
+}
+
+/**********************************************************************************************************************/
+
 /*
  * Stop hotplug detection thread.
  */
@@ -1687,6 +2026,26 @@ stop_hotplug( void )
 
      D_DEBUG_AT( Debug_LinuxInput, "%s()\n", __FUNCTION__ );
 
+     if (dfb_config->linux_input_epoll) {
+          if (socket_fd <= 0)
+               goto exit;
+
+          pthread_mutex_lock( &epoll_lock );
+
+          epoll_ctl( epoll_fd, EPOLL_CTL_DEL, socket_fd, NULL );
+
+          close( socket_fd );
+          socket_fd = 0;
+
+          pthread_mutex_unlock( &epoll_lock );
+
+          epoll_unref();
+
+          pthread_mutex_destroy(&driver_suspended_lock);
+
+          goto exit;
+     }
+
      /* Exit immediately if the hotplug thread is not created successfully in
       * launch_hotplug().
       */
@@ -1744,6 +2103,35 @@ launch_hotplug(CoreDFB         *core,
      D_ASSERT( input_driver != NULL );
      D_ASSERT( hotplug_thread == NULL );
 
+     if (dfb_config->linux_input_epoll) {
+          socket_fd = udev_hotplug_open();
+          if (socket_fd == -1) {
+               D_INFO( "Linux/Input: Fail to open udev socket, disable detecting "
+                       "hotplug with Linux Input provider\n" );
+               socket_fd = 0;
+               return DFB_UNSUPPORTED;
+          }
+
+          if (epoll_ref()) {
+               close( socket_fd );
+               socket_fd = 0;
+               return DFB_UNSUPPORTED;
+          }
+
+          pthread_mutex_init(&driver_suspended_lock, NULL);
+
+          pthread_mutex_lock( &epoll_lock );
+
+          epoll_hotplug_core   = core;
+          epoll_hotplug_driver = input_driver;
+
+          epoll_add( socket_fd, EPOLL_ID_HOTPLUG );
+
+          pthread_mutex_unlock( &epoll_lock );
+
+          return DFB_OK;
+     }
+
      data = D_CALLOC(1, sizeof(HotplugThreadData));
 
      if (!data) {
@@ -1894,6 +2282,30 @@ driver_open_device( CoreInputDevice  *device,
           set_led( data, LED_CAPSL, 0 );
      }
 
+     if (dfb_config->linux_input_epoll) {
+          if (epoll_ref())
+               goto driver_open_device_error;
+
+          pthread_mutex_lock( &epoll_lock );
+
+          device_init_state( data );
+
+          if (epoll_add( fd, number )) {
+               pthread_mutex_unlock( &epoll_lock );
+               epoll_unref();
+               goto driver_open_device_error;
+          }
+
+          epoll_devices[number] = data;
+
+          pthread_mutex_unlock( &epoll_lock );
+
+          /* set private data pointer */
+          *driver_data = data;
+
+          return DFB_OK;
+     }
+
      /* open a pipe to awake the reader thread when we want to quit */
      ret = pipe( data->quitpipe );
      if (ret < 0) {
@@ -2041,13 +2453,27 @@ driver_close_device( void *driver_data )
 
      D_DEBUG_AT( Debug_LinuxInput, "%s()\n", __FUNCTION__ );
 
-     /* stop input thread */
-     res = write( data->quitpipe[1], " ", 1 );
-     (void)res;
-     direct_thread_join( data->thread );
-     direct_thread_destroy( data->thread );
-     close( data->quitpipe[0] );
-     close( data->quitpipe[1] );
+     if (dfb_config->linux_input_epoll) {
+          /* stop polling the device */
+          pthread_mutex_lock( &epoll_lock );
+
+          epoll_ctl( epoll_fd, EPOLL_CTL_DEL, data->fd, NULL );
+
+          epoll_devices[data->index] = NULL;
+
+          pthread_mutex_unlock( &epoll_lock );
+
+          epoll_unref();
+     }
+     else {
+          /* stop input thread */
+          res = write( data->quitpipe[1], " ", 1 );
+          (void)res;
+          direct_thread_join( data->thread );
+          direct_thread_destroy( data->thread );
+          close( data->quitpipe[0] );
+          close( data->quitpipe[1] );
+     }
 
      if (data->has_leds) {
           /* restore LED state */
@@ -0,0 +1,406 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <directfb.h>
+
+#include <core/input.h>
+#include <core/input_recording.h>
+
+#include <direct/clock.h>
+#include <direct/debug.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+#include <direct/util.h>
+
+#include <misc/conf.h>
+
+#define DFB_INPUTDRIVER_HAS_AXIS_INFO
+
+#include <core/input_driver.h>
+#include <directfb_version.h>
+
+DFB_INPUT_DRIVER( replay )
+
+D_DEBUG_DOMAIN( Replay, "Input/Replay", "Input Replay Driver" );
+
+/* maximum number of events with the same time dispatched at once */
+#define REPLAY_FRAME_MAX 16
+
+/*
+ * declaration of private data
+ */
+typedef struct {
+     CoreInputDevice     *device;
+     DirectThread        *thread;
+
+     DFBInputRecord      *records;      /* whole recording, read at open to avoid file access while playing */
+     unsigned int         num_records;
+
+     DirectMutex          lock;
+     DirectWaitQueue      wq;
+     bool                 stop;
+} ReplayData;
+
+/**********************************************************************************************************************/
+
+static DFBResult
+load_recording( const char       *filename,
+                DFBInputRecord  **ret_records,
+                unsigned int     *ret_num )
+{
+     DFBInputRecordingHeader  header;
+     DFBInputRecord          *records;
+     unsigned int             num  = 0;
+     unsigned int             size = 256;
+     FILE                    *file;
+
+     file = fopen( filename, "rb" );
+     if (!file) {
+          D_PERROR( "Input/Replay: Could not open '%s'!\n", filename );
+          return DFB_IO;
+     }
+
+     if (fread( &header, sizeof(header), 1, file ) != 1 ||
+         memcmp( header.magic, DFB_INPUT_RECORDING_MAGIC, sizeof(header.magic) ))
+     {
+          D_ERROR( "Input/Replay: '%s' is no input recording!\n", filename );
+          fclose( file );
+          return DFB_UNSUPPORTED;
+     }
+
+     if (header.version != DFB_INPUT_RECORDING_VERSION || header.event_size != sizeof(DFBInputEvent)) {
+          D_ERROR( "Input/Replay: '%s' has version %u and event size %u, expected %u and %zu!\n", filename,
+                   header.version, header.event_size, DFB_INPUT_RECORDING_VERSION, sizeof(DFBInputEvent) );
+          fclose( file );
+          return DFB_UNSUPPORTED;
+     }
+
+     if (header.num_records)
+          size = header.num_records;
+
+     records = D_MALLOC( size * sizeof(DFBInputRecord) );
+     if (!records) {
+          fclose( file );
+          return D_OOM();
+     }
+
+     /* Unfinished recordings are read until the end of the file. */
+     while (fread( &records[num], sizeof(DFBInputRecord), 1, file ) == 1) {
+          if (++num == size) {
+               DFBInputRecord *grown;
+
+               if (header.num_records)
+                    break;
+
+               grown = D_REALLOC( records, size * 2 * sizeof(DFBInputRecord) );
+               if (!grown) {
+                    D_FREE( records );
+                    fclose( file );
+                    return D_OOM();
+               }
+
+               records = grown;
+               size   *= 2;
+          }
+     }
+
+     fclose( file );
+
+     if (!num) {
+          D_ERROR( "Input/Replay: '%s' has no events!\n", filename );
+          D_FREE( records );
+          return DFB_UNSUPPORTED;
+     }
+
+     D_DEBUG_AT( Replay, "  -> loaded %u events, %lld.%03lld sec\n", num,
+                 (long long) records[num-1].time / 1000000, (long long) records[num-1].time / 1000 % 1000 );
+
+     *ret_records = records;
+     *ret_num     = num;
+
+     return DFB_OK;
+}
+
+/*
+ * Waits until the time on the monotonic clock, returns false if the device is closed.
+ */
+static bool
+wait_until( ReplayData *data,
+            long long   time )
+{
+     long long now;
+
+     direct_mutex_lock( &data->lock );
+
+     while (!data->stop) {
+          now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+          if (now >= time)
+               break;
+
+          direct_waitqueue_wait_timeout( &data->wq, &data->lock, time - now );
+     }
+
+     direct_mutex_unlock( &data->lock );
+
+     return !data->stop;
+}
+
+/*
+ * Input thread playing the recording.
+ * Events recorded at the same time are dispatched as one frame.
+ */
+static void *
+replayEventThread( DirectThread *thread, void *driver_data )
+{
+     ReplayData    *data   = driver_data;
+     unsigned int   speed  = dfb_config->input_replay_speed;
+     unsigned int   passes = 0;
+     DFBInputEvent  events[REPLAY_FRAME_MAX];
+
+     do {
+          unsigned int i, n;
+          unsigned int frames   = 0;
+          long long    start    = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+          long long    late     = 0;
+          long long    late_max = 0;
+
+          for (i=0; i<data->num_records; i+=n) {
+               const DFBInputRecord *record = &data->records[i];
+
+               if (speed) {
+                    long long time = start + record->time * 100 / speed;
+                    long long lateness;
+
+                    if (!wait_until( data, time ))
+                         return NULL;
+
+                    lateness = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) - time;
+
+                    late += lateness;
+
+                    if (late_max < lateness)
+                         late_max = lateness;
+               }
+               else if (data->stop)
+                    return NULL;
+
+               for (n=0; n<REPLAY_FRAME_MAX && i + n < data->num_records; n++) {
+                    if (data->records[i+n].time != record->time)
+                         break;
+
+                    events[n] = data->records[i+n].event;
+
+                    /* Let the input core stamp the events with the time of dispatching. */
+                    events[n].flags &= ~DIEF_TIMESTAMP;
+               }
+
+               dfb_input_dispatch_frame( data->device, events, n );
+
+               frames++;
+          }
+
+          /* Looping without delays, report the first pass only and let others run between passes. */
+          if (speed || !passes)
+               D_INFO( "Input/Replay: Played %u events in %lld ms, %lld us late on average, %lld us at most\n",
+                       data->num_records, (direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) - start) / 1000,
+                       late / frames, late_max );
+
+          if (!speed)
+               direct_sched_yield();
+
+          passes++;
+     } while (dfb_config->input_replay_loop);
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Return the number of available devices.
+ * Called once during initialization of DirectFB.
+ */
+static int
+driver_get_available( void )
+{
+     if (dfb_config->input_replay)
+          return 1;
+
+     return 0;
+}
+
+/*
+ * Fill out general information about this driver.
+ * Called once during initialization of DirectFB.
+ */
+static void
+driver_get_info( InputDriverInfo *info )
+{
+     /* fill driver info structure */
+     snprintf( info->name,
+               DFB_INPUT_DRIVER_INFO_NAME_LENGTH, "Input Replay Driver" );
+     snprintf( info->vendor,
+               DFB_INPUT_DRIVER_INFO_VENDOR_LENGTH, "DirectFB" );
+
+     info->version.major = DIRECTFB_MAJOR_VERSION;
+     info->version.minor = DIRECTFB_MINOR_VERSION;
+}
+
+/*
+ * Load the recording, fill out information about device,
+ * allocate and fill private data, start input thread.
+ * Called during initialization, resuming or taking over mastership.
+ */
+static DFBResult
+driver_open_device( CoreInputDevice  *device,
+                    unsigned int      number,
+                    InputDeviceInfo  *info,
+                    void            **driver_data )
+{
+     DFBResult   ret;
+     ReplayData *data;
+
+     D_DEBUG_AT( Replay, "%s( '%s' )\n", __FUNCTION__, dfb_config->input_replay );
+
+     /* allocate and fill private data */
+     data = D_CALLOC( 1, sizeof(ReplayData) );
+     if (!data)
+          return D_OOM();
+
+     data->device = device;
+
+     ret = load_recording( dfb_config->input_replay, &data->records, &data->num_records );
+     if (ret) {
+          D_FREE( data );
+          return ret;
+     }
+
+     direct_mutex_init( &data->lock );
+     direct_waitqueue_init( &data->wq );
+
+     /* set device name */
+     snprintf( info->desc.name,
+               DFB_INPUT_DEVICE_DESC_NAME_LENGTH, "Input Replay" );
+
+     /* set device vendor */
+     snprintf( info->desc.vendor,
+               DFB_INPUT_DEVICE_DESC_VENDOR_LENGTH, "DirectFB" );
+
+     /* set one of the primary input device IDs */
+     info->prefered_id = DIDID_ANY;
+
+     /* set type flags, the recording may contain events of any device */
+     info->desc.type = DIDTF_KEYBOARD | DIDTF_MOUSE |
+                       DIDTF_JOYSTICK | DIDTF_REMOTE | DIDTF_VIRTUAL;
+
+     /* set capabilities */
+     info->desc.caps     = DICAPS_ALL;
+     info->desc.max_axis = DIAI_LAST;
+
+     /* start input thread */
+     data->thread = direct_thread_create( DTT_INPUT, replayEventThread, data, "Input Replay" );
+     if (!data->thread) {
+          D_ERROR( "Input/Replay: Could not create the input thread!\n" );
+
+          direct_waitqueue_deinit( &data->wq );
+          direct_mutex_deinit( &data->lock );
+
+          D_FREE( data->records );
+          D_FREE( data );
+
+          return DFB_INIT;
+     }
+
+     /* set private data pointer */
+     *driver_data = data;
+
+     return DFB_OK;
+}
+
+/*
+ * Fetch one entry from the device's keymap if supported.
+ */
+static DFBResult
+driver_get_keymap_entry( CoreInputDevice           *device,
+                         void                      *driver_data,
+                         DFBInputDeviceKeymapEntry *entry )
+{
+     return DFB_UNSUPPORTED;
+}
+
+static DFBResult
+driver_get_axis_info( CoreInputDevice              *device,
+                      void                         *driver_data,
+                      DFBInputDeviceAxisIdentifier  axis,
+                      DFBInputDeviceAxisInfo       *ret_info )
+{
+     /* absolute axes are recorded with their range in each event */
+     ret_info->flags   = DIAIF_ABS_MIN | DIAIF_ABS_MAX;
+     ret_info->abs_min = 0;
+     ret_info->abs_max = 65535;
+
+     return DFB_OK;
+}
+
+/*
+ * End thread, free the recording and private data.
+ */
+static void
+driver_close_device( void *driver_data )
+{
+     ReplayData *data = driver_data;
+
+     /* stop input thread */
+     direct_mutex_lock( &data->lock );
+
+     data->stop = true;
+
+     direct_waitqueue_broadcast( &data->wq );
+
+     direct_mutex_unlock( &data->lock );
+
+     direct_thread_join( data->thread );
+     direct_thread_destroy( data->thread );
+
+     direct_waitqueue_deinit( &data->wq );
+     direct_mutex_deinit( &data->lock );
+
+     /* free private data */
+     D_FREE( data->records );
+     D_FREE( data );
+}
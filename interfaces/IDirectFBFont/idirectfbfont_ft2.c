@@ -49,9 +49,11 @@
 
 #include <media/idirectfbfont.h>
 
+#include <direct/hash.h>
 #include <direct/mem.h>
 #include <direct/memcpy.h>
 #include <direct/messages.h>
+#include <direct/processor.h>
 #include <direct/utf8.h>
 #include <direct/util.h>
 
@@ -93,42 +95,85 @@ static FT_Library      library           = NULL;
 static int             library_ref_count = 0;
 static pthread_mutex_t library_mutex     = PTHREAD_MUTEX_INITIALIZER;
 
-#define KERNING_CACHE_MIN    0
-#define KERNING_CACHE_MAX  127
-#define KERNING_CACHE_SIZE (KERNING_CACHE_MAX - KERNING_CACHE_MIN + 1)
+/* number of kerning pairs cached per font, must be a power of two */
+#define KERNING_CACHE_BITS  12
+#define KERNING_CACHE_SIZE  (1 << KERNING_CACHE_BITS)
 
-#define KERNING_DO_CACHE(a,b)      ((a) >= KERNING_CACHE_MIN && \
-                                    (a) <= KERNING_CACHE_MAX && \
-                                    (b) >= KERNING_CACHE_MIN && \
-                                    (b) <= KERNING_CACHE_MAX)
-
-#define KERNING_CACHE_ENTRY(a,b)   \
-     (data->kerning[(a)-KERNING_CACHE_MIN][(b)-KERNING_CACHE_MIN])
+#define KERNING_CACHE_HASH(a,b)    \
+     ((((u32)(a) * 0x9e3779b1u) ^ (u32)(b)) * 0x85ebca6bu >> (32 - KERNING_CACHE_BITS))
 
 #define CHAR_INDEX(c)    (((c) < 256) ? data->indices[c] : FT_Get_Char_Index( data->face, c ))
 
+typedef struct __FT2PrefetchWorker FT2PrefetchWorker;
+
 typedef struct {
-     FT_Face      face;
-     int          disable_charmap;
-     int          fixed_advance;
-     bool         fixed_clip;
-     unsigned int indices[256];
-     int          outline_radius;
-     int          outline_opacity;
-     float        up_unit_x;     /* unit vector pointing 'up' in for */
-     float        up_unit_y;     /* this font's rotation             */
+     FT_Face            face;
+     int                disable_charmap;
+     int                fixed_advance;
+     bool               fixed_clip;
+     unsigned int       indices[256];
+     int                outline_radius;
+     int                outline_opacity;
+     float              up_unit_x;     /* unit vector pointing 'up' in for */
+     float              up_unit_y;     /* this font's rotation             */
+
+     /* for opening the face again in each prefetch worker */
+     const void        *content;
+     unsigned int       content_size;
+     int                face_index;
+     FT_F26Dot6         char_width;
+     FT_F26Dot6         char_height;
+     bool               transform;
+     FT_Matrix          matrix;
+     FT_Int             load_flags;
+
+     FT2PrefetchWorker *workers;
+     unsigned int       num_workers;
+
+     pthread_mutex_t    prefetch_lock;
+     pthread_cond_t     prefetch_cond;
+     unsigned int       prefetch_pending;
+     DirectHash        *prepared;      /* rasterized glyphs waiting for upload */
 } FT2ImplData;
 
+/*
+ * glyph rasterized by a prefetch worker
+ */
+typedef struct {
+     FT_Bitmap    bitmap;        /* buffer follows the struct */
+     int          bitmap_left;
+     int          bitmap_top;
+     FT_Vector    advance;
+     int          uploads;       /* number of layers not uploaded yet */
+} FT2PreparedGlyph;
+
+struct __FT2PrefetchWorker {
+     DirectProcessor  processor;
+
+     FT2ImplData     *data;
+
+     FT_Library       library;       /* private instances, FreeType is not thread safe */
+     FT_Face          face;
+};
+
+typedef struct {
+     unsigned int index;
+} FT2PrefetchJob;
+
+/*
+ * Direct mapped, a colliding pair replaces the previous entry.
+ */
 typedef struct {
-     bool        initialised;
-     signed char x;
-     signed char y;
+     u32         prev;          /* ~0 if unused */
+     u32         current;
+     s16         x;
+     s16         y;
 } KerningCacheEntry;
 
 typedef struct {
      FT2ImplData base;
 
-     KerningCacheEntry kerning[KERNING_CACHE_SIZE][KERNING_CACHE_SIZE];
+     KerningCacheEntry kerning[KERNING_CACHE_SIZE];
 } FT2ImplKerningData;
 
 /**********************************************************************************************************************/
@@ -259,34 +304,322 @@ static const CoreFontEncodingFuncs ft2Latin1Funcs = {
 
 /**********************************************************************************************************************/
 
+static FT2PreparedGlyph *
+prepared_glyph_lookup( FT2ImplData  *data,
+                       unsigned int  index )
+{
+     FT2PreparedGlyph *prepared;
+
+     if (!data->prepared)
+          return NULL;
+
+     pthread_mutex_lock( &data->prefetch_lock );
+
+     prepared = direct_hash_lookup( data->prepared, index );
+
+     pthread_mutex_unlock( &data->prefetch_lock );
+
+     return prepared;
+}
+
+/*
+ * Called when a layer of the glyph has been uploaded, entries are only removed with the font being locked.
+ */
+static void
+prepared_glyph_release( FT2ImplData      *data,
+                        unsigned int      index,
+                        FT2PreparedGlyph *prepared )
+{
+     if (--prepared->uploads > 0)
+          return;
+
+     pthread_mutex_lock( &data->prefetch_lock );
+
+     direct_hash_remove( data->prepared, index );
+
+     pthread_mutex_unlock( &data->prefetch_lock );
+
+     D_FREE( prepared );
+}
+
+static bool
+free_prepared_glyphs( DirectHash    *hash,
+                      unsigned long  key,
+                      void          *value,
+                      void          *ctx )
+{
+     D_FREE( value );
+
+     return true;
+}
+
+static DFBResult
+prefetch_worker_open( FT2PrefetchWorker *worker )
+{
+     FT_Error     err;
+     FT2ImplData *data = worker->data;
+
+     err = FT_Init_FreeType( &worker->library );
+     if (err) {
+          worker->library = NULL;
+          return DFB_FAILURE;
+     }
+
+     err = FT_New_Memory_Face( worker->library, data->content, data->content_size, data->face_index, &worker->face );
+     if (err)
+          goto error;
+
+     if (data->transform)
+          FT_Set_Transform( worker->face, &data->matrix, NULL );
+
+     if (data->char_width || data->char_height) {
+          err = FT_Set_Char_Size( worker->face, data->char_width, data->char_height, 0, 0 );
+          if (err) {
+               FT_Done_Face( worker->face );
+               goto error;
+          }
+     }
+
+     return DFB_OK;
+
+
+error:
+     worker->face = NULL;
+
+     FT_Done_FreeType( worker->library );
+     worker->library = NULL;
+
+     return DFB_FAILURE;
+}
+
+static DirectResult
+prefetch_worker_process( DirectProcessor *processor,
+                         void            *job_data,
+                         void            *context )
+{
+     FT2PrefetchJob    *job      = job_data;
+     FT2PrefetchWorker *worker   = context;
+     FT2ImplData       *data     = worker->data;
+     FT2PreparedGlyph  *prepared = NULL;
+
+     if (!worker->library && prefetch_worker_open( worker ))
+          D_ERROR( "DirectFB/FontFT2: Could not open face for prefetching!\n" );
+
+     if (worker->face && !FT_Load_Glyph( worker->face, job->index, data->load_flags | FT_LOAD_RENDER )) {
+          FT_GlyphSlot slot = worker->face->glyph;
+
+          /* Glyphs with bottom-up bitmaps are loaded later on the regular path. */
+          if (slot->bitmap.pitch >= 0) {
+               size_t size = slot->bitmap.pitch * slot->bitmap.rows;
+
+               prepared = D_MALLOC( sizeof(FT2PreparedGlyph) + size );
+               if (prepared) {
+                    prepared->bitmap        = slot->bitmap;
+                    prepared->bitmap.buffer = (unsigned char*) (prepared + 1);
+                    prepared->bitmap_left   = slot->bitmap_left;
+                    prepared->bitmap_top    = slot->bitmap_top;
+                    prepared->advance       = slot->advance;
+                    prepared->uploads       = data->outline_radius ? 2 : 1;
+
+                    if (size)
+                         direct_memcpy( prepared->bitmap.buffer, slot->bitmap.buffer, size );
+               }
+               else
+                    D_OOM();
+          }
+     }
+
+     pthread_mutex_lock( &data->prefetch_lock );
+
+     if (prepared) {
+          if (direct_hash_lookup( data->prepared, job->index ))
+               D_FREE( prepared );
+          else
+               direct_hash_insert( data->prepared, job->index, prepared );
+     }
+
+     if (!--data->prefetch_pending)
+          pthread_cond_broadcast( &data->prefetch_cond );
+
+     pthread_mutex_unlock( &data->prefetch_lock );
+
+     direct_processor_recycle( processor, job );
+
+     return DR_OK;
+}
+
+static const DirectProcessorFuncs prefetch_worker_funcs = {
+     .Process = prefetch_worker_process,
+};
+
+static DFBResult
+prefetch_init( FT2ImplData *data )
+{
+     DFBResult    ret;
+     unsigned int i;
+
+     if (data->workers)
+          return DFB_OK;
+
+     if (!data->prepared) {
+          ret = direct_hash_create( 97, &data->prepared );
+          if (ret)
+               return ret;
+     }
+
+     data->workers = D_CALLOC( dfb_config->font_prefetch_threads, sizeof(FT2PrefetchWorker) );
+     if (!data->workers)
+          return D_OOM();
+
+     for (i=0; i<dfb_config->font_prefetch_threads; i++) {
+          FT2PrefetchWorker *worker = &data->workers[i];
+
+          worker->data = data;
+
+          ret = direct_processor_init( &worker->processor, "FT2 Prefetch", &prefetch_worker_funcs,
+                                       sizeof(FT2PrefetchJob), worker, 0 );
+          if (ret)
+               break;
+
+          data->num_workers++;
+     }
+
+     if (!data->num_workers) {
+          D_FREE( data->workers );
+          data->workers = NULL;
+          return ret;
+     }
+
+     return DFB_OK;
+}
+
+static void
+prefetch_deinit( FT2ImplData *data )
+{
+     unsigned int i;
+
+     for (i=0; i<data->num_workers; i++) {
+          FT2PrefetchWorker *worker = &data->workers[i];
+
+          direct_processor_destroy( &worker->processor );
+
+          if (worker->face)
+               FT_Done_Face( worker->face );
+
+          if (worker->library)
+               FT_Done_FreeType( worker->library );
+     }
+
+     if (data->workers)
+          D_FREE( data->workers );
+
+     if (data->prepared) {
+          direct_hash_iterate( data->prepared, free_prepared_glyphs, NULL );
+          direct_hash_destroy( data->prepared );
+     }
+
+     pthread_cond_destroy( &data->prefetch_cond );
+     pthread_mutex_destroy( &data->prefetch_lock );
+}
+
+static DFBResult
+prepare_glyphs( CoreFont           *thiz,
+                const unsigned int *indices,
+                unsigned int        num )
+{
+     DFBResult    ret;
+     unsigned int i;
+     FT2ImplData *data = thiz->impl_data;
+
+     if (!dfb_config->font_prefetch_threads)
+          return DFB_UNSUPPORTED;
+
+     pthread_mutex_lock( &data->prefetch_lock );
+
+     ret = prefetch_init( data );
+     if (ret) {
+          pthread_mutex_unlock( &data->prefetch_lock );
+          return ret;
+     }
+
+     data->prefetch_pending += num;
+
+     pthread_mutex_unlock( &data->prefetch_lock );
+
+     for (i=0; i<num; i++) {
+          FT2PrefetchWorker *worker = &data->workers[i % data->num_workers];
+          FT2PrefetchJob    *job;
+
+          job = direct_processor_allocate( &worker->processor );
+          if (!job) {
+               pthread_mutex_lock( &data->prefetch_lock );
+               data->prefetch_pending -= num - i;
+               pthread_mutex_unlock( &data->prefetch_lock );
+               break;
+          }
+
+          job->index = indices[i];
+
+          direct_processor_post( &worker->processor, job );
+     }
+
+     /* Wait for the workers, uploading is done by the core afterwards. */
+     pthread_mutex_lock( &data->prefetch_lock );
+
+     while (data->prefetch_pending)
+          pthread_cond_wait( &data->prefetch_cond, &data->prefetch_lock );
+
+     pthread_mutex_unlock( &data->prefetch_lock );
+
+     return DFB_OK;
+}
+
+/**********************************************************************************************************************/
+
 static DFBResult
 render_glyph( CoreFont      *thiz,
               unsigned int   index,
               CoreGlyphData *info )
 {
-     FT_Error     err;
-     FT_Face      face;
-     FT_Int       load_flags;
-     u8          *src;
-     int          y;
-     FT2ImplData *data    = thiz->impl_data;
-     CoreSurface *surface = info->surface;
+     FT_Error          err;
+     FT_Face           face;
+     FT_Int            load_flags;
+     u8               *src;
+     int               y;
+     FT2ImplData      *data    = thiz->impl_data;
+     CoreSurface      *surface = info->surface;
      CoreSurfaceBufferLock  lock;
+     FT2PreparedGlyph *prepared;
+     const FT_Bitmap  *bitmap;
+     int               bitmap_left;
+     int               bitmap_top;
+
+     prepared = prepared_glyph_lookup( data, index );
+     if (prepared) {
+          bitmap      = &prepared->bitmap;
+          bitmap_left = prepared->bitmap_left;
+          bitmap_top  = prepared->bitmap_top;
+     }
+     else {
+          pthread_mutex_lock ( &library_mutex );
 
-     pthread_mutex_lock ( &library_mutex );
+          face = data->face;
 
-     face = data->face;
+          load_flags = (unsigned long) face->generic.data;
+          load_flags |= FT_LOAD_RENDER;
 
-     load_flags = (unsigned long) face->generic.data;
-     load_flags |= FT_LOAD_RENDER;
+          if ((err = FT_Load_Glyph( face, index, load_flags ))) {
+               D_DEBUG( "DirectFB/FontFT2: Could not render glyph for character index #%d!\n", index );
+               pthread_mutex_unlock ( &library_mutex );
+               return DFB_FAILURE;
+          }
 
-     if ((err = FT_Load_Glyph( face, index, load_flags ))) {
-          D_DEBUG( "DirectFB/FontFT2: Could not render glyph for character index #%d!\n", index );
           pthread_mutex_unlock ( &library_mutex );
-          return DFB_FAILURE;
-     }
 
-     pthread_mutex_unlock ( &library_mutex );
+          bitmap      = &face->glyph->bitmap;
+          bitmap_left = face->glyph->bitmap_left;
+          bitmap_top  = face->glyph->bitmap_top;
+     }
 
      err = dfb_surface_lock_buffer( surface, CSBR_BACK, CSAID_CPU, CSAF_WRITE, &lock );
      if (err) {
@@ -294,19 +627,19 @@ render_glyph( CoreFont      *thiz,
           return err;
      }
 
-     info->width = face->glyph->bitmap.width;
+     info->width = bitmap->width;
      if (info->width + info->start > surface->config.size.w)
           info->width = surface->config.size.w - info->start;
 
-     info->height = face->glyph->bitmap.rows;
+     info->height = bitmap->rows;
      if (info->height > surface->config.size.h)
           info->height = surface->config.size.h;
 
      /* bitmap_left and bitmap_top are relative to the glyph's origin on the
         baseline.  info->left and info->top are relative to the top-left of the
         character cell. */
-     info->left =   face->glyph->bitmap_left - thiz->ascender*thiz->up_unit_x;
-     info->top  = - face->glyph->bitmap_top  - thiz->ascender*thiz->up_unit_y;
+     info->left =   bitmap_left - thiz->ascender*thiz->up_unit_x;
+     info->top  = - bitmap_top  - thiz->ascender*thiz->up_unit_y;
 
      if (info->layer == 1 && info->width > 0 && info->height > 0) {
           int   xoffset, yoffset;
@@ -314,13 +647,13 @@ render_glyph( CoreFont      *thiz,
           void *blurred = NULL;
           int   radius  = data->outline_radius;
 
-          switch (face->glyph->bitmap.pixel_mode) {
+          switch (bitmap->pixel_mode) {
                case ft_pixel_mode_grays:
                     blurred = D_CALLOC( 1, (info->width + radius) * (info->height + radius) );
                     if (blurred) {
                          for (yoffset=0; yoffset<radius; yoffset++) {
                               for (xoffset=0; xoffset<radius; xoffset++) {
-                                   src = face->glyph->bitmap.buffer;
+                                   src = bitmap->buffer;
 
                                    for (y=0; y < info->height; y++) {
                                         int  i;
@@ -332,7 +665,7 @@ render_glyph( CoreFont      *thiz,
                                              dst8[i] = (val < 255) ? val : 255;
                                         }
 
-                                        src += face->glyph->bitmap.pitch;
+                                        src += bitmap->pitch;
                                    }
                               }
                          }
@@ -366,7 +699,7 @@ render_glyph( CoreFont      *thiz,
                     u8  *dst8  = addr;
                     u32 *dst32 = addr;
 
-                    switch (face->glyph->bitmap.pixel_mode) {
+                    switch (bitmap->pixel_mode) {
                          case ft_pixel_mode_grays:
                               switch (surface->config.format) {
                                    case DSPF_ARGB:
@@ -418,7 +751,7 @@ render_glyph( CoreFont      *thiz,
                     info->width = data->fixed_advance;
           }
 
-          src = face->glyph->bitmap.buffer;
+          src = bitmap->buffer;
           lock.addr += DFB_BYTES_PER_LINE(surface->config.format, info->start);
 
           for (y=0; y < info->height; y++) {
@@ -427,7 +760,7 @@ render_glyph( CoreFont      *thiz,
                u16 *dst16 = lock.addr;
                u32 *dst32 = lock.addr;
 
-               switch (face->glyph->bitmap.pixel_mode) {
+               switch (bitmap->pixel_mode) {
                     case ft_pixel_mode_grays:
                          switch (surface->config.format) {
                               case DSPF_ARGB:
@@ -662,7 +995,7 @@ render_glyph( CoreFont      *thiz,
 
                }
 
-               src += face->glyph->bitmap.pitch;
+               src += bitmap->pitch;
 
                lock.addr += lock.pitch;
           }
@@ -670,6 +1003,9 @@ render_glyph( CoreFont      *thiz,
 
      dfb_surface_unlock_buffer( surface, &lock );
 
+     if (prepared)
+          prepared_glyph_release( data, index, prepared );
+
      return DFB_OK;
 }
 
@@ -679,10 +1015,32 @@ get_glyph_info( CoreFont      *thiz,
                 unsigned int   index,
                 CoreGlyphData *info )
 {
-     FT_Error err;
-     FT_Face  face;
-     FT_Int   load_flags;
-     FT2ImplData *data = (FT2ImplData*) thiz->impl_data;
+     FT_Error          err;
+     FT_Face           face;
+     FT_Int            load_flags;
+     FT2ImplData      *data = (FT2ImplData*) thiz->impl_data;
+     FT2PreparedGlyph *prepared;
+
+     prepared = prepared_glyph_lookup( data, index );
+     if (prepared) {
+          info->width  = prepared->bitmap.width;
+          info->height = prepared->bitmap.rows;
+
+          if (data->fixed_advance) {
+               info->xadvance = - data->fixed_advance * thiz->up_unit_y;
+               info->yadvance =   data->fixed_advance * thiz->up_unit_x;
+          }
+          else {
+               info->xadvance =   prepared->advance.x << 2;
+               info->yadvance = - prepared->advance.y << 2;
+          }
+
+          /* Nothing to upload for empty glyphs. */
+          if (info->width < 1 || info->height < 1)
+               prepared_glyph_release( data, index, prepared );
+
+          goto out;
+     }
 
      pthread_mutex_lock ( &library_mutex );
 
@@ -724,6 +1082,7 @@ get_glyph_info( CoreFont      *thiz,
           info->yadvance = - face->glyph->advance.y << 2;
      }
 
+out:
      if (data->fixed_clip && info->width > data->fixed_advance)
           info->width = data->fixed_advance;
 
@@ -746,58 +1105,38 @@ get_kerning( CoreFont     *thiz,
      FT_Vector vector;
 
      FT2ImplKerningData *data = thiz->impl_data;
-     KerningCacheEntry *cache = NULL;
+     KerningCacheEntry  *cache;
 
      D_ASSUME( (kern_x != NULL) || (kern_y != NULL) );
 
+     cache = &data->kerning[KERNING_CACHE_HASH( prev, current )];
+
      /*
-      * Use cached values if characters are in the
-      * cachable range and the cache entry is already filled.
+      * Lookup the kerning values for the character pair
+      * and cache them, replacing any other pair in the slot.
+      * Both under the lock, as another thread may replace the pair.
       */
-     if (KERNING_DO_CACHE (prev, current)) {
-          cache = &KERNING_CACHE_ENTRY (prev, current);
-
-          if (!cache->initialised && FT_HAS_KERNING(data->base.face)) {
-               FT_Vector vector;
-
-               pthread_mutex_lock ( &library_mutex );
-
-               /* Lookup kerning values for the character pair. */
-               FT_Get_Kerning( data->base.face,
-                               prev, current, ft_kerning_default, &vector );
-
-               cache->x = (signed char) ((int)(- vector.x*data->base.up_unit_x + vector.y*data->base.up_unit_x) >> 6);
-               cache->y = (signed char) ((int)(  vector.y*data->base.up_unit_y + vector.x*data->base.up_unit_x) >> 6);
-
-               cache->initialised = true;
-
-               pthread_mutex_unlock ( &library_mutex );
-          }
-
-          if (kern_x)
-               *kern_x = (int) cache->x;
-
-          if (kern_y)
-               *kern_y = (int) cache->y;
-
-          return DFB_OK;
-     }
-
      pthread_mutex_lock ( &library_mutex );
 
-     /* Lookup kerning values for the character pair. */
-     /* The vector returned by FreeType does not allow for any rotation. */
-     FT_Get_Kerning( data->base.face,
-                     prev, current, ft_kerning_default, &vector );
+     if (cache->prev != prev || cache->current != current) {
+          /* The vector returned by FreeType does not allow for any rotation. */
+          FT_Get_Kerning( data->base.face,
+                          prev, current, ft_kerning_default, &vector );
 
-     pthread_mutex_unlock ( &library_mutex );
+          /* Convert to integer. */
+          cache->x       = (int)(- vector.x*thiz->up_unit_y + vector.y*thiz->up_unit_x) >> 6;
+          cache->y       = (int)(  vector.y*thiz->up_unit_y + vector.x*thiz->up_unit_x) >> 6;
+          cache->prev    = prev;
+          cache->current = current;
+     }
 
-     /* Convert to integer. */
      if (kern_x)
-          *kern_x = (int)(- vector.x*thiz->up_unit_y + vector.y*thiz->up_unit_x) >> 6;
+          *kern_x = cache->x;
 
      if (kern_y)
-          *kern_y = (int)(  vector.y*thiz->up_unit_y + vector.x*thiz->up_unit_x) >> 6;
+          *kern_y = cache->y;
+
+     pthread_mutex_unlock ( &library_mutex );
 
      return DFB_OK;
 }
@@ -851,6 +1190,8 @@ IDirectFBFont_FT2_Destruct( IDirectFBFont *thiz )
      if (data->font->impl_data) {
           FT2ImplData *impl_data = (FT2ImplData*) data->font->impl_data;
 
+          prefetch_deinit( impl_data );
+
           pthread_mutex_lock ( &library_mutex );
           FT_Done_Face( impl_data->face );
           pthread_mutex_unlock ( &library_mutex );
@@ -935,6 +1276,9 @@ Construct( IDirectFBFont               *thiz,
      float sin_rot = 0.0;
      float cos_rot = 1.0;
 
+     FT_F26Dot6 char_width  = 0;
+     FT_F26Dot6 char_height = 0;
+
      D_DEBUG( "DirectFB/FontFT2: "
               "Construct font from file `%s' (index %d) at pixel size %d x %d and rotation %d.\n",
               filename,
@@ -1097,6 +1441,9 @@ Construct( IDirectFBFont               *thiz,
           pthread_mutex_lock ( &library_mutex );
           err = FT_Set_Char_Size( face, fw, fh, 0, 0 );
           pthread_mutex_unlock ( &library_mutex );
+
+          char_width  = fw;
+          char_height = fh;
           if (err) {
                D_ERROR( "DirectB/FontFT2: "
                          "Could not set pixel size to %d x %d!\n",
@@ -1151,12 +1498,26 @@ Construct( IDirectFBFont               *thiz,
      D_DEBUG( "DirectFB/FontFT2: height = %d, ascender = %d, descender = %d, maxadvance = %d, up unit: %5.2f,%5.2f\n",
               font->height, font->ascender, font->descender, font->maxadvance, font->up_unit_x, font->up_unit_y );
 
-     font->GetGlyphData = get_glyph_info;
-     font->RenderGlyph  = render_glyph;
+     font->GetGlyphData  = get_glyph_info;
+     font->RenderGlyph   = render_glyph;
+     font->PrepareGlyphs = prepare_glyphs;
+
+     /* Glyphs rendered by another FreeType version must not be taken from the glyph store. */
+     {
+          FT_Int major, minor, patch;
+
+          FT_Library_Version( library, &major, &minor, &patch );
+
+          font->renderer_version = (major << 16) | (minor << 8) | patch;
+     }
 
      if (FT_HAS_KERNING(face) && !disable_kerning) {
           font->GetKerning = get_kerning;
           data = D_CALLOC( 1, sizeof(FT2ImplKerningData) );
+
+          /* Mark all kerning cache entries unused. */
+          for (i=0; data && i<KERNING_CACHE_SIZE; i++)
+               ((FT2ImplKerningData*) data)->kerning[i].prev = ~0;
      }
      else
           data = D_CALLOC( 1, sizeof(FT2ImplData) );
@@ -1190,6 +1551,24 @@ Construct( IDirectFBFont               *thiz,
      data->up_unit_x = font->up_unit_x;
      data->up_unit_y = font->up_unit_y;
 
+     data->content      = ctx->content;
+     data->content_size = ctx->content_size;
+     data->face_index   = (desc->flags & DFDESC_INDEX) ? desc->index : 0;
+     data->char_width   = char_width;
+     data->char_height  = char_height;
+     data->load_flags   = load_flags;
+
+     if ((desc->flags & DFDESC_ROTATION) && desc->rotation) {
+          data->transform = true;
+          data->matrix.xx =  (int)(cos_rot*65536.0);
+          data->matrix.xy = -(int)(sin_rot*65536.0);
+          data->matrix.yx =  (int)(sin_rot*65536.0);
+          data->matrix.yy =  (int)(cos_rot*65536.0);
+     }
+
+     pthread_mutex_init( &data->prefetch_lock, NULL );
+     pthread_cond_init( &data->prefetch_cond, NULL );
+
      font->impl_data = data;
 
      dfb_font_register_encoding( font, "UTF8",   &ft2UTF8Funcs,   DTEID_UTF8 );
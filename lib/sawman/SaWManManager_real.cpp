@@ -140,6 +140,8 @@ ISaWManManager_Real::QueueUpdate(
      if (!update || dfb_region_region_intersect( &region, update )) {
           dfb_updates_add( &tier->left.updates, &region );
           dfb_updates_add( &tier->right.updates, &region );
+
+          sawman_backdrop_invalidate( m_sawman, tier, 0 );
      }
 
      sawman_unlock( m_sawman );
@@ -266,6 +268,8 @@ ISaWManManager_Real::SetScalingMode(
                dfb_updates_add( &tier->left.updates, &update );
                dfb_updates_add( &tier->right.updates, &update );
           }
+
+          sawman_backdrop_invalidate( m_sawman, NULL, 0 );
      }
 
      sawman_unlock( m_sawman );
@@ -340,6 +340,12 @@ ISaWMan_RegisterListeners( ISaWMan               *thiz,
 
      fusion_reactor_attach( m_sawman->reactor, ISaWMan_Listener, listener, &listener->reaction );
 
+     if (listeners->WindowBlit && sawman_lock( m_sawman ) == DR_OK) {
+          m_sawman->blit_listeners++;
+
+          sawman_unlock( m_sawman );
+     }
+
      return DFB_OK;
 }
 
@@ -357,6 +363,14 @@ ISaWMan_UnregisterListeners( ISaWMan *thiz,
           if (listener->context == context) {
                fusion_reactor_detach( m_sawman->reactor, &listener->reaction );
 
+               if (listener->listeners.WindowBlit && sawman_lock( m_sawman ) == DR_OK) {
+                    D_ASSERT( m_sawman->blit_listeners > 0 );
+
+                    m_sawman->blit_listeners--;
+
+                    sawman_unlock( m_sawman );
+               }
+
                direct_list_remove( &data->listeners, &listener->link );
                
                D_FREE( listener );
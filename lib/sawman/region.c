@@ -137,6 +137,7 @@ typedef struct {
 #define PIXREGION_BOX(reg,i) (&PIXREGION_BOXPTR(reg)[i])
 #define PIXREGION_TOP(reg) PIXREGION_BOX(reg, (reg)->data->numRects)
 #define PIXREGION_END(reg) PIXREGION_BOX(reg, (reg)->data->numRects - 1)
+#define PIXREGION_INLINE(reg) ((reg)->data == &(reg)->inline_storage.data)
 
 
 #undef assert
@@ -255,6 +256,10 @@ allocData(region_type_t * region, size_t n)
 
      MISC_REGION_ASSERT( region );
 
+     /* Small regions keep their boxes in the region itself */
+     if (region->inline_ok && n <= MISC_REGION_INLINE_BOXES && !PIXREGION_INLINE(region))
+          return &region->inline_storage.data;
+
      sz = PIXREGION_SZOF(n);
      if (!sz)
           return NULL;
@@ -265,7 +270,8 @@ allocData(region_type_t * region, size_t n)
 #define freeData(reg)                             \
      do {                                         \
           if ((reg)->data && (reg)->data->size) { \
-               if ((reg)->shmpool) SHFREE((reg)->shmpool, (reg)->data); else D_FREE((reg)->data);               \
+               if (PIXREGION_INLINE(reg)) ;       \
+               else if ((reg)->shmpool) SHFREE((reg)->shmpool, (reg)->data); else D_FREE((reg)->data);          \
                (reg)->data = NULL;                \
           }                                       \
      } while (0)
@@ -351,6 +357,7 @@ misc_region_init (region_type_t       *region,
      region->extents = *misc_region_emptyBox;
      region->data = misc_region_emptyData;
      region->shmpool = shmpool;
+     region->inline_ok = true;
 
      D_MAGIC_SET( region, misc_region_t );
 }
@@ -366,6 +373,7 @@ misc_region_init_rect (region_type_t *region,
      region->extents.y2 = y + height;
      region->data = NULL;
      region->shmpool = shmpool;
+     region->inline_ok = true;
 
      D_MAGIC_SET( region, misc_region_t );
 }
@@ -378,6 +386,7 @@ misc_region_init_with_extents (region_type_t *region,
      region->extents = *extents;
      region->data = NULL;
      region->shmpool = shmpool;
+     region->inline_ok = true;
 
      D_MAGIC_SET( region, misc_region_t );
 }
@@ -475,16 +484,28 @@ misc_rect_alloc (region_type_t * region, int n)
                     n = 250;
           }
           n += region->data->numRects;
-          data_size = PIXREGION_SZOF(n);
-          if (!data_size)
-               data = NULL;
-          else
-               data = region->shmpool ?
-                         SHREALLOC( region->shmpool, region->data, PIXREGION_SZOF(n) ) :
-                              D_REALLOC( region->data, PIXREGION_SZOF(n) );
-          if (!data)
-               return misc_break (region);
-          region->data = data;
+          if (PIXREGION_INLINE(region)) {
+               /* Grow within the inline storage or move the boxes out to the heap */
+               if (n > MISC_REGION_INLINE_BOXES) {
+                    data = allocData(region, n);
+                    if (!data)
+                         return misc_break (region);
+                    memcpy( data, region->data, PIXREGION_SZOF(region->data->numRects) );
+                    region->data = data;
+               }
+          }
+          else {
+               data_size = PIXREGION_SZOF(n);
+               if (!data_size)
+                    data = NULL;
+               else
+                    data = region->shmpool ?
+                              SHREALLOC( region->shmpool, region->data, PIXREGION_SZOF(n) ) :
+                                   D_REALLOC( region->data, PIXREGION_SZOF(n) );
+               if (!data)
+                    return misc_break (region);
+               region->data = data;
+          }
      }
      region->data->size = n;
      return true;
@@ -519,6 +540,48 @@ misc_region_copy (region_type_t *dst, region_type_t *src)
      return true;
 }
 
+/*======================================================================
+ *          Band Helpers
+ *====================================================================*/
+
+/* true iff both bands have their boxes at the same horizontal positions */
+static inline bool
+misc_band_equal_x( const box_type_t *a, const box_type_t *b, int num )
+{
+     int i;
+
+     for (i = 0; i < num; i++) {
+          if ((a[i].x1 != b[i].x1) || (a[i].x2 != b[i].x2))
+               return false;
+     }
+
+     return true;
+}
+
+/* set the bottom of each box in the band */
+static inline void
+misc_band_set_y2( box_type_t *boxes, int num, int y2 )
+{
+     int i;
+
+     for (i = 0; i < num; i++)
+          boxes[i].y2 = y2;
+}
+
+/* copy the horizontal extents of a band, replacing top and bottom */
+static inline void
+misc_band_copy_y( box_type_t *dst, const box_type_t *src, int num, int y1, int y2 )
+{
+     int i;
+
+     for (i = 0; i < num; i++) {
+          dst[i].x1 = src[i].x1;
+          dst[i].y1 = y1;
+          dst[i].x2 = src[i].x2;
+          dst[i].y2 = y2;
+     }
+}
+
 /*======================================================================
  *          Generic Region Operator
  *====================================================================*/
@@ -579,26 +642,15 @@ misc_coalesce (
       */
      y2 = pCurBox->y2;
 
-     do {
-          if ((pPrevBox->x1 != pCurBox->x1) || (pPrevBox->x2 != pCurBox->x2)) {
-               return(curStart);
-          }
-          pPrevBox++;
-          pCurBox++;
-          numRects--;
-     } while (numRects);
+     if (!misc_band_equal_x( pPrevBox, pCurBox, numRects ))
+          return(curStart);
 
      /*
       * The bands may be merged, so set the bottom y of each box
       * in the previous band to the bottom y of the current band.
       */
-     numRects = curStart - prevStart;
      region->data->numRects -= numRects;
-     do {
-          pPrevBox--;
-          pPrevBox->y2 = y2;
-          numRects--;
-     } while (numRects);
+     misc_band_set_y2( pPrevBox, numRects, y2 );
      return prevStart;
 }
 
@@ -650,11 +702,7 @@ misc_region_appendNonO (
      RECTALLOC(region, newRects);
      pNextRect = PIXREGION_TOP(region);
      region->data->numRects += newRects;
-     do {
-          assert(r->x1 < r->x2);
-          ADDRECT(pNextRect, r->x1, y1, r->x2, y2);
-          r++;
-     } while (r != rEnd);
+     misc_band_copy_y( pNextRect, r, newRects, y1, y2 );
 
      return true;
 }
@@ -750,6 +798,7 @@ misc_op(
      int    r2y1;
      int             newSize;
      int             numRects;
+     box_type_t      oldBoxes[MISC_REGION_INLINE_BOXES]; /* Inline rectangles of newReg */
 
      MISC_REGION_ASSERT( newReg );
      MISC_REGION_ASSERT( reg1 );
@@ -783,11 +832,34 @@ misc_op(
          ((newReg == reg2) && (numRects > 1))) {
           oldData = newReg->data;
           newReg->data = misc_region_emptyData;
+
+          /*
+           * Inline rectangles would be overwritten by the result, so work on a copy.
+           */
+          if (oldData == &newReg->inline_storage.data) {
+               memcpy( oldBoxes, oldData + 1, oldData->numRects * sizeof(box_type_t) );
+
+               if (newReg == reg1) {
+                    r1    = oldBoxes;
+                    r1End = r1 + oldData->numRects;
+               }
+
+               if (newReg == reg2) {
+                    r2    = oldBoxes;
+                    r2End = r2 + oldData->numRects;
+               }
+
+               oldData = NULL;
+          }
      }
      /* guess at new size */
      if (numRects > newSize)
           newSize = numRects;
      newSize <<= 1;
+     /* stay within the inline storage if the sources would fit into it */
+     if (newSize > MISC_REGION_INLINE_BOXES && newReg->inline_ok &&
+         PIXREGION_NUM_RECTS(reg1) + PIXREGION_NUM_RECTS(reg2) <= MISC_REGION_INLINE_BOXES)
+          newSize = MISC_REGION_INLINE_BOXES;
      if (!newReg->data)
           newReg->data = misc_region_emptyData;
      else if (newReg->data->size)
@@ -1470,6 +1542,22 @@ validate (region_type_t * badreg,
           return true;
      }
 
+     /* The regions below are moved around by value, so they must not use inline storage */
+     if (PIXREGION_INLINE(badreg)) {
+          region_data_type_t *data;
+
+          badreg->inline_ok = false;
+
+          data = allocData(badreg, numRects);
+          if (!data)
+               return misc_break (badreg);
+
+          memcpy( data, badreg->data, PIXREGION_SZOF(numRects) );
+          data->size = numRects;
+
+          badreg->data = data;
+     }
+
      /* Step 1: Sort the rects array into ascending (y1, x1) order */
      QuickSortRects(PIXREGION_BOXPTR(badreg), numRects);
 
@@ -1485,6 +1573,7 @@ validate (region_type_t * badreg,
      ri[0].prevBand = 0;
      ri[0].curBand = 0;
      ri[0].reg = *badreg;
+     ri[0].reg.inline_ok = false;
      box = PIXREGION_BOXPTR(&ri[0].reg);
      ri[0].reg.extents = *box;
      ri[0].reg.data->numRects = 1;
@@ -1554,6 +1643,7 @@ validate (region_type_t * badreg,
           rit->reg.extents = *box;
           rit->reg.data = NULL;
           rit->reg.shmpool = NULL;
+          rit->reg.inline_ok = false;
           D_MAGIC_SET( &rit->reg, misc_region_t );
           if (!misc_rect_alloc(&rit->reg, (i+numRI) / numRI)) /* MUST force allocation */
                goto bail;
@@ -1599,6 +1689,7 @@ validate (region_type_t * badreg,
                goto bail;
      }
      *badreg = ri[0].reg;
+     badreg->inline_ok = true;
      D_FREE(ri);
      good(badreg);
      return ret;
@@ -1610,6 +1701,8 @@ bail:
      }
      D_FREE (ri);
 
+     badreg->inline_ok = true;
+
      return misc_break (badreg);
 }
 
@@ -2230,6 +2323,32 @@ misc_region_init_boxes (region_type_t *region,
      if (count == 0)
           return true;
 
+     /*
+      * Few boxes are cheaper to union one by one, which also keeps the
+      * result in the inline storage unless it grows beyond it.
+      */
+     if (count <= MISC_REGION_INLINE_BOXES / 2) {
+          int i;
+
+          for (i = 0; i < count; i++) {
+               misc_region_t box;
+
+               if (boxes[i].x1 >= boxes[i].x2 || boxes[i].y1 >= boxes[i].y2)
+                    continue;
+
+               misc_region_init_with_extents( &box, NULL, (box_type_t*) &boxes[i] );
+
+               if (!misc_region_union( region, region, &box )) {
+                    misc_region_deinit( &box );
+                    return false;
+               }
+
+               misc_region_deinit( &box );
+          }
+
+          return true;
+     }
+
      if (!misc_rect_alloc(region, count))
           return false;
 
@@ -128,6 +128,17 @@ struct misc_region_data {
 /*  misc_box_t        rects[size];   in memory but not explicitly declared */
 };
 
+/*
+ * Number of boxes a region can hold without allocating.
+ *
+ * misc_op() guesses twice the input size, so this covers operations on up to four rectangles.
+ */
+#define MISC_REGION_INLINE_BOXES  8
+
+/*
+ * A region must not be copied by assignment, its data may point into the region itself.
+ * Use misc_region_copy() instead.
+ */
 struct misc_region {
      int                  magic;
 
@@ -135,6 +146,13 @@ struct misc_region {
 
      FusionSHMPoolShared *shmpool;
      misc_region_data_t  *data;
+
+     bool                 inline_ok;
+
+     struct {
+          misc_region_data_t  data;
+          misc_box_t          boxes[MISC_REGION_INLINE_BOXES];
+     }                    inline_storage;
 };
 
 /**********************************************************************************************************************/
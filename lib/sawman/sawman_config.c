@@ -75,6 +75,8 @@ static const char *config_usage =
      "  update-region-mode=<num>           Set internal update region mode (1-3, default 2)\n"
      "  keep-implicit-key-grabs            Causes implicit key grabs to stay even when window is withdrawn\n"
      "  hide-cursor-without-window         Hides the cursor when no window has control over it\n"
+     "  composition-threads=<num>          Compose updates in bands using <num> threads (software only, default 1)\n"
+     "  [no-]backdrop-cache                Cache composition of unchanged windows below updated ones\n"
      "\n";
 
 
@@ -418,6 +420,31 @@ sawman_config_set( const char *name, const char *value )
      } else
      if (strcmp (name, "hide-cursor-without-window") == 0) {
           sawman_config->hide_cursor_without_window = true;
+     } else
+     if (strcmp (name, "backdrop-cache") == 0) {
+          sawman_config->backdrop_cache = true;
+     } else
+     if (strcmp (name, "no-backdrop-cache") == 0) {
+          sawman_config->backdrop_cache = false;
+     } else
+     if (strcmp (name, "composition-threads" ) == 0) {
+          if (value) {
+               int threads;
+
+               if (sscanf( value, "%d", &threads ) < 1) {
+                    D_ERROR("SaWMan/Config '%s': Could not parse value!\n", name);
+                    return DFB_INVARG;
+               }
+               if (threads < 1 || threads > 8) {
+                    D_ERROR("SaWMan/Config '%s': Value %d out of bounds!\n", name, threads);
+                    return DFB_INVARG;
+               }
+               sawman_config->composition_threads = threads;
+          }
+          else {
+               D_ERROR("SaWMan/Config '%s': No value specified!\n", name);
+               return DFB_INVARG;
+          }
      } else
           return DFB_UNSUPPORTED;
 
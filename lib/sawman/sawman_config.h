@@ -68,6 +68,10 @@ typedef struct {
      DFBDimension          passive3d_mode;
 
      bool                  hide_cursor_without_window;
+
+     int                   composition_threads;  /* Number of threads composing a tier in bands (software rendering only). */
+
+     bool                  backdrop_cache;  /* Cache composition of unchanged windows below the ones being updated. */
 } SaWManConfig;
 
 
@@ -1128,7 +1128,8 @@ sawman_set_driver_config( DFBDisplayLayerID            layer_id,
           region.x2 = INT_MAX;
           region.y2 = INT_MAX;
 
-          tier->force_reconfig = true;
+          tier->force_reconfig     = true;
+          tier->single_rejected_id = 0;
 
           dfb_wm_update_stack( tier->stack, &region, DSFLIP_NONE );
 
@@ -464,10 +464,12 @@ draw_window( SaWManTier   *tier,
           return;
 
 
-     sawman_dispatch_blit( sawman, sawwin, right_eye, &sawwin->src, &dst, &clip );
+     if (!tier->compose_bands) {
+          sawman_dispatch_blit( sawman, sawwin, right_eye, &sawwin->src, &dst, &clip );
 
-     if (sawwin2)
-          sawman_dispatch_blit( sawman, sawwin2, right_eye, &sawwin2->src, &dst, &clip );
+          if (sawwin2)
+               sawman_dispatch_blit( sawman, sawwin2, right_eye, &sawwin2->src, &dst, &clip );
+     }
 
 
      /* Backup clipping region. */
@@ -767,7 +769,8 @@ sawman_draw_window( SaWManTier   *tier,
      D_DEBUG_AT( SaWMan_Draw, "%s( %p, %d,%d-%dx%d )\n", __FUNCTION__,
                  sawwin, DFB_RECTANGLE_VALS_FROM_REGION( pregion ) );
 
-     border = sawman_window_border( sawwin );
+     /* No borders while composing in bands, sawman_window_border() needs the lock. */
+     border = tier->compose_bands ? 0 : sawman_window_border( sawwin );
 
      /* if input only, we only draw the border */
      input = (window->caps & DWCAPS_INPUTONLY) || (window->config.options & DWOP_INPUTONLY);
@@ -845,8 +848,8 @@ sawman_draw_two_windows( SaWManTier   *tier,
      bool input1 = (window1->caps & DWCAPS_INPUTONLY) || (window1->config.options & DWOP_INPUTONLY);
      bool input2 = (window2->caps & DWCAPS_INPUTONLY) || (window2->config.options & DWOP_INPUTONLY);
 
-     int border1 = sawman_window_border( sawwin1 );
-     int border2 = sawman_window_border( sawwin2 );
+     int border1 = tier->compose_bands ? 0 : sawman_window_border( sawwin1 );
+     int border2 = tier->compose_bands ? 0 : sawman_window_border( sawwin2 );
 
      if (color1 || color2) {
           /* window 1 */
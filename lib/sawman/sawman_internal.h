@@ -318,6 +318,7 @@ struct __SaWMan_SaWMan {
      FusionCall                call;
 
      FusionReactor            *reactor;
+     int                       blit_listeners;     /* listeners for SWMLC_WINDOW_BLIT, changed with lock held */
 };
 
 /*
@@ -386,8 +387,16 @@ struct __SaWMan_SaWManTier {
      DFBRectangle            single_dst;
      DFBSurfacePixelFormat   single_format;
      DFBDisplayLayerOptions  single_options;
+     DFBDisplayLayerBufferMode single_buffermode;
      DFBColorKey             single_key;
 
+     /* last single mode configuration refused by the application manager or driver,
+        cleared on changes of the window or the layer configuration */
+     DFBWindowID             single_rejected_id;
+     DFBRectangle            single_rejected_src;
+     DFBSurfacePixelFormat   single_rejected_format;
+     DFBDisplayLayerOptions  single_rejected_options;
+
      bool                    border_only;
      DFBDisplayLayerConfig   border_config;
 
@@ -415,6 +424,17 @@ struct __SaWMan_SaWManTier {
      bool                    driver_config_set;
 
      bool                    force_reconfig;
+
+     /* composition of the unchanged windows at the bottom, see sawman_updates.c */
+     CoreSurface            *backdrop;
+     bool                    backdrop_valid;
+     int                     backdrop_floor;      /* windows below this layout index are in the backdrop */
+     int                     backdrop_changed;    /* lowest layout index changed since last repaint */
+     int                     backdrop_candidate;
+     int                     backdrop_stable;
+
+     /* composition threads are drawing without holding the lock, see compose_parallel() */
+     bool                    compose_bands;
 };
 
 /*
@@ -479,6 +499,8 @@ struct __SaWMan_SaWManGrabbedKey {
 
 /**********************************************************************************************************************/
 
+typedef struct __SaWMan_SaWManCompositor SaWManCompositor;
+
 typedef struct {
      CoreDFB                      *core;
      FusionWorld                  *world;
@@ -491,6 +513,8 @@ typedef struct {
      CoreGraphicsStateClient       client;
 
      FusionSkirmish                update_skirmish;
+
+     SaWManCompositor             *compositor;         /* threads composing bands of the updates in parallel */
 } WMData;
 
 /**********************************************************************************************************************/
@@ -32,15 +32,20 @@
 
 #include <config.h>
 
+#include <limits.h>
 #include <unistd.h>
 
 #include <direct/debug.h>
 #include <direct/list.h>
+#include <direct/mem.h>
+#include <direct/thread.h>
 
 #include <fusion/conf.h>
 #include <fusion/fusion.h>
 #include <fusion/shmalloc.h>
 
+#include <core/CoreGraphicsStateClient.h>
+#include <core/gfxcard.h>
 #include <core/layer_context.h>
 #include <core/layer_control.h>
 #include <core/layer_region.h>
@@ -279,10 +284,15 @@ static void collate( DirectLink **updates )
 
 /**********************************************************************************************************************/
 
+/*
+ * Composes the windows from 'start' down to 'floor', the ones below 'floor' are already in the destination
+ * unless 'floor' is zero, in which case the background is drawn where no window is visible.
+ */
 static void
 update_region( SaWMan          *sawman,
                SaWManTier      *tier,
                CardState       *state,
+               int              floor,
                int              start,
                int              x1,
                int              y1,
@@ -308,7 +318,7 @@ update_region( SaWMan          *sawman,
           return;
 
      /* Find next intersecting window. */
-     while (i >= 0) {
+     while (i >= floor) {
           sawwin = fusion_vector_at( &sawman->layout, i );
           D_MAGIC_ASSERT( sawwin, SaWManWindow );
 
@@ -325,7 +335,7 @@ update_region( SaWMan          *sawman,
      }
 
      /* Intersecting window found? */
-     if (i >= 0) {
+     if (i >= floor) {
           D_MAGIC_ASSERT( sawwin, SaWManWindow );
           D_MAGIC_COREWINDOW_ASSERT( window );
 
@@ -335,31 +345,31 @@ update_region( SaWMan          *sawman,
                                                               sawwin->bounds.y );
 
                if (!dfb_region_region_intersect( &opaque, &region )) {
-                    update_region( sawman, tier, state, i-1, x1, y1, x2, y2, right_eye );
+                    update_region( sawman, tier, state, floor, i-1, x1, y1, x2, y2, right_eye );
 
                     sawman_draw_window( tier, sawwin, state, &region, true, right_eye );
                }
                else {
                     if ((window->config.opacity < 0xff) || (window->config.options & DWOP_COLORKEYING)) {
                          /* draw everything below */
-                         update_region( sawman, tier, state, i-1, x1, y1, x2, y2, right_eye );
+                         update_region( sawman, tier, state, floor, i-1, x1, y1, x2, y2, right_eye );
                     }
                     else {
                          /* left */
                          if (opaque.x1 != x1)
-                              update_region( sawman, tier, state, i-1, x1, opaque.y1, opaque.x1-1, opaque.y2, right_eye );
+                              update_region( sawman, tier, state, floor, i-1, x1, opaque.y1, opaque.x1-1, opaque.y2, right_eye );
 
                          /* upper */
                          if (opaque.y1 != y1)
-                              update_region( sawman, tier, state, i-1, x1, y1, x2, opaque.y1-1, right_eye );
+                              update_region( sawman, tier, state, floor, i-1, x1, y1, x2, opaque.y1-1, right_eye );
 
                          /* right */
                          if (opaque.x2 != x2)
-                              update_region( sawman, tier, state, i-1, opaque.x2+1, opaque.y1, x2, opaque.y2, right_eye );
+                              update_region( sawman, tier, state, floor, i-1, opaque.x2+1, opaque.y1, x2, opaque.y2, right_eye );
 
                          /* lower */
                          if (opaque.y2 != y2)
-                              update_region( sawman, tier, state, i-1, x1, opaque.y2+1, x2, y2, right_eye );
+                              update_region( sawman, tier, state, floor, i-1, x1, opaque.y2+1, x2, y2, right_eye );
                     }
 
                     /* left */
@@ -393,7 +403,7 @@ update_region( SaWMan          *sawman,
           else {
                if (SAWMAN_TRANSLUCENT_WINDOW( window )) {
                     /* draw everything below */
-                    update_region( sawman, tier, state, i-1, x1, y1, x2, y2, right_eye );
+                    update_region( sawman, tier, state, floor, i-1, x1, y1, x2, y2, right_eye );
                }
                else {
                     DFBRegion dst = DFB_REGION_INIT_FROM_RECTANGLE( &sawwin->dst );
@@ -402,25 +412,25 @@ update_region( SaWMan          *sawman,
 
                     /* left */
                     if (dst.x1 != x1)
-                         update_region( sawman, tier, state, i-1, x1, dst.y1, dst.x1-1, dst.y2, right_eye );
+                         update_region( sawman, tier, state, floor, i-1, x1, dst.y1, dst.x1-1, dst.y2, right_eye );
 
                     /* upper */
                     if (dst.y1 != y1)
-                         update_region( sawman, tier, state, i-1, x1, y1, x2, dst.y1-1, right_eye );
+                         update_region( sawman, tier, state, floor, i-1, x1, y1, x2, dst.y1-1, right_eye );
 
                     /* right */
                     if (dst.x2 != x2)
-                         update_region( sawman, tier, state, i-1, dst.x2+1, dst.y1, x2, dst.y2, right_eye );
+                         update_region( sawman, tier, state, floor, i-1, dst.x2+1, dst.y1, x2, dst.y2, right_eye );
 
                     /* lower */
                     if (dst.y2 != y2)
-                         update_region( sawman, tier, state, i-1, x1, dst.y2+1, x2, y2, right_eye );
+                         update_region( sawman, tier, state, floor, i-1, x1, dst.y2+1, x2, y2, right_eye );
                }
 
                sawman_draw_window( tier, sawwin, state, &region, true, right_eye  );
           }
      }
-     else
+     else if (!floor)
           sawman_draw_background( tier, state, &region );
 }
 
@@ -1248,6 +1258,580 @@ sawman_flush_updating( SaWMan     *sawman,
      }
 }
 
+/**********************************************************************************************************************/
+
+static void
+compose_setup( SaWManTier      *tier,
+               CardState       *state,
+               CoreSurface     *destination,
+               const DFBRegion *clip,
+               bool             right_eye )
+{
+     CoreLayerRegion *region = tier->region;
+
+     /* Set destination. */
+     state->destination  = destination;
+     state->to_eye       = right_eye ? DSSE_RIGHT : DSSE_LEFT;
+     state->modified    |= SMF_DESTINATION | SMF_TO;
+
+     if (!DFB_PLANAR_PIXELFORMAT(region->config.format))
+          dfb_state_set_dst_colorkey( state, dfb_color_to_pixel( region->config.format,
+                                                                 region->config.src_key.r,
+                                                                 region->config.src_key.g,
+                                                                 region->config.src_key.b ) );
+     else
+          dfb_state_set_dst_colorkey( state, 0 );
+
+     /* Set clipping region. */
+     dfb_state_set_clip( state, clip );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Backdrop cache
+ *
+ * The composition of the windows at the bottom of a tier which did not change for a few repaints
+ * is kept in a surface. Updates of windows above (e.g. translucent menus) copy it from there and
+ * only draw the windows above, instead of composing the whole group below again each time.
+ *
+ * Every update notification of a window lowers 'backdrop_changed' to the window's layout index,
+ * changes of the background or the layout (insert, remove, restack, geometry) lower it to zero.
+ */
+
+#define SAWMAN_BACKDROP_STABLE  3     /* repaints with the same lowest changed window before caching below it */
+
+void
+sawman_backdrop_invalidate( SaWMan     *sawman,
+                            SaWManTier *tier,
+                            int         index )
+{
+     D_MAGIC_ASSERT( sawman, SaWMan );
+
+     if (!tier) {
+          direct_list_foreach (tier, sawman->tiers)
+               sawman_backdrop_invalidate( sawman, tier, index );
+
+          return;
+     }
+
+     D_MAGIC_ASSERT( tier, SaWManTier );
+
+     if (index < tier->backdrop_changed)
+          tier->backdrop_changed = index;
+
+     if (index < tier->backdrop_floor)
+          tier->backdrop_valid = false;
+}
+
+/*
+ * Draws the windows from 'from' to 'to' (exclusive) like update_region(), i.e. with the same opaque
+ * parts and culling, over the ones below 'from' (or the background if zero) in the destination.
+ */
+static void
+backdrop_paint( SaWMan          *sawman,
+                SaWManTier      *tier,
+                CardState       *state,
+                const DFBRegion *clip,
+                int              from,
+                int              to )
+{
+     DFBRegion region = *clip;
+
+     if (to > from)
+          update_region( sawman, tier, state, from, to - 1, region.x1, region.y1, region.x2, region.y2, false );
+     else if (!from)
+          sawman_draw_background( tier, state, &region );
+}
+
+static bool
+backdrop_worth( SaWMan     *sawman,
+                SaWManTier *tier,
+                int         floor )
+{
+     int i;
+
+     if (tier->stack->bg.mode == DLBM_DONTCARE)
+          return false;
+
+     for (i=0; i<floor && i<fusion_vector_size( &sawman->layout ); i++) {
+          SaWManWindow *sawwin = fusion_vector_at( &sawman->layout, i );
+          CoreWindow   *window = sawwin->window;
+
+          if (SAWMAN_VISIBLE_WINDOW( window ) && (tier->classes & (1 << window->config.stacking)))
+               return true;
+     }
+
+     return false;
+}
+
+/*
+ * Called once per repaint of a tier, checks the validity of the backdrop and (re)creates it
+ * after the windows below the ones changing were stable for a few repaints.
+ */
+static void
+backdrop_update( SaWMan     *sawman,
+                 SaWManTier *tier,
+                 WMData     *wmdata )
+{
+     DFBResult    ret;
+     int          changed = tier->backdrop_changed;
+     CoreSurface *surface = tier->region->surface;
+     CardState   *state   = &wmdata->state;
+     DFBRegion    clip    = DFB_REGION_INIT_FROM_DIMENSION( &tier->size );
+
+     tier->backdrop_changed = INT_MAX;
+
+     if (!sawman_config->backdrop_cache || (tier->region->config.options & DLOP_STEREO)) {
+          tier->backdrop_valid = false;
+          return;
+     }
+
+     /* Only windows above the cached ones changed? */
+     if (tier->backdrop_valid && changed >= tier->backdrop_floor)
+          return;
+
+     tier->backdrop_valid = false;
+
+     if (changed == INT_MAX)
+          return;
+
+     if (changed != tier->backdrop_candidate) {
+          tier->backdrop_candidate = changed;
+          tier->backdrop_stable    = 0;
+     }
+
+     if (++tier->backdrop_stable < SAWMAN_BACKDROP_STABLE || !backdrop_worth( sawman, tier, changed ))
+          return;
+
+     if (tier->backdrop && (tier->backdrop->config.size.w != tier->size.w ||
+                            tier->backdrop->config.size.h != tier->size.h ||
+                            tier->backdrop->config.format != surface->config.format))
+          dfb_surface_unlink( &tier->backdrop );
+
+     if (!tier->backdrop) {
+          CoreSurface *backdrop;
+
+          ret = dfb_surface_create_simple( wmdata->core, tier->size.w, tier->size.h, surface->config.format,
+                                           surface->config.colorspace, DSCAPS_NONE, CSTF_SHARED, 0,
+                                           surface->palette, &backdrop );
+          if (ret) {
+               D_DERROR( ret, "SaWMan/Update: Could not create backdrop cache surface!\n" );
+               return;
+          }
+
+          ret = dfb_surface_globalize( backdrop );
+          D_ASSERT( ret == DFB_OK );
+
+          tier->backdrop = backdrop;
+     }
+
+     D_DEBUG_AT( SaWMan_Update, "  -> caching %d windows below in backdrop of tier %p\n", changed, tier );
+
+     compose_setup( tier, state, tier->backdrop, &clip, false );
+
+     backdrop_paint( sawman, tier, state, &clip, 0, changed );
+
+     /* Reset destination. */
+     state->destination  = NULL;
+     state->modified    |= SMF_DESTINATION;
+
+     tier->backdrop_floor = changed;
+     tier->backdrop_valid = true;
+}
+
+/**********************************************************************************************************************/
+
+static void
+compose_region( SaWMan          *sawman,
+                SaWManTier      *tier,
+                CardState       *state,
+                const DFBRegion *update,
+                bool             right_eye )
+{
+     DFB_REGION_ASSERT( update );
+
+     compose_setup( tier, state, tier->region->surface, update, right_eye );
+
+     /* Copy the cached windows below and draw the ones above. */
+     if (!right_eye && tier->backdrop_valid) {
+          DFBRectangle rect  = DFB_RECTANGLE_INIT_FROM_REGION( update );
+          DFBPoint     point = { update->x1, update->y1 };
+
+          state->source    = tier->backdrop;
+          state->from_eye  = DSSE_LEFT;
+          state->modified |= SMF_SOURCE | SMF_FROM;
+
+          dfb_state_set_blitting_flags( state, DSBLIT_NOFX );
+
+          CoreGraphicsStateClient_Blit( state->client, &rect, &point, 1 );
+
+          state->source    = NULL;
+          state->modified |= SMF_SOURCE;
+
+          backdrop_paint( sawman, tier, state, update, tier->backdrop_floor, fusion_vector_size( &sawman->layout ) );
+
+          return;
+     }
+
+     /* Compose updated region. */
+     switch (sawman_config->update_region_mode) {
+          case 1:
+               update_region( sawman, tier, state, 0,
+                              fusion_vector_size( &sawman->layout ) - 1,
+                              update->x1, update->y1, update->x2, update->y2,
+                              right_eye );
+
+               break;
+          case 3:
+               update_region3( sawman, tier, state,
+                               fusion_vector_size( &sawman->layout ) - 1,
+                               update->x1, update->y1, update->x2, update->y2,
+                               right_eye );
+
+               break;
+          case 4:
+               update_region4( sawman, tier, state,
+                               fusion_vector_size( &sawman->layout ) - 1,
+                               update->x1, update->y1, update->x2, update->y2,
+                               right_eye );
+
+               break;
+          case 2:
+          default:
+               update_region2( sawman, tier, state,
+                               fusion_vector_size( &sawman->layout ) - 1,
+                               update->x1, update->y1, update->x2, update->y2,
+                               right_eye );
+     }
+}
+
+/*
+ * Composes one horizontal band of each update, band boundaries are the same for all threads.
+ */
+static void
+compose_band( SaWMan          *sawman,
+              SaWManTier      *tier,
+              CardState       *state,
+              const DFBRegion *updates,
+              int              num_updates,
+              int              band,
+              int              num_bands,
+              bool             right_eye )
+{
+     int i;
+
+     for (i=0; i<num_updates; i++) {
+          int       height = updates[i].y2 - updates[i].y1 + 1;
+          DFBRegion clip   = updates[i];
+
+          clip.y1 = updates[i].y1 + height *  band      / num_bands;
+          clip.y2 = updates[i].y1 + height * (band + 1) / num_bands - 1;
+
+          if (clip.y1 <= clip.y2)
+               compose_region( sawman, tier, state, &clip, right_eye );
+     }
+
+     /* Reset destination. */
+     state->destination  = NULL;
+     state->modified    |= SMF_DESTINATION;
+}
+
+/**********************************************************************************************************************/
+
+#define SAWMAN_COMPOSE_MAX_THREADS  8
+#define SAWMAN_COMPOSE_MIN_PIXELS   (128 * 128)
+
+typedef struct {
+     SaWManCompositor        *compositor;
+     int                      band;
+
+     DirectThread            *thread;
+
+     CardState                state;
+     CoreGraphicsStateClient  client;
+} SaWManComposeWorker;
+
+struct __SaWMan_SaWManCompositor {
+     int                  num_bands;     /* including the calling thread composing band 0 */
+     int                  num_workers;
+     SaWManComposeWorker  workers[SAWMAN_COMPOSE_MAX_THREADS - 1];
+
+     DirectMutex          lock;
+     DirectWaitQueue      job_wq;
+     DirectWaitQueue      done_wq;
+
+     unsigned int         serial;
+     int                  pending;
+     bool                 quit;
+
+     /* current job, valid while serial is unchanged */
+     SaWMan              *sawman;
+     SaWManTier          *tier;
+     const DFBRegion     *updates;
+     int                  num_updates;
+     bool                 right_eye;
+};
+
+static void *
+compose_worker_main( DirectThread *thread,
+                     void         *arg )
+{
+     SaWManComposeWorker *worker     = arg;
+     SaWManCompositor    *compositor = worker->compositor;
+     unsigned int         serial     = 0;
+
+     direct_mutex_lock( &compositor->lock );
+
+     while (true) {
+          while (compositor->serial == serial && !compositor->quit)
+               direct_waitqueue_wait( &compositor->job_wq, &compositor->lock );
+
+          if (compositor->quit)
+               break;
+
+          serial = compositor->serial;
+
+          direct_mutex_unlock( &compositor->lock );
+
+          compose_band( compositor->sawman, compositor->tier, &worker->state,
+                        compositor->updates, compositor->num_updates,
+                        worker->band, compositor->num_bands, compositor->right_eye );
+
+          CoreGraphicsStateClient_Flush( &worker->client, 0, CGSCFF_NONE );
+
+          direct_mutex_lock( &compositor->lock );
+
+          if (!--compositor->pending)
+               direct_waitqueue_broadcast( &compositor->done_wq );
+     }
+
+     direct_mutex_unlock( &compositor->lock );
+
+     return NULL;
+}
+
+static void
+compositor_shutdown( SaWManCompositor *compositor )
+{
+     int i;
+
+     direct_mutex_lock( &compositor->lock );
+
+     compositor->quit = true;
+
+     direct_waitqueue_broadcast( &compositor->job_wq );
+
+     direct_mutex_unlock( &compositor->lock );
+
+     for (i=0; i<compositor->num_workers; i++) {
+          SaWManComposeWorker *worker = &compositor->workers[i];
+
+          direct_thread_join( worker->thread );
+          direct_thread_destroy( worker->thread );
+
+          CoreGraphicsStateClient_Deinit( &worker->client );
+
+          dfb_state_destroy( &worker->state );
+     }
+
+     direct_waitqueue_deinit( &compositor->done_wq );
+     direct_waitqueue_deinit( &compositor->job_wq );
+     direct_mutex_deinit( &compositor->lock );
+
+     D_FREE( compositor );
+}
+
+static SaWManCompositor *
+compositor_create( WMData *wmdata,
+                   int     num_bands )
+{
+     int               i;
+     SaWManCompositor *compositor;
+
+     compositor = D_CALLOC( 1, sizeof(SaWManCompositor) );
+     if (!compositor) {
+          D_OOM();
+          return NULL;
+     }
+
+     compositor->num_bands = num_bands;
+
+     direct_mutex_init( &compositor->lock );
+     direct_waitqueue_init( &compositor->job_wq );
+     direct_waitqueue_init( &compositor->done_wq );
+
+     for (i=0; i<num_bands-1; i++) {
+          SaWManComposeWorker *worker = &compositor->workers[i];
+
+          worker->compositor = compositor;
+          worker->band       = i + 1;
+
+          dfb_state_init( &worker->state, wmdata->core );
+
+          if (CoreGraphicsStateClient_Init( &worker->client, &worker->state )) {
+               dfb_state_destroy( &worker->state );
+               break;
+          }
+
+          /* Only rendering directly from this thread can run concurrently. */
+          if (worker->client.renderer || worker->client.requestor) {
+               CoreGraphicsStateClient_Deinit( &worker->client );
+               dfb_state_destroy( &worker->state );
+               break;
+          }
+
+          worker->thread = direct_thread_create( DTT_DEFAULT, compose_worker_main, worker, "SaWMan/Compose" );
+          if (!worker->thread) {
+               CoreGraphicsStateClient_Deinit( &worker->client );
+               dfb_state_destroy( &worker->state );
+               break;
+          }
+
+          compositor->num_workers++;
+     }
+
+     if (compositor->num_workers != num_bands - 1) {
+          D_ERROR( "SaWMan/Update: Could only start %d of %d composition threads!\n", compositor->num_workers, num_bands - 1 );
+
+          compositor_shutdown( compositor );
+
+          return NULL;
+     }
+
+     D_DEBUG_AT( SaWMan_Update, "  -> started %d composition threads\n", compositor->num_workers );
+
+     return compositor;
+}
+
+void
+sawman_compositor_destroy( WMData *wmdata )
+{
+     D_ASSERT( wmdata != NULL );
+
+     if (wmdata->compositor) {
+          compositor_shutdown( wmdata->compositor );
+
+          wmdata->compositor = NULL;
+     }
+}
+
+/*
+ * Checks if the updates can be composed in bands with identical results.
+ *
+ * Only software rendering done directly by this process is split, with disjoint updates
+ * (cursor is drawn afterwards) and no stretched blits (clipping would change the rounding).
+ *
+ * The composition threads don't hold the lock, so there must be no window borders and no
+ * listeners for window blits, which would be called from these threads.
+ */
+static bool
+compose_parallel( SaWMan          *sawman,
+                  SaWManTier      *tier,
+                  const DFBRegion *updates,
+                  int              num_updates,
+                  WMData          *wmdata )
+{
+     int               i, n;
+     unsigned int      pixels = 0;
+     SaWManWindow     *sawwin;
+     CoreWindowStack  *stack = tier->stack;
+     CardCapabilities  caps;
+
+     if (sawman_config->composition_threads < 2 || wmdata->client.renderer || wmdata->client.requestor)
+          return false;
+
+     if (sawman->blit_listeners)
+          return false;
+
+     dfb_gfxcard_get_capabilities( &caps );
+
+     if (caps.accel && !dfb_config->software_only)
+          return false;
+
+     for (i=0; i<num_updates; i++) {
+          for (n=i+1; n<num_updates; n++) {
+               if (dfb_region_region_intersects( &updates[i], &updates[n] ))
+                    return false;
+          }
+
+          pixels += (updates[i].x2 - updates[i].x1 + 1) * (updates[i].y2 - updates[i].y1 + 1);
+     }
+
+     if (pixels < SAWMAN_COMPOSE_MIN_PIXELS)
+          return false;
+
+     if (stack->bg.mode == DLBM_IMAGE &&
+         (stack->bg.image->config.size.w != stack->width || stack->bg.image->config.size.h != stack->height))
+          return false;
+
+     fusion_vector_foreach (sawwin, i, sawman->layout) {
+          CoreWindow *window = sawwin->window;
+
+          if (SAWMAN_VISIBLE_WINDOW( window ) && (tier->classes & (1 << window->config.stacking)) &&
+              (sawwin->src.w != sawwin->dst.w || sawwin->src.h != sawwin->dst.h || sawman_window_border( sawwin )))
+               return false;
+     }
+
+     /* Number of threads changed at runtime? */
+     if (wmdata->compositor && wmdata->compositor->num_bands != sawman_config->composition_threads)
+          sawman_compositor_destroy( wmdata );
+
+     if (!wmdata->compositor) {
+          wmdata->compositor = compositor_create( wmdata, sawman_config->composition_threads );
+          if (!wmdata->compositor) {
+               /* Don't retry each frame. */
+               sawman_config->composition_threads = 1;
+               return false;
+          }
+     }
+
+     return true;
+}
+
+static void
+compose_updates( SaWMan          *sawman,
+                 SaWManTier      *tier,
+                 const DFBRegion *updates,
+                 int              num_updates,
+                 bool             right_eye,
+                 WMData          *wmdata )
+{
+     SaWManCompositor *compositor = wmdata->compositor;
+
+     D_ASSERT( compositor != NULL );
+
+     direct_mutex_lock( &compositor->lock );
+
+     compositor->sawman      = sawman;
+     compositor->tier        = tier;
+     compositor->updates     = updates;
+     compositor->num_updates = num_updates;
+     compositor->right_eye   = right_eye;
+     compositor->pending     = compositor->num_workers;
+     compositor->serial++;
+
+     tier->compose_bands = true;
+
+     direct_waitqueue_broadcast( &compositor->job_wq );
+
+     direct_mutex_unlock( &compositor->lock );
+
+     /* Compose the first band meanwhile. */
+     compose_band( sawman, tier, &wmdata->state, updates, num_updates, 0, compositor->num_bands, right_eye );
+
+     direct_mutex_lock( &compositor->lock );
+
+     while (compositor->pending)
+          direct_waitqueue_wait( &compositor->done_wq, &compositor->lock );
+
+     direct_mutex_unlock( &compositor->lock );
+
+     tier->compose_bands = false;
+}
+
+/**********************************************************************************************************************/
+
 static void
 repaint_tier( SaWMan              *sawman,
               SaWManTier          *tier,
@@ -1263,6 +1847,7 @@ repaint_tier( SaWMan              *sawman,
      CoreSurface     *surface;
      DFBRegion        cursor_inter;
      CoreWindowStack *stack;
+     bool             parallel;
 
      D_MAGIC_ASSERT( sawman, SaWMan );
      D_MAGIC_ASSERT( tier, SaWManTier );
@@ -1291,6 +1876,13 @@ repaint_tier( SaWMan              *sawman,
 
      sawman_dispatch_tier_update( sawman, tier, right_eye, updates, num_updates );
 
+     if (!right_eye)
+          backdrop_update( sawman, tier, wmdata );
+
+     parallel = compose_parallel( sawman, tier, updates, num_updates, wmdata );
+     if (parallel)
+          compose_updates( sawman, tier, updates, num_updates, right_eye, wmdata );
+
      for (i=0; i<num_updates; i++) {
           const DFBRegion *update = &updates[i];
 
@@ -1299,52 +1891,8 @@ repaint_tier( SaWMan              *sawman,
           D_DEBUG_AT( SaWMan_Update, "  -> %d, %d - %dx%d  (%d)\n",
                       DFB_RECTANGLE_VALS_FROM_REGION( update ), i );
 
-          /* Set destination. */
-          state->destination  = surface;
-          state->to_eye       = right_eye ? DSSE_RIGHT : DSSE_LEFT;
-          state->modified    |= SMF_DESTINATION | SMF_TO;
-
-          if (!DFB_PLANAR_PIXELFORMAT(region->config.format))
-               dfb_state_set_dst_colorkey( state, dfb_color_to_pixel( region->config.format,
-                                                                      region->config.src_key.r,
-                                                                      region->config.src_key.g,
-                                                                      region->config.src_key.b ) );
-          else
-               dfb_state_set_dst_colorkey( state, 0 );
-
-          /* Set clipping region. */
-          dfb_state_set_clip( state, update );
-
-          /* Compose updated region. */
-          switch (sawman_config->update_region_mode) {
-               case 1:
-                    update_region( sawman, tier, state,
-                                   fusion_vector_size( &sawman->layout ) - 1,
-                                   update->x1, update->y1, update->x2, update->y2,
-                                   right_eye );
-
-                    break;
-               case 3:
-                    update_region3( sawman, tier, state,
-                                    fusion_vector_size( &sawman->layout ) - 1,
-                                    update->x1, update->y1, update->x2, update->y2,
-                                    right_eye );
-
-                    break;
-               case 4:
-                    update_region4( sawman, tier, state,
-                                    fusion_vector_size( &sawman->layout ) - 1,
-                                    update->x1, update->y1, update->x2, update->y2,
-                                    right_eye );
-
-                    break;
-               case 2:
-               default:
-                    update_region2( sawman, tier, state,
-                                    fusion_vector_size( &sawman->layout ) - 1,
-                                    update->x1, update->y1, update->x2, update->y2,
-                                    right_eye );
-          }
+          if (!parallel)
+               compose_region( sawman, tier, state, update, right_eye );
 
           /* Update cursor? */
           cursor_inter = tier->cursor_region;
@@ -1382,6 +1930,29 @@ repaint_tier( SaWMan              *sawman,
      CoreGraphicsStateClient_Flush( &wmdata->client, 0, CGSCFF_NONE );
 }
 
+/*
+ * Checks if the (opaque) single window candidate hides the window below completely.
+ */
+static inline bool
+single_occludes( SaWManWindow *single,
+                 SaWManWindow *below )
+{
+     if (SAWMAN_TRANSLUCENT_WINDOW( single->window ))
+          return false;
+
+     return below->dst.x                 >= single->dst.x                 &&
+            below->dst.y                 >= single->dst.y                 &&
+            below->dst.x + below->dst.w  <= single->dst.x + single->dst.w  &&
+            below->dst.y + below->dst.h  <= single->dst.y + single->dst.h;
+}
+
+/*
+ * Plans the scan-out of a tier: returns the window that can be shown directly by the layer
+ * (bypassing composition) or NULL if the tier needs to be composed.
+ *
+ * The topmost visible window is the candidate. Windows below it don't prevent direct scan-out
+ * as long as the candidate is opaque and covers them completely.
+ */
 static SaWManWindow *
 get_single_window( SaWMan     *sawman,
                    SaWManTier *tier,
@@ -1409,9 +1980,17 @@ get_single_window( SaWMan     *sawman,
                     return NULL;
                }
 
-               if (      single
-                    || ( window->caps & (DWCAPS_INPUTONLY | DWCAPS_COLOR) )
-                    || ( window->config.options & DWOP_INPUTONLY ) )
+               if (single) {
+                    if (single_occludes( single, sawwin ))
+                         continue;
+
+                    D_DEBUG_AT( SaWMan_Auto, "  -> window %p below single %p is visible, composing\n", sawwin, single );
+
+                    return NULL;
+               }
+
+               if (   ( window->caps & (DWCAPS_INPUTONLY | DWCAPS_COLOR) )
+                   || ( window->config.options & DWOP_INPUTONLY ) )
                     return NULL;
 
                single = sawwin;
@@ -1498,6 +2077,52 @@ windows_updating( SaWMan     *sawman,
      return false;
 }
 
+static void
+single_reject( SaWManTier             *tier,
+               SaWManWindow           *single,
+               const DFBRectangle     *src,
+               DFBSurfacePixelFormat   format,
+               DFBDisplayLayerOptions  options )
+{
+     tier->single_rejected_id      = single->id;
+     tier->single_rejected_src     = *src;
+     tier->single_rejected_format  = format;
+     tier->single_rejected_options = options;
+}
+
+/*
+ * Translates the tier updates into the source area of the single window, so that only
+ * changed parts are copied to the layer buffer. That's only possible for a front only
+ * buffer, other buffer modes (as demanded by the application manager) get a full copy.
+ */
+static int
+single_updated_regions( SaWManTier      *tier,
+                        SaWManWindow    *single,
+                        const DFBRegion *src_region,
+                        DFBRegion       *ret_regions )
+{
+     int i;
+     int num = 0;
+
+     /* Scaled windows are copied completely. */
+     if (single->src.w != single->dst.w || single->src.h != single->dst.h || tier->single_buffermode != DLBM_FRONTONLY) {
+          ret_regions[0] = *src_region;
+
+          return 1;
+     }
+
+     for (i=0; i<tier->left.updates.num_regions; i++) {
+          DFBRegion region = tier->left.updates.regions[i];
+
+          dfb_region_translate( &region, single->src.x - single->dst.x, single->src.y - single->dst.y );
+
+          if (dfb_region_region_intersect( &region, src_region ))
+               ret_regions[num++] = region;
+     }
+
+     return num;
+}
+
 static DFBResult
 process_single( SaWMan              *sawman,
                 SaWManTier          *tier,
@@ -1623,6 +2248,13 @@ process_single( SaWMan              *sawman,
           single_key.index = window->config.color_key;
      }
 
+     /* Configuration refused before? Don't ask the application manager and driver again each frame. */
+     if (tier->single_rejected_id      == single->id &&
+         DFB_RECTANGLE_EQUAL( tier->single_rejected_src, src ) &&
+         tier->single_rejected_format  == surface->config.format &&
+         tier->single_rejected_options == options)
+          return DFB_UNSUPPORTED;
+
      /* Complete reconfig? */
      if (tier->single_window  != single ||
          !DFB_RECTANGLE_EQUAL( tier->single_src, src ) ||
@@ -1659,6 +2291,8 @@ process_single( SaWMan              *sawman,
                     break;
 
                default:
+                    D_DEBUG_AT( SaWMan_Auto, "  -> single mode refused by application manager\n" );
+                    single_reject( tier, single, &src, surface->config.format, options );
                     return DFB_UNSUPPORTED;
           }
 
@@ -1679,8 +2313,13 @@ process_single( SaWMan              *sawman,
           /* Let the driver examine the modified configuration. */
           ret = funcs->TestRegion( layer, layer->driver_data, layer->layer_data,
                                    &region_config, &failed );
-          if (ret)
+          if (ret) {
+               D_DEBUG_AT( SaWMan_Auto, "  -> single mode not supported by layer (failed 0x%08x)\n", failed );
+               single_reject( tier, single, &src, surface->config.format, options );
                return ret;
+          }
+
+          tier->single_rejected_id = 0;
 
           tier->single_mode     = true;
           tier->single_window   = single;
@@ -1690,6 +2329,7 @@ process_single( SaWMan              *sawman,
           tier->single_dst      = dst;
           tier->single_format   = surface->config.format;
           tier->single_options  = options;
+          tier->single_buffermode = config.buffermode;
           tier->single_key      = single_key;
 
           tier->active          = false;
@@ -1811,8 +2451,12 @@ process_single( SaWMan              *sawman,
                                             &src_region, 1, -window->config.z - src_region.x1, - src_region.y1, &wmdata->client );
           }
           else {
-               dfb_gfx_copy_regions_client( surface, CSBR_FRONT, DSSE_LEFT, tier->region->surface, CSBR_BACK, DSSE_LEFT,
-                                            &src_region, 1, - src_region.x1, - src_region.y1, &wmdata->client );
+               DFBRegion regions[SAWMAN_MAX_UPDATE_REGIONS];
+               int       num = single_updated_regions( tier, single, &src_region, regions );
+
+               if (num)
+                    dfb_gfx_copy_regions_client( surface, CSBR_FRONT, DSSE_LEFT, tier->region->surface, CSBR_BACK, DSSE_LEFT,
+                                                 regions, num, - src_region.x1, - src_region.y1, &wmdata->client );
           }
      }
 
@@ -1899,6 +2543,8 @@ set_config( SaWMan     *sawman,
      dfb_updates_reset( &tier->left.updates );
      dfb_updates_reset( &tier->right.updates );
 
+     sawman_backdrop_invalidate( sawman, tier, 0 );
+
      /* Temporarily to avoid configuration errors. */
      dfb_layer_context_set_screenposition( tier->context, 0, 0 );
 
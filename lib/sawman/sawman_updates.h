@@ -49,6 +49,16 @@ void         sawman_flush_updating ( SaWMan                *sawman,
                                      SaWManTier            *tier,
                                      WMData                *wmdata );
 
+void         sawman_compositor_destroy( WMData             *wmdata );
+
+/*
+ * Notifies the backdrop cache of a change of the window at layout 'index' (0 for background or layout).
+ * A NULL tier applies to all tiers.
+ */
+void         sawman_backdrop_invalidate( SaWMan            *sawman,
+                                         SaWManTier        *tier,
+                                         int                index );
+
 
 #ifdef __cplusplus
 }
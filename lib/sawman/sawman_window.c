@@ -60,6 +60,7 @@
 
 #include "sawman_config.h"
 #include "sawman_draw.h"
+#include "sawman_updates.h"
 #include "sawman_window.h"
 
 #include "isawman.h"
@@ -277,6 +278,8 @@ sawman_update_window( SaWMan              *sawman,
 
      tier = sawman_tier_by_class( sawman, window->config.stacking );
      updates = update_flags & SWMUF_RIGHT_EYE ? &tier->right.updates : &tier->left.updates;
+
+     sawman_backdrop_invalidate( sawman, tier, sawman_window_index( sawman, sawwin ) );
      stereo_offset = window->config.z;       /* z is 0 for mono windows */
      if (update_flags & SWMUF_RIGHT_EYE)
           stereo_offset *= -1;
@@ -621,6 +624,8 @@ sawman_remove_window( SaWMan       *sawman,
 
      fusion_vector_remove( &sawman->layout, index );
 
+     sawman_backdrop_invalidate( sawman, NULL, 0 );
+
      /* Release all explicit key grabs. */
      direct_list_foreach_safe (key, next, sawman->grabbed_keys) {
           if (key->owner == sawwin) {
@@ -1302,6 +1307,8 @@ sawman_restack_window( SaWMan                 *sawman,
           /* Actually change the stacking order now. */
           fusion_vector_move( &sawman->layout, old, index );
 
+          sawman_backdrop_invalidate( sawman, NULL, 0 );
+
           D_DEBUG_AT( SaWMan_Stacking, "  -> now index %d\n", fusion_vector_index_of( &sawman->layout, sawwin ) );
 
           dfb_wm_dispatch_WindowRestack( layer->core, window, index );
@@ -1816,6 +1823,8 @@ sawman_update_visible( SaWMan *sawman )
 
      dfb_updates_reset( &sawman->bg.visible );
 
+     sawman_backdrop_invalidate( sawman, NULL, 0 );
+
      for (i=0; i<sawman->layout.count; i++) {
           SaWManWindow *window = sawman->layout.elements[i];
 
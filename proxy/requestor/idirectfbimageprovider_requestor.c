@@ -47,6 +47,8 @@
 #include <idirectfb_dispatcher.h>
 #include <idirectfbimageprovider_dispatcher.h>
 
+#include <media/idirectfbimageprovider_async.h>
+
 #include "idirectfbsurface_requestor.h"
 
 
@@ -262,6 +264,8 @@ Construct( IDirectFBImageProvider *thiz,
      thiz->GetImageDescription   = IDirectFBImageProvider_Requestor_GetImageDescription;
      thiz->RenderTo              = IDirectFBImageProvider_Requestor_RenderTo;
      thiz->SetRenderCallback     = IDirectFBImageProvider_Requestor_SetRenderCallback;
+     thiz->RenderToAsync         = IDirectFBImageProvider_Async_RenderTo;
+     thiz->CancelRenderAsync     = IDirectFBImageProvider_Async_Cancel;
 
      return DFB_OK;
 }
@@ -244,7 +244,7 @@ dfb_layer_region_flip_update2( CoreLayerRegion      *region,
                        right_update->x2 == surface->config.size.w - 1 &&
                        right_update->y2 == surface->config.size.h - 1)))))
                {
-                    dfb_surface_flip_buffers( surface, false );
+                    dfb_surface_flip_buffers2( surface, false, flags & DSFLIP_MAILBOX );
 
                     /* Use the driver's routine if the region is realized. */
                     if (D_FLAGS_ARE_SET( region->state, CLRSF_ENABLED | CLRSF_ACTIVE )) {
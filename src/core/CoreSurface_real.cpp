@@ -870,7 +870,7 @@ ISurface_Real::Flip2(
                    r.x2 == obj->config.size.w - 1 &&
                    r.y2 == obj->config.size.h - 1))
               {
-                  ret = dfb_surface_flip_buffers( obj, swap );
+                  ret = dfb_surface_flip_buffers2( obj, swap, flags & DSFLIP_MAILBOX );
                   if (ret)
                       goto out;
               }
@@ -892,7 +892,7 @@ ISurface_Real::Flip2(
                   l.x2 == obj->config.size.w - 1 &&
                   l.y2 == obj->config.size.h - 1))
              {
-                  ret = dfb_surface_flip_buffers( obj, swap );
+                  ret = dfb_surface_flip_buffers2( obj, swap, flags & DSFLIP_MAILBOX );
                   if (ret)
                       goto out;
              }
@@ -49,6 +49,7 @@ extern "C" {
 
 #include <core/core.h>
 #include <core/layers_internal.h>
+#include <core/screen.h>
 #include <core/surface_allocation.h>
 #include <core/surface_pool.h>
 #include <core/system.h>
@@ -64,12 +65,21 @@ extern "C" {
 
 D_DEBUG_DOMAIN( DirectFB_Task_Display,      "DirectFB/Task/Display",      "DirectFB DisplayTask" );
 D_DEBUG_DOMAIN( DirectFB_Task_Display_List, "DirectFB/Task/Display/List", "DirectFB DisplayTask List" );
+D_DEBUG_DOMAIN( DirectFB_Task_Display_Pace, "DirectFB/Task/Display/Pace", "DirectFB DisplayTask Pacing" );
 
 /*********************************************************************************************************************/
 
 namespace DirectFB {
 
 
+/*
+ * Retrace grid of the primary layer, used for resampling input
+ */
+static Direct::Mutex retrace_lock;
+static long long     retrace_phase;
+static long long     retrace_interval;
+
+
 extern "C" {
 
 DFBResult
@@ -100,11 +110,252 @@ DisplayTask_GetPTS( DFB_DisplayTask *task )
      return pts;
 }
 
+void
+DisplayTask_Displayed( DFB_DisplayTask *task )
+{
+     D_DEBUG_AT( DirectFB_Task, "%s( %p )\n", __FUNCTION__, task );
+
+     task->Displayed();
+}
+
+long long
+DisplayTask_PredictRetrace( long long  time,
+                            long long *ret_interval )
+{
+     long long retrace;
+
+     Direct::Mutex::Lock l1( retrace_lock );
+
+     if (!retrace_phase)
+          return 0;
+
+     if (time < retrace_phase)
+          retrace = retrace_phase - (retrace_phase - time - 1) / retrace_interval * retrace_interval;
+     else
+          retrace = retrace_phase + ((time - retrace_phase) / retrace_interval + 1) * retrace_interval;
+
+     if (ret_interval)
+          *ret_interval = retrace_interval;
+
+     return retrace;
+}
+
+DFB_DisplayPacing *
+DisplayPacing_New( void )
+{
+     return new DisplayPacing();
+}
+
+void
+DisplayPacing_Delete( DFB_DisplayPacing *pacing )
+{
+     D_ASSERT( pacing != NULL );
+
+     delete pacing;
+}
+
 /*********************************************************************************************************************/
 
 }
 
 
+DisplayPacing::DisplayPacing()
+     :
+     interval( 0 ),
+     phase( 0 ),
+     latency( 0 ),
+     jitter( 0 ),
+     latest( NULL ),
+     pending( 0 ),
+     frames( 0 ),
+     dropped( 0 ),
+     merged( 0 ),
+     predicted( 0 ),
+     missed( 0 ),
+     stats_time( direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) )
+{
+}
+
+long long
+DisplayPacing::NextSlot( long long time ) const
+{
+     long long diff = time - phase;
+
+     /* First retrace at or after the given time */
+     if (diff <= 0)
+          return phase - (-diff / interval) * interval;
+
+     return phase + (diff + interval - 1) / interval * interval;
+}
+
+long long
+DisplayPacing::Schedule( DisplayTask *task,
+                         long long    frame_interval,
+                         long long    pts,
+                         long long    now )
+{
+     long long emit = 0;
+
+     Direct::Mutex::Lock l1( lock );
+
+     interval = frame_interval > 0 ? frame_interval : 16666;
+
+     if (!phase)
+          phase = now;
+
+     if (pts > 0) {
+          /* Retrace closest to the requested time */
+          task->deadline = NextSlot( pts - interval / 2 );
+
+          /* Predicted to be late, aim at the next retrace that can still be made instead of running off the grid */
+          if (task->deadline < now + latency) {
+               task->deadline = NextSlot( now + latency );
+
+               predicted++;
+          }
+
+          emit = task->deadline - latency - jitter;
+     }
+     else
+          task->deadline = now + latency;
+
+     latest = task;
+     pending++;
+
+     task->paced = true;
+
+     D_DEBUG_AT( DirectFB_Task_Display_Pace, "DisplayPacing::%s( %p, pts %lld ) <- deadline %lld us from now, emit %lld, latency %lld, jitter %lld, pending %u\n",
+                 __FUNCTION__, task, pts, task->deadline - now, emit > now ? emit - now : 0, latency, jitter, pending );
+
+     return emit > now ? emit : 0;
+}
+
+bool
+DisplayPacing::Drop( DisplayTask *task,
+                     long long    now )
+{
+     Direct::Mutex::Lock l1( lock );
+
+     if (!latest || latest == task)
+          return false;
+
+     /* Mailbox mode, the newest frame always wins */
+     if (task->flip_flags & DSFLIP_MAILBOX) {
+          D_DEBUG_AT( DirectFB_Task_Display_Pace, "DisplayPacing::%s( %p ) <- mailbox, newer %p queued\n", __FUNCTION__, task, latest );
+
+          latest->MergeUpdates( task );
+
+          dropped++;
+
+          return true;
+     }
+
+     /* Frames without a time stamp are meant to be shown as soon as possible, not on a particular retrace */
+     if (!dfb_config->frame_pacing || task->pts <= 0)
+          return false;
+
+     /* Still in time for its retrace */
+     if (now + latency <= task->deadline)
+          return false;
+
+     /* The newer frame is meant for a later retrace than the one this frame can still make */
+     if (latest->deadline > NextSlot( now + latency ))
+          return false;
+
+     D_DEBUG_AT( DirectFB_Task_Display_Pace, "DisplayPacing::%s( %p ) <- %lld us late, newer %p queued\n",
+                 __FUNCTION__, task, now + latency - task->deadline, latest );
+
+     latest->MergeUpdates( task );
+
+     if (task->region->config.buffermode == DLBM_FRONTONLY || task->region->config.buffermode == DLBM_BACKSYSTEM)
+          merged++;
+     else
+          dropped++;
+
+     return true;
+}
+
+/*
+ * Called after running the task and when finalising it, which may happen without running it
+ */
+void
+DisplayPacing::Done( DisplayTask *task )
+{
+     Direct::Mutex::Lock l1( lock );
+
+     if (latest == task)
+          latest = NULL;
+
+     if (!task->paced)
+          return;
+
+     task->paced = false;
+
+     D_ASSERT( pending > 0 );
+
+     pending--;
+}
+
+/*
+ * Called when the system reports the task's buffer on screen, i.e. at the retrace for systems with CSCAPS_NOTIFY_DISPLAY
+ */
+void
+DisplayPacing::Displayed( DisplayTask *task,
+                          long long    now )
+{
+     long long deviation;
+
+     Direct::Mutex::Lock l1( lock );
+
+     deviation = now - task->deadline;
+
+     /* Moving averages weighting each new sample by 1/8 */
+     latency += (now - task->run_start - latency) / 8;
+     jitter  += (ABS( deviation ) - jitter) / 8;
+
+     if (deviation > interval / 2)
+          missed++;
+
+     frames++;
+
+     phase = now;
+
+     if (task->layer->shared->layer_id == DLID_PRIMARY) {
+          Direct::Mutex::Lock l2( retrace_lock );
+
+          retrace_phase    = phase;
+          retrace_interval = interval;
+     }
+
+     D_DEBUG_AT( DirectFB_Task_Display_Pace, "DisplayPacing::%s( %p ) <- took %lld us, %lld us off deadline\n",
+                 __FUNCTION__, task, now - task->run_start, deviation );
+}
+
+bool
+DisplayPacing::Report( long long       interval_ms,
+                       long long       now,
+                       Direct::String &ret_stats )
+{
+     Direct::Mutex::Lock l1( lock );
+
+     if ((now - stats_time) / 1000LL < interval_ms)
+          return false;
+
+     ret_stats.PrintF( "%lu frames, %lu dropped, %lu merged, %lu predicted late, %lu missed, latency %lld us, jitter %lld us",
+                       frames, dropped, merged, predicted, missed, latency, jitter );
+
+     frames     = 0;
+     dropped    = 0;
+     merged     = 0;
+     predicted  = 0;
+     missed     = 0;
+     stats_time = now;
+
+     return true;
+}
+
+/*********************************************************************************************************************/
+
 const Direct::String DisplayTask::_Type( "Display" );
 
 const Direct::String &
@@ -142,8 +393,16 @@ DisplayTask::DisplayTask( CoreLayerRegion       *region,
      if (right_allocation)
           dfb_surface_allocation_ref( right_allocation );
 
-     layer = dfb_layer_at( region->layer_id );
-     index = dfb_surface_buffer_index( left_allocation->buffer );
+     layer    = dfb_layer_at( region->layer_id );
+     index     = dfb_surface_buffer_index( left_allocation->buffer );
+     deadline  = 0;
+     run_start = 0;
+     paced     = false;
+
+     /* Window flips done until now are shown by this frame at the earliest */
+     latency_origin = layer->shared->latency_origin;
+
+     layer->shared->latency_origin = 0;
 
      if (left_update) {
           this->left_update = &this->left_update_region;
@@ -296,7 +555,23 @@ DisplayTask::Flush()
      D_DEBUG_AT( DirectFB_Task_Display_List, "  -> adding to list %p\n", region->display_tasks );
      region->display_tasks->Append( this );
 
-     if (pts > 0 && !(dfb_system_caps() & CSCAPS_DISPLAY_PTS)) {
+     if (region->display_pacing) {
+          long long interval = 0;
+          long long emit;
+
+          dfb_screen_get_frame_interval( layer->screen, &interval );
+
+          emit = region->display_pacing->Schedule( this, interval, dfb_config->frame_pacing ? pts : 0,
+                                                   direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) );
+
+          if (emit && !(dfb_system_caps() & CSCAPS_DISPLAY_PTS)) {
+               D_DEBUG_AT( DirectFB_Task_Display, "  -> paced, setting emit time stamp to %lld us\n", emit );
+
+               ts_emit = emit;
+          }
+     }
+
+     if (!dfb_config->frame_pacing && pts > 0 && !(dfb_system_caps() & CSCAPS_DISPLAY_PTS)) {
           D_DEBUG_AT( DirectFB_Task_Display, "  -> system WITHOUT display task PTS support, setting emit time stamp to %lld us\n", pts );
 
           ts_emit = pts;
@@ -315,6 +590,13 @@ DisplayTask::Finalise()
      if (layer->display_task == this)
           layer->display_task = NULL;
 
+     /* Flushed tasks may be finalised without being run */
+     if (region->display_pacing)
+          region->display_pacing->Done( this );
+
+     if (latency_origin)
+          dfb_core_trace_latency( layer->core, DLTS_DISPLAY, latency_origin );
+
      SurfaceTask::Finalise();
 }
 
@@ -330,10 +612,14 @@ DisplayTask::Run()
      const DisplayLayerFuncs *funcs;
      CoreSurfaceBufferLock    left  = {0};
      CoreSurfaceBufferLock    right = {0};
+     DisplayPacing           *pacing;
+     bool                     dropped = false;
 
      D_DEBUG_AT( DirectFB_Task_Display, "DisplayTask::%s( %p [%s], region %p )\n", __FUNCTION__,
                  this, *ToString<DirectFB::Task>(*this), region );
 
+     run_start = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
      funcs = layer->funcs;
      D_ASSERT( funcs != NULL );
      D_ASSERT( funcs->SetRegion != NULL );
@@ -344,6 +630,7 @@ DisplayTask::Run()
      dfb_layer_region_lock( region );
 
      surface = region->surface;
+     pacing  = region->display_pacing;
 
      dfb_surface_ref( surface );
 
@@ -412,6 +699,17 @@ DisplayTask::Run()
      else
           D_ASSUME( D_FLAGS_IS_SET( region->state, CLRSF_REALIZED ) );
 
+     /* Skip a late frame if a newer one is queued for the same retrace, or any frame replaced in mailbox mode */
+     if (pacing && pacing->Drop( this, direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) )) {
+          D_DEBUG_AT( DirectFB_Task_Display, "  -> dropping frame (index %d)\n", index );
+
+          dropped = true;
+
+          /* Handed on to the newer frame by MergeUpdates() */
+          latency_origin = 0;
+          goto out;
+     }
+
      D_DEBUG_AT( DirectFB_Task_Display, "  -> setting task for index %d\n", index );
 
      /* Call SurfaceTask::CacheInvalidate() for cache invalidation */
@@ -518,6 +816,16 @@ out:
           }
      }
 
+     if (pacing) {
+          long long      now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+          Direct::String stats;
+
+          pacing->Done( this );
+
+          if (dfb_config->frame_pacing_stats && pacing->Report( dfb_config->frame_pacing_stats, now, stats ))
+               D_INFO( "Core/Layer/%u: Pacing %s\n", layer->shared->layer_id, *stats );
+     }
+
      dfb_surface_unref( surface );
 
      Release();
@@ -530,6 +838,15 @@ out:
           return ret;
      }
 
+     /* Never shown, so neither the system nor the next task will finish it */
+     if (dropped) {
+          dfb_layer_region_unlock( region );
+
+          Done();
+
+          return DFB_OK;
+     }
+
      if (!(dfb_system_caps() & CSCAPS_DISPLAY_TASKS)) {
           D_DEBUG_AT( DirectFB_Task_Display, "  -> system WITHOUT display task support, calling Task_Done on previous task\n" );
 
@@ -544,6 +861,34 @@ out:
      return DFB_OK;
 }
 
+void
+DisplayTask::Displayed()
+{
+     if (region->display_pacing && run_start)
+          region->display_pacing->Displayed( this, direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ) );
+}
+
+void
+DisplayTask::MergeUpdates( const DisplayTask *older )
+{
+     D_DEBUG_AT( DirectFB_Task_Display, "DisplayTask::%s( %p <- %p )\n", __FUNCTION__, this, older );
+
+     if (older->latency_origin && (!latency_origin || older->latency_origin < latency_origin))
+          latency_origin = older->latency_origin;
+
+     /* Missing update regions mean the whole surface, keep left and right consistent */
+     if (!older->left_update || !left_update) {
+          left_update  = NULL;
+          right_update = NULL;
+          return;
+     }
+
+     dfb_region_region_union( left_update, older->left_update );
+
+     if (older->right_update && right_update)
+          dfb_region_region_union( right_update, older->right_update );
+}
+
 void
 DisplayTask::Describe( Direct::String &string ) const
 {
@@ -61,6 +61,23 @@ DFBResult        DisplayTask_Generate ( CoreLayerRegion         *region,
 
 long long        DisplayTask_GetPTS   ( DFB_DisplayTask         *task );
 
+/*
+ * Called by dfb_surface_notify_display2() when the task's buffer has been displayed.
+ */
+void             DisplayTask_Displayed( DFB_DisplayTask         *task );
+
+/*
+ * Returns the first retrace of the primary layer after the given time (monotonic clock),
+ * or 0 if nothing has been displayed yet.
+ */
+long long        DisplayTask_PredictRetrace( long long           time,
+                                             long long          *ret_interval );
+
+
+DFB_DisplayPacing *DisplayPacing_New   ( void );
+
+void               DisplayPacing_Delete( DFB_DisplayPacing       *pacing );
+
 
 /*********************************************************************************************************************/
 
@@ -87,8 +104,65 @@ long long        DisplayTask_GetPTS   ( DFB_DisplayTask         *task );
 namespace DirectFB {
 
 
+/*
+ * Per region frame pacing
+ *
+ * Display tasks are emitted so that they complete right before the vertical retrace their frame is meant for,
+ * using the measured time from running a task until its content is on screen. A frame predicted to miss its
+ * retrace is moved to the next one instead of being shown off the grid, and a late frame with a time stamp is
+ * dropped (its update merged into the newer one) when a newer frame for the same retrace is already queued.
+ *
+ * Frames flipped with DSFLIP_MAILBOX are always replaced by a newer queued frame, regardless of their deadline.
+ * Without frame pacing enabled, tasks are only tracked for this and for the statistics.
+ */
+class DisplayPacing
+{
+public:
+     DisplayPacing();
+
+     long long      Schedule ( DisplayTask    *task,
+                               long long       frame_interval,
+                               long long       pts,
+                               long long       now );
+
+     bool           Drop     ( DisplayTask    *task,
+                               long long       now );
+
+     void           Done     ( DisplayTask    *task );
+
+     void           Displayed( DisplayTask    *task,
+                               long long       now );
+
+     bool           Report   ( long long       interval_ms,
+                               long long       now,
+                               Direct::String &ret_stats );
+
+private:
+     long long      NextSlot ( long long       time ) const;
+
+     Direct::Mutex  lock;
+
+     long long      interval;      /* frame interval of the screen */
+     long long      phase;         /* time of the last display, anchoring the retrace grid */
+     long long      latency;       /* average time from running a task until it is displayed */
+     long long      jitter;        /* average deviation of display times from their deadlines */
+
+     DisplayTask   *latest;        /* most recently flushed task, not run or finalised yet */
+     unsigned int   pending;
+
+     unsigned long  frames;
+     unsigned long  dropped;
+     unsigned long  merged;
+     unsigned long  predicted;
+     unsigned long  missed;
+     long long      stats_time;
+};
+
+
 class DisplayTask : public SurfaceTask
 {
+     friend class DisplayPacing;
+
 public:
      DisplayTask( CoreLayerRegion       *region,
                   const DFBRegion       *left_update,
@@ -131,12 +205,20 @@ private:
      CoreLayer             *layer;
      CoreLayerContext      *context;
      int                    index;
+     long long              deadline;
+     long long              run_start;
+     bool                   paced;           /* counted as pending by the DisplayPacing */
+     long long              latency_origin;  /* oldest input event time of window flips shown by this frame */
+
+     void MergeUpdates( const DisplayTask *older );
 
 public:
      long long GetPTS() const {
           return pts;
      }
 
+     void Displayed();
+
 private:
      static const Direct::String _Type;
 };
@@ -35,12 +35,15 @@
 #include <config.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <errno.h>
 
 #include <pthread.h>
 
+#include <direct/atomic.h>
+#include <direct/clock.h>
 #include <direct/hash.h>
 #include <direct/list.h>
 
@@ -58,6 +61,7 @@
 #include <core/core_parts.h>
 #include <core/fonts.h>
 #include <core/graphics_state.h>
+#include <core/image_cache.h>
 #include <core/layer_context.h>
 #include <core/layer_region.h>
 #include <core/palette.h>
@@ -1533,6 +1537,93 @@ dfb_core_font_manager( CoreDFB *core )
      return core->font_manager;
 }
 
+CoreImageCache *
+dfb_core_image_cache( CoreDFB *core )
+{
+     D_ASSUME( core != NULL );
+
+     if (!core)
+          core = core_dfb;
+
+     D_MAGIC_ASSERT( core, CoreDFB );
+     D_MAGIC_ASSERT( core->shared, CoreDFBShared );
+
+     return core->shared->image_cache;
+}
+
+void
+dfb_core_trace_latency( CoreDFB         *core,
+                        DFBLatencyStage  stage,
+                        long long        origin )
+{
+     CoreDFBShared       *shared;
+     DFBLatencyHistogram *histogram;
+     long long            latency;
+     int                  bucket = 0;
+
+     D_ASSUME( core != NULL );
+     D_ASSERT( stage >= 0 && stage < DLTS_NUM );
+
+     if (!core)
+          core = core_dfb;
+
+     D_MAGIC_ASSERT( core, CoreDFB );
+
+     shared = core->shared;
+
+     D_MAGIC_ASSERT( shared, CoreDFBShared );
+
+     if (!origin)
+          return;
+
+     latency = direct_clock_get_time( DIRECT_CLOCK_REALTIME ) - origin;
+
+     /* Clock adjustments or a driver not using the system time. */
+     if (latency < 0)
+          return;
+
+     while (bucket < DFB_LATENCY_BUCKETS - 1 && latency >= (128LL << bucket))
+          bucket++;
+
+     histogram = &shared->latency.stages[stage];
+
+     D_SYNC_ADD( &histogram->count, 1 );
+     D_SYNC_ADD( &histogram->buckets[bucket], 1 );
+
+     /* Racy between processes, but good enough for the sum and the maximum. */
+     histogram->total += latency;
+
+     if (histogram->max < latency)
+          histogram->max = latency;
+}
+
+DFBResult
+dfb_core_get_latency_stats( CoreDFB         *core,
+                            DFBLatencyStats *ret_stats,
+                            bool             reset )
+{
+     CoreDFBShared *shared;
+
+     D_ASSUME( core != NULL );
+     D_ASSERT( ret_stats != NULL );
+
+     if (!core)
+          core = core_dfb;
+
+     D_MAGIC_ASSERT( core, CoreDFB );
+
+     shared = core->shared;
+
+     D_MAGIC_ASSERT( shared, CoreDFBShared );
+
+     *ret_stats = shared->latency;
+
+     if (reset)
+          memset( &shared->latency, 0, sizeof(shared->latency) );
+
+     return DFB_OK;
+}
+
 /******************************************************************************/
 
 struct __CoreDFB_CoreMemoryPermission {
@@ -1762,6 +1853,12 @@ dfb_core_shutdown( CoreDFB *core, bool emergency )
 
      TaskManager_SyncAll();
 
+     /* Release cached images. */
+     if (shared->image_cache) {
+          dfb_image_cache_destroy( shared->image_cache );
+          shared->image_cache = NULL;
+     }
+
      /* Destroy surface and palette objects. */
      fusion_object_pool_destroy( shared->graphics_state_pool, core->world );
      fusion_object_pool_destroy( shared->surface_client_pool, core->world );
@@ -1838,6 +1935,12 @@ dfb_core_initialize( CoreDFB *core )
 
      register_genefx();
 
+     if (dfb_config->image_cache) {
+          ret = dfb_image_cache_create( core, dfb_config->image_cache * 1024UL, &shared->image_cache );
+          if (ret)
+               D_DERROR( ret, "DirectFB/Core: Could not create image cache!\n" );
+     }
+
      if (dfb_config->resource_manager) {
           DirectInterfaceFuncs *funcs;
 
@@ -1922,6 +2025,8 @@ dfb_core_leave_callback( FusionWorld *world,
                          void        *ctx )
 {
      Core_Resource_DisposeIdentity( fusion_id );
+
+     dfb_windows_dispose_event_rings( core_dfb, fusion_id );
 }
 
 static int
@@ -233,6 +233,37 @@ void         dfb_core_cleanup_remove( CoreDFB     *core,
 
 DFBFontManager *dfb_core_font_manager( CoreDFB *core );
 
+/*
+ * Returns the cache of decoded images shared by all processes, NULL if disabled.
+ */
+CoreImageCache *dfb_core_image_cache( CoreDFB *core );
+
+/*
+ * Adds the time since 'origin' to the latency histogram of a stage.
+ *
+ * The origin is the time of the input event in microseconds, as given by gettimeofday().
+ * Callers only trace if the "latency-trace" option is set.
+ */
+void         dfb_core_trace_latency( CoreDFB         *core,
+                                     DFBLatencyStage  stage,
+                                     long long        origin );
+
+/*
+ * Copies the latency histograms, optionally clearing them.
+ */
+DFBResult    dfb_core_get_latency_stats( CoreDFB         *core,
+                                         DFBLatencyStats *ret_stats,
+                                         bool             reset );
+
+/*
+ * Returns the latency origin of an input event timestamp.
+ */
+static __inline__ long long
+dfb_core_latency_origin( const struct timeval *timestamp )
+{
+     return timestamp->tv_sec * 1000000LL + timestamp->tv_usec;
+}
+
 
 
 
@@ -280,6 +311,10 @@ struct __DFB_CoreDFBShared {
 
      FusionCall           call;
      FusionHash          *field_hash;
+
+     DFBLatencyStats      latency;      /* input latency histograms, see dfb_core_trace_latency() */
+
+     CoreImageCache      *image_cache;  /* decoded images, NULL unless enabled */
 };
 
 struct __DFB_CoreDFB {
@@ -71,6 +71,8 @@ typedef struct __DFB_DFBFontCacheRow         DFBFontCacheRow;
 
 typedef struct __DFB_CoreGraphicsSerial      CoreGraphicsSerial;
 
+typedef struct __DFB_CoreImageCache          CoreImageCache;
+
 typedef struct __DFB_CoreScreen              CoreScreen;
 
 typedef struct __DFB_CoreInputDevice         CoreInputDevice;
@@ -92,6 +94,7 @@ typedef struct __DFB_CoreSurfacePoolTransfer CoreSurfacePoolTransfer;
 
 typedef struct __DFB_CoreWindow              CoreWindow;
 typedef struct __DFB_CoreWindowConfig        CoreWindowConfig;
+typedef struct __DFB_CoreWindowEventRing     CoreWindowEventRing;
 typedef struct __DFB_CoreWindowStack         CoreWindowStack;
 
 
@@ -117,6 +120,7 @@ class Task;
 class SurfaceBuffer;
 class SurfaceTask;
 class DisplayTask;
+class DisplayPacing;
 }
 #define DFB_Util_FPS               DirectFB::Util::FPS
 #define DFB_Renderer               DirectFB::Graphics::Renderer
@@ -134,6 +138,7 @@ class DisplayTask;
 #define DFB_DisplayTaskList        Direct::List<DirectFB::DisplayTask*>
 #define DFB_DisplayTaskListLocked  Direct::ListLocked<DirectFB::DisplayTask*>
 #define DFB_DisplayTaskListSimple  Direct::ListSimple<DirectFB::DisplayTask*>
+#define DFB_DisplayPacing          DirectFB::DisplayPacing
 #else
 typedef void DFB_Util_FPS;
 typedef void DFB_Renderer;
@@ -150,6 +155,7 @@ typedef void DFB_DisplayTask;
 typedef void DFB_DisplayTaskList;
 typedef void DFB_DisplayTaskListLocked;
 typedef void DFB_DisplayTaskListSimple;
+typedef void DFB_DisplayPacing;
 #endif
 
 
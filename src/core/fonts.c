@@ -37,6 +37,8 @@
 
 #include <pthread.h>
 
+#include <sys/stat.h>
+
 #include <directfb.h>
 
 #include <core/core.h>
@@ -51,6 +53,7 @@
 #include <direct/hash.h>
 #include <direct/map.h>
 #include <direct/mem.h>
+#include <direct/memcpy.h>
 #include <direct/messages.h>
 #include <direct/utf8.h>
 #include <direct/util.h>
@@ -75,6 +78,9 @@ static bool free_glyphs( DirectHash    *hash,
                          void          *value,
                          void          *ctx );
 
+static void font_run_destroy( CoreFont    *font,
+                              CoreFontRun *run );
+
 /**********************************************************************************************************************/
 
 struct __DFB_DFBFontManager {
@@ -742,7 +748,8 @@ dfb_font_create( CoreDFB                   *core,
 void
 dfb_font_destroy( CoreFont *font )
 {
-     int i;
+     int          i;
+     CoreFontRun *run, *next;
 
      D_DEBUG_AT( Core_Font, "%s()\n", __FUNCTION__ );
 
@@ -750,6 +757,14 @@ dfb_font_destroy( CoreFont *font )
 
      dfb_font_dispose( font );
 
+     direct_list_foreach_safe (run, next, font->runs)
+          font_run_destroy( font, run );
+
+     D_ASSERT( font->num_runs == 0 );
+
+     if (font->store)
+          dfb_glyph_store_close( font->store );
+
      for (i=0; i<DFB_FONT_MAX_LAYERS; i++)
           direct_hash_destroy( font->layers[i].glyph_hash );
 
@@ -801,18 +816,114 @@ dfb_font_dispose( CoreFont *font )
 
 /**********************************************************************************************************************/
 
+static DFBGlyphStore *
+font_glyph_store( CoreFont *font )
+{
+     DFBResult           ret;
+     u64                 key;
+     DFBFontDescription *desc = &font->description;
+     int                 params[17];
+
+     if (font->store || !font->content_key)
+          return font->store;
+
+     memset( params, 0, sizeof(params) );
+
+     /* Everything affecting the rendered glyphs besides the font file itself. */
+     params[0]  = font->pixel_format;
+     params[1]  = font->surface_caps;
+     params[2]  = font->blittingflags;
+     params[3]  = font->attributes;
+     params[4]  = font->flags;
+     params[5]  = desc->flags;
+     params[6]  = (desc->flags & DFDESC_ATTRIBUTES)      ? desc->attributes      : 0;
+     params[7]  = (desc->flags & DFDESC_HEIGHT)          ? desc->height          : 0;
+     params[8]  = (desc->flags & DFDESC_WIDTH)           ? desc->width           : 0;
+     params[9]  = (desc->flags & DFDESC_INDEX)           ? desc->index           : 0;
+     params[10] = (desc->flags & DFDESC_FIXEDADVANCE)    ? desc->fixed_advance   : 0;
+     params[11] = (desc->flags & DFDESC_FRACT_HEIGHT)    ? desc->fract_height    : 0;
+     params[12] = (desc->flags & DFDESC_FRACT_WIDTH)     ? desc->fract_width     : 0;
+     params[13] = (desc->flags & DFDESC_OUTLINE_WIDTH)   ? desc->outline_width   : 0;
+     params[14] = (desc->flags & DFDESC_OUTLINE_OPACITY) ? desc->outline_opacity : 0;
+     params[15] = (desc->flags & DFDESC_ROTATION)        ? desc->rotation        : 0;
+     params[16] = font->renderer_version;
+
+     key = dfb_glyph_store_key_add( font->content_key, params, sizeof(params) );
+
+     ret = dfb_glyph_store_open( dfb_config->font_cache_dir, key, font->pixel_format, &font->store );
+     if (ret) {
+          D_DEBUG_AT( Core_Font, "  -> glyph store not available (%s)\n", DirectFBErrorString( ret ) );
+
+          /* Do not try again for this font. */
+          font->content_key = 0;
+     }
+
+     return font->store;
+}
+
+static void
+font_glyph_store_append( CoreFont      *font,
+                         CoreGlyphData *data )
+{
+     DFBResult          ret;
+     DFBGlyphStoreEntry entry;
+     DFBRectangle       rect;
+     void              *pixels = NULL;
+
+     entry.width    = data->width;
+     entry.height   = data->height;
+     entry.left     = data->left;
+     entry.top      = data->top;
+     entry.xadvance = data->xadvance;
+     entry.yadvance = data->yadvance;
+     entry.data     = NULL;
+     entry.pitch    = 0;
+
+     if (data->width > 0 && data->height > 0) {
+          entry.pitch = DFB_BYTES_PER_LINE( font->pixel_format, data->width );
+
+          pixels = D_MALLOC( entry.pitch * data->height );
+          if (!pixels) {
+               D_OOM();
+               return;
+          }
+
+          rect.x = data->start;
+          rect.y = 0;
+          rect.w = data->width;
+          rect.h = data->height;
+
+          ret = dfb_surface_read_buffer( data->surface, CSBR_BACK, pixels, entry.pitch, &rect );
+          if (ret) {
+               D_DEBUG_AT( Core_Font, "  -> could not read back glyph for storing (%s)\n", DirectFBErrorString( ret ) );
+               D_FREE( pixels );
+               return;
+          }
+
+          entry.data = pixels;
+     }
+
+     dfb_glyph_store_append( font->store, data->index, data->layer, &entry );
+
+     if (pixels)
+          D_FREE( pixels );
+}
+
 DFBResult
 dfb_font_get_glyph_data( CoreFont       *font,
                          unsigned int    index,
                          unsigned int    layer,
                          CoreGlyphData **ret_data )
 {
-     DFBResult        ret;
-     CoreGlyphData   *data;
-     int              align;
-     DFBFontManager  *manager;
-     DFBFontCache    *cache;
-     DFBFontCacheRow *row = NULL;
+     DFBResult           ret;
+     CoreGlyphData      *data;
+     int                 align;
+     DFBFontManager     *manager;
+     DFBFontCache       *cache;
+     DFBFontCacheRow    *row = NULL;
+     DFBGlyphStore      *store;
+     DFBGlyphStoreEntry  entry;
+     bool                stored = false;
 
      D_DEBUG_AT( Core_Font, "%s( index %u, layer %u )\n", __FUNCTION__, index, layer );
 
@@ -877,27 +988,47 @@ dfb_font_get_glyph_data( CoreFont       *font,
 retry:
      data->retry = false;
 
-     /* Get glyph data from font implementation */
-     ret = font->GetGlyphData( font, index, data );
-     if (ret) {
-          D_DERROR( ret, "Core/Font: Could not get glyph info for index %d!\n", index );
-          data->start = data->width = data->height = 0;
+     /* Look for a glyph rendered previously, maybe by another process */
+     store = font_glyph_store( font );
+     if (store && dfb_glyph_store_lookup( store, index, layer, &entry ) == DFB_OK) {
+          D_DEBUG_AT( Core_Font, "  -> found in glyph store\n" );
 
-          /* If the font module returned BUFFEREMPTY we will retry loading next time */
-          if (ret == DFB_BUFFEREMPTY)
-               data->retry = true;
+          data->width    = entry.width;
+          data->height   = entry.height;
+          data->left     = entry.left;
+          data->top      = entry.top;
+          data->xadvance = entry.xadvance;
+          data->yadvance = entry.yadvance;
 
-          goto out;
+          stored = true;
      }
+     else {
+          /* Get glyph data from font implementation */
+          ret = font->GetGlyphData( font, index, data );
+          if (ret) {
+               D_DERROR( ret, "Core/Font: Could not get glyph info for index %d!\n", index );
+               data->start = data->width = data->height = 0;
+
+               /* If the font module returned BUFFEREMPTY we will retry loading next time */
+               if (ret == DFB_BUFFEREMPTY)
+                    data->retry = true;
 
-     if (!(font->flags & CFF_SUBPIXEL_ADVANCE)) {
-          data->xadvance <<= 8;
-          data->yadvance <<= 8;
+               goto out;
+          }
+
+          if (!(font->flags & CFF_SUBPIXEL_ADVANCE)) {
+               data->xadvance <<= 8;
+               data->yadvance <<= 8;
+          }
      }
 
      if (data->width < 1 || data->height < 1) {
           D_DEBUG_AT( Core_Font, "  -> zero size glyph bitmap!\n" );
           data->start = data->width = data->height = 0;
+
+          if (store && !stored)
+               font_glyph_store_append( font, data );
+
           goto out;
      }
 
@@ -943,8 +1074,14 @@ retry:
 
      row->stamp = manager->row_stamp++;
 
-     /* Render the glyph data into the surface. */
-     ret = font->RenderGlyph( font, index, data );
+     /* Render the glyph data into the surface, or copy it from the glyph store. */
+     if (stored) {
+          DFBRectangle rect = { data->start, 0, data->width, data->height };
+
+          ret = dfb_surface_write_buffer( data->surface, CSBR_BACK, entry.data, entry.pitch, &rect );
+     }
+     else
+          ret = font->RenderGlyph( font, index, data );
      if (ret) {
           D_DEBUG_AT( Core_Font, "  -> rendering glyph failed!\n" );
           data->start = data->width = data->height = 0;
@@ -959,6 +1096,9 @@ retry:
      if (!dfb_config->task_manager)
           dfb_gfxcard_flush_texture_cache();
 
+     if (store && !stored)
+          font_glyph_store_append( font, data );
+
      CORE_GLYPH_DATA_DEBUG_AT( Core_Font, data );
 
 
@@ -987,6 +1127,132 @@ error:
      return ret;
 }
 
+static int
+compare_indices( const void *a,
+                 const void *b )
+{
+     unsigned int ia = *(const unsigned int*) a;
+     unsigned int ib = *(const unsigned int*) b;
+
+     return (ia > ib) - (ia < ib);
+}
+
+DFBResult
+dfb_font_prefetch( CoreFont           *font,
+                   const unsigned int *indices,
+                   int                 num )
+{
+     int                 i, l, n = 0, r = 0;
+     int                 layers;
+     unsigned int       *missing;
+     unsigned int       *render;
+     CoreGlyphData      *glyph;
+     DFBGlyphStore      *store;
+     DFBGlyphStoreEntry  entry;
+
+     D_DEBUG_AT( Core_Font, "%s( %p, %d )\n", __FUNCTION__, font, num );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( indices != NULL || num == 0 );
+
+     if (num <= 0)
+          return DFB_OK;
+
+     layers = (font->attributes & DFFA_OUTLINED) ? 2 : 1;
+
+     /* Glyphs to load, followed by those of them to rasterize. */
+     missing = D_MALLOC( num * 2 * sizeof(unsigned int) );
+     if (!missing)
+          return D_OOM();
+
+     render = missing + num;
+
+     direct_memcpy( missing, indices, num * sizeof(unsigned int) );
+
+     qsort( missing, num, sizeof(unsigned int), compare_indices );
+
+     /* Collect unique indices not being loaded yet. */
+     dfb_font_lock( font );
+
+     store = font_glyph_store( font );
+
+     for (i=0; i<num; i++) {
+          if (i && missing[i] == missing[i-1])
+               continue;
+
+          if (direct_hash_lookup( font->layers[0].glyph_hash, missing[i] ))
+               continue;
+
+          missing[n++] = missing[i];
+
+          /* Glyphs from the glyph store are uploaded without rasterizing them. */
+          if (store && dfb_glyph_store_lookup( store, missing[i], 0, &entry ) == DFB_OK &&
+              (layers == 1 || dfb_glyph_store_lookup( store, missing[i], 1, &entry ) == DFB_OK))
+               continue;
+
+          render[r++] = missing[i];
+     }
+
+     dfb_font_unlock( font );
+
+     D_DEBUG_AT( Core_Font, "  -> %d glyphs to load, %d to rasterize\n", n, r );
+
+     if (!n) {
+          D_FREE( missing );
+          return DFB_OK;
+     }
+
+     /* Rasterize without holding the lock, so drawing is not stalled meanwhile. */
+     if (font->PrepareGlyphs && r)
+          font->PrepareGlyphs( font, render, r );
+
+     /* Upload into the glyph cache. */
+     dfb_font_lock( font );
+
+     for (i=0; i<n; i++) {
+          for (l=0; l<layers; l++)
+               dfb_font_get_glyph_data( font, missing[i], l, &glyph );
+     }
+
+     dfb_font_unlock( font );
+
+     D_FREE( missing );
+
+     return DFB_OK;
+}
+
+void
+dfb_font_set_content( CoreFont     *font,
+                      const char   *filename,
+                      const void   *content,
+                      unsigned int  size )
+{
+     struct stat st;
+
+     D_DEBUG_AT( Core_Font, "%s( '%s', %p, %u )\n", __FUNCTION__, filename ?: "", content, size );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+
+     if (!dfb_config->font_cache_dir || !content || !size)
+          return;
+
+     /* Identify font files without reading them, a modified file gets a new key. */
+     if (filename && stat( filename, &st ) == 0) {
+          u64 id[6];
+
+          id[0] = st.st_dev;
+          id[1] = st.st_ino;
+          id[2] = st.st_size;
+          id[3] = st.st_mtim.tv_sec;
+          id[4] = st.st_mtim.tv_nsec;
+          id[5] = size;
+
+          font->content_key = dfb_glyph_store_key( id, sizeof(id) ) ? : 1;
+     }
+     else
+          font->content_key = dfb_glyph_store_key( content, size ) ? : 1;
+}
+
 /**********************************************************************************************************************/
 
 DFBResult
@@ -1122,6 +1388,195 @@ dfb_font_decode_text( CoreFont          *font,
      return DFB_OK;
 }
 
+/**********************************************************************************************************************/
+
+static unsigned int
+font_run_hash( DFBTextEncodingID  encoding,
+               const u8          *text,
+               int                bytes )
+{
+     int          i;
+     unsigned int hash = encoding;
+
+     for (i=0; i<bytes; i++)
+          hash = hash * 31 + text[i];
+
+     return hash;
+}
+
+static void
+font_run_destroy( CoreFont    *font,
+                  CoreFontRun *run )
+{
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_MAGIC_ASSERT( run, CoreFontRun );
+     D_ASSERT( font->num_runs > 0 );
+
+     direct_list_remove( &font->runs, &run->link );
+
+     font->num_runs--;
+
+     D_MAGIC_CLEAR( run );
+
+     D_FREE( run );
+}
+
+DFBResult
+dfb_font_lookup_run( CoreFont           *font,
+                     DFBTextEncodingID   encoding,
+                     const void         *text,
+                     int                 bytes,
+                     CoreFontRun       **ret_run )
+{
+     unsigned int  hash;
+     CoreFontRun  *run;
+
+     D_DEBUG_AT( Core_Font, "%s( %p [%d], %d )\n", __FUNCTION__, text, bytes, encoding );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( text != NULL );
+     D_ASSERT( bytes >= 0 );
+     D_ASSERT( ret_run != NULL );
+
+     hash = font_run_hash( encoding, text, bytes );
+
+     direct_list_foreach (run, font->runs) {
+          D_MAGIC_ASSERT( run, CoreFontRun );
+
+          if (run->hash == hash && run->encoding == encoding &&
+              run->bytes == bytes && !memcmp( run->text, text, bytes ))
+          {
+               if (run->retry) {
+                    font_run_destroy( font, run );
+                    break;
+               }
+
+               D_DEBUG_AT( Core_Font, "  -> cached (%p)\n", run );
+
+               direct_list_move_to_front( &font->runs, &run->link );
+
+               *ret_run = run;
+
+               return DFB_OK;
+          }
+     }
+
+     return DFB_ITEMNOTFOUND;
+}
+
+DFBResult
+dfb_font_get_run( CoreFont           *font,
+                  DFBTextEncodingID   encoding,
+                  const void         *text,
+                  int                 bytes,
+                  CoreFontRun       **ret_run )
+{
+     DFBResult     ret;
+     int           i, num;
+     int           x = 0, y = 0;
+     int           kern_x, kern_y;
+     unsigned int  prev = 0;
+     unsigned int  indices[bytes];
+     CoreFontRun  *run;
+
+     D_DEBUG_AT( Core_Font, "%s( %p [%d], %d )\n", __FUNCTION__, text, bytes, encoding );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( text != NULL );
+     D_ASSERT( bytes >= 0 );
+     D_ASSERT( ret_run != NULL );
+
+     if (dfb_font_lookup_run( font, encoding, text, bytes, ret_run ) == DFB_OK)
+          return DFB_OK;
+
+     /* Decode string to character indices. */
+     ret = dfb_font_decode_text( font, encoding, text, bytes, indices, &num );
+     if (ret)
+          return ret;
+
+     /* Allocate run with glyph arrays and key text in one block. */
+     run = D_MALLOC( sizeof(CoreFontRun) + num * (2 * sizeof(DFBPoint) + sizeof(unsigned int)) + bytes );
+     if (!run)
+          return D_OOM();
+
+     run->hash      = font_run_hash( encoding, text, bytes );
+     run->encoding  = encoding;
+     run->bytes     = bytes;
+     run->num       = num;
+     run->positions = (DFBPoint*) (run + 1);
+     run->ends      = run->positions + num;
+     run->indices   = (unsigned int*) (run->ends + num);
+     run->text      = (const u8*) (run->indices + num);
+     run->retry     = false;
+
+     memset( &run->ink, 0, sizeof(DFBRectangle) );
+
+     direct_memcpy( (u8*) run->text, text, bytes );
+     direct_memcpy( run->indices, indices, num * sizeof(unsigned int) );
+
+     /* Calculate pen positions including kerning and the ink extents. */
+     for (i=0; i<num; i++) {
+          CoreGlyphData *glyph;
+          DFBRectangle   rect;
+          unsigned int   current = indices[i];
+
+          run->positions[i].x = x;
+          run->positions[i].y = y;
+
+          if (dfb_font_get_glyph_data( font, current, 0, &glyph )) {
+               run->ends[i].x = x;
+               run->ends[i].y = y;
+               run->retry = true;
+               prev = current;
+               continue;
+          }
+
+          if (prev && font->GetKerning && font->GetKerning( font, prev, current, &kern_x, &kern_y ) == DFB_OK) {
+               x += kern_x << 8;
+               y += kern_y << 8;
+
+               run->positions[i].x = x;
+               run->positions[i].y = y;
+          }
+
+          if (glyph->retry)
+               run->retry = true;
+
+          rect.x = x + (glyph->left << 8);
+          rect.y = y + (glyph->top << 8);
+          rect.w = glyph->width << 8;
+          rect.h = glyph->height << 8;
+
+          dfb_rectangle_union( &run->ink, &rect );
+
+          x   += glyph->xadvance;
+          y   += glyph->yadvance;
+          prev = current;
+
+          run->ends[i].x = x;
+          run->ends[i].y = y;
+     }
+
+     run->xadvance = x;
+     run->yadvance = y;
+
+     D_MAGIC_SET( run, CoreFontRun );
+
+     /* Keep at least the most recent run, drop least recently used ones. */
+     while (font->num_runs && font->num_runs >= dfb_config->max_font_runs)
+          font_run_destroy( font, (CoreFontRun*) direct_list_get_last( font->runs ) );
+
+     direct_list_prepend( &font->runs, &run->link );
+
+     font->num_runs++;
+
+     D_DEBUG_AT( Core_Font, "  -> new run (%p) with %d glyphs\n", run, num );
+
+     *ret_run = run;
+
+     return DFB_OK;
+}
+
 DFBResult
 dfb_font_decode_character( CoreFont          *font,
                            DFBTextEncodingID  encoding,
@@ -41,6 +41,7 @@
 
 #include <core/coretypes.h>
 
+#include <core/glyph_store.h>
 #include <core/state.h>
 
 
@@ -168,6 +169,36 @@ typedef enum {
 
 #define DFB_FONT_MAX_LAYERS 2
 
+/*
+ * laid out text run, cached per font
+ */
+typedef struct {
+     DirectLink                    link;
+
+     int                           magic;
+
+     unsigned int                  hash;
+     DFBTextEncodingID             encoding;
+     const u8                     *text;          /* copy of the text used as the key */
+     int                           bytes;
+
+     int                           num;           /* number of glyphs                 */
+     unsigned int                 *indices;       /* glyph indices                    */
+     DFBPoint                     *positions;     /* pen position per glyph relative
+                                                     to the origin, 24.8 fixed point  */
+     DFBPoint                     *ends;          /* pen position after each glyph's
+                                                     advance, used for line breaking  */
+
+     int                           xadvance;      /* advance of the whole run,        */
+     int                           yadvance;      /* 24.8 fixed point                 */
+
+     DFBRectangle                  ink;           /* union of glyph bitmaps relative
+                                                     to the origin, 24.8 fixed point  */
+
+     bool                          retry;         /* glyph loading will be retried,   */
+                                                  /* do not reuse the layout          */
+} CoreFontRun;
+
 /*
  * font struct
  */
@@ -223,6 +254,11 @@ struct _CoreFont {
                                                    int           *ret_x,
                                                    int           *ret_y );
 
+     /* optional, rasterizes glyphs in advance without the font being locked */
+     DFBResult                  (* PrepareGlyphs)( CoreFont           *thiz,
+                                                   const unsigned int *indices,
+                                                   unsigned int        num );
+
 
      int                           magic;
 
@@ -230,6 +266,13 @@ struct _CoreFont {
      int                           underline_thickness;
 
      CoreFontFlags                 flags;
+
+     DirectLink                   *runs;          /* cached text runs, most recent first */
+     unsigned int                  num_runs;
+
+     u64                           content_key;   /* identity of the font file, 0 disables the glyph store */
+     u32                           renderer_version; /* version of the rasterizer, set by the implementation */
+     DFBGlyphStore                *store;         /* persistent glyph cache, opened on first glyph miss */
 };
 
 #define CORE_FONT_DEBUG_AT(Domain, font)                                             \
@@ -287,6 +330,25 @@ DFBResult dfb_font_get_glyph_data( CoreFont        *font,
                                    unsigned int     layer,
                                    CoreGlyphData  **glyph_data );
 
+/*
+ * loads glyph data of all layers for the given indices into the cache,
+ * rasterizing them via PrepareGlyphs() if the font implementation supports it
+ *
+ * The font must not be locked.
+ */
+DFBResult dfb_font_prefetch( CoreFont           *font,
+                             const unsigned int *indices,
+                             int                 num );
+
+/*
+ * enables the persistent glyph cache (see "font-cache-dir" option) for a font loaded from the given content,
+ * identified by the file if a filename is given, otherwise by hashing the content
+ */
+void      dfb_font_set_content( CoreFont     *font,
+                                const char   *filename,
+                                const void   *content,
+                                unsigned int  size );
+
 
 /*
  * Called by font module to register encoding implementations.
@@ -321,6 +383,28 @@ DFBResult dfb_font_decode_text( CoreFont          *font,
                                 unsigned int      *ret_indices,
                                 int               *ret_num );
 
+/*
+ * Returns the laid out run of a text if cached, otherwise DFB_ITEMNOTFOUND.
+ *
+ * The font must be locked. The run is only valid until the font is unlocked.
+ */
+DFBResult dfb_font_lookup_run( CoreFont           *font,
+                               DFBTextEncodingID   encoding,
+                               const void         *text,
+                               int                 bytes,
+                               CoreFontRun       **ret_run );
+
+/*
+ * Returns the laid out run of a text, decoding and measuring it only if not cached yet.
+ *
+ * The font must be locked. The run is only valid until the font is unlocked.
+ */
+DFBResult dfb_font_get_run( CoreFont           *font,
+                            DFBTextEncodingID   encoding,
+                            const void         *text,
+                            int                 bytes,
+                            CoreFontRun       **ret_run );
+
 DFBResult dfb_font_decode_character( CoreFont          *font,
                                      DFBTextEncodingID  encoding,
                                      u32                character,
@@ -3648,26 +3648,84 @@ font_state_restore( CardState *state,
      }
 }
 
+/*
+ * Checks if glyphs may be blitted in any order.
+ *
+ * All glyphs of one layer use the same color, and Porter/Duff SRC_OVER with the same color
+ * does not depend on the order. Other blend functions, destination color keying or plain
+ * copies of overlapping glyphs do.
+ */
+static bool
+glyph_blits_reorder( const CardState *state )
+{
+     if (!(state->blittingflags & (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA)))
+          return false;
+
+     if (state->blittingflags & DSBLIT_DST_COLORKEY)
+          return false;
+
+     return (state->src_blend == DSBF_ONE || state->src_blend == DSBF_SRCALPHA) && state->dst_blend == DSBF_INVSRCALPHA;
+}
+
+/*
+ * Blits the collected glyphs with one batch per glyph cache surface,
+ * or per sequence of glyphs from the same surface if they must not be reordered.
+ */
+static void
+glyph_blits_flush( CoreGraphicsStateClient  *client,
+                   CoreSurface             **surfaces,
+                   DFBRectangle             *rects,
+                   DFBPoint                 *points,
+                   int                       num,
+                   bool                      reorder )
+{
+     int start = 0;
+
+     while (start < num) {
+          int          i;
+          int          end     = start + 1;
+          CoreSurface *surface = surfaces[start];
+
+          /* Move all glyphs from the same surface next to each other. */
+          for (i=end; i<num; i++) {
+               if (!reorder) {
+                    if (surfaces[i] != surface)
+                         break;
+
+                    end++;
+                    continue;
+               }
+
+               if (surfaces[i] == surface) {
+                    if (i != end) {
+                         surfaces[i] = surfaces[end];
+                         surfaces[end] = surface;
+
+                         D_UTIL_SWAP( rects[i], rects[end] );
+                         D_UTIL_SWAP( points[i], points[end] );
+                    }
+
+                    end++;
+               }
+          }
+
+          D_DEBUG_AT( Core_GraphicsOps, "  -> %d glyphs from surface %p\n", end - start, surface );
+
+          dfb_state_set_source( client->state, surface );
+
+          CoreGraphicsStateClient_Blit( client, &rects[start], &points[start], end - start );
+
+          start = end;
+     }
+}
+
 void
 dfb_gfxcard_drawstring( const u8 *text, int bytes,
                         DFBTextEncodingID encoding, int x, int y,
                         CoreFont *font, unsigned int layers, CoreGraphicsStateClient *client,
                         DFBSurfaceTextFlags flags )
 {
-     DFBResult     ret;
-     unsigned int  prev = 0;
-     unsigned int  indices[bytes];
-     int           i, l, num;
-     int           kern_x;
-     int           kern_y;
-     CoreSurface  *surface;
-     CardState     state_backup;
-     DFBPoint      points[50];
-     DFBRectangle  rects[50];
-     int           num_blits = 0;
-     int           ox = x;
-     int           oy = y;
-     CardState    *state;
+     DFBPoint point = { x, y };
 
      if (encoding == DTEID_UTF8)
           D_DEBUG_AT( Core_GraphicsOps, "%s( '%s' [%d], %d,%d, %p, %p )\n",
@@ -3676,10 +3734,33 @@ dfb_gfxcard_drawstring( const u8 *text, int bytes,
           D_DEBUG_AT( Core_GraphicsOps, "%s( %p [%d], %d, %d,%d, %p, %p )\n",
                       __FUNCTION__, text, bytes, encoding, x, y, font, client );
 
+     dfb_gfxcard_drawstrings( &text, &bytes, &point, 1, encoding, font, layers, client, flags );
+}
+
+void
+dfb_gfxcard_drawstrings( const u8 * const *texts, const int *bytes, const DFBPoint *points, int num,
+                         DFBTextEncodingID encoding, CoreFont *font, unsigned int layers,
+                         CoreGraphicsStateClient *client, DFBSurfaceTextFlags flags )
+{
+     int           i, l, s;
+     CoreSurface  *surface;
+     CardState     state_backup;
+     CoreSurface  *surfaces[128];
+     DFBPoint      dpoints[128];
+     DFBRectangle  rects[128];
+     int           num_blits = 0;
+     CoreSurface  *refs[128];
+     int           num_refs = 0;
+     bool          reorder;
+     CardState    *state;
+
+     D_DEBUG_AT( Core_GraphicsOps, "%s( %d strings, %d, %p, %p )\n", __FUNCTION__, num, encoding, font, client );
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
-     D_ASSERT( text != NULL );
-     D_ASSERT( bytes > 0 );
+     D_ASSERT( texts != NULL );
+     D_ASSERT( bytes != NULL );
+     D_ASSERT( points != NULL );
      D_ASSERT( font != NULL );
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
@@ -3690,75 +3771,92 @@ dfb_gfxcard_drawstring( const u8 *text, int bytes,
      surface = state->destination;
      D_MAGIC_ASSERT( surface, CoreSurface );
 
-     /* simple prechecks */
-     if (!(font->description.flags & DFDESC_ROTATION) || !font->description.rotation) {
-          if (!(state->render_options & DSRO_MATRIX) &&
-              (x > state->clip.x2 || y > state->clip.y2 ||
-               y + font->height <= state->clip.y1)) {
-               return;
-          }
-     }
-
-     /* Decode string to character indices. */
-     ret = dfb_font_decode_text( font, encoding, text, bytes, indices, &num );
-     if (ret)
-          return;
-
      font_state_prepare( state, &state_backup, font, surface, !(flags & DSTF_BLEND_FUNCS) );
 
+     reorder = glyph_blits_reorder( state );
+
      dfb_font_lock( font );
 
      for (l=layers-1; l>=0; l--) {
-          x = ox << 8;
-          y = oy << 8;
-
           if (layers > 1)
                dfb_state_set_color( state, &state->colors[l] );
 
-          /* blit glyphs */
-          for (i=0; i<num; i++) {
-               DFBResult      ret;
-               CoreGlyphData *glyph;
-               unsigned int   current = indices[i];
+          for (s=0; s<num; s++) {
+               DFBResult    ret;
+               CoreFontRun *run;
+               int          x = points[s].x << 8;
+               int          y = points[s].y << 8;
+
+               D_ASSERT( texts[s] != NULL );
+               D_ASSERT( bytes[s] > 0 );
+
+               /* simple prechecks */
+               if (!(font->description.flags & DFDESC_ROTATION) || !font->description.rotation) {
+                    if (!(state->render_options & DSRO_MATRIX) &&
+                        (points[s].x > state->clip.x2 || points[s].y > state->clip.y2 ||
+                         points[s].y + font->height <= state->clip.y1)) {
+                         continue;
+                    }
+               }
 
-               ret = dfb_font_get_glyph_data( font, current, l, &glyph );
+               /* Lookup or create the laid out run. */
+               ret = dfb_font_get_run( font, encoding, texts[s], bytes[s], &run );
                if (ret) {
-                    D_DEBUG_AT( Core_GraphicsOps, "  -> dfb_font_get_glyph_data() failed! [%s]\n", DirectFBErrorString( ret ) );
-                    prev = current;
+                    D_DEBUG_AT( Core_GraphicsOps, "  -> dfb_font_get_run() failed! [%s]\n", DirectFBErrorString( ret ) );
                     continue;
                }
 
-               if (prev && font->GetKerning && font->GetKerning( font, prev, current, &kern_x, &kern_y) == DFB_OK) {
-                    x += kern_x << 8;
-                    y += kern_y << 8;
-               }
+               /* collect glyphs */
+               for (i=0; i<run->num; i++) {
+                    CoreGlyphData *glyph;
 
-               if (glyph->width) {
-                    if (glyph->surface != state->source || num_blits == D_ARRAY_SIZE(rects)) {
-                         if (num_blits) {
-                              CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
-                              num_blits = 0;
+                    ret = dfb_font_get_glyph_data( font, run->indices[i], l, &glyph );
+                    if (ret) {
+                         D_DEBUG_AT( Core_GraphicsOps, "  -> dfb_font_get_glyph_data() failed! [%s]\n", DirectFBErrorString( ret ) );
+                         continue;
+                    }
+
+                    if (!glyph->width)
+                         continue;
+
+                    if (num_blits == D_ARRAY_SIZE(rects)) {
+                         glyph_blits_flush( client, surfaces, rects, dpoints, num_blits, reorder );
+                         num_blits = 0;
+
+                         while (num_refs)
+                              dfb_surface_unref( refs[--num_refs] );
+                    }
+
+                    /* Looking up further glyphs may evict the row of a collected one, keep its surface alive. */
+                    if (!num_blits || surfaces[num_blits-1] != glyph->surface) {
+                         int r;
+
+                         for (r=0; r<num_refs; r++) {
+                              if (refs[r] == glyph->surface)
+                                   break;
                          }
 
-                         if (glyph->surface != state->source)
-                              dfb_state_set_source( state, glyph->surface );
+                         if (r == num_refs && dfb_surface_ref( glyph->surface ) == DR_OK)
+                              refs[num_refs++] = glyph->surface;
                     }
 
-                    points[num_blits] = (DFBPoint){ (x >> 8) + glyph->left, (y >> 8) + glyph->top };
-                    rects[num_blits]  = (DFBRectangle){ glyph->start, 0, glyph->width, glyph->height };
+                    surfaces[num_blits] = glyph->surface;
+                    dpoints[num_blits]  = (DFBPoint){ ((x + run->positions[i].x) >> 8) + glyph->left,
+                                                      ((y + run->positions[i].y) >> 8) + glyph->top };
+                    rects[num_blits]    = (DFBRectangle){ glyph->start, 0, glyph->width, glyph->height };
 
                     num_blits++;
                }
-
-               x   += glyph->xadvance;
-               y   += glyph->yadvance;
-               prev = current;
           }
 
+          /* blit glyphs, one batch per glyph cache surface */
           if (num_blits) {
-               CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
+               glyph_blits_flush( client, surfaces, rects, dpoints, num_blits, reorder );
                num_blits = 0;
           }
+
+          while (num_refs)
+               dfb_surface_unref( refs[--num_refs] );
      }
 
      dfb_font_unlock( font );
@@ -473,6 +473,20 @@ void dfb_gfxcard_drawstring             ( const u8             *text,
                                           CoreGraphicsStateClient *client,
                                           DFBSurfaceTextFlags   flags );
 
+/*
+ * Draws a number of strings with the same font, blitting all glyphs from the
+ * same glyph cache surface with one batch. Points are the origins of the strings.
+ */
+void dfb_gfxcard_drawstrings            ( const u8      * const *texts,
+                                          const int            *bytes,
+                                          const DFBPoint       *points,
+                                          int                   num,
+                                          DFBTextEncodingID     encoding,
+                                          CoreFont             *font,
+                                          unsigned int          layers,
+                                          CoreGraphicsStateClient *client,
+                                          DFBSurfaceTextFlags   flags );
+
 void dfb_gfxcard_drawglyph              ( CoreGlyphData       **glyph,
                                           int                   x,
                                           int                   y,
@@ -0,0 +1,535 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/file.h>
+
+#include <directfb.h>
+#include <directfb_util.h>
+
+#include <direct/debug.h>
+#include <direct/filesystem.h>
+#include <direct/hash.h>
+#include <direct/mem.h>
+#include <direct/memcpy.h>
+#include <direct/messages.h>
+#include <direct/system.h>
+#include <direct/util.h>
+
+#include <core/glyph_store.h>
+
+
+D_DEBUG_DOMAIN( Core_GlyphStore, "Core/GlyphStore", "DirectFB Persistent Glyph Cache" );
+
+/**********************************************************************************************************************/
+
+#define GLYPH_STORE_VERSION       1
+#define GLYPH_STORE_RECORD_MAGIC  0x47797068   /* 'Gyph' */
+#define GLYPH_STORE_MAX_SIZE      (64 * 1024 * 1024)
+
+typedef struct {
+     char           magic[8];                  /* "DFBGLYPH" */
+     u32            version;
+     u32            format;
+     u64            key;
+} GlyphStoreHeader;
+
+typedef struct {
+     u32            magic;
+     u32            index;
+     u32            layer;
+
+     s32            width;
+     s32            height;
+     s32            pitch;
+     s32            left;
+     s32            top;
+     s32            xadvance;
+     s32            yadvance;
+
+     u32            size;                      /* of pixel data following the record, padded to 4 bytes */
+     u32            checksum;                  /* of pixel data, detects torn writes */
+} GlyphStoreRecord;
+
+struct __DFB_DFBGlyphStore {
+     int                    magic;
+
+     DirectFile             file;
+     DFBSurfacePixelFormat  format;
+     u64                    key;
+
+     void                  *map;
+     size_t                 map_size;
+
+     size_t                 scanned;          /* offset of first record not indexed yet */
+     bool                   broken;           /* stop indexing after torn or invalid record */
+
+     DirectHash            *records;          /* (index << 1 | layer) -> record offset */
+};
+
+/**********************************************************************************************************************/
+
+static u64
+store_hash( u64         hash,
+            const void *data,
+            size_t      size )
+{
+     const u8 *bytes = data;
+     size_t    i;
+
+     /* 64 bit FNV-1a, processing whole words where possible */
+     for (i = 0; i + 8 <= size; i += 8) {
+          u64 word;
+
+          direct_memcpy( &word, bytes + i, 8 );
+
+          hash ^= word;
+          hash *= 0x100000001b3ULL;
+          hash ^= hash >> 29;
+     }
+
+     for (; i < size; i++) {
+          hash ^= bytes[i];
+          hash *= 0x100000001b3ULL;
+     }
+
+     return hash;
+}
+
+static u32
+store_checksum( const void *data,
+                size_t      size )
+{
+     u64 hash = store_hash( 0xcbf29ce484222325ULL, data, size );
+
+     return (u32)(hash ^ (hash >> 32));
+}
+
+static unsigned long
+store_record_key( unsigned int index,
+                  unsigned int layer )
+{
+     return ((unsigned long) index << 1) | layer;
+}
+
+static DFBResult
+store_remap( DFBGlyphStore *store )
+{
+     DirectResult    ret;
+     DirectFileInfo  info;
+     void           *map;
+
+     ret = direct_file_get_info( &store->file, &info );
+     if (ret)
+          return (DFBResult) ret;
+
+     if (info.size == store->map_size)
+          return DFB_OK;
+
+     if (info.size < sizeof(GlyphStoreHeader))
+          return DFB_FAILURE;
+
+     ret = direct_file_map( &store->file, NULL, 0, info.size, DFP_READ, &map );
+     if (ret)
+          return (DFBResult) ret;
+
+     if (store->map)
+          direct_file_unmap( &store->file, store->map, store->map_size );
+
+     store->map      = map;
+     store->map_size = info.size;
+
+     return DFB_OK;
+}
+
+static void
+store_scan( DFBGlyphStore *store )
+{
+     while (!store->broken && store->scanned + sizeof(GlyphStoreRecord) <= store->map_size) {
+          const GlyphStoreRecord *record = (const GlyphStoreRecord*) ((const u8*) store->map + store->scanned);
+          const u8               *pixels = (const u8*) (record + 1);
+
+          /* Incomplete record at the end, possibly being written right now. */
+          if (record->magic == GLYPH_STORE_RECORD_MAGIC &&
+              store->scanned + sizeof(GlyphStoreRecord) + record->size > store->map_size)
+               break;
+
+          if (record->magic != GLYPH_STORE_RECORD_MAGIC || (record->size & 3) || record->layer > 1 ||
+              record->width < 0 || record->height < 0 || record->pitch < 0 ||
+              (u64) record->pitch * record->height > record->size ||
+              store_checksum( pixels, record->size ) != record->checksum)
+          {
+               D_DEBUG_AT( Core_GlyphStore, "  -> invalid record at offset %zu, ignoring the rest\n", store->scanned );
+
+               store->broken = true;
+               break;
+          }
+
+          direct_hash_insert( store->records, store_record_key( record->index, record->layer ),
+                              (void*)(unsigned long) store->scanned );
+
+          store->scanned += sizeof(GlyphStoreRecord) + record->size;
+     }
+}
+
+/*
+ * Drops what follows the last complete record, e.g. left behind by a process that died while appending.
+ *
+ * Called with the file locked, so that no append is in progress.
+ */
+static DFBResult
+store_repair( DFBGlyphStore *store )
+{
+     DFBResult ret;
+
+     ret = store_remap( store );
+     if (ret)
+          return ret;
+
+     /* Another process may have repaired the file and appended valid records meanwhile. */
+     store->broken = false;
+
+     store_scan( store );
+
+     if (store->scanned == store->map_size)
+          return DFB_OK;
+
+     D_DEBUG_AT( Core_GlyphStore, "  -> truncating %zu bytes at offset %zu\n",
+                 store->map_size - store->scanned, store->scanned );
+
+     if (ftruncate( store->file.fd, store->scanned ) < 0) {
+          ret = (DFBResult) errno2result( errno );
+          D_DERROR( ret, "Core/GlyphStore: Could not truncate torn record!\n" );
+          return ret;
+     }
+
+     store->broken = false;
+
+     return store_remap( store );
+}
+
+/*
+ * Creates the file with the header under a temporary name and links it into place,
+ * so that other processes never see a file without a complete header.
+ */
+static DFBResult
+store_create( const char             *filename,
+              const GlyphStoreHeader *header )
+{
+     DFBResult  ret;
+     DirectFile file;
+     size_t     written;
+     char       tmpname[strlen( filename ) + 16];
+
+     snprintf( tmpname, sizeof(tmpname), "%s.%d", filename, direct_getpid() );
+
+     ret = (DFBResult) direct_file_open( &file, tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+     if (ret)
+          return ret;
+
+     ret = (DFBResult) direct_file_write( &file, header, sizeof(GlyphStoreHeader), &written );
+     if (ret == DFB_OK && written != sizeof(GlyphStoreHeader))
+          ret = DFB_IO;
+
+     direct_file_close( &file );
+
+     /* Another process creating the file at the same time is fine. */
+     if (ret == DFB_OK && link( tmpname, filename ) < 0 && errno != EEXIST)
+          ret = (DFBResult) errno2result( errno );
+
+     unlink( tmpname );
+
+     return ret;
+}
+
+/**********************************************************************************************************************/
+
+DFBResult
+dfb_glyph_store_open( const char             *directory,
+                      u64                     key,
+                      DFBSurfacePixelFormat   format,
+                      DFBGlyphStore         **ret_store )
+{
+     DFBResult         ret;
+     DFBGlyphStore    *store;
+     GlyphStoreHeader  header;
+     char              filename[strlen( directory ) + 40];
+
+     D_DEBUG_AT( Core_GlyphStore, "%s( '%s', 0x%016llx, %s )\n", __FUNCTION__,
+                 directory, (unsigned long long) key, dfb_pixelformat_name( format ) );
+
+     D_ASSERT( directory != NULL );
+     D_ASSERT( ret_store != NULL );
+
+     snprintf( filename, sizeof(filename), "%s/%016llx.glyphs", directory, (unsigned long long) key );
+
+     store = D_CALLOC( 1, sizeof(DFBGlyphStore) );
+     if (!store)
+          return D_OOM();
+
+     store->format = format;
+     store->key    = key;
+
+     memset( &header, 0, sizeof(header) );
+
+     direct_memcpy( header.magic, "DFBGLYPH", 8 );
+
+     header.version = GLYPH_STORE_VERSION;
+     header.format  = format;
+     header.key     = key;
+
+     if (direct_file_open( &store->file, filename, O_RDWR | O_APPEND, 0 ) != DR_OK) {
+          ret = store_create( filename, &header );
+          if (ret) {
+               D_DERROR( ret, "Core/GlyphStore: Could not create '%s'!\n", filename );
+               goto error;
+          }
+
+          ret = (DFBResult) direct_file_open( &store->file, filename, O_RDWR | O_APPEND, 0 );
+          if (ret) {
+               D_DERROR( ret, "Core/GlyphStore: Could not open '%s'!\n", filename );
+               goto error;
+          }
+     }
+
+     ret = store_remap( store );
+     if (ret) {
+          D_DEBUG_AT( Core_GlyphStore, "  -> file too short or not mappable\n" );
+          goto error_file;
+     }
+
+     if (memcmp( store->map, &header, sizeof(header) )) {
+          D_DEBUG_AT( Core_GlyphStore, "  -> header mismatch\n" );
+          ret = DFB_UNSUPPORTED;
+          goto error_map;
+     }
+
+     ret = (DFBResult) direct_hash_create( 251, &store->records );
+     if (ret)
+          goto error_map;
+
+     store->scanned = sizeof(GlyphStoreHeader);
+
+     flock( store->file.fd, LOCK_EX );
+
+     ret = store_repair( store );
+
+     flock( store->file.fd, LOCK_UN );
+
+     if (ret) {
+          direct_hash_destroy( store->records );
+          goto error_map;
+     }
+
+     D_DEBUG_AT( Core_GlyphStore, "  -> %d glyphs in '%s'\n", direct_hash_count( store->records ), filename );
+
+     D_MAGIC_SET( store, DFBGlyphStore );
+
+     *ret_store = store;
+
+     return DFB_OK;
+
+
+error_map:
+     direct_file_unmap( &store->file, store->map, store->map_size );
+
+error_file:
+     direct_file_close( &store->file );
+
+error:
+     D_FREE( store );
+
+     return ret;
+}
+
+void
+dfb_glyph_store_close( DFBGlyphStore *store )
+{
+     D_DEBUG_AT( Core_GlyphStore, "%s( %p )\n", __FUNCTION__, store );
+
+     D_MAGIC_ASSERT( store, DFBGlyphStore );
+
+     direct_hash_destroy( store->records );
+
+     if (store->map)
+          direct_file_unmap( &store->file, store->map, store->map_size );
+
+     direct_file_close( &store->file );
+
+     D_MAGIC_CLEAR( store );
+
+     D_FREE( store );
+}
+
+DFBResult
+dfb_glyph_store_lookup( DFBGlyphStore      *store,
+                        unsigned int        index,
+                        unsigned int        layer,
+                        DFBGlyphStoreEntry *ret_entry )
+{
+     unsigned long           offset;
+     const GlyphStoreRecord *record;
+
+     D_MAGIC_ASSERT( store, DFBGlyphStore );
+     D_ASSERT( layer < 2 );
+     D_ASSERT( ret_entry != NULL );
+
+     offset = (unsigned long) direct_hash_lookup( store->records, store_record_key( index, layer ) );
+     if (!offset) {
+          /* Pick up glyphs appended by other processes meanwhile. */
+          if (store->broken || store_remap( store ))
+               return DFB_ITEMNOTFOUND;
+
+          store_scan( store );
+
+          offset = (unsigned long) direct_hash_lookup( store->records, store_record_key( index, layer ) );
+          if (!offset)
+               return DFB_ITEMNOTFOUND;
+     }
+
+     D_ASSERT( offset + sizeof(GlyphStoreRecord) <= store->map_size );
+
+     record = (const GlyphStoreRecord*) ((const u8*) store->map + offset);
+
+     ret_entry->width    = record->width;
+     ret_entry->height   = record->height;
+     ret_entry->left     = record->left;
+     ret_entry->top      = record->top;
+     ret_entry->xadvance = record->xadvance;
+     ret_entry->yadvance = record->yadvance;
+     ret_entry->pitch    = record->pitch;
+     ret_entry->data     = (record->width && record->height) ? (const void*) (record + 1) : NULL;
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_glyph_store_append( DFBGlyphStore            *store,
+                        unsigned int              index,
+                        unsigned int              layer,
+                        const DFBGlyphStoreEntry *entry )
+{
+     DFBResult         ret;
+     GlyphStoreRecord *record;
+     u8               *pixels;
+     int               line;
+     size_t            size;
+     size_t            written;
+     int               y;
+
+     D_DEBUG_AT( Core_GlyphStore, "%s( %p, index %u, layer %u )\n", __FUNCTION__, store, index, layer );
+
+     D_MAGIC_ASSERT( store, DFBGlyphStore );
+     D_ASSERT( layer < 2 );
+     D_ASSERT( entry != NULL );
+     D_ASSERT( entry->data != NULL || !entry->width || !entry->height );
+
+     if (store->map_size >= GLYPH_STORE_MAX_SIZE)
+          return DFB_LIMITEXCEEDED;
+
+     line = entry->data ? DFB_BYTES_PER_LINE( store->format, entry->width ) : 0;
+     size = (line * entry->height + 3) & ~3;
+
+     /* Write the record in one go, so that concurrent appends to the file do not interleave. */
+     record = D_CALLOC( 1, sizeof(GlyphStoreRecord) + size );
+     if (!record)
+          return D_OOM();
+
+     pixels = (u8*) (record + 1);
+
+     for (y = 0; line && y < entry->height; y++)
+          direct_memcpy( pixels + y * line, (const u8*) entry->data + y * entry->pitch, line );
+
+     record->magic    = GLYPH_STORE_RECORD_MAGIC;
+     record->index    = index;
+     record->layer    = layer;
+     record->width    = entry->width;
+     record->height   = entry->height;
+     record->pitch    = line;
+     record->left     = entry->left;
+     record->top      = entry->top;
+     record->xadvance = entry->xadvance;
+     record->yadvance = entry->yadvance;
+     record->size     = size;
+     record->checksum = store_checksum( pixels, size );
+
+     /* Appends are serialized with the repair of a torn record by other processes. */
+     flock( store->file.fd, LOCK_EX );
+
+     if (store->broken)
+          ret = store_repair( store );
+     else
+          ret = DFB_OK;
+
+     if (ret == DFB_OK) {
+          ret = (DFBResult) direct_file_write( &store->file, record, sizeof(GlyphStoreRecord) + size, &written );
+          if (ret == DFB_OK && written != sizeof(GlyphStoreRecord) + size)
+               ret = DFB_IO;
+     }
+
+     flock( store->file.fd, LOCK_UN );
+
+     D_FREE( record );
+
+     if (ret)
+          D_DERROR( ret, "Core/GlyphStore: Could not append glyph %u!\n", index );
+
+     return ret;
+}
+
+/**********************************************************************************************************************/
+
+u64
+dfb_glyph_store_key( const void   *content,
+                     unsigned int  size )
+{
+     D_ASSERT( content != NULL || size == 0 );
+
+     return store_hash( 0xcbf29ce484222325ULL, content, size );
+}
+
+u64
+dfb_glyph_store_key_add( u64           key,
+                         const void   *data,
+                         unsigned int  size )
+{
+     D_ASSERT( data != NULL || size == 0 );
+
+     return store_hash( key, data, size );
+}
@@ -0,0 +1,98 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+#ifndef __CORE__GLYPH_STORE_H__
+#define __CORE__GLYPH_STORE_H__
+
+#include <directfb.h>
+
+#include <core/coretypes.h>
+
+
+/*
+ * Persistent glyph cache file
+ *
+ * Keeps rendered glyph images with their metrics in a file shared between processes and
+ * reboots. The file is mapped read-only and only ever appended to, so new glyphs written
+ * by other processes are picked up when looking up a glyph that is not known yet.
+ */
+typedef struct __DFB_DFBGlyphStore DFBGlyphStore;
+
+typedef struct {
+     int                 width;
+     int                 height;
+     int                 left;
+     int                 top;
+     int                 xadvance;           /* 24.8 fixed point */
+     int                 yadvance;           /* 24.8 fixed point */
+
+     const void         *data;              /* pixels in the font's format, NULL if width or height is 0 */
+     int                 pitch;
+} DFBGlyphStoreEntry;
+
+
+/*
+ * Opens or creates the glyph cache file for the given key within the directory.
+ */
+DFBResult dfb_glyph_store_open  ( const char               *directory,
+                                  u64                       key,
+                                  DFBSurfacePixelFormat     format,
+                                  DFBGlyphStore           **ret_store );
+
+void      dfb_glyph_store_close ( DFBGlyphStore            *store );
+
+/*
+ * Returns DFB_ITEMNOTFOUND if the glyph is not in the file.
+ *
+ * The pixel data stays valid until the next lookup or until the store is closed.
+ */
+DFBResult dfb_glyph_store_lookup( DFBGlyphStore            *store,
+                                  unsigned int              index,
+                                  unsigned int              layer,
+                                  DFBGlyphStoreEntry       *ret_entry );
+
+DFBResult dfb_glyph_store_append( DFBGlyphStore            *store,
+                                  unsigned int              index,
+                                  unsigned int              layer,
+                                  const DFBGlyphStoreEntry *entry );
+
+/*
+ * Calculates a key from the font file contents, use with dfb_glyph_store_key_add() for other parameters.
+ */
+u64       dfb_glyph_store_key   ( const void               *content,
+                                  unsigned int              size );
+
+u64       dfb_glyph_store_key_add( u64                      key,
+                                   const void              *data,
+                                   unsigned int             size );
+
+#endif
@@ -0,0 +1,292 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#include <config.h>
+
+#include <string.h>
+
+#include <directfb.h>
+
+#include <direct/debug.h>
+#include <direct/list.h>
+#include <direct/messages.h>
+
+#include <fusion/conf.h>
+#include <fusion/fusion.h>
+#include <fusion/hash.h>
+#include <fusion/lock.h>
+#include <fusion/shmalloc.h>
+
+#include <core/core.h>
+#include <core/image_cache.h>
+#include <core/surface.h>
+
+#include <gfx/convert.h>
+
+
+D_DEBUG_DOMAIN( Core_ImageCache, "Core/ImageCache", "DirectFB Core Image Cache" );
+
+/**********************************************************************************************************************/
+
+typedef struct {
+     DirectLink           link;
+
+     int                  magic;
+
+     char                *key;
+     CoreSurface         *surface;      /* global reference */
+     unsigned long        size;         /* bytes of pixel data */
+} CoreImageCacheEntry;
+
+struct __DFB_CoreImageCache {
+     int                  magic;
+
+     FusionSHMPoolShared *shmpool;
+
+     FusionSkirmish       lock;
+
+     FusionHash          *hash;         /* entries by key */
+     DirectLink          *entries;      /* most recently used first */
+
+     unsigned long        size;
+     unsigned long        max_size;
+
+     unsigned int         hits;
+     unsigned int         misses;
+};
+
+/**********************************************************************************************************************/
+
+static void
+entry_remove( CoreImageCache      *cache,
+              CoreImageCacheEntry *entry )
+{
+     D_MAGIC_ASSERT( entry, CoreImageCacheEntry );
+
+     D_DEBUG_AT( Core_ImageCache, "  -> removing '%s' (%lu bytes)\n", entry->key, entry->size );
+
+     fusion_hash_remove( cache->hash, entry->key, NULL, NULL );
+
+     direct_list_remove( &cache->entries, &entry->link );
+
+     cache->size -= entry->size;
+
+     dfb_surface_unlink( &entry->surface );
+
+     D_MAGIC_CLEAR( entry );
+
+     SHFREE( cache->shmpool, entry->key );
+     SHFREE( cache->shmpool, entry );
+}
+
+/**********************************************************************************************************************/
+
+DFBResult
+dfb_image_cache_create( CoreDFB         *core,
+                        unsigned long    max_size,
+                        CoreImageCache **ret_cache )
+{
+     DFBResult       ret;
+     CoreImageCache *cache;
+
+     D_DEBUG_AT( Core_ImageCache, "%s( %lu )\n", __FUNCTION__, max_size );
+
+     D_ASSERT( ret_cache != NULL );
+
+     cache = SHCALLOC( dfb_core_shmpool( core ), 1, sizeof(CoreImageCache) );
+     if (!cache)
+          return D_OOSHM();
+
+     cache->shmpool  = dfb_core_shmpool( core );
+     cache->max_size = max_size;
+
+     ret = fusion_hash_create( cache->shmpool, HASH_STRING, HASH_PTR, 61, &cache->hash );
+     if (ret) {
+          SHFREE( cache->shmpool, cache );
+          return ret;
+     }
+
+     fusion_skirmish_init2( &cache->lock, "Image Cache", dfb_core_world( core ), fusion_config->secure_fusion );
+
+     D_MAGIC_SET( cache, CoreImageCache );
+
+     *ret_cache = cache;
+
+     return DFB_OK;
+}
+
+void
+dfb_image_cache_destroy( CoreImageCache *cache )
+{
+     CoreImageCacheEntry *entry;
+     DirectLink          *next;
+
+     D_DEBUG_AT( Core_ImageCache, "%s( %p )\n", __FUNCTION__, cache );
+
+     D_MAGIC_ASSERT( cache, CoreImageCache );
+
+     D_DEBUG_AT( Core_ImageCache, "  -> %u hits, %u misses, %lu bytes\n", cache->hits, cache->misses, cache->size );
+
+     direct_list_foreach_safe (entry, next, cache->entries)
+          entry_remove( cache, entry );
+
+     fusion_hash_destroy( cache->hash );
+
+     fusion_skirmish_destroy( &cache->lock );
+
+     D_MAGIC_CLEAR( cache );
+
+     SHFREE( cache->shmpool, cache );
+}
+
+DFBResult
+dfb_image_cache_lookup( CoreImageCache  *cache,
+                        const char      *key,
+                        CoreSurface    **ret_surface )
+{
+     DFBResult            ret = DFB_ITEMNOTFOUND;
+     CoreImageCacheEntry *entry;
+
+     D_DEBUG_AT( Core_ImageCache, "%s( '%s' )\n", __FUNCTION__, key );
+
+     D_MAGIC_ASSERT( cache, CoreImageCache );
+     D_ASSERT( key != NULL );
+     D_ASSERT( ret_surface != NULL );
+
+     if (fusion_skirmish_prevail( &cache->lock ))
+          return DFB_FUSION;
+
+     entry = fusion_hash_lookup( cache->hash, key );
+     if (entry) {
+          D_MAGIC_ASSERT( entry, CoreImageCacheEntry );
+
+          /* Take the reference while the cache still holds its own. */
+          ret = dfb_surface_ref( entry->surface );
+          if (ret == DFB_OK) {
+               direct_list_move_to_front( &cache->entries, &entry->link );
+
+               *ret_surface = entry->surface;
+
+               cache->hits++;
+          }
+     }
+     else
+          cache->misses++;
+
+     fusion_skirmish_dismiss( &cache->lock );
+
+     D_DEBUG_AT( Core_ImageCache, "  -> %s\n", ret ? "miss" : "hit" );
+
+     return ret;
+}
+
+DFBResult
+dfb_image_cache_insert( CoreImageCache *cache,
+                        const char     *key,
+                        CoreSurface    *surface )
+{
+     DFBResult            ret;
+     CoreImageCacheEntry *entry;
+     unsigned long        size;
+
+     D_DEBUG_AT( Core_ImageCache, "%s( '%s', %p )\n", __FUNCTION__, key, surface );
+
+     D_MAGIC_ASSERT( cache, CoreImageCache );
+     D_ASSERT( key != NULL );
+     D_MAGIC_ASSERT( surface, CoreSurface );
+
+     size = DFB_BYTES_PER_LINE( surface->config.format, surface->config.size.w ) *
+            DFB_PLANE_MULTIPLY( surface->config.format, surface->config.size.h );
+
+     if (size > cache->max_size) {
+          D_DEBUG_AT( Core_ImageCache, "  -> %lu bytes exceed the budget\n", size );
+          return DFB_LIMITEXCEEDED;
+     }
+
+     if (fusion_skirmish_prevail( &cache->lock ))
+          return DFB_FUSION;
+
+     /* Another process may have decoded the same image meanwhile. */
+     if (fusion_hash_lookup( cache->hash, key )) {
+          fusion_skirmish_dismiss( &cache->lock );
+          return DFB_OK;
+     }
+
+     /* Evict the least recently used entries. */
+     while (cache->entries && cache->size + size > cache->max_size)
+          entry_remove( cache, (CoreImageCacheEntry*) cache->entries->prev );
+
+     entry = SHCALLOC( cache->shmpool, 1, sizeof(CoreImageCacheEntry) );
+     if (!entry) {
+          ret = D_OOSHM();
+          goto out;
+     }
+
+     entry->key = SHSTRDUP( cache->shmpool, key );
+     if (!entry->key) {
+          SHFREE( cache->shmpool, entry );
+          ret = D_OOSHM();
+          goto out;
+     }
+
+     ret = dfb_surface_link( &entry->surface, surface );
+     if (ret)
+          goto error;
+
+     ret = fusion_hash_insert( cache->hash, entry->key, entry );
+     if (ret) {
+          dfb_surface_unlink( &entry->surface );
+          goto error;
+     }
+
+     entry->size = size;
+
+     D_MAGIC_SET( entry, CoreImageCacheEntry );
+
+     direct_list_prepend( &cache->entries, &entry->link );
+
+     cache->size += size;
+
+     D_DEBUG_AT( Core_ImageCache, "  -> %lu bytes, %lu/%lu used\n", size, cache->size, cache->max_size );
+
+     goto out;
+
+error:
+     SHFREE( cache->shmpool, entry->key );
+     SHFREE( cache->shmpool, entry );
+
+out:
+     fusion_skirmish_dismiss( &cache->lock );
+
+     return ret;
+}
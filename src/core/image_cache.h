@@ -0,0 +1,70 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#ifndef __CORE__IMAGE_CACHE_H__
+#define __CORE__IMAGE_CACHE_H__
+
+#include <directfb.h>
+
+#include <core/coretypes.h>
+
+/*
+ * Decoded images shared by all processes, see 'image-cache' option.
+ *
+ * Entries are surfaces holding an image decoded at a certain size and format, looked up by a key
+ * identifying the file and these parameters. The cache keeps a global reference to each surface.
+ * The least recently used entries are evicted when the memory budget is exceeded.
+ */
+
+DFBResult dfb_image_cache_create ( CoreDFB             *core,
+                                   unsigned long        max_size,
+                                   CoreImageCache     **ret_cache );
+
+void      dfb_image_cache_destroy( CoreImageCache      *cache );
+
+/*
+ * Returns a local reference to the surface cached under the key, DFB_ITEMNOTFOUND if there is none.
+ */
+DFBResult dfb_image_cache_lookup ( CoreImageCache      *cache,
+                                   const char          *key,
+                                   CoreSurface        **ret_surface );
+
+/*
+ * Adds the surface under the key, unless another process did already.
+ */
+DFBResult dfb_image_cache_insert ( CoreImageCache      *cache,
+                                   const char          *key,
+                                   CoreSurface         *surface );
+
+
+#endif
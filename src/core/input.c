@@ -72,6 +72,7 @@
 #include <core/layers.h>
 #include <core/input.h>
 #include <core/input_hub.h>
+#include <core/input_resampler.h>
 #include <core/windows.h>
 #include <core/windows_internal.h>
 
@@ -92,6 +93,8 @@
 #define CHECK_INTERVAL 20000  // Microseconds
 #define CHECK_NUMBER   200
 
+#define CORE_INPUT_CHANNEL_FRAME  1  // Reactor channel of CoreInputFrame messages
+
 
 D_DEBUG_DOMAIN( Core_Input,    "Core/Input",     "DirectFB Input Core" );
 D_DEBUG_DOMAIN( Core_InputEvt, "Core/Input/Evt", "DirectFB Input Core Events & Dispatch" );
@@ -144,6 +147,7 @@ typedef struct {
      bool                         first_press;   /* first press of key */
 
      FusionReactor               *reactor;       /* event dispatcher */
+     int                          event_reactions; /* attached to single events, not frames */
      FusionSkirmish               lock;
 
      unsigned int                 axis_num;
@@ -164,6 +168,8 @@ struct __DFB_CoreInputDevice {
      void               *driver_data;
 
      CoreDFB            *core;
+
+     CoreInputResampler *resampler;  /* created with the first motion if enabled */
 };
 
 /**********************************************************************************************************************/
@@ -353,6 +359,8 @@ static void fixup_mouse_event( CoreInputDevice    *device,
 
 static void flush_keys       ( CoreInputDevice    *device );
 
+static void stop_resampler   ( CoreInputDevice    *device );
+
 static bool core_input_filter( CoreInputDevice    *device,
                                DFBInputEvent      *event );
 
@@ -626,6 +634,8 @@ dfb_input_core_shutdown( DFBInputCore *data,
                device->driver_data = NULL;
                driver->funcs->CloseDevice( driver_data );
 
+               stop_resampler( device );
+
                if (data->hub)
                     CoreInputHub_RemoveDevice( data->hub, device->shared->id );
           }
@@ -753,6 +763,8 @@ dfb_input_core_suspend( DFBInputCore *data )
                driver->funcs->CloseDevice( driver_data );
           }
 
+          stop_resampler( device );
+
           flush_keys( device );
      }
 
@@ -849,6 +861,29 @@ dfb_input_attach( CoreInputDevice *device,
                   ReactionFunc     func,
                   void            *ctx,
                   Reaction        *reaction )
+{
+     DirectResult ret;
+
+     D_DEBUG_AT( Core_Input, "%s( %p, %p, %p, %p )\n", __FUNCTION__, device, func, ctx, reaction );
+
+     D_MAGIC_ASSERT( device, CoreInputDevice );
+
+     D_ASSERT( core_input != NULL );
+     D_ASSERT( device != NULL );
+     D_ASSERT( device->shared != NULL );
+
+     ret = fusion_reactor_attach( device->shared->reactor, func, ctx, reaction );
+     if (ret == DR_OK)
+          D_SYNC_ADD( &device->shared->event_reactions, 1 );
+
+     return ret;
+}
+
+DirectResult
+dfb_input_attach_frame( CoreInputDevice *device,
+                        ReactionFunc     func,
+                        void            *ctx,
+                        Reaction        *reaction )
 {
      D_DEBUG_AT( Core_Input, "%s( %p, %p, %p, %p )\n", __FUNCTION__, device, func, ctx, reaction );
 
@@ -858,12 +893,33 @@ dfb_input_attach( CoreInputDevice *device,
      D_ASSERT( device != NULL );
      D_ASSERT( device->shared != NULL );
 
-     return fusion_reactor_attach( device->shared->reactor, func, ctx, reaction );
+     return fusion_reactor_attach_channel( device->shared->reactor, CORE_INPUT_CHANNEL_FRAME, func, ctx, reaction );
 }
 
 DirectResult
 dfb_input_detach( CoreInputDevice *device,
                   Reaction        *reaction )
+{
+     DirectResult ret;
+
+     D_DEBUG_AT( Core_Input, "%s( %p, %p )\n", __FUNCTION__, device, reaction );
+
+     D_MAGIC_ASSERT( device, CoreInputDevice );
+
+     D_ASSERT( core_input != NULL );
+     D_ASSERT( device != NULL );
+     D_ASSERT( device->shared != NULL );
+
+     ret = fusion_reactor_detach( device->shared->reactor, reaction );
+     if (ret == DR_OK)
+          D_SYNC_ADD( &device->shared->event_reactions, -1 );
+
+     return ret;
+}
+
+DirectResult
+dfb_input_detach_frame( CoreInputDevice *device,
+                        Reaction        *reaction )
 {
      D_DEBUG_AT( Core_Input, "%s( %p, %p )\n", __FUNCTION__, device, reaction );
 
@@ -882,6 +938,8 @@ dfb_input_attach_global( CoreInputDevice *device,
                          void            *ctx,
                          GlobalReaction  *reaction )
 {
+     DirectResult ret;
+
      D_DEBUG_AT( Core_Input, "%s( %p, %d, %p, %p )\n", __FUNCTION__, device, index, ctx, reaction );
 
      D_MAGIC_ASSERT( device, CoreInputDevice );
@@ -890,13 +948,19 @@ dfb_input_attach_global( CoreInputDevice *device,
      D_ASSERT( device != NULL );
      D_ASSERT( device->shared != NULL );
 
-     return fusion_reactor_attach_global( device->shared->reactor, index, ctx, reaction );
+     ret = fusion_reactor_attach_global( device->shared->reactor, index, ctx, reaction );
+     if (ret == DR_OK)
+          D_SYNC_ADD( &device->shared->event_reactions, 1 );
+
+     return ret;
 }
 
 DirectResult
 dfb_input_detach_global( CoreInputDevice *device,
                          GlobalReaction  *reaction )
 {
+     DirectResult ret;
+
      D_DEBUG_AT( Core_Input, "%s( %p, %p )\n", __FUNCTION__, device, reaction );
 
      D_MAGIC_ASSERT( device, CoreInputDevice );
@@ -905,7 +969,11 @@ dfb_input_detach_global( CoreInputDevice *device,
      D_ASSERT( device != NULL );
      D_ASSERT( device->shared != NULL );
 
-     return fusion_reactor_detach_global( device->shared->reactor, reaction );
+     ret = fusion_reactor_detach_global( device->shared->reactor, reaction );
+     if (ret == DR_OK)
+          D_SYNC_ADD( &device->shared->event_reactions, -1 );
+
+     return ret;
 }
 
 const char *
@@ -937,37 +1005,12 @@ dfb_input_event_type_name( DFBInputEventType type )
      return "<invalid>";
 }
 
-void
-dfb_input_dispatch( CoreInputDevice *device, DFBInputEvent *event )
+/*
+ * Fixes up the event, passes it to the hub and returns false if it has been filtered.
+ */
+static bool
+input_prepare_event( CoreInputDevice *device, DFBInputEvent *event )
 {
-     D_DEBUG_AT( Core_Input, "%s( %p, %p )\n", __FUNCTION__, device, event );
-
-     D_MAGIC_ASSERT( device, CoreInputDevice );
-
-     D_ASSERT( core_input != NULL );
-     D_ASSERT( device != NULL );
-     D_ASSERT( event != NULL );
-
-     /*
-      * When a USB device is hot-removed, it is possible that there are pending events
-      * still being dispatched and the shared field becomes NULL.
-      */
-
-     /*
-      * 0. Sanity checks & debugging...
-      */
-     if (!device->shared) {
-          D_DEBUG_AT( Core_Input, "  -> No shared data!\n" );
-          return;
-     }
-
-     D_ASSUME( device->shared->reactor != NULL );
-
-     if (!device->shared->reactor) {
-          D_DEBUG_AT( Core_Input, "  -> No reactor!\n" );
-          return;
-     }
-
      D_DEBUG_AT( Core_InputEvt, "  -> (%02x) %s%s%s\n", event->type,
                  dfb_input_event_type_name( event->type ),
                  (event->flags & DIEF_FOLLOW) ? " [FOLLOW]" : "",
@@ -1006,6 +1049,8 @@ dfb_input_dispatch( CoreInputDevice *device, DFBInputEvent *event )
           gettimeofday( &event->timestamp, NULL );
           event->flags |= DIEF_TIMESTAMP;
      }
+     else if (dfb_config->latency_trace)
+          dfb_core_trace_latency( device->core, DLTS_INPUT, dfb_core_latency_origin( &event->timestamp ) );
 
      switch (event->type) {
           case DIET_BUTTONPRESS:
@@ -1074,10 +1119,183 @@ dfb_input_dispatch( CoreInputDevice *device, DFBInputEvent *event )
      if (core_local->hub)
           CoreInputHub_DispatchEvent( core_local->hub, device->shared->id, event );
 
-     if (core_input_filter( device, event ))
+     if (core_input_filter( device, event )) {
           D_DEBUG_AT( Core_InputEvt, "  ****>> FILTERED\n" );
-     else
-          fusion_reactor_dispatch( device->shared->reactor, event, true, dfb_input_globals );
+          return false;
+     }
+
+     return true;
+}
+
+
+static bool
+input_can_dispatch( CoreInputDevice *device )
+{
+     /*
+      * When a USB device is hot-removed, it is possible that there are pending events
+      * still being dispatched and the shared field becomes NULL.
+      */
+     if (!device->shared) {
+          D_DEBUG_AT( Core_Input, "  -> No shared data!\n" );
+          return false;
+     }
+
+     D_ASSUME( device->shared->reactor != NULL );
+
+     if (!device->shared->reactor) {
+          D_DEBUG_AT( Core_Input, "  -> No reactor!\n" );
+          return false;
+     }
+
+     return true;
+}
+
+/*
+ * Sends up to CORE_INPUT_FRAME_MAX events as one message to the frame reactions.
+ */
+static void
+input_dispatch_frame( CoreInputDevice     *device,
+                      const DFBInputEvent *events,
+                      int                  num )
+{
+     CoreInputFrame frame;
+
+     D_ASSERT( num > 0 );
+     D_ASSERT( num <= CORE_INPUT_FRAME_MAX );
+
+     frame.num = num;
+
+     direct_memcpy( frame.events, events, num * sizeof(DFBInputEvent) );
+
+     fusion_reactor_dispatch_channel( device->shared->reactor, CORE_INPUT_CHANNEL_FRAME, &frame,
+                                      sizeof(frame) - (CORE_INPUT_FRAME_MAX - num) * sizeof(DFBInputEvent),
+                                      true, NULL );
+}
+
+/*
+ * Dispatches prepared events one by one if anyone still listens to single events, and then as one frame.
+ */
+static void
+input_dispatch_events( CoreInputDevice     *device,
+                       const DFBInputEvent *events,
+                       int                  num )
+{
+     int i;
+
+     if (device->shared->event_reactions > 0) {
+          for (i=0; i<num; i++)
+               fusion_reactor_dispatch( device->shared->reactor, &events[i], true, dfb_input_globals );
+     }
+
+     input_dispatch_frame( device, events, num );
+}
+
+static void
+input_resampler_dispatch( void          *ctx,
+                          DFBInputEvent *events,
+                          int            num )
+{
+     CoreInputDevice *device = ctx;
+
+     D_MAGIC_ASSERT( device, CoreInputDevice );
+
+     if (input_can_dispatch( device ))
+          input_dispatch_events( device, events, num );
+}
+
+/*
+ * Returns the resampler of the device, creating it for the first motion event of a pointing device.
+ */
+static CoreInputResampler *
+input_resampler( CoreInputDevice     *device,
+                 const DFBInputEvent *event )
+{
+     if (!device->resampler && dfb_config->input_resample && event->type == DIET_AXISMOTION &&
+         (device->shared->device_info.desc.type & DIDTF_MOUSE))
+          CoreInputResampler_Create( device->shared->id, input_resampler_dispatch, device, &device->resampler );
+
+     return device->resampler;
+}
+
+void
+dfb_input_dispatch( CoreInputDevice *device, DFBInputEvent *event )
+{
+     CoreInputResampler *resampler;
+     DFBInputEvent       events[CORE_INPUT_RESAMPLER_EVENTS + 1];
+     int                 num = 0;
+
+     D_DEBUG_AT( Core_Input, "%s( %p, %p )\n", __FUNCTION__, device, event );
+
+     D_MAGIC_ASSERT( device, CoreInputDevice );
+
+     D_ASSERT( core_input != NULL );
+     D_ASSERT( device != NULL );
+     D_ASSERT( event != NULL );
+
+     if (!input_can_dispatch( device ))
+          return;
+
+     if (!input_prepare_event( device, event ))
+          return;
+
+     resampler = input_resampler( device, event );
+     if (resampler) {
+          if (CoreInputResampler_AddEvent( resampler, event ))
+               return;
+
+          /* Deliver the latest position before anything else */
+          num = CoreInputResampler_Flush( resampler, events );
+     }
+
+     events[num++] = *event;
+
+     input_dispatch_events( device, events, num );
+}
+
+void
+dfb_input_dispatch_frame( CoreInputDevice *device, DFBInputEvent *events, int num )
+{
+     int                 i;
+     int                 count = 0;
+     CoreInputResampler *resampler;
+     DFBInputEvent       frame[CORE_INPUT_FRAME_MAX];
+
+     D_DEBUG_AT( Core_Input, "%s( %p, %p [%d] )\n", __FUNCTION__, device, events, num );
+
+     D_MAGIC_ASSERT( device, CoreInputDevice );
+
+     D_ASSERT( core_input != NULL );
+     D_ASSERT( device != NULL );
+     D_ASSERT( events != NULL );
+     D_ASSERT( num >= 0 );
+
+     if (!input_can_dispatch( device ))
+          return;
+
+     /* Collect the events not filtered or resampled, making room for the event and a flushed position. */
+     for (i=0; i<num; i++) {
+          if (!input_prepare_event( device, &events[i] ))
+               continue;
+
+          if (count > CORE_INPUT_FRAME_MAX - CORE_INPUT_RESAMPLER_EVENTS - 1) {
+               input_dispatch_events( device, frame, count );
+
+               count = 0;
+          }
+
+          resampler = input_resampler( device, &events[i] );
+          if (resampler) {
+               if (CoreInputResampler_AddEvent( resampler, &events[i] ))
+                    continue;
+
+               count += CoreInputResampler_Flush( resampler, &frame[count] );
+          }
+
+          frame[count++] = events[i];
+     }
+
+     if (count)
+          input_dispatch_events( device, frame, count );
 }
 
 DFBInputDeviceID
@@ -1807,6 +2025,8 @@ dfb_input_remove_device(int device_index, void *driver_in)
 
      device->driver->funcs->CloseDevice( device->driver_data );
 
+     stop_resampler( device );
+
      if (core_local->hub)
           CoreInputHub_RemoveDevice( core_local->hub, device->shared->id );
 
@@ -2973,6 +3193,18 @@ flush_keys( CoreInputDevice *device )
      }
 }
 
+static void
+stop_resampler( CoreInputDevice *device )
+{
+     D_MAGIC_ASSERT( device, CoreInputDevice );
+
+     if (device->resampler) {
+          CoreInputResampler_Destroy( device->resampler );
+
+          device->resampler = NULL;
+     }
+}
+
 static void
 dump_primary_layer_surface( CoreDFB *core )
 {
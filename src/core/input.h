@@ -127,6 +127,17 @@ typedef struct {
 } InputDriverFuncs;
 
 
+#define CORE_INPUT_FRAME_MAX     32
+
+/*
+ * Message sent to frame reactions, only 'num' events are valid.
+ */
+typedef struct {
+     int                 num;
+     DFBInputEvent       events[CORE_INPUT_FRAME_MAX];
+} CoreInputFrame;
+
+
 typedef DFBEnumerationResult (*InputDeviceCallback) (CoreInputDevice *device,
                                                      void            *ctx);
 
@@ -143,6 +154,20 @@ DirectResult dfb_input_attach       ( CoreInputDevice *device,
 DirectResult dfb_input_detach       ( CoreInputDevice *device,
                                       Reaction        *reaction );
 
+/*
+ * Attaches a local reaction receiving a CoreInputFrame per dispatch instead of single events.
+ *
+ * Single events are only dispatched while reactions attached with dfb_input_attach() or
+ * dfb_input_attach_global() exist.
+ */
+DirectResult dfb_input_attach_frame ( CoreInputDevice *device,
+                                      ReactionFunc     func,
+                                      void            *ctx,
+                                      Reaction        *reaction );
+
+DirectResult dfb_input_detach_frame ( CoreInputDevice *device,
+                                      Reaction        *reaction );
+
 DirectResult dfb_input_attach_global( CoreInputDevice *device,
                                       int              index,
                                       void            *ctx,
@@ -162,6 +187,16 @@ DFBResult    dfb_input_set_global   ( ReactionFunc     func,
 void         dfb_input_dispatch     ( CoreInputDevice *device,
                                       DFBInputEvent   *event );
 
+/*
+ * Dispatches a group of events belonging together, e.g. all events of one evdev report.
+ *
+ * Events are fixed up in place. Reactions attached with dfb_input_attach() still get each event,
+ * frame reactions get the group as one message, split into chunks of CORE_INPUT_FRAME_MAX.
+ */
+void         dfb_input_dispatch_frame( CoreInputDevice *device,
+                                       DFBInputEvent   *events,
+                                       int              num );
+
 
 
 void              dfb_input_device_description( const CoreInputDevice     *device,
@@ -0,0 +1,63 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#ifndef __CORE__INPUT_RECORDING_H__
+#define __CORE__INPUT_RECORDING_H__
+
+#include <directfb.h>
+
+/*
+ * File format of input recordings, written by dfbrecordinput and played by the 'replay' input driver.
+ *
+ * The header is followed by records, sorted by time. Events are stored as they were received, so a
+ * recording can only be played on the same architecture, which is checked via the event size.
+ */
+
+#define DFB_INPUT_RECORDING_MAGIC      "DFBInRec"
+#define DFB_INPUT_RECORDING_VERSION    1
+
+typedef struct {
+     char                magic[8];          /* DFB_INPUT_RECORDING_MAGIC */
+     u32                 version;           /* DFB_INPUT_RECORDING_VERSION */
+     u32                 event_size;        /* sizeof(DFBInputEvent) */
+     u32                 num_records;       /* number of records, 0 if the recording was not finished */
+     u32                 reserved[5];
+} DFBInputRecordingHeader;
+
+typedef struct {
+     s64                 time;              /* microseconds since the first event */
+     DFBInputEvent       event;
+} DFBInputRecord;
+
+
+#endif
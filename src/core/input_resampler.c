@@ -0,0 +1,508 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#include <config.h>
+
+#include <directfb.h>
+
+#include <direct/clock.h>
+#include <direct/debug.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+
+#include <core/DisplayTask.h>
+#include <core/input_resampler.h>
+#include <core/layers.h>
+#include <core/screen.h>
+
+#include <misc/conf.h>
+
+
+D_DEBUG_DOMAIN( Core_InputResampler, "Core/Input/Resampler", "DirectFB Input Core Resampler" );
+
+/**********************************************************************************************************************/
+
+#define RESAMPLER_HISTORY          8  /* number of samples kept for interpolation */
+#define RESAMPLER_MIN_DELTA     2000  /* minimum time between the latest two samples to extrapolate (us) */
+#define RESAMPLER_MAX_DELTA    20000  /* maximum time between the latest two samples to extrapolate (us) */
+#define RESAMPLER_MAX_PREDICT   8000  /* maximum time to extrapolate beyond the latest sample (us) */
+
+#define RESAMPLER_SAMPLE(r,n)   (&(r)->samples[((r)->latest + RESAMPLER_HISTORY - (n)) % RESAMPLER_HISTORY])
+
+typedef struct {
+     long long                     time;           /* event time on the monotonic clock */
+     int                           x;              /* absolute position or sum of relative motion */
+     int                           y;
+} ResamplerSample;
+
+struct __CoreDFB__CoreInputResampler {
+     int                           magic;
+
+     DFBInputDeviceID              device_id;
+
+     CoreInputResamplerDispatch    dispatch;
+     void                         *ctx;
+
+     DirectMutex                   lock;
+     DirectWaitQueue               wq;
+     DirectThread                 *thread;
+     bool                          stop;
+     bool                          idle;           /* thread waits for samples */
+
+     bool                          relative;       /* motion is relative */
+     DFBInputEvent                 axis[2];        /* latest X/Y events, templates for the delivered ones */
+     bool                          has_axis[2];
+     struct timeval                timestamp;      /* timestamp of the latest event */
+
+     ResamplerSample               current;        /* sample being assembled from X/Y events */
+     bool                          incomplete;     /* current sample awaits an event without DIEF_FOLLOW */
+
+     ResamplerSample               samples[RESAMPLER_HISTORY];
+     int                           num_samples;
+     int                           latest;         /* index of the latest sample */
+
+     bool                          pending;        /* samples not delivered yet */
+     bool                          settled;        /* delivered position is the one of the latest sample */
+     int                           x;              /* delivered position */
+     int                           y;
+     long long                     last_target;    /* time of the delivered position */
+};
+
+/**********************************************************************************************************************/
+
+static long long
+resampler_event_time( const DFBInputEvent *event )
+{
+     long long now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+     long long time;
+
+     if (!(event->flags & DIEF_TIMESTAMP))
+          return now;
+
+     /* Event timestamps are taken from the realtime clock */
+     time = event->timestamp.tv_sec * 1000000LL + event->timestamp.tv_usec
+            - direct_clock_get_time( DIRECT_CLOCK_REALTIME ) + now;
+
+     return MIN( time, now );
+}
+
+static void
+resampler_commit( CoreInputResampler *resampler )
+{
+     ResamplerSample *latest = &resampler->samples[resampler->latest];
+
+     if (!resampler->incomplete)
+          return;
+
+     resampler->incomplete = false;
+
+     /* Samples sharing a timestamp are combined, time never goes backwards */
+     if (resampler->num_samples && resampler->current.time <= latest->time) {
+          resampler->current.time = latest->time;
+
+          *latest = resampler->current;
+     }
+     else {
+          resampler->latest = (resampler->latest + 1) % RESAMPLER_HISTORY;
+
+          resampler->samples[resampler->latest] = resampler->current;
+
+          if (resampler->num_samples < RESAMPLER_HISTORY)
+               resampler->num_samples++;
+     }
+
+     resampler->pending = true;
+     resampler->settled = false;
+
+     if (resampler->idle)
+          direct_waitqueue_broadcast( &resampler->wq );
+}
+
+/*
+ * Calculates the position at the target time from the samples around it, or predicts it from the latest two samples.
+ */
+static void
+resampler_position( CoreInputResampler *resampler,
+                    long long           target,
+                    int                *ret_x,
+                    int                *ret_y )
+{
+     const ResamplerSample *s0;
+     const ResamplerSample *s1 = RESAMPLER_SAMPLE( resampler, 0 );
+     long long              delta;
+     int                    n;
+
+     target = MAX( target, resampler->last_target );
+
+     if (resampler->num_samples < 2)
+          goto latest;
+
+     if (target >= s1->time) {
+          s0    = RESAMPLER_SAMPLE( resampler, 1 );
+          delta = s1->time - s0->time;
+
+          /* Too close for a reliable velocity or too old to still be moving */
+          if (delta < RESAMPLER_MIN_DELTA || delta > RESAMPLER_MAX_DELTA)
+               goto latest;
+
+          target = MIN( target, s1->time + MIN( delta / 2, RESAMPLER_MAX_PREDICT ) );
+     }
+     else {
+          for (n=1; n<resampler->num_samples; n++) {
+               s0 = RESAMPLER_SAMPLE( resampler, n );
+
+               if (s0->time <= target)
+                    break;
+
+               s1 = s0;
+          }
+
+          /* Older than all samples */
+          if (n == resampler->num_samples)
+               goto latest;
+
+          delta = s1->time - s0->time;
+     }
+
+     D_ASSERT( delta > 0 );
+
+     *ret_x = s0->x + (long long) (s1->x - s0->x) * (target - s0->time) / delta;
+     *ret_y = s0->y + (long long) (s1->y - s0->y) * (target - s0->time) / delta;
+
+     D_DEBUG_AT( Core_InputResampler, "  -> %4d,%4d at %lld us from latest\n", *ret_x, *ret_y,
+                 target - RESAMPLER_SAMPLE( resampler, 0 )->time );
+
+     resampler->last_target = target;
+
+     return;
+
+
+latest:
+     s1 = RESAMPLER_SAMPLE( resampler, 0 );
+
+     *ret_x = s1->x;
+     *ret_y = s1->y;
+
+     resampler->last_target = MAX( resampler->last_target, s1->time );
+}
+
+/*
+ * Writes the events moving the delivered position to the given one.
+ */
+static int
+resampler_events( CoreInputResampler *resampler,
+                  int                 x,
+                  int                 y,
+                  DFBInputEvent      *ret_events )
+{
+     int i;
+     int num          = 0;
+     int position[2]  = { x, y };
+     int delivered[2] = { resampler->x, resampler->y };
+
+     for (i=0; i<2; i++) {
+          DFBInputEvent *event;
+
+          if (!resampler->has_axis[i] || position[i] == delivered[i])
+               continue;
+
+          event = &ret_events[num++];
+
+          *event = resampler->axis[i];
+
+          event->flags     &= ~DIEF_FOLLOW;
+          event->timestamp  = resampler->timestamp;
+
+          if (resampler->relative)
+               event->axisrel = position[i] - delivered[i];
+          else
+               event->axisabs = position[i];
+     }
+
+     if (num == 2)
+          ret_events[0].flags |= DIEF_FOLLOW;
+
+     resampler->x = x;
+     resampler->y = y;
+
+     return num;
+}
+
+static void *
+resampler_thread( DirectThread *thread,
+                  void         *arg )
+{
+     CoreInputResampler *resampler = arg;
+
+     D_MAGIC_ASSERT( resampler, CoreInputResampler );
+
+     direct_mutex_lock( &resampler->lock );
+
+     while (!resampler->stop) {
+          long long       now;
+          long long       retrace;
+          long long       interval;
+          int             x, y, num;
+          DFBInputEvent   events[CORE_INPUT_RESAMPLER_EVENTS];
+          ResamplerSample *latest;
+
+          if (resampler->settled) {
+               resampler->idle = true;
+
+               direct_waitqueue_wait( &resampler->wq, &resampler->lock );
+
+               resampler->idle = false;
+               continue;
+          }
+
+          now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+          /* Nothing displayed yet, assume a retrace grid of the primary screen starting at zero */
+          retrace = DisplayTask_PredictRetrace( now, &interval );
+          if (!retrace) {
+               if (dfb_screen_get_frame_interval( dfb_layer_screen( dfb_layer_at( DLID_PRIMARY ) ), &interval ) ||
+                   interval <= 0)
+                    interval = 16666;
+
+               retrace = now - now % interval + interval;
+          }
+
+          if (direct_waitqueue_wait_timeout( &resampler->wq, &resampler->lock, retrace - now ) != DR_TIMEOUT)
+               continue;
+
+          latest = RESAMPLER_SAMPLE( resampler, 0 );
+
+          /* New samples are resampled, otherwise the latest one is delivered to settle on it */
+          if (resampler->pending)
+               resampler_position( resampler, retrace - dfb_config->input_resample_offset, &x, &y );
+          else {
+               x = latest->x;
+               y = latest->y;
+
+               resampler->last_target = MAX( resampler->last_target, latest->time );
+          }
+
+          num = resampler_events( resampler, x, y, events );
+
+          resampler->pending = false;
+          resampler->settled = (x == latest->x && y == latest->y);
+
+          D_DEBUG_AT( Core_InputResampler, "  -> device %u: %d events for retrace in %lld us (interval %lld)%s\n",
+                      resampler->device_id, num, retrace - direct_clock_get_time( DIRECT_CLOCK_MONOTONIC ),
+                      interval, resampler->settled ? ", settled" : "" );
+
+          /* Dispatched while locked, so that events flushed by the device cannot overtake these */
+          if (num)
+               resampler->dispatch( resampler->ctx, events, num );
+     }
+
+     direct_mutex_unlock( &resampler->lock );
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
+DFBResult
+CoreInputResampler_Create( DFBInputDeviceID             device_id,
+                           CoreInputResamplerDispatch   dispatch,
+                           void                        *ctx,
+                           CoreInputResampler         **ret_resampler )
+{
+     CoreInputResampler *resampler;
+
+     D_DEBUG_AT( Core_InputResampler, "%s( %u )\n", __FUNCTION__, device_id );
+
+     D_ASSERT( dispatch != NULL );
+     D_ASSERT( ret_resampler != NULL );
+
+     resampler = D_CALLOC( 1, sizeof(CoreInputResampler) );
+     if (!resampler)
+          return D_OOM();
+
+     resampler->device_id = device_id;
+     resampler->dispatch  = dispatch;
+     resampler->ctx       = ctx;
+     resampler->settled   = true;
+
+     direct_mutex_init( &resampler->lock );
+     direct_waitqueue_init( &resampler->wq );
+
+     D_MAGIC_SET( resampler, CoreInputResampler );
+
+     resampler->thread = direct_thread_create( DTT_INPUT, resampler_thread, resampler, "Input Resampler" );
+     if (!resampler->thread) {
+          D_MAGIC_CLEAR( resampler );
+
+          direct_waitqueue_deinit( &resampler->wq );
+          direct_mutex_deinit( &resampler->lock );
+
+          D_FREE( resampler );
+
+          return DFB_INIT;
+     }
+
+     *ret_resampler = resampler;
+
+     return DFB_OK;
+}
+
+DFBResult
+CoreInputResampler_Destroy( CoreInputResampler *resampler )
+{
+     D_DEBUG_AT( Core_InputResampler, "%s( %p )\n", __FUNCTION__, resampler );
+
+     D_MAGIC_ASSERT( resampler, CoreInputResampler );
+
+     direct_mutex_lock( &resampler->lock );
+
+     resampler->stop = true;
+
+     direct_waitqueue_broadcast( &resampler->wq );
+
+     direct_mutex_unlock( &resampler->lock );
+
+     direct_thread_join( resampler->thread );
+     direct_thread_destroy( resampler->thread );
+
+     direct_waitqueue_deinit( &resampler->wq );
+     direct_mutex_deinit( &resampler->lock );
+
+     D_MAGIC_CLEAR( resampler );
+
+     D_FREE( resampler );
+
+     return DFB_OK;
+}
+
+bool
+CoreInputResampler_AddEvent( CoreInputResampler  *resampler,
+                             const DFBInputEvent *event )
+{
+     int  index;
+     bool relative;
+
+     D_MAGIC_ASSERT( resampler, CoreInputResampler );
+     D_ASSERT( event != NULL );
+
+     if (event->type != DIET_AXISMOTION)
+          return false;
+
+     switch (event->axis) {
+          case DIAI_X:
+               index = 0;
+               break;
+
+          case DIAI_Y:
+               index = 1;
+               break;
+
+          default:
+               return false;
+     }
+
+     if (event->flags & DIEF_AXISREL)
+          relative = true;
+     else if (event->flags & DIEF_AXISABS)
+          relative = false;
+     else
+          return false;
+
+     direct_mutex_lock( &resampler->lock );
+
+     /* Devices hardly ever switch, start over without delivering what is left */
+     if (relative != resampler->relative) {
+          D_DEBUG_AT( Core_InputResampler, "  -> device %u: switching to %s motion\n",
+                      resampler->device_id, relative ? "relative" : "absolute" );
+
+          resampler->relative    = relative;
+          resampler->has_axis[0] = false;
+          resampler->has_axis[1] = false;
+          resampler->num_samples = 0;
+          resampler->pending     = false;
+          resampler->settled     = true;
+          resampler->x           = 0;
+          resampler->y           = 0;
+          resampler->current.x   = 0;
+          resampler->current.y   = 0;
+     }
+
+     resampler->axis[index]     = *event;
+     resampler->has_axis[index] = true;
+     resampler->timestamp       = event->timestamp;
+
+     if (index)
+          resampler->current.y = relative ? resampler->current.y + event->axisrel : event->axisabs;
+     else
+          resampler->current.x = relative ? resampler->current.x + event->axisrel : event->axisabs;
+
+     resampler->current.time = resampler_event_time( event );
+     resampler->incomplete   = true;
+
+     if (!(event->flags & DIEF_FOLLOW))
+          resampler_commit( resampler );
+
+     direct_mutex_unlock( &resampler->lock );
+
+     return true;
+}
+
+int
+CoreInputResampler_Flush( CoreInputResampler *resampler,
+                          DFBInputEvent      *ret_events )
+{
+     int              num = 0;
+     ResamplerSample *latest;
+
+     D_MAGIC_ASSERT( resampler, CoreInputResampler );
+     D_ASSERT( ret_events != NULL );
+
+     direct_mutex_lock( &resampler->lock );
+
+     resampler_commit( resampler );
+
+     if (!resampler->settled) {
+          latest = RESAMPLER_SAMPLE( resampler, 0 );
+
+          num = resampler_events( resampler, latest->x, latest->y, ret_events );
+
+          resampler->last_target = MAX( resampler->last_target, latest->time );
+          resampler->pending     = false;
+          resampler->settled     = true;
+     }
+
+     direct_mutex_unlock( &resampler->lock );
+
+     return num;
+}
@@ -0,0 +1,77 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#ifndef __CORE__INPUT_RESAMPLER_H__
+#define __CORE__INPUT_RESAMPLER_H__
+
+#include <directfb.h>
+
+/*
+ * Pointer motion resampling
+ *
+ * Absolute or relative X/Y motion of a device is collected with the event timestamps and delivered once per display
+ * frame, right at the retrace predicted by the display pacing of the primary layer. The position is interpolated
+ * at the configured offset before that retrace, or extrapolated a little beyond the latest event if the offset is
+ * negative or events are sparse. Any other event of the device first flushes the latest raw position.
+ */
+
+#define CORE_INPUT_RESAMPLER_EVENTS  2  /* maximum number of events returned by CoreInputResampler_Flush() */
+
+typedef struct __CoreDFB__CoreInputResampler CoreInputResampler;
+
+typedef void (*CoreInputResamplerDispatch)( void          *ctx,
+                                            DFBInputEvent *events,
+                                            int            num );
+
+
+DFBResult CoreInputResampler_Create  ( DFBInputDeviceID             device_id,
+                                       CoreInputResamplerDispatch   dispatch,
+                                       void                        *ctx,
+                                       CoreInputResampler         **ret_resampler );
+
+DFBResult CoreInputResampler_Destroy ( CoreInputResampler          *resampler );
+
+/*
+ * Takes the event if it is X/Y axis motion, returns false otherwise.
+ */
+bool      CoreInputResampler_AddEvent( CoreInputResampler          *resampler,
+                                       const DFBInputEvent         *event );
+
+/*
+ * Writes the latest raw position if it has not been delivered yet, returns the number of events.
+ */
+int       CoreInputResampler_Flush   ( CoreInputResampler          *resampler,
+                                       DFBInputEvent               *ret_events );
+
+
+#endif
@@ -58,6 +58,7 @@
 #include <core/CoreSurface.h>
 #include <core/CoreSurfaceClient.h>
 #include <core/Debug.h>
+#include <core/DisplayTask.h>
 #include <core/Task.h>
 
 #include <gfx/util.h>
@@ -109,6 +110,9 @@ region_destructor( FusionObject *object, bool zombie, void *ctx )
      if (region->display_tasks)
           TaskList_Delete( region->display_tasks );
 
+     if (region->display_pacing)
+          DisplayPacing_Delete( region->display_pacing );
+
      /* Remove the region from the context. */
      ret = fusion_object_lookup( core_dfb->shared->layer_context_pool, region->context_id, (FusionObject**) &context );
      if (ret == DFB_OK)
@@ -167,7 +171,8 @@ static ReactionResult surface_react( const void *msg_data,
           region->surface_flip_count = evt->flip_count;
 
           if (!CoreLayerRegion_FlipUpdate2( region, &evt->update, &evt->update_right,
-                                            DSFLIP_ONSYNC | DSFLIP_UPDATE, evt->flip_count, evt->time_stamp ))
+                                            DSFLIP_ONSYNC | DSFLIP_UPDATE | (evt->flip_flags & DSFLIP_MAILBOX),
+                                            evt->flip_count, evt->time_stamp ))
                CoreSurfaceClient_FrameAck( region->surface_client, evt->flip_count );
      }
      else if (evt->type == DSEVT_DESTROYED)
@@ -229,8 +234,10 @@ dfb_layer_region_create( CoreLayerContext  *context,
      else
           region->surface_accessor = CSAID_LAYER0 + region->layer_id;
 
-     if (dfb_config->task_manager)
-          region->display_tasks = TaskList_New( true );
+     if (dfb_config->task_manager) {
+          region->display_tasks  = TaskList_New( true );
+          region->display_pacing = DisplayPacing_New();
+     }
 
      CoreLayerRegion_Init_Dispatch( layer->core, region, &region->call );
 
@@ -646,7 +653,7 @@ dfb_layer_region_flip_update( CoreLayerRegion     *region,
                          D_DEBUG_AT( Core_Layers, "  -> Flipping region not using driver...\n" );
 
                          /* Just do the hardware independent work. */
-                         dfb_surface_flip_buffers( surface, false );
+                         dfb_surface_flip_buffers2( surface, false, flags & DSFLIP_MAILBOX );
                     }
                     break;
                }
@@ -874,7 +881,7 @@ dfb_layer_region_flip_update_stereo( CoreLayerRegion     *region,
                          D_DEBUG_AT( Core_Layers, "  -> Flipping region not using driver...\n" );
 
                          /* Just do the hardware independent work. */
-                         dfb_surface_flip_buffers( surface, false );
+                         dfb_surface_flip_buffers2( surface, false, flags & DSFLIP_MAILBOX );
                     }
                     break;
                }
@@ -91,6 +91,8 @@ typedef struct {
      FusionCall                         call;
 
      DFBSurfacePixelFormat              pixelformat;
+
+     long long                          latency_origin;   /* oldest input event time of window flips not displayed yet */
 } CoreLayerShared;
 
 struct __DFB_CoreLayer {
@@ -213,6 +215,8 @@ struct __DFB_CoreLayerRegion {
      DFBDisplayLayerID           layer_id;
 
      u32                         surface_flip_count;
+
+     DFB_DisplayPacing          *display_pacing;
 };
 
 
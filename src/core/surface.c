@@ -41,6 +41,7 @@
 #include <direct/debug.h>
 
 #include <core/core.h>
+#include <core/DisplayTask.h>
 #include <core/palette.h>
 #include <core/surface.h>
 #include <core/surface_pool.h>
@@ -466,6 +467,8 @@ dfb_surface_create( CoreDFB                  *core,
      }
      dfb_surface_set_stereo_eye(surface, DSSE_LEFT);
 
+     surface->display_index = -1;
+
      dfb_surface_unlock( surface );
 
 
@@ -644,8 +647,13 @@ dfb_surface_notify_display2( CoreSurface     *surface,
           }
 
           layer->display_task_onscreen = task;
+
+          if (task)
+               DisplayTask_Displayed( task );
      }
 
+     surface->display_index = index;
+
 //     notification.flags   = CSNF_DISPLAY;
 //     notification.surface = surface;
 //     notification.index   = index;
@@ -737,10 +745,16 @@ dfb_surface_flip( CoreSurface *surface, bool swap )
 
 DFBResult
 dfb_surface_flip_buffers( CoreSurface *surface, bool swap )
+{
+     return dfb_surface_flip_buffers2( surface, swap, false );
+}
+
+DFBResult
+dfb_surface_flip_buffers2( CoreSurface *surface, bool swap, bool mailbox )
 {
      unsigned int back, front;
 
-     D_DEBUG_AT( Core_Surface, "%s( %p, %sswap )\n", __FUNCTION__, surface, swap ? "" : "NO " );
+     D_DEBUG_AT( Core_Surface, "%s( %p, %sswap%s )\n", __FUNCTION__, surface, swap ? "" : "NO ", mailbox ? ", mailbox" : "" );
 
      D_MAGIC_ASSERT( surface, CoreSurface );
 
@@ -764,8 +778,27 @@ dfb_surface_flip_buffers( CoreSurface *surface, bool swap )
           surface->buffer_indices[back] = surface->buffer_indices[front];
           surface->buffer_indices[front] = tmp;
      }
-     else
+     else {
+          unsigned int idle = (surface->flips + CSBR_IDLE) % surface->num_buffers;
+
+          /*
+           * Mailbox mode: if the current front buffer has not been shown yet while the idle one is on
+           * screen, the regular rotation would hand out the displayed buffer as the next back buffer.
+           * Exchange both, so the undisplayed frame gets overwritten instead of waiting for the display.
+           */
+          if (mailbox && surface->num_buffers == 3 && surface->display_index >= 0 &&
+              surface->buffer_indices[front] != surface->display_index &&
+              surface->buffer_indices[idle]  == surface->display_index)
+          {
+               int tmp = surface->buffer_indices[idle];
+               surface->buffer_indices[idle] = surface->buffer_indices[front];
+               surface->buffer_indices[front] = tmp;
+
+               D_DEBUG_AT( Core_Surface, "  -> mailbox, reusing undisplayed buffer %d\n", surface->buffer_indices[idle] );
+          }
+
           surface->flips++;
+     }
 
      D_DEBUG_AT( Core_Surface, "  -> flips %d <-----------------\n", surface->flips );
 
@@ -1030,6 +1063,8 @@ dfb_surface_reconfig( CoreSurface             *surface,
      }
      dfb_surface_set_stereo_eye(surface, DSSE_LEFT);
 
+     surface->display_index = -1;
+
      dfb_surface_notify( surface, CSNF_SIZEFORMAT );
 
      if (dfb_config->surface_clear)
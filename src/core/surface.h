@@ -269,6 +269,8 @@ struct __DFB_CoreSurface
      FusionHash              *frames;
 
      DirectSerial             config_serial;
+
+     int                      display_index;   /* buffer index last shown by the layer, -1 if unknown */
 };
 
 #define CORE_SURFACE_ASSERT(surface)                                                           \
@@ -340,6 +342,14 @@ DFBResult dfb_surface_flip          ( CoreSurface                  *surface,
 DFBResult dfb_surface_flip_buffers  ( CoreSurface                  *surface,
                                       bool                          swap );
 
+/*
+ * Like dfb_surface_flip_buffers(), but in mailbox mode a triple buffered surface never hands out
+ * the buffer being displayed as the new back buffer, reusing an undisplayed front buffer instead.
+ */
+DFBResult dfb_surface_flip_buffers2 ( CoreSurface                  *surface,
+                                      bool                          swap,
+                                      bool                          mailbox );
+
 DFBResult dfb_surface_dispatch_event( CoreSurface                  *surface,
                                       DFBSurfaceEventType           type );
 
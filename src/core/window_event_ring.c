@@ -0,0 +1,182 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#include <config.h>
+
+#include <directfb.h>
+
+#include <direct/atomic.h>
+#include <direct/debug.h>
+#include <direct/messages.h>
+#include <direct/system.h>
+
+#include <fusion/fusion.h>
+#include <fusion/shmalloc.h>
+
+#include <core/core.h>
+#include <core/window_event_ring.h>
+
+
+D_DEBUG_DOMAIN( Core_WindowEventRing, "Core/Windows/EventRing", "DirectFB Core Window Event Ring" );
+
+/**********************************************************************************************************************/
+
+DFBResult
+dfb_window_event_ring_create( CoreDFB              *core,
+                              unsigned int          size,
+                              CoreWindowEventRing **ret_ring )
+{
+     CoreWindowEventRing *ring;
+     unsigned int         num = 16;
+
+     D_ASSERT( ret_ring != NULL );
+
+     while (num < size)
+          num <<= 1;
+
+     D_DEBUG_AT( Core_WindowEventRing, "%s( %u ) <- %u events\n", __FUNCTION__, size, num );
+
+     ring = SHCALLOC( dfb_core_shmpool( core ), 1, sizeof(CoreWindowEventRing) + (num - 1) * sizeof(DFBWindowEvent) );
+     if (!ring)
+          return D_OOSHM();
+
+     ring->owner = fusion_id( dfb_core_world( core ) );
+     ring->size  = num;
+
+     D_MAGIC_SET( ring, CoreWindowEventRing );
+
+     *ret_ring = ring;
+
+     return DFB_OK;
+}
+
+void
+dfb_window_event_ring_destroy( CoreDFB             *core,
+                               CoreWindowEventRing *ring )
+{
+     D_DEBUG_AT( Core_WindowEventRing, "%s( %p )\n", __FUNCTION__, ring );
+
+     D_MAGIC_ASSERT( ring, CoreWindowEventRing );
+
+     if (ring->dropped)
+          D_DEBUG_AT( Core_WindowEventRing, "  -> %u events dropped\n", ring->dropped );
+
+     D_MAGIC_CLEAR( ring );
+
+     SHFREE( dfb_core_shmpool( core ), ring );
+}
+
+bool
+dfb_window_event_ring_write( CoreWindowEventRing  *ring,
+                             const DFBWindowEvent *event )
+{
+     unsigned int head;
+
+     D_MAGIC_ASSERT( ring, CoreWindowEventRing );
+     D_ASSERT( event != NULL );
+
+     head = ring->head;
+
+     if (head - ring->tail == ring->size) {
+          if (!ring->dropped++)
+               D_WARN( "window event ring of fusionee %lu is full", ring->owner );
+
+          return false;
+     }
+
+     ring->events[head & (ring->size - 1)] = *event;
+
+     /* Publish the event before checking for a sleeping reader. */
+     D_SYNC_ADD_AND_FETCH( &ring->head, 1 );
+
+     if (D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->waiting, 1, 0 ))
+          direct_futex_wake( &ring->waiting, 1 );
+
+     return true;
+}
+
+int
+dfb_window_event_ring_read( CoreWindowEventRing *ring,
+                            DFBWindowEvent      *ret_events,
+                            int                  max )
+{
+     int          num = 0;
+     unsigned int head;
+     unsigned int tail;
+
+     D_MAGIC_ASSERT( ring, CoreWindowEventRing );
+     D_ASSERT( ret_events != NULL );
+     D_ASSERT( max > 0 );
+
+     tail = ring->tail;
+
+     while (!ring->stop && ring->head == tail) {
+          /* Announce the wait, then look again in case the writer did not see it. */
+          D_SYNC_BOOL_COMPARE_AND_SWAP( &ring->waiting, 0, 1 );
+
+          if (ring->stop || ring->head != tail) {
+               ring->waiting = 0;
+               break;
+          }
+
+          direct_futex_wait( &ring->waiting, 1 );
+     }
+
+     if (ring->stop)
+          return 0;
+
+     /* Read the index with a barrier, so that the events are not read before it. */
+     head = D_SYNC_ADD_AND_FETCH( &ring->head, 0 );
+
+     while (num < max && head != tail)
+          ret_events[num++] = ring->events[tail++ & (ring->size - 1)];
+
+     /* Free the slots only after copying the events. */
+     D_SYNC_ADD_AND_FETCH( &ring->tail, num );
+
+     return num;
+}
+
+void
+dfb_window_event_ring_stop( CoreWindowEventRing *ring )
+{
+     D_DEBUG_AT( Core_WindowEventRing, "%s( %p )\n", __FUNCTION__, ring );
+
+     D_MAGIC_ASSERT( ring, CoreWindowEventRing );
+
+     ring->stop = 1;
+
+     D_SYNC_FETCH_AND_CLEAR( &ring->waiting );
+
+     direct_futex_wake( &ring->waiting, 1 );
+}
@@ -0,0 +1,108 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#ifndef __CORE__WINDOW_EVENT_RING_H__
+#define __CORE__WINDOW_EVENT_RING_H__
+
+#include <directfb.h>
+
+#include <core/coretypes.h>
+
+#include <fusion/types.h>
+
+/*
+ * Window events for a slave's event buffer in shared memory
+ *
+ * The master writes each event of the windows the ring is attached to (see dfb_window_attach_event_ring()),
+ * the owning slave reads them without a Fusion dispatch per event. Both sides only advance their own index,
+ * the reader sleeps on a futex that the writer wakes up if needed. Events are dropped while the ring is full,
+ * except for CORE_WINDOW_RING_LIFECYCLE_EVENTS which are dispatched via CORE_WINDOW_RING_CHANNEL instead.
+ */
+struct __DFB_CoreWindowEventRing {
+     int                 magic;
+
+     FusionID            owner;        /* fusionee reading the ring */
+
+     unsigned int        size;         /* number of events, a power of two */
+     unsigned int        head;         /* next event to write, advanced by the master */
+     unsigned int        tail;         /* next event to read, advanced by the owner */
+     unsigned int        dropped;      /* events lost while the ring was full */
+
+     int                 waiting;      /* futex, set by the owner before sleeping */
+     int                 stop;         /* reader is asked to return */
+
+     DFBWindowEvent      events[1];
+};
+
+/*
+ * Window events never dropped, the owner keeps a window reference until it sees DWET_DESTROYED.
+ */
+#define CORE_WINDOW_RING_LIFECYCLE_EVENTS  (DWET_CLOSE | DWET_DESTROYED)
+
+/*
+ * Window reactor channel for events that did not fit into a ring, see CoreWindowEventRingOverflow.
+ */
+#define CORE_WINDOW_RING_CHANNEL           1
+
+typedef struct {
+     CoreWindowEventRing *ring;            /* ring that was full, only its owner queues the event */
+     DFBWindowEvent       event;
+} CoreWindowEventRingOverflow;
+
+
+DFBResult dfb_window_event_ring_create ( CoreDFB                *core,
+                                         unsigned int            size,
+                                         CoreWindowEventRing   **ret_ring );
+
+void      dfb_window_event_ring_destroy( CoreDFB                *core,
+                                         CoreWindowEventRing    *ring );
+
+/*
+ * Called by the master, returns false if the ring is full.
+ * Lifecycle events are dispatched via CORE_WINDOW_RING_CHANNEL by the caller then.
+ */
+bool      dfb_window_event_ring_write  ( CoreWindowEventRing    *ring,
+                                         const DFBWindowEvent   *event );
+
+/*
+ * Called by the owner, waits for events unless some are available and returns up to max events.
+ * Returns 0 after dfb_window_event_ring_stop().
+ */
+int       dfb_window_event_ring_read   ( CoreWindowEventRing    *ring,
+                                         DFBWindowEvent         *ret_events,
+                                         int                     max );
+
+void      dfb_window_event_ring_stop   ( CoreWindowEventRing    *ring );
+
+
+#endif
@@ -55,10 +55,12 @@
 #include <core/gfxcard.h>
 #include <core/input.h>
 #include <core/palette.h>
+#include <core/screen.h>
 #include <core/state.h>
 #include <core/system.h>
 #include <core/windows.h>
 #include <core/windowstack.h>
+#include <core/window_event_ring.h>
 #include <core/wm.h>
 
 #include <core/CoreLayerRegion.h>
@@ -70,9 +72,12 @@
 #include <misc/conf.h>
 #include <misc/util.h>
 
+#include <direct/atomic.h>
+#include <direct/clock.h>
 #include <direct/debug.h>
 #include <direct/mem.h>
 #include <direct/messages.h>
+#include <direct/thread.h>
 #include <direct/trace.h>
 #include <direct/util.h>
 
@@ -94,6 +99,27 @@ typedef struct {
      GlobalReaction   reaction;
 } StackDevice;
 
+typedef struct {
+     DirectLink       link;
+
+     CoreWindow      *window;       /* referenced while queued */
+     long long        deadline;
+} ThrottledWindow;
+
+/*
+ * Forwards throttled window updates to the window manager once they are due (master only).
+ */
+static struct {
+     DirectMutex      lock;
+     DirectWaitQueue  wq;
+     DirectThread    *thread;
+     DirectLink      *windows;
+     bool             stop;
+} throttle = {
+     .lock = DIRECT_MUTEX_INITIALIZER( throttle.lock ),
+     .wq   = DIRECT_WAITQUEUE_INITIALIZER( throttle.wq )
+};
+
 /**************************************************************************************************/
 
 static bool
@@ -161,6 +187,8 @@ window_destructor( FusionObject *object, bool zombie, void *ctx )
           fusion_vector_destroy( &window->subwindows );
      }
 
+     fusion_vector_destroy( &window->event_rings );
+
      dfb_windowstack_unlock( stack );
 
      /* Unlink the primary region of the context. */
@@ -336,6 +364,284 @@ init_subwindow( CoreWindow      *window,
      return DFB_OK;
 }
 
+/*
+ * Minimum time between two updates of the window being forwarded to the window manager, 0 for no limit.
+ */
+static long long
+window_update_interval( CoreWindow *window )
+{
+     long long    interval = 0;
+     unsigned int rate     = window->config.max_update_rate;
+
+     if (!rate)
+          rate = dfb_config->window_max_update_rate;
+
+     if (dfb_config->window_update_throttle)
+          dfb_screen_get_frame_interval( dfb_layer_screen( dfb_layer_at( window->stack->context->layer_id ) ),
+                                         &interval );
+
+     if (rate && 1000000LL / rate > interval)
+          interval = 1000000LL / rate;
+
+     return interval;
+}
+
+static void window_throttle_flush( CoreWindow *window );
+
+/*
+ * Hands the input event time of the flips being forwarded to the display task created next for the layer.
+ */
+static void
+window_latency_to_layer( CoreWindow *window )
+{
+     CoreLayerShared *shared;
+     long long        origin = window->flip_latency_origin;
+
+     if (!origin)
+          return;
+
+     window->flip_latency_origin = 0;
+
+     shared = dfb_layer_at( window->stack->context->layer_id )->shared;
+
+     if (!shared->latency_origin || shared->latency_origin > origin)
+          shared->latency_origin = origin;
+}
+
+static void *
+window_throttle_loop( DirectThread *thread,
+                      void         *arg )
+{
+     D_DEBUG_AT( Core_Windows, "%s()\n", __FUNCTION__ );
+
+     direct_mutex_lock( &throttle.lock );
+
+     while (!throttle.stop) {
+          long long        now  = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+          ThrottledWindow *next = NULL;
+          ThrottledWindow *entry;
+
+          direct_list_foreach (entry, throttle.windows) {
+               if (!next || entry->deadline < next->deadline)
+                    next = entry;
+          }
+
+          if (!next) {
+               direct_waitqueue_wait( &throttle.wq, &throttle.lock );
+               continue;
+          }
+
+          if (next->deadline > now) {
+               direct_waitqueue_wait_timeout( &throttle.wq, &throttle.lock, next->deadline - now );
+               continue;
+          }
+
+          direct_list_remove( &throttle.windows, &next->link );
+
+          direct_mutex_unlock( &throttle.lock );
+
+          window_throttle_flush( next->window );
+
+          D_FREE( next );
+
+          direct_mutex_lock( &throttle.lock );
+     }
+
+     direct_mutex_unlock( &throttle.lock );
+
+     return NULL;
+}
+
+static void
+window_throttle_shutdown( void *ctx,
+                          int   emergency )
+{
+     ThrottledWindow *entry, *next;
+
+     D_DEBUG_AT( Core_Windows, "%s()\n", __FUNCTION__ );
+
+     direct_mutex_lock( &throttle.lock );
+
+     throttle.stop = true;
+
+     direct_waitqueue_broadcast( &throttle.wq );
+
+     direct_mutex_unlock( &throttle.lock );
+
+     direct_thread_join( throttle.thread );
+     direct_thread_destroy( throttle.thread );
+
+     direct_list_foreach_safe (entry, next, throttle.windows) {
+          dfb_window_unref( entry->window );
+
+          D_FREE( entry );
+     }
+
+     throttle.thread  = NULL;
+     throttle.windows = NULL;
+     throttle.stop    = false;
+}
+
+/*
+ * Queues the window for the throttle thread, which takes over the reference held by the caller on success.
+ */
+static DFBResult
+window_throttle_queue( CoreWindow *window,
+                       long long   deadline )
+{
+     ThrottledWindow *entry;
+
+     entry = D_CALLOC( 1, sizeof(ThrottledWindow) );
+     if (!entry)
+          return D_OOM();
+
+     entry->window   = window;
+     entry->deadline = deadline;
+
+     direct_mutex_lock( &throttle.lock );
+
+     if (!throttle.thread) {
+          throttle.thread = direct_thread_create( DTT_DEFAULT, window_throttle_loop, NULL, "Window Throttle" );
+          if (!throttle.thread) {
+               direct_mutex_unlock( &throttle.lock );
+
+               D_FREE( entry );
+
+               /* The caller forwards the update right away. */
+               return DFB_FAILURE;
+          }
+
+          dfb_core_cleanup_add( dfb_layer_at( window->stack->context->layer_id )->core,
+                                window_throttle_shutdown, NULL, false );
+     }
+
+     window->updates.queued = true;
+
+     direct_list_append( &throttle.windows, &entry->link );
+
+     direct_waitqueue_broadcast( &throttle.wq );
+
+     direct_mutex_unlock( &throttle.lock );
+
+     return DFB_OK;
+}
+
+static void
+window_throttle_flush( CoreWindow *window )
+{
+     CoreWindowStack *stack = window->stack;
+     long long        now;
+
+     D_MAGIC_ASSERT( window, CoreWindow );
+
+     if (dfb_windowstack_lock( stack )) {
+          dfb_window_unref( window );
+          return;
+     }
+
+     now = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+
+     /* Deferred again after being forwarded meanwhile, keep the reference for the new deadline */
+     if (window->updates.deadline > now && !DFB_WINDOW_DESTROYED( window ) &&
+         window_throttle_queue( window, window->updates.deadline ) == DFB_OK)
+     {
+          dfb_windowstack_unlock( stack );
+          return;
+     }
+
+     window->updates.queued = false;
+
+     if (window->updates.deadline && !DFB_WINDOW_DESTROYED( window )) {
+          D_DEBUG_AT( Core_Windows, "%s( %p ) <- forwarding throttled update %d,%d-%dx%d, %lld us late\n", __FUNCTION__,
+                      window, DFB_RECTANGLE_VALS_FROM_REGION( &window->updates.left ), now - window->updates.deadline );
+
+          window->updates.deadline = 0;
+          window->updates.last     = now;
+          window->updates.forwarded++;
+
+          window_latency_to_layer( window );
+
+          dfb_wm_update_window( window, &window->updates.left, &window->updates.right, DSFLIP_NONE );
+
+          CoreSurfaceClient_FrameAck( window->surface_client, window->updates.flip_count );
+     }
+
+     dfb_windowstack_unlock( stack );
+
+     dfb_window_unref( window );
+}
+
+/*
+ * Merges the update into the pending one if the window updates faster than allowed.
+ *
+ * Returns true if the update has been deferred, in which case the frame is acknowledged once it is forwarded,
+ * otherwise the update to forward now (including a pending one) is returned.
+ */
+static bool
+window_throttle_update( CoreWindow            *window,
+                        const DFBSurfaceEvent *evt,
+                        DFBRegion             *ret_left,
+                        DFBRegion             *ret_right )
+{
+     long long now      = direct_clock_get_time( DIRECT_CLOCK_MONOTONIC );
+     long long interval = window_update_interval( window );
+
+     *ret_left  = evt->update;
+     *ret_right = evt->update_right;
+
+     if (window->updates.deadline) {
+          dfb_region_region_union( &window->updates.left, &evt->update );
+          dfb_region_region_union( &window->updates.right, &evt->update_right );
+
+          /* A newer frame replaces the pending one, whereas partial updates of the same frame are just merged */
+          if (window->updates.flip_count != evt->flip_count)
+               window->updates.dropped++;
+          else
+               window->updates.merged++;
+
+          window->updates.flip_count = evt->flip_count;
+
+          if (now < window->updates.deadline)
+               return true;
+
+          /* Due already, forward it right away */
+          *ret_left  = window->updates.left;
+          *ret_right = window->updates.right;
+
+          window->updates.deadline = 0;
+     }
+     else if (interval && now - window->updates.last < interval) {
+          D_DEBUG_AT( Core_Windows, "  -> throttling update, %lld us since the last one (interval %lld)\n",
+                      now - window->updates.last, interval );
+
+          /* Still queued from an update forwarded early, otherwise the frame is only acknowledged if it gets queued */
+          if (window->updates.queued) {
+               window->updates.deadline = window->updates.last + interval;
+          }
+          else if (dfb_window_ref( window ) == DR_OK) {
+               if (window_throttle_queue( window, window->updates.last + interval ) == DFB_OK)
+                    window->updates.deadline = window->updates.last + interval;
+               else
+                    dfb_window_unref( window );
+          }
+
+          if (window->updates.deadline) {
+               window->updates.left       = evt->update;
+               window->updates.right      = evt->update_right;
+               window->updates.flip_count = evt->flip_count;
+
+               return true;
+          }
+
+          D_DEBUG_AT( Core_Windows, "  -> could not defer the update, forwarding it now\n" );
+     }
+
+     window->updates.last = now;
+     window->updates.forwarded++;
+
+     return false;
+}
+
 static ReactionResult
 window_surface_react( const void *msg_data,
                       void       *ctx )
@@ -373,9 +679,18 @@ window_surface_react( const void *msg_data,
           window->surface_flip_count = evt->flip_count;
 
           if (!dfb_config->single_window || fusion_vector_size( &window->stack->visible_windows ) != 1) {
+               DFBRegion left, right;
+
+               if (window_throttle_update( window, evt, &left, &right )) {
+                    dfb_windowstack_unlock( window->stack );
+                    return RS_OK;
+               }
+
                D_DEBUG_AT( Core_Windows, "  -> dispatching update to window manager\n" );
 
-               dfb_wm_update_window( window, &evt->update, &evt->update_right, DSFLIP_NONE );
+               window_latency_to_layer( window );
+
+               dfb_wm_update_window( window, &left, &right, DSFLIP_NONE );
           }
 
           CoreSurfaceClient_FrameAck( window->surface_client, evt->flip_count );
@@ -569,6 +884,8 @@ dfb_window_create( CoreWindowStack             *stack,
      if (desc->flags & DWDESC_RESOURCE_ID)
           window->resource_id = desc->resource_id;
 
+     fusion_vector_init( &window->event_rings, 2, stack->shmpool );
+
      D_MAGIC_SET( window, CoreWindow );
 
      ret = dfb_wm_preconfigure_window( stack, window );
@@ -1077,7 +1394,14 @@ dfb_window_set_config( CoreWindow             *window,
           return DFB_DESTROYED;
      }
 
-     ret = dfb_wm_set_window_config( window, config, flags );
+     /* Update throttling is done here, not by the window manager. */
+     if (flags & CWCF_MAX_UPDATE_RATE) {
+          window->config.max_update_rate = config->max_update_rate;
+
+          flags &= ~CWCF_MAX_UPDATE_RATE;
+     }
+
+     ret = flags ? dfb_wm_set_window_config( window, config, flags ) : DFB_OK;
 
      /* Unlock the window stack. */
      dfb_windowstack_unlock( stack );
@@ -1819,6 +2143,8 @@ dfb_window_repaint( CoreWindow          *window,
      if (!dfb_config->single_window || fusion_vector_size( &window->stack->visible_windows ) != 1) {
           D_DEBUG_AT( Core_Windows, "  -> dispatching update to window manager\n" );
 
+          window_latency_to_layer( window );
+
           ret = dfb_wm_update_window( window, left_region, right_region, flags );
      }
 
@@ -1912,13 +2238,209 @@ dfb_window_post_event( CoreWindow     *window,
      if (! (event->type & window->config.events))
           return;
 
-     gettimeofday( &event->timestamp, NULL );
+     if (dfb_config->latency_trace && window->stack && window->stack->latency_origin &&
+         (event->type & CORE_WINDOW_INPUT_EVENTS))
+     {
+          long long origin = window->stack->latency_origin;
+
+          /* Keep the time of the input event for the client and remember it for the next flip. */
+          event->timestamp.tv_sec  = origin / 1000000;
+          event->timestamp.tv_usec = origin % 1000000;
+
+          window->latency_origin = origin;
+
+          dfb_core_trace_latency( core_dfb, DLTS_WM, origin );
+     }
+     else
+          gettimeofday( &event->timestamp, NULL );
 
      event->clazz     = DFEC_WINDOW;
      event->window_id = window->id;
 
-     if (!core_window_filter( window, event ))
-          dfb_window_dispatch( window, event, dfb_window_globals );
+     if (!core_window_filter( window, event )) {
+          if (fusion_vector_has_elements( &window->event_rings )) {
+               int                  i;
+               CoreWindowEventRing *ring;
+
+               dfb_windowstack_lock( window->stack );
+
+               fusion_vector_foreach (ring, i, window->event_rings) {
+                    if (!dfb_window_event_ring_write( ring, event ) &&
+                        (event->type & CORE_WINDOW_RING_LIFECYCLE_EVENTS))
+                    {
+                         CoreWindowEventRingOverflow overflow;
+
+                         /* The owner would keep the window forever without its destruction event. */
+                         overflow.ring  = ring;
+                         overflow.event = *event;
+
+                         dfb_window_dispatch_channel( window, CORE_WINDOW_RING_CHANNEL,
+                                                      &overflow, sizeof(overflow), dfb_window_globals );
+                    }
+               }
+
+               dfb_windowstack_unlock( window->stack );
+          }
+
+          if (window->listeners > 0)
+               dfb_window_dispatch( window, event, dfb_window_globals );
+     }
+}
+
+DirectResult
+dfb_window_attach_listener( CoreWindow   *window,
+                            ReactionFunc  func,
+                            void         *ctx,
+                            Reaction     *reaction )
+{
+     DirectResult ret;
+
+     D_DEBUG_AT( Core_Windows, "%s( %p, %p, %p, %p )\n", __FUNCTION__, window, func, ctx, reaction );
+
+     D_MAGIC_ASSERT( window, CoreWindow );
+
+     ret = dfb_window_attach( window, func, ctx, reaction );
+     if (ret == DR_OK)
+          D_SYNC_ADD( &window->listeners, 1 );
+
+     return ret;
+}
+
+DirectResult
+dfb_window_detach_listener( CoreWindow *window,
+                            Reaction   *reaction )
+{
+     DirectResult ret;
+
+     D_DEBUG_AT( Core_Windows, "%s( %p, %p )\n", __FUNCTION__, window, reaction );
+
+     D_MAGIC_ASSERT( window, CoreWindow );
+
+     ret = dfb_window_detach( window, reaction );
+     if (ret == DR_OK)
+          D_SYNC_ADD( &window->listeners, -1 );
+
+     return ret;
+}
+
+DFBResult
+dfb_window_attach_event_ring( CoreWindow          *window,
+                              CoreWindowEventRing *ring )
+{
+     DFBResult ret;
+
+     D_DEBUG_AT( Core_Windows, "%s( %p, %p )\n", __FUNCTION__, window, ring );
+
+     D_MAGIC_ASSERT( window, CoreWindow );
+     D_MAGIC_ASSERT( ring, CoreWindowEventRing );
+
+     if (!window->stack)
+          return DFB_DESTROYED;
+
+     if (dfb_windowstack_lock( window->stack ))
+          return DFB_FUSION;
+
+     if (DFB_WINDOW_DESTROYED( window ))
+          ret = DFB_DESTROYED;
+     else
+          ret = fusion_vector_add( &window->event_rings, ring );
+
+     dfb_windowstack_unlock( window->stack );
+
+     return ret;
+}
+
+DFBResult
+dfb_window_detach_event_ring( CoreWindow          *window,
+                              CoreWindowEventRing *ring )
+{
+     int index;
+
+     D_DEBUG_AT( Core_Windows, "%s( %p, %p )\n", __FUNCTION__, window, ring );
+
+     D_MAGIC_ASSERT( window, CoreWindow );
+
+     if (!window->stack)
+          return DFB_DESTROYED;
+
+     if (dfb_windowstack_lock( window->stack ))
+          return DFB_FUSION;
+
+     index = fusion_vector_index_of( &window->event_rings, ring );
+     if (index >= 0)
+          fusion_vector_remove( &window->event_rings, index );
+
+     dfb_windowstack_unlock( window->stack );
+
+     return index >= 0 ? DFB_OK : DFB_ITEMNOTFOUND;
+}
+
+/*
+ * Collects the windows having event rings, without locking their stacks while the pool is locked.
+ */
+static bool
+ring_windows_callback( FusionObjectPool *pool,
+                       FusionObject     *object,
+                       void             *ctx )
+{
+     CoreWindow   *window  = (CoreWindow*) object;
+     FusionVector *windows = ctx;
+
+     if (object->state == FOS_ACTIVE && fusion_vector_has_elements( &window->event_rings ) &&
+         dfb_window_ref( window ) == DR_OK)
+          fusion_vector_add( windows, window );
+
+     return true;
+}
+
+void
+dfb_windows_dispose_event_rings( CoreDFB  *core,
+                                 FusionID  owner )
+{
+     int                  i, n;
+     FusionVector         windows;
+     FusionVector         rings;
+     CoreWindow          *window;
+     CoreWindowEventRing *ring;
+
+     D_DEBUG_AT( Core_Windows, "%s( %lu )\n", __FUNCTION__, owner );
+
+     D_MAGIC_ASSERT( core, CoreDFB );
+
+     fusion_vector_init( &windows, 8, NULL );
+     fusion_vector_init( &rings, 2, NULL );
+
+     fusion_object_pool_enum( core->shared->window_pool, ring_windows_callback, &windows );
+
+     fusion_vector_foreach (window, i, windows) {
+          if (window->stack && !dfb_windowstack_lock( window->stack )) {
+               for (n=fusion_vector_size( &window->event_rings ) - 1; n>=0; n--) {
+                    ring = fusion_vector_at( &window->event_rings, n );
+
+                    if (ring->owner != owner)
+                         continue;
+
+                    fusion_vector_remove( &window->event_rings, n );
+
+                    if (fusion_vector_index_of( &rings, ring ) < 0)
+                         fusion_vector_add( &rings, ring );
+               }
+
+               dfb_windowstack_unlock( window->stack );
+          }
+
+          dfb_window_unref( window );
+     }
+
+     /* No window writes to them anymore. */
+     fusion_vector_foreach (ring, i, rings) {
+          D_DEBUG_AT( Core_Windows, "  -> destroying ring %p of fusionee %lu\n", ring, owner );
+
+          dfb_window_event_ring_destroy( core, ring );
+     }
+
+     fusion_vector_destroy( &rings );
+     fusion_vector_destroy( &windows );
 }
 
 DFBResult
@@ -69,8 +69,15 @@ typedef enum {
 #define CWCF_DST_GEOMETRY          DWCONF_DST_GEOMETRY
 #define CWCF_ROTATION              DWCONF_ROTATION
 #define CWCF_APPLICATION_ID        DWCONF_APPLICATION_ID
+#define CWCF_MAX_UPDATE_RATE       DWCONF_MAX_UPDATE_RATE
 #define CWCF_ALL                   DWCONF_ALL
 
+/*
+ * Window events caused directly by input events.
+ */
+#define CORE_WINDOW_INPUT_EVENTS   (DWET_KEYDOWN | DWET_KEYUP | DWET_BUTTONDOWN | DWET_BUTTONUP | \
+                                    DWET_MOTION | DWET_WHEEL)
+
 struct __DFB_CoreWindowConfig {
      DFBRectangle             bounds;         /* position and size */
      int                      opacity;        /* global alpha factor */
@@ -98,6 +105,8 @@ struct __DFB_CoreWindowConfig {
 
      DFBWindowCursorFlags     cursor_flags;
      DFBDimension             cursor_resolution;
+
+     unsigned int             max_update_rate; /* updates per second shown at most, 0 for the screen refresh rate */
 };
 
 
@@ -326,6 +335,33 @@ DFBResult dfb_window_ungrab_key     ( CoreWindow                 *window,
 
 void dfb_window_post_event( CoreWindow *window, DFBWindowEvent *event );
 
+/*
+ * Attach a reaction to all events of the window, the event dispatch is skipped while there is none.
+ */
+DirectResult dfb_window_attach_listener( CoreWindow                 *window,
+                                         ReactionFunc                func,
+                                         void                       *ctx,
+                                         Reaction                   *reaction );
+
+DirectResult dfb_window_detach_listener( CoreWindow                 *window,
+                                         Reaction                   *reaction );
+
+/*
+ * Let the window post its events to a ring in shared memory (see core/window_event_ring.h)
+ * in addition to dispatching them to the listeners.
+ */
+DFBResult dfb_window_attach_event_ring( CoreWindow                 *window,
+                                        CoreWindowEventRing        *ring );
+
+DFBResult dfb_window_detach_event_ring( CoreWindow                 *window,
+                                        CoreWindowEventRing        *ring );
+
+/*
+ * Detach and destroy the event rings of a fusionee that left without detaching them (master only).
+ */
+void      dfb_windows_dispose_event_rings( CoreDFB              *core,
+                                           FusionID              owner );
+
 DFBResult dfb_window_send_configuration( CoreWindow *window );
 
 DFBWindowID dfb_window_id( const CoreWindow *window );
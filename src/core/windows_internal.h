@@ -130,6 +130,25 @@ struct __DFB_CoreWindow {
      CoreSurfaceClient      *surface_client;
      Reaction                surface_event_reaction;
      u32                     surface_flip_count;
+
+     struct {
+          long long          last;           /* time the last update was forwarded to the window manager */
+          long long          deadline;       /* time the pending update is due, 0 if none is pending */
+          DFBRegion          left;           /* pending update, merged from all updates throttled since */
+          DFBRegion          right;
+          u32                flip_count;     /* flip count acknowledged when the pending update is forwarded */
+          bool               queued;         /* referenced by the throttle thread */
+
+          unsigned long      forwarded;      /* updates forwarded to the window manager */
+          unsigned long      merged;         /* updates merged into another one */
+          unsigned long      dropped;        /* frames replaced by a newer one before being shown */
+     } updates;
+
+     long long               latency_origin; /* time of the last input event posted, until the next flip */
+     long long               flip_latency_origin; /* oldest input event time of flips not forwarded to the window manager yet */
+
+     FusionVector            event_rings;    /* event rings of slave event buffers, written by the master */
+     int                     listeners;      /* reactions to all events, the event rings are not counted */
 };
 
 typedef enum {
@@ -218,6 +237,8 @@ struct __DFB_CoreWindowStack {
      long long               motion_ts;
 
      FusionVector            visible_windows;     /* list of visible windows */
+
+     long long               latency_origin;      /* time of the input event processed by the window manager */
 };
 
 
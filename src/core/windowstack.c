@@ -108,6 +108,9 @@ static DFBEnumerationResult stack_attach_devices( CoreInputDevice *device,
 static DFBEnumerationResult stack_detach_devices( CoreInputDevice *device,
                                                   void            *ctx );
 
+static ReactionResult stack_input_frame_listener( const void *msg_data,
+                                                  void       *ctx );
+
 /**********************************************************************************************************************/
 
 // Implement stack_containers_XXX function family to maintain the connections
@@ -286,7 +289,7 @@ dfb_windowstack_detach_devices( CoreWindowStack *stack )
           DirectLink  *next   = l->next;
           StackDevice *device = (StackDevice*) l;
 
-          dfb_input_detach( dfb_input_device_at( device->id ), &device->reaction );
+          dfb_input_detach_frame( dfb_input_device_at( device->id ), &device->reaction );
 
           SHFREE( stack->shmpool, device );
 
@@ -1010,6 +1013,79 @@ _dfb_windowstack_inputdevice_listener( const void *msg_data,
      return RS_OK;
 }
 
+/*
+ * Processes all events of an input frame with one lock of the window stack.
+ */
+static ReactionResult
+stack_input_frame_listener( const void *msg_data,
+                            void       *ctx )
+{
+     DFBResult             ret;
+     const CoreInputFrame *frame = msg_data;
+     CoreWindowStack      *stack = ctx;
+     int                   i;
+     int                   num   = 0;
+     bool                  keep  = false;
+
+     D_DEBUG_AT( Core_WindowStack, "%s( %p, %p )\n", __FUNCTION__, msg_data, ctx );
+
+     D_ASSERT( msg_data != NULL );
+     D_MAGIC_ASSERT( stack, CoreWindowStack );
+     D_ASSERT( frame->num > 0 );
+     D_ASSERT( frame->num <= CORE_INPUT_FRAME_MAX );
+
+     /* Same as in _dfb_windowstack_inputdevice_listener(), keep the layer context while using it. */
+     if (dfb_layer_context_ref_stat( stack->context, &num ) || num == 0)
+          return RS_REMOVE;
+
+     if (dfb_layer_context_ref( stack->context ))
+          return RS_REMOVE;
+
+     /* Lock the window stack. */
+     if (dfb_windowstack_lock( stack )) {
+          dfb_layer_context_unref( stack->context );
+          return RS_REMOVE;
+     }
+
+     for (i=0; i<frame->num; i++) {
+          const DFBInputEvent *event = &frame->events[i];
+
+          /* Pointer motion is accumulated and delivered before any other event. */
+          if (event->type == DIET_AXISMOTION && (event->axis == DIAI_X || event->axis == DIAI_Y)) {
+               WindowStack_Input_Add( stack, event );
+               continue;
+          }
+
+          WindowStack_Input_Flush( stack );
+
+          /* Call the window manager to dispatch the event. */
+          if (dfb_layer_context_active( stack->context ))
+               dfb_wm_process_input( stack, event );
+     }
+
+     /* Remaining motion is delivered when the dispatcher has no more messages, the cleanup keeps the reference. */
+     if ((stack->motion_x.type || stack->motion_y.type) && !stack->motion_cleanup) {
+          ret = (DFBResult) fusion_dispatch_cleanup_add( dfb_core_world(core_dfb),
+                                                         WindowStack_Input_DispatchCleanup,
+                                                         stack, &stack->motion_cleanup );
+          if (ret) {
+               D_DERROR( ret, "Core/WindowStack: Failed to add dispatch cleanup!\n" );
+               WindowStack_Input_Flush( stack );
+          }
+          else
+               keep = true;
+     }
+
+     /* Unlock the window stack. */
+     dfb_windowstack_unlock( stack );
+
+     // Decrease the layer context's reference count.
+     if (!keep)
+          dfb_layer_context_unref( stack->context );
+
+     return RS_OK;
+}
+
 /*
  * listen to the background image
  */
@@ -1061,7 +1137,7 @@ stack_attach_devices( CoreInputDevice *device,
 
      direct_list_prepend( &stack->devices, &dev->link );
 
-     dfb_input_attach( device, _dfb_windowstack_inputdevice_listener, ctx, &dev->reaction );
+     dfb_input_attach_frame( device, stack_input_frame_listener, ctx, &dev->reaction );
 
      return DFENUM_OK;
 }
@@ -1084,7 +1160,7 @@ stack_detach_devices( CoreInputDevice *device,
           if (dfb_input_device_id(device) == dev->id) {
                direct_list_remove( &stack->devices, &dev->link );
 
-               dfb_input_detach( device, &dev->reaction );
+               dfb_input_detach_frame( device, &dev->reaction );
                SHFREE( stack->shmpool, dev );
                return DFENUM_OK;
           }
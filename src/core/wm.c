@@ -1003,6 +1003,19 @@ dfb_wm_process_input( CoreWindowStack     *stack,
 
      D_ASSERT( event != NULL );
 
+     if (dfb_config->latency_trace) {
+          DFBResult ret;
+
+          /* Window events posted meanwhile carry the time of the input event. */
+          stack->latency_origin = dfb_core_latency_origin( &event->timestamp );
+
+          ret = wm_local->funcs->ProcessInput( stack, wm_local->data, stack->stack_data, event );
+
+          stack->latency_origin = 0;
+
+          return ret;
+     }
+
      /* Dispatch input event via window manager. */
      return wm_local->funcs->ProcessInput( stack, wm_local->data, stack->stack_data, event );
 }
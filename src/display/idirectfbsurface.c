@@ -777,6 +777,9 @@ IDirectFBSurface_Flip( IDirectFBSurface    *thiz,
 
      IDirectFBSurface_StopAll( data );
 
+     if (dfb_config->flip_mailbox && (surface->config.caps & DSCAPS_TRIPLE))
+          flags |= DSFLIP_MAILBOX;
+
      /* FIXME: This is a temporary workaround for LiTE. */
      if (data->parent) {
           IDirectFBSurface_data *parent_data;
@@ -2564,6 +2567,65 @@ IDirectFBSurface_TextureTriangles( IDirectFBSurface     *thiz,
      return DFB_OK;
 }
 
+/*
+ * Calculates the origin of a string from the position passed to DrawString() and the text flags.
+ */
+static DFBResult
+drawstring_origin( IDirectFBSurface_data *data,
+                   CoreFont              *core_font,
+                   const char            *text,
+                   int                    bytes,
+                   int                   *x,
+                   int                   *y,
+                   DFBSurfaceTextFlags    flags )
+{
+     if (!(flags & DSTF_TOP)) {
+          *x += core_font->ascender * core_font->up_unit_x;
+          *y += core_font->ascender * core_font->up_unit_y;
+
+          if (flags & DSTF_BOTTOM) {
+               *x -= core_font->descender * core_font->up_unit_x;
+               *y -= core_font->descender * core_font->up_unit_y;
+          }
+     }
+
+     if (flags & (DSTF_RIGHT | DSTF_CENTER)) {
+          DFBResult    ret;
+          CoreFontRun *run;
+          int          xsize;
+          int          ysize;
+
+          dfb_font_lock( core_font );
+
+          /* The laid out run is cached and reused when drawing the string. */
+          ret = dfb_font_get_run( core_font, data->encoding, text, bytes, &run );
+          if (ret) {
+               dfb_font_unlock( core_font );
+               return ret;
+          }
+
+          xsize = run->xadvance;
+          ysize = run->yadvance;
+
+          dfb_font_unlock( core_font );
+
+          /* Justify. */
+          if (flags & DSTF_RIGHT) {
+               *x -= xsize >> 8;
+               *y -= ysize >> 8;
+          }
+          else if (flags & DSTF_CENTER) {
+               *x -= xsize >> 9;
+               *y -= ysize >> 9;
+          }
+     }
+
+     *x += data->area.wanted.x;
+     *y += data->area.wanted.y;
+
+     return DFB_OK;
+}
+
 static DFBResult
 IDirectFBSurface_DrawString( IDirectFBSurface *thiz,
                              const char *text, int bytes,
@@ -2620,70 +2682,122 @@ IDirectFBSurface_DrawString( IDirectFBSurface *thiz,
           layers = 2;
      }
 
-     if (!(flags & DSTF_TOP)) {
-          x += core_font->ascender * core_font->up_unit_x;
-          y += core_font->ascender * core_font->up_unit_y;
+     ret = drawstring_origin( data, core_font, text, bytes, &x, &y, flags );
+     if (ret)
+          return ret;
 
-          if (flags & DSTF_BOTTOM) {
-               x -= core_font->descender * core_font->up_unit_x;
-               y -= core_font->descender * core_font->up_unit_y;
+     dfb_gfxcard_drawstring( (const unsigned char*) text, bytes, data->encoding,
+                             x, y, core_font, layers, &data->state_client, flags );
+
+     return DFB_OK;
+}
+
+static DFBResult
+IDirectFBSurface_DrawStrings( IDirectFBSurface     *thiz,
+                              const char * const   *texts,
+                              const int            *bytes,
+                              const DFBPoint       *points,
+                              unsigned int          num,
+                              DFBSurfaceTextFlags   flags )
+{
+     DFBResult           ret = DFB_OK;
+     unsigned int        i;
+     int                 n = 0;
+     IDirectFBFont      *font;
+     IDirectFBFont_data *font_data;
+     CoreFont           *core_font;
+     unsigned int        layers = 1;
+     const u8          **local_texts;
+     int                *local_bytes;
+     DFBPoint           *local_points;
+     bool                malloced = (num > 256);
+
+     DIRECT_INTERFACE_GET_DATA(IDirectFBSurface)
+
+     D_DEBUG_AT( Surface, "%s( %p, %u )\n", __FUNCTION__, thiz, num );
+
+     if (!data->surface)
+          return DFB_DESTROYED;
+
+     if (!texts || !points)
+          return DFB_INVARG;
+
+     if (!data->area.current.w || !data->area.current.h)
+          return DFB_INVAREA;
+
+     if (data->locked)
+          return DFB_LOCKED;
+
+     if (!data->font)
+          return DFB_MISSINGFONT;
+
+     if (num == 0)
+          return DFB_OK;
+
+     /* Like DrawString(), a text is required unless its length is zero. */
+     if (bytes) {
+          for (i=0; i<num; i++) {
+               if (!texts[i] && bytes[i] > 0)
+                    return DFB_INVARG;
           }
      }
 
-     if (flags & (DSTF_RIGHT | DSTF_CENTER)) {
-          int          i, num, kx, ky;
-          int          xsize = 0;
-          int          ysize = 0;
-          unsigned int prev = 0;
-          unsigned int indices[bytes];
+     font = data->font;
 
-          /* FIXME: Avoid double locking and decoding. */
-          dfb_font_lock( core_font );
+     DIRECT_INTERFACE_GET_DATA_FROM( font, font_data, IDirectFBFont );
 
-          /* Decode string to character indices. */
-          ret = dfb_font_decode_text( core_font, data->encoding, text, bytes, indices, &num );
-          if (ret) {
-               dfb_font_unlock( core_font );
-               return ret;
-          }
+     if(!font_data)
+          return DFB_DESTROYED;
 
-          /* Calculate string width. */
-          for (i=0; i<num; i++) {
-               unsigned int   current = indices[i];
-               CoreGlyphData *glyph;
-
-               if (dfb_font_get_glyph_data( core_font, current, 0, &glyph ) == DFB_OK) {
-                    xsize += glyph->xadvance;
-                    ysize += glyph->yadvance;
-
-                    if (prev && core_font->GetKerning &&
-                        core_font->GetKerning( core_font, prev, current, &kx, &ky ) == DFB_OK) {
-                         xsize += kx << 8;
-                         ysize += ky << 8;
-                    }
-               }
+     if (core_dfb->shutdown_running)
+          return DFB_OK;
 
-               prev = current;
-          }
+     core_font = font_data->font;
 
-          dfb_font_unlock( core_font );
+     if (flags & DSTF_OUTLINE) {
+          if (!(core_font->attributes & DFFA_OUTLINED))
+               return DFB_UNSUPPORTED;
 
-          /* Justify. */
-          if (flags & DSTF_RIGHT) {
-               x -= xsize >> 8;
-               y -= ysize >> 8;
-          }
-          else if (flags & DSTF_CENTER) {
-               x -= xsize >> 9;
-               y -= ysize >> 9;
-          }
+          layers = 2;
      }
 
-     dfb_gfxcard_drawstring( (const unsigned char*) text, bytes, data->encoding,
-                             data->area.wanted.x + x, data->area.wanted.y + y,
-                             core_font, layers, &data->state_client, flags );
+     if (malloced) {
+          local_texts = D_MALLOC( (sizeof(u8*) + sizeof(int) + sizeof(DFBPoint)) * num );
+          if (!local_texts)
+               return D_OOM();
+     }
+     else
+          local_texts = alloca( (sizeof(u8*) + sizeof(int) + sizeof(DFBPoint)) * num );
 
-     return DFB_OK;
+     local_points = (DFBPoint*) (local_texts + num);
+     local_bytes  = (int*) (local_points + num);
+
+     for (i=0; i<num; i++) {
+          int len = (bytes && bytes[i] >= 0) ? bytes[i] : (texts[i] ? strlen( texts[i] ) : 0);
+
+          if (!len)
+               continue;
+
+          local_texts[n]  = (const u8*) texts[i];
+          local_bytes[n]  = len;
+          local_points[n] = points[i];
+
+          ret = drawstring_origin( data, core_font, texts[i], len, &local_points[n].x, &local_points[n].y, flags );
+          if (ret)
+               goto out;
+
+          n++;
+     }
+
+     if (n)
+          dfb_gfxcard_drawstrings( local_texts, local_bytes, local_points, n, data->encoding,
+                                   core_font, layers, &data->state_client, flags );
+
+out:
+     if (malloced)
+          D_FREE( local_texts );
+
+     return ret;
 }
 
 static DFBResult
@@ -3212,6 +3326,9 @@ IDirectFBSurface_FlipStereo( IDirectFBSurface    *thiz,
 
      IDirectFBSurface_StopAll( data );
 
+     if (dfb_config->flip_mailbox && (data->surface->config.caps & DSCAPS_TRIPLE))
+          flags |= DSFLIP_MAILBOX;
+
      if (data->parent) {
           IDirectFBSurface_data *parent_data;
 
@@ -3982,6 +4099,7 @@ DFBResult IDirectFBSurface_Construct( IDirectFBSurface       *thiz,
      thiz->SetFont = IDirectFBSurface_SetFont;
      thiz->GetFont = IDirectFBSurface_GetFont;
      thiz->DrawString = IDirectFBSurface_DrawString;
+     thiz->DrawStrings = IDirectFBSurface_DrawStrings;
      thiz->DrawGlyph = IDirectFBSurface_DrawGlyph;
      thiz->SetEncoding = IDirectFBSurface_SetEncoding;
 
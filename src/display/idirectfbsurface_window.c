@@ -66,6 +66,7 @@
 #include <direct/mem.h>
 #include <direct/thread.h>
 
+#include <misc/conf.h>
 #include <misc/util.h>
 
 #include <gfx/util.h>
@@ -131,6 +132,27 @@ IDirectFBSurface_Window_Release( IDirectFBSurface *thiz )
      return DFB_OK;
 }
 
+/*
+ * Traces the latency of the last input event posted to the window and keeps it with the flip,
+ * the window core hands it on to the display when forwarding the update to the window manager.
+ */
+static void
+trace_flip_latency( IDirectFBSurface_Window_data *data )
+{
+     CoreWindow *window = data->window;
+     long long   origin = window->latency_origin;
+
+     if (!origin || !window->stack)
+          return;
+
+     window->latency_origin = 0;
+
+     dfb_core_trace_latency( data->base.core, DLTS_FLIP, origin );
+
+     if (!window->flip_latency_origin || window->flip_latency_origin > origin)
+          window->flip_latency_origin = origin;
+}
+
 static DFBResult
 IDirectFBSurface_Window_Flip( IDirectFBSurface    *thiz,
                               const DFBRegion     *region,
@@ -142,6 +164,9 @@ IDirectFBSurface_Window_Flip( IDirectFBSurface    *thiz,
 
      D_DEBUG_AT( Surface, "%s( %p, %p, 0x%08x )\n", __FUNCTION__, thiz, region, flags );
 
+     if (dfb_config->latency_trace)
+          trace_flip_latency( data );
+
      ret = IDirectFBSurface_Flip( thiz, region, flags );
      if (ret)
           return ret;
@@ -167,6 +192,9 @@ IDirectFBSurface_Window_FlipStereo( IDirectFBSurface    *thiz,
 
      D_DEBUG_AT( Surface, "%s( %p, %p, %p, 0x%08x )\n", __FUNCTION__, thiz, left_region, right_region, flags );
 
+     if (dfb_config->latency_trace)
+          trace_flip_latency( data );
+
      ret = IDirectFBSurface_FlipStereo( thiz, left_region, right_region, flags );
      if (ret)
           return ret;
@@ -87,6 +87,7 @@
 #include <input/idirectfbinputdevice.h>
 #include <media/idirectfbfont.h>
 #include <media/idirectfbimageprovider.h>
+#include <media/idirectfbimageprovider_async.h>
 #include <media/idirectfbvideoprovider.h>
 #include <media/idirectfbdatabuffer.h>
 
@@ -286,6 +287,8 @@ IDirectFB_Destruct( IDirectFB *thiz )
 
      D_DEBUG_AT( IDFB, "%s( %p )\n", __FUNCTION__, thiz );
 
+     IDirectFBImageProvider_Async_Shutdown();
+
      drop_window( data, false );
 
      if (data->primary.context)
@@ -886,8 +889,8 @@ IDirectFB_CreateSurface( IDirectFB                    *thiz,
 
                          data->primary.window = window;
 
-                         dfb_window_attach( window, focus_listener,
-                                            data, &data->primary.reaction );
+                         dfb_window_attach_listener( window, focus_listener,
+                                                     data, &data->primary.reaction );
 
                          CoreWindow_ChangeOptions( window, DWOP_NONE, DWOP_SCALE );
 
@@ -1788,6 +1791,24 @@ IDirectFB_GetSurface( IDirectFB         *thiz,
      return ret;
 }
 
+static DFBResult
+IDirectFB_GetLatencyStats( IDirectFB       *thiz,
+                           DFBLatencyStats *ret_stats,
+                           DFBBoolean       reset )
+{
+     DIRECT_INTERFACE_GET_DATA(IDirectFB)
+
+     D_DEBUG_AT( IDFB, "%s( %p, %p, %s )\n", __FUNCTION__, thiz, ret_stats, reset ? "reset" : "" );
+
+     if (!ret_stats)
+          return DFB_INVARG;
+
+     if (!dfb_config->latency_trace)
+          return DFB_UNSUPPORTED;
+
+     return dfb_core_get_latency_stats( data->core, ret_stats, reset );
+}
+
 static void
 LoadBackgroundImage( IDirectFB       *dfb,
                      CoreWindowStack *stack,
@@ -2141,6 +2162,7 @@ IDirectFB_Construct( IDirectFB *thiz )
      thiz->WaitForSync = IDirectFB_WaitForSync;
      thiz->GetInterface = IDirectFB_GetInterface;
      thiz->GetSurface = IDirectFB_GetSurface;
+     thiz->GetLatencyStats = IDirectFB_GetLatencyStats;
 
      direct_mutex_init( &data->init_lock );
      direct_waitqueue_init( &data->init_wq );
@@ -2376,7 +2398,7 @@ drop_window( IDirectFB_data *data, bool enable_cursor )
      if (!data->primary.window)
           return;
 
-     dfb_window_detach( data->primary.window, &data->primary.reaction );
+     dfb_window_detach_listener( data->primary.window, &data->primary.reaction );
      dfb_window_unref( data->primary.window );
 
      data->primary.window  = NULL;
@@ -44,6 +44,10 @@
 #include <sys/socket.h>
 #endif
 
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
 #include <directfb.h>
 
 #include <direct/debug.h>
@@ -55,15 +59,18 @@
 #include <direct/thread.h>
 #include <direct/util.h>
 
+#include <fusion/conf.h>
 #include <fusion/reactor.h>
 
 #if !DIRECTFB_BUILD_PURE_VOODOO
+#include <core/core.h>
 #include <core/coredefs.h>
 #include <core/coretypes.h>
 
 #include <core/CoreWindow.h>
 
 #include <core/input.h>
+#include <core/window_event_ring.h>
 #include <core/windows.h>
 #include <core/windows_internal.h>
 #endif
@@ -80,11 +87,6 @@ D_DEBUG_DOMAIN( IDFBEvBuf,         "IDFBEventBuffer",         "IDirectFBEventBuf
 D_DEBUG_DOMAIN( IDFBEvBuf_Surface, "IDFBEventBuffer/Surface", "IDirectFBEventBuffer Interface Surface" );
 
 
-typedef struct {
-     DirectLink   link;
-     DFBEvent     evt;
-} EventBufferItem;
-
 #if !DIRECTFB_BUILD_PURE_VOODOO
 typedef struct {
      DirectLink       link;
@@ -99,7 +101,8 @@ typedef struct {
      DirectLink   link;
 
      CoreWindow  *window;       /* pointer to core window struct */
-     Reaction     reaction;
+     Reaction     reaction;     /* to all events, or to those not fitting into the event ring */
+     bool         ring;         /* events come via the event ring */
 } AttachedWindow;
 
 typedef struct {
@@ -124,7 +127,11 @@ typedef struct {
      DirectLink                   *windows;        /* attached windows */
      DirectLink                   *surfaces;       /* attached surfaces */
 
-     DirectLink                   *events;         /* linked list containing events */
+     DFBEvent                     *events;         /* ring of preallocated events */
+     unsigned int                  events_size;    /* number of entries in the ring */
+     unsigned int                  events_first;   /* index of the oldest event */
+     unsigned int                  events_count;   /* number of queued events */
+     unsigned int                  events_dropped; /* number of events lost on overflow */
 
      DirectMutex                   events_mutex;   /* mutex lock for accessing the event queue */
 
@@ -135,6 +142,13 @@ typedef struct {
 
      DirectThread                 *pipe_thread;    /* thread feeding the pipe */
 
+     int                           notify_fd;      /* readable while events are queued, -1 if not created */
+
+#if !DIRECTFB_BUILD_PURE_VOODOO
+     CoreWindowEventRing          *ring;           /* window events written by the master, see 'window-event-ring' */
+     DirectThread                 *ring_thread;    /* thread reading the ring */
+#endif
+
      DFBEventBufferStats           stats;
      bool                          stats_enabled;
 } IDirectFBEventBuffer_data;
@@ -142,18 +156,35 @@ typedef struct {
 /*
  * adds an event to the event queue
  */
-static void IDirectFBEventBuffer_AddItem( IDirectFBEventBuffer_data *data,
-                                          EventBufferItem           *item );
+static void IDirectFBEventBuffer_AddEvent( IDirectFBEventBuffer_data *data,
+                                           DFBEvent                  *event );
+
+/*
+ * puts an event into the queue without waking up waiters, called with events_mutex locked
+ */
+static void IDirectFBEventBuffer_QueueEvent( IDirectFBEventBuffer_data *data,
+                                             const DFBEvent            *event );
+
+/*
+ * copies the oldest event and removes it from the queue, called with events_mutex locked
+ */
+static void IDirectFBEventBuffer_TakeEvent( IDirectFBEventBuffer_data *data,
+                                            DFBEvent                  *event );
 
 #if !DIRECTFB_BUILD_PURE_VOODOO
-static ReactionResult IDirectFBEventBuffer_InputReact( const void *msg_data,
-                                                       void       *ctx );
+static ReactionResult IDirectFBEventBuffer_InputFrameReact( const void *msg_data,
+                                                            void       *ctx );
 
 static ReactionResult IDirectFBEventBuffer_WindowReact( const void *msg_data,
                                                         void       *ctx );
 
+static ReactionResult IDirectFBEventBuffer_RingOverflowReact( const void *msg_data,
+                                                              void       *ctx );
+
 static ReactionResult IDirectFBEventBuffer_SurfaceReact( const void *msg_data,
                                                          void       *ctx );
+
+static void *IDirectFBEventBuffer_RingThread( DirectThread *thread, void *arg );
 #endif
 
 #ifndef WIN32
@@ -210,9 +241,8 @@ IDirectFBEventBuffer_Destruct( IDirectFBEventBuffer *thiz )
      AttachedDevice            *device;
      AttachedSurface           *surface;
      AttachedWindow            *window;
-#endif
-     EventBufferItem           *item;
      DirectLink                *n;
+#endif
 
      D_DEBUG_AT( IDFBEvBuf, "%s( %p )\n", __FUNCTION__, thiz );
 
@@ -253,14 +283,28 @@ IDirectFBEventBuffer_Destruct( IDirectFBEventBuffer *thiz )
      }
 
      direct_list_foreach_safe (device, n, data->devices) {
-          dfb_input_detach( device->device, &device->reaction );
+          dfb_input_detach_frame( device->device, &device->reaction );
 
           D_FREE( device );
      }
 
+     if (data->ring) {
+          dfb_window_event_ring_stop( data->ring );
+
+          direct_thread_join( data->ring_thread );
+          direct_thread_destroy( data->ring_thread );
+     }
+
      direct_list_foreach_safe (window, n, data->windows) {
-          if (window->window)
+          if (!window->window)
+               continue;
+
+          if (window->ring) {
+               dfb_window_detach_event_ring( window->window, data->ring );
                dfb_window_detach( window->window, &window->reaction );
+          }
+          else
+               dfb_window_detach_listener( window->window, &window->reaction );
      }
 
      direct_list_foreach_safe (window, n, data->windows) {
@@ -269,12 +313,18 @@ IDirectFBEventBuffer_Destruct( IDirectFBEventBuffer *thiz )
 
           D_FREE( window );
      }
+
+     if (data->ring)
+          dfb_window_event_ring_destroy( core_dfb, data->ring );
 #endif
 
-     direct_mutex_lock( &data->events_mutex );
+     if (data->events_dropped)
+          D_DEBUG_AT( IDFBEvBuf, "  -> %u events dropped on overflow\n", data->events_dropped );
 
-     direct_list_foreach_safe (item, n, data->events)
-          D_FREE( item );
+     if (data->notify_fd >= 0)
+          close( data->notify_fd );
+
+     D_FREE( data->events );
 
      direct_waitqueue_deinit( &data->wait_condition );
      direct_mutex_deinit( &data->events_mutex );
@@ -310,8 +360,7 @@ IDirectFBEventBuffer_Release( IDirectFBEventBuffer *thiz )
 static DFBResult
 IDirectFBEventBuffer_Reset( IDirectFBEventBuffer *thiz )
 {
-     EventBufferItem *item;
-     DirectLink      *n;
+     DFBEvent event;
 
      DIRECT_INTERFACE_GET_DATA(IDirectFBEventBuffer)
 
@@ -322,10 +371,8 @@ IDirectFBEventBuffer_Reset( IDirectFBEventBuffer *thiz )
 
      direct_mutex_lock( &data->events_mutex );
 
-     direct_list_foreach_safe (item, n, data->events)
-          D_FREE( item );
-
-     data->events = NULL;
+     while (data->events_count)
+          IDirectFBEventBuffer_TakeEvent( data, &event );
 
      direct_mutex_unlock( &data->events_mutex );
 
@@ -346,9 +393,9 @@ IDirectFBEventBuffer_WaitForEvent( IDirectFBEventBuffer *thiz )
 
      direct_mutex_lock( &data->events_mutex );
 
-     if (!data->events)
+     if (!data->events_count)
           direct_waitqueue_wait( &data->wait_condition, &data->events_mutex );
-     if (!data->events)
+     if (!data->events_count)
           ret = DFB_INTERRUPTED;
 
      direct_mutex_unlock( &data->events_mutex );
@@ -372,7 +419,7 @@ IDirectFBEventBuffer_WaitForEventWithTimeout( IDirectFBEventBuffer *thiz,
           return DFB_UNSUPPORTED;
 
      if (direct_mutex_trylock( &data->events_mutex ) == 0) {
-          if (data->events) {
+          if (data->events_count) {
                direct_mutex_unlock ( &data->events_mutex );
                return ret;
           }
@@ -382,11 +429,11 @@ IDirectFBEventBuffer_WaitForEventWithTimeout( IDirectFBEventBuffer *thiz,
      if (!locked)
           direct_mutex_lock( &data->events_mutex );
 
-     if (!data->events) {
+     if (!data->events_count) {
           ret = direct_waitqueue_wait_timeout( &data->wait_condition,
                                                &data->events_mutex,
                                                seconds * 1000000 + milli_seconds * 1000 );
-          if (ret != DR_TIMEOUT && !data->events)
+          if (ret != DR_TIMEOUT && !data->events_count)
                ret = DFB_INTERRUPTED;
      }
 
@@ -414,8 +461,6 @@ static DFBResult
 IDirectFBEventBuffer_GetEvent( IDirectFBEventBuffer *thiz,
                                DFBEvent             *event )
 {
-     EventBufferItem *item;
-
      DIRECT_INTERFACE_GET_DATA(IDirectFBEventBuffer)
 
      D_DEBUG_AT( IDFBEvBuf, "%s( %p, %p )\n", __FUNCTION__, thiz, event );
@@ -427,49 +472,13 @@ IDirectFBEventBuffer_GetEvent( IDirectFBEventBuffer *thiz,
 
      direct_mutex_lock( &data->events_mutex );
 
-     if (!data->events) {
+     if (!data->events_count) {
           D_DEBUG_AT( IDFBEvBuf, "  -> no events, returning BUFFEREMPTY\n" );
           direct_mutex_unlock( &data->events_mutex );
           return DFB_BUFFEREMPTY;
      }
 
-     item = (EventBufferItem*) data->events;
-
-     switch (item->evt.clazz) {
-          case DFEC_INPUT:
-               event->input = item->evt.input;
-               break;
-
-          case DFEC_WINDOW:
-               event->window = item->evt.window;
-               break;
-
-          case DFEC_USER:
-               event->user = item->evt.user;
-               break;
-
-          case DFEC_VIDEOPROVIDER:
-               event->videoprovider = item->evt.videoprovider;
-               break;
-
-          case DFEC_UNIVERSAL:
-               direct_memcpy( event, &item->evt, item->evt.universal.size );
-               break;
-
-          case DFEC_SURFACE:
-               event->surface = item->evt.surface;
-               break;
-
-          default:
-               D_BUG("unknown event class");
-     }
-
-     if (data->stats_enabled)
-          CollectEventStatistics( &data->stats, &item->evt, -1 );
-
-     direct_list_remove( &data->events, &item->link );
-
-     D_FREE( item );
+     IDirectFBEventBuffer_TakeEvent( data, event );
 
      direct_mutex_unlock( &data->events_mutex );
 
@@ -482,7 +491,7 @@ static DFBResult
 IDirectFBEventBuffer_PeekEvent( IDirectFBEventBuffer *thiz,
                                 DFBEvent             *event )
 {
-     EventBufferItem *item;
+     const DFBEvent *first;
 
      DIRECT_INTERFACE_GET_DATA(IDirectFBEventBuffer)
 
@@ -493,41 +502,17 @@ IDirectFBEventBuffer_PeekEvent( IDirectFBEventBuffer *thiz,
 
      direct_mutex_lock( &data->events_mutex );
 
-     if (!data->events) {
+     if (!data->events_count) {
           direct_mutex_unlock( &data->events_mutex );
           return DFB_BUFFEREMPTY;
      }
 
-     item = (EventBufferItem*) data->events;
+     first = &data->events[data->events_first];
 
-     switch (item->evt.clazz) {
-          case DFEC_INPUT:
-               event->input = item->evt.input;
-               break;
-
-          case DFEC_WINDOW:
-               event->window = item->evt.window;
-               break;
-
-          case DFEC_USER:
-               event->user = item->evt.user;
-               break;
-
-          case DFEC_VIDEOPROVIDER:
-               event->videoprovider = item->evt.videoprovider;
-               break;
-
-          case DFEC_UNIVERSAL:
-               direct_memcpy( event, &item->evt, item->evt.universal.size );
-               break;
-
-          case DFEC_SURFACE:
-               event->surface = item->evt.surface;
-               break;
-
-          default:
-               D_BUG("unknown event class");
-     }
+     if (first->clazz == DFEC_UNIVERSAL)
+          direct_memcpy( event, first, first->universal.size );
+     else
+          *event = *first;
 
      direct_mutex_unlock( &data->events_mutex );
 
@@ -541,20 +526,19 @@ IDirectFBEventBuffer_HasEvent( IDirectFBEventBuffer *thiz )
 {
      DIRECT_INTERFACE_GET_DATA(IDirectFBEventBuffer)
 
-     D_DEBUG_AT( IDFBEvBuf, "%s( %p ) <- events: %p, pipe: %d\n", __FUNCTION__, thiz, data->events, data->pipe );
+     D_DEBUG_AT( IDFBEvBuf, "%s( %p ) <- events: %u, pipe: %d\n", __FUNCTION__, thiz, data->events_count, data->pipe );
 
      if (data->pipe)
           return DFB_UNSUPPORTED;
 
-     return (data->events ? DFB_OK : DFB_BUFFEREMPTY);
+     return (data->events_count ? DFB_OK : DFB_BUFFEREMPTY);
 }
 
 static DFBResult
 IDirectFBEventBuffer_PostEvent( IDirectFBEventBuffer *thiz,
                                 const DFBEvent       *event )
 {
-     EventBufferItem *item;
-     int              size;
+     DFBEvent evt;
 
      DIRECT_INTERFACE_GET_DATA(IDirectFBEventBuffer)
 
@@ -563,64 +547,45 @@ IDirectFBEventBuffer_PostEvent( IDirectFBEventBuffer *thiz,
 
      dump_event( event );
 
-     switch (event->clazz) {
-          case DFEC_INPUT:
-          case DFEC_WINDOW:
-          case DFEC_USER:
-          case DFEC_VIDEOPROVIDER:
-          case DFEC_SURFACE:
-               size = sizeof(EventBufferItem);
-               break;
-
-          case DFEC_UNIVERSAL:
-               size = event->universal.size;
-               if (size < sizeof(DFBUniversalEvent))
-                    return DFB_INVARG;
-               /* We must not exceed the union to avoid crashes in generic code (reading DFBEvents)
-                * and to support pipe mode where each written block has to have a fixed size. */
-               if (size > sizeof(DFBEvent))
-                    return DFB_INVARG;
-               size += sizeof(DirectLink);
-               break;
-
-          default:
-               return DFB_INVARG;
-     }
-
-     item = D_CALLOC( 1, size );
-     if (!item)
-          return D_OOM();
+     memset( &evt, 0, sizeof(DFBEvent) );
 
      switch (event->clazz) {
           case DFEC_INPUT:
-               item->evt.input = event->input;
+               evt.input = event->input;
                break;
 
           case DFEC_WINDOW:
-               item->evt.window = event->window;
+               evt.window = event->window;
                break;
 
           case DFEC_USER:
-               item->evt.user = event->user;
+               evt.user = event->user;
                break;
 
           case DFEC_VIDEOPROVIDER:
-               item->evt.videoprovider = event->videoprovider;
+               evt.videoprovider = event->videoprovider;
                break;
 
           case DFEC_UNIVERSAL:
-               direct_memcpy( &item->evt, event, event->universal.size );
+               if (event->universal.size < sizeof(DFBUniversalEvent))
+                    return DFB_INVARG;
+               /* We must not exceed the union to avoid crashes in generic code (reading DFBEvents)
+                * and to support pipe mode where each written block has to have a fixed size. */
+               if (event->universal.size > sizeof(DFBEvent))
+                    return DFB_INVARG;
+
+               direct_memcpy( &evt, event, event->universal.size );
                break;
 
           case DFEC_SURFACE:
-               item->evt.surface = event->surface;
+               evt.surface = event->surface;
                break;
 
           default:
-               D_BUG("unexpected event class");
+               return DFB_INVARG;
      }
 
-     IDirectFBEventBuffer_AddItem( data, item );
+     IDirectFBEventBuffer_AddEvent( data, &evt );
 
      return DFB_OK;
 }
@@ -643,8 +608,8 @@ IDirectFBEventBuffer_CreateFileDescriptor( IDirectFBEventBuffer *thiz,
      /* Lock the event queue. */
      direct_mutex_lock( &data->events_mutex );
 
-     /* Already in pipe mode? */
-     if (data->pipe) {
+     /* Already in pipe mode or readiness signalled via GetNotifyDescriptor()? */
+     if (data->pipe || data->notify_fd >= 0) {
           direct_mutex_unlock( &data->events_mutex );
           return DFB_BUSY;
      }
@@ -685,6 +650,61 @@ IDirectFBEventBuffer_CreateFileDescriptor( IDirectFBEventBuffer *thiz,
 #endif
 }
 
+static DFBResult
+IDirectFBEventBuffer_GetNotifyDescriptor( IDirectFBEventBuffer *thiz,
+                                          int                  *ret_fd )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+     DIRECT_INTERFACE_GET_DATA(IDirectFBEventBuffer)
+
+     D_DEBUG_AT( IDFBEvBuf, "%s( %p )\n", __FUNCTION__, thiz );
+
+     /* Check arguments. */
+     if (!ret_fd)
+          return DFB_INVARG;
+
+     /* Lock the event queue. */
+     direct_mutex_lock( &data->events_mutex );
+
+     /* Events are read from the descriptor in pipe mode. */
+     if (data->pipe) {
+          direct_mutex_unlock( &data->events_mutex );
+          return DFB_UNSUPPORTED;
+     }
+
+     if (data->notify_fd < 0) {
+          data->notify_fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+          if (data->notify_fd < 0) {
+               DFBResult ret = errno2result( errno );
+
+               D_PERROR( "%s(): eventfd() failed!\n", __FUNCTION__ );
+               direct_mutex_unlock( &data->events_mutex );
+               return ret;
+          }
+
+          /* Signal events already in the queue. */
+          if (data->events_count) {
+               u64 one = 1;
+
+               if (write( data->notify_fd, &one, sizeof(one) ) < 0)
+                    D_DEBUG_AT( IDFBEvBuf, "  -> could not signal fd %d\n", data->notify_fd );
+          }
+
+          D_DEBUG_AT( IDFBEvBuf, "  -> created fd %d\n", data->notify_fd );
+     }
+
+     /* Unlock the event queue. */
+     direct_mutex_unlock( &data->events_mutex );
+
+     *ret_fd = data->notify_fd;
+
+     return DFB_OK;
+#else
+     D_UNIMPLEMENTED();
+     return DFB_UNIMPLEMENTED;
+#endif
+}
+
 static DFBResult
 IDirectFBEventBuffer_EnableStatistics( IDirectFBEventBuffer *thiz,
                                        DFBBoolean            enable )
@@ -703,11 +723,11 @@ IDirectFBEventBuffer_EnableStatistics( IDirectFBEventBuffer *thiz,
      }
 
      if (enable) {
-          EventBufferItem *item;
+          unsigned int i;
 
           /* Collect statistics for events already in the queue. */
-          direct_list_foreach (item, data->events)
-               CollectEventStatistics( &data->stats, &item->evt, 1 );
+          for (i=0; i<data->events_count; i++)
+               CollectEventStatistics( &data->stats, &data->events[(data->events_first + i) % data->events_size], 1 );
      }
      else {
           /* Clear statistics. */
@@ -764,6 +784,14 @@ IDirectFBEventBuffer_Construct( IDirectFBEventBuffer      *thiz,
      data->ref        = 1;
      data->filter     = filter;
      data->filter_ctx = filter_ctx;
+     data->notify_fd  = -1;
+
+     data->events_size = dfb_config->event_buffer_size;
+     data->events      = D_MALLOC( data->events_size * sizeof(DFBEvent) );
+     if (!data->events) {
+          DIRECT_DEALLOCATE_INTERFACE( thiz );
+          return D_OOM();
+     }
 
      direct_mutex_init( &data->events_mutex );
      direct_waitqueue_init( &data->wait_condition );
@@ -779,6 +807,7 @@ IDirectFBEventBuffer_Construct( IDirectFBEventBuffer      *thiz,
      thiz->PostEvent               = IDirectFBEventBuffer_PostEvent;
      thiz->WakeUp                  = IDirectFBEventBuffer_WakeUp;
      thiz->CreateFileDescriptor    = IDirectFBEventBuffer_CreateFileDescriptor;
+     thiz->GetNotifyDescriptor     = IDirectFBEventBuffer_GetNotifyDescriptor;
      thiz->EnableStatistics        = IDirectFBEventBuffer_EnableStatistics;
      thiz->GetStatistics           = IDirectFBEventBuffer_GetStatistics;
 
@@ -811,8 +840,8 @@ DFBResult IDirectFBEventBuffer_AttachInputDevice( IDirectFBEventBuffer *thiz,
 
      direct_list_prepend( &data->devices, &attached->link );
 
-     dfb_input_attach( device, IDirectFBEventBuffer_InputReact,
-                       data, &attached->reaction );
+     dfb_input_attach_frame( device, IDirectFBEventBuffer_InputFrameReact,
+                             data, &attached->reaction );
 
      return DFB_OK;
 }
@@ -834,7 +863,7 @@ DFBResult IDirectFBEventBuffer_DetachInputDevice( IDirectFBEventBuffer *thiz,
           if (attached->device == device) {
                direct_list_remove( &data->devices, &attached->link );
                
-               dfb_input_detach( attached->device, &attached->reaction );
+               dfb_input_detach_frame( attached->device, &attached->reaction );
                
                D_FREE( attached );
                
@@ -865,8 +894,31 @@ DFBResult IDirectFBEventBuffer_AttachWindow( IDirectFBEventBuffer *thiz,
 
      direct_list_prepend( &data->windows, &attached->link );
 
-     dfb_window_attach( window, IDirectFBEventBuffer_WindowReact,
-                        data, &attached->reaction );
+     /*
+      * Slaves may let the master write the window events into shared memory, saving a Fusion dispatch
+      * per event. Not in secure mode, where slaves can't write to the shared memory pool.
+      */
+     if (dfb_config->window_event_ring && !dfb_core_is_master( core_dfb ) && !fusion_config->secure_fusion) {
+          if (!data->ring && !dfb_window_event_ring_create( core_dfb, dfb_config->window_event_ring, &data->ring )) {
+               data->ring_thread = direct_thread_create( DTT_MESSAGING, IDirectFBEventBuffer_RingThread,
+                                                         data, "EventBufferRing" );
+               if (!data->ring_thread) {
+                    dfb_window_event_ring_destroy( core_dfb, data->ring );
+                    data->ring = NULL;
+               }
+          }
+
+          if (data->ring && !dfb_window_attach_event_ring( window, data->ring )) {
+               attached->ring = true;
+
+               dfb_window_attach_channel( window, CORE_WINDOW_RING_CHANNEL, IDirectFBEventBuffer_RingOverflowReact,
+                                          data, &attached->reaction );
+          }
+     }
+
+     if (!attached->ring)
+          dfb_window_attach_listener( window, IDirectFBEventBuffer_WindowReact,
+                                      data, &attached->reaction );
 
      CoreWindow_AllowFocus( window );
 
@@ -892,7 +944,13 @@ DFBResult IDirectFBEventBuffer_DetachWindow( IDirectFBEventBuffer *thiz,
                direct_list_remove( &data->windows, &attached->link );
 
                if (attached->window) {
-                    dfb_window_detach( attached->window, &attached->reaction );
+                    if (attached->ring) {
+                         dfb_window_detach_event_ring( attached->window, data->ring );
+                         dfb_window_detach( attached->window, &attached->reaction );
+                    }
+                    else
+                         dfb_window_detach_listener( attached->window, &attached->reaction );
+
                     dfb_window_unref( attached->window );
                }
                
@@ -928,25 +986,22 @@ DFBResult IDirectFBEventBuffer_AttachSurface( IDirectFBEventBuffer *thiz,
      D_DEBUG_AT( IDFBEvBuf, "  -> flip count %u\n", surface->flips );
 
      if (surface->flips > 0 || !(surface->config.caps & DSCAPS_FLIPPING)) {
-          EventBufferItem *item;
-
-          item = D_CALLOC( 1, sizeof(EventBufferItem) );
-          if (!item)
-               D_OOM();
-          else {
-               item->evt.surface.clazz        = DFEC_SURFACE;
-               item->evt.surface.type         = DSEVT_UPDATE;
-               item->evt.surface.surface_id   = surface->object.id;
-               item->evt.surface.update.x1    = 0;
-               item->evt.surface.update.y1    = 0;
-               item->evt.surface.update.x2    = surface->config.size.w - 1;
-               item->evt.surface.update.y2    = surface->config.size.h - 1;
-               item->evt.surface.update_right = item->evt.surface.update;
-               item->evt.surface.flip_count   = surface->flips;
-               item->evt.surface.time_stamp   = surface->last_frame_time;
-
-               IDirectFBEventBuffer_AddItem( data, item );
-          }
+          DFBEvent evt;
+
+          memset( &evt, 0, sizeof(DFBEvent) );
+
+          evt.surface.clazz        = DFEC_SURFACE;
+          evt.surface.type         = DSEVT_UPDATE;
+          evt.surface.surface_id   = surface->object.id;
+          evt.surface.update.x1    = 0;
+          evt.surface.update.y1    = 0;
+          evt.surface.update.x2    = surface->config.size.w - 1;
+          evt.surface.update.y2    = surface->config.size.h - 1;
+          evt.surface.update_right = evt.surface.update;
+          evt.surface.flip_count   = surface->flips;
+          evt.surface.time_stamp   = surface->last_frame_time;
+
+          IDirectFBEventBuffer_AddEvent( data, &evt );
      }
 
      return DFB_OK;
@@ -984,86 +1039,363 @@ DFBResult IDirectFBEventBuffer_DetachSurface( IDirectFBEventBuffer *thiz,
 
 /* file internals */
 
-static void IDirectFBEventBuffer_AddItem( IDirectFBEventBuffer_data *data,
-                                          EventBufferItem           *item )
+static inline DFBEvent *
+ring_event( IDirectFBEventBuffer_data *data,
+            unsigned int               index )
 {
-     if (data->filter && data->filter( &item->evt, data->filter_ctx )) {
-          D_FREE( item );
-          return;
+     return &data->events[(data->events_first + index) % data->events_size];
+}
+
+/*
+ * Doubles the ring, unwrapping the queued events to the start of the new storage.
+ */
+static DFBResult
+ring_grow( IDirectFBEventBuffer_data *data )
+{
+     unsigned int  i;
+     unsigned int  size = data->events_size * 2;
+     DFBEvent     *events;
+
+     events = D_MALLOC( size * sizeof(DFBEvent) );
+     if (!events)
+          return D_OOM();
+
+     for (i=0; i<data->events_count; i++)
+          events[i] = *ring_event( data, i );
+
+     D_FREE( data->events );
+
+     data->events       = events;
+     data->events_size  = size;
+     data->events_first = 0;
+
+     D_DEBUG_AT( IDFBEvBuf, "  -> grown to %u events\n", size );
+
+     return DFB_OK;
+}
+
+static bool
+is_motion_event( const DFBEvent *event )
+{
+     switch (event->clazz) {
+          case DFEC_INPUT:
+               return event->input.type == DIET_AXISMOTION;
+
+          case DFEC_WINDOW:
+               return event->window.type == DWET_MOTION;
+
+          default:
+               break;
      }
 
-     direct_mutex_lock( &data->events_mutex );
+     return false;
+}
 
-     if (data->stats_enabled)
-          CollectEventStatistics( &data->stats, &item->evt, 1 );
+/*
+ * Merges a motion event into a queued one from the same source, looking back only as far as
+ * the last event that is no motion, so that motion never moves across a button or key event.
+ */
+static bool
+ring_coalesce_motion( IDirectFBEventBuffer_data *data,
+                      const DFBEvent            *event )
+{
+     unsigned int i;
+
+     if (!is_motion_event( event ))
+          return false;
+
+     for (i=data->events_count; i>0; i--) {
+          DFBEvent *queued = ring_event( data, i - 1 );
+
+          if (!is_motion_event( queued ) || queued->clazz != event->clazz)
+               return false;
+
+          if (event->clazz == DFEC_INPUT) {
+               if (queued->input.device_id != event->input.device_id || queued->input.axis != event->input.axis)
+                    continue;
+
+               if (queued->input.flags & event->input.flags & DIEF_AXISREL) {
+                    int rel = queued->input.axisrel + event->input.axisrel;
+
+                    queued->input         = event->input;
+                    queued->input.axisrel = rel;
+               }
+               else
+                    queued->input = event->input;
+
+               return true;
+          }
+
+          if (queued->window.window_id == event->window.window_id) {
+               queued->window = event->window;
+
+               return true;
+          }
+     }
+
+     return false;
+}
+
+static void
+notify_fd_set( IDirectFBEventBuffer_data *data,
+               bool                       ready )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+     u64     value = 1;
+     ssize_t ret;
+
+     if (data->notify_fd < 0)
+          return;
+
+     if (ready)
+          ret = write( data->notify_fd, &value, sizeof(value) );
+     else
+          ret = read( data->notify_fd, &value, sizeof(value) );
+
+     (void) ret;
+#endif
+}
+
+static void IDirectFBEventBuffer_AddEvent( IDirectFBEventBuffer_data *data,
+                                           DFBEvent                  *event )
+{
+     if (data->filter && data->filter( event, data->filter_ctx ))
+          return;
 
-     direct_list_append( &data->events, &item->link );
+     direct_mutex_lock( &data->events_mutex );
+
+     IDirectFBEventBuffer_QueueEvent( data, event );
 
      direct_waitqueue_broadcast( &data->wait_condition );
 
      direct_mutex_unlock( &data->events_mutex );
 }
 
+static void IDirectFBEventBuffer_QueueEvent( IDirectFBEventBuffer_data *data,
+                                             const DFBEvent            *event )
+{
+     if (data->events_count == data->events_size) {
+          switch (dfb_config->event_buffer_overflow) {
+               case DCEO_COALESCE_MOTION:
+                    if (ring_coalesce_motion( data, event )) {
+                         data->events_dropped++;
+                         return;
+                    }
+                    /* fall through */
+
+               case DCEO_DROP_OLDEST:
+                    break;
+
+               default:
+                    ring_grow( data );
+                    break;
+          }
+
+          /* Keep the newest events if the ring is still full. */
+          if (data->events_count == data->events_size) {
+               DFBEvent dropped;
+
+               IDirectFBEventBuffer_TakeEvent( data, &dropped );
+
+               data->events_dropped++;
+          }
+     }
+
+     if (data->stats_enabled)
+          CollectEventStatistics( &data->stats, event, 1 );
+
+     *ring_event( data, data->events_count++ ) = *event;
+
+     if (data->events_count == 1)
+          notify_fd_set( data, true );
+}
+
+static void IDirectFBEventBuffer_TakeEvent( IDirectFBEventBuffer_data *data,
+                                            DFBEvent                  *event )
+{
+     const DFBEvent *first;
+
+     D_ASSERT( data->events_count > 0 );
+
+     first = &data->events[data->events_first];
+
+     if (first->clazz == DFEC_UNIVERSAL)
+          direct_memcpy( event, first, first->universal.size );
+     else
+          *event = *first;
+
+     if (data->stats_enabled)
+          CollectEventStatistics( &data->stats, first, -1 );
+
+     if (++data->events_first == data->events_size)
+          data->events_first = 0;
+
+     if (--data->events_count == 0)
+          notify_fd_set( data, false );
+}
+
 #if !DIRECTFB_BUILD_PURE_VOODOO
-static ReactionResult IDirectFBEventBuffer_InputReact( const void *msg_data,
-                                                       void       *ctx )
+/*
+ * Queues all events of an input frame and wakes up waiters once.
+ */
+static ReactionResult IDirectFBEventBuffer_InputFrameReact( const void *msg_data,
+                                                            void       *ctx )
 {
-     const DFBInputEvent       *evt  = msg_data;
-     IDirectFBEventBuffer_data *data = ctx;
-     EventBufferItem           *item;
+     const CoreInputFrame      *frame = msg_data;
+     IDirectFBEventBuffer_data *data  = ctx;
+     DFBEvent                   event;
+     DFBInputEvent              events[CORE_INPUT_FRAME_MAX];
+     int                        num = 0;
+     int                        i;
 
-     D_DEBUG_AT( IDFBEvBuf, "%s( %p, %p ) <- type %06x\n", __FUNCTION__, evt, data, evt->type );
+     D_DEBUG_AT( IDFBEvBuf, "%s( %p, %p ) <- %d events\n", __FUNCTION__, frame, data, frame->num );
 
-     if (dfb_config->discard_repeat_events && (evt->flags & DIEF_REPEAT)) {
-          D_DEBUG_AT( IDFBEvBuf, "  -> discarding repeat event!\n" );
-          return DFB_OK;
+     D_ASSERT( frame->num <= CORE_INPUT_FRAME_MAX );
+
+     /* Run the filter without holding the mutex, like for single events. */
+     for (i=0; i<frame->num; i++) {
+          const DFBInputEvent *evt = &frame->events[i];
+
+          if (dfb_config->discard_repeat_events && (evt->flags & DIEF_REPEAT)) {
+               D_DEBUG_AT( IDFBEvBuf, "  -> discarding repeat event!\n" );
+               continue;
+          }
+
+          event.input = *evt;
+          event.clazz = DFEC_INPUT;
+
+          if (data->filter && data->filter( &event, data->filter_ctx ))
+               continue;
+
+          events[num++] = event.input;
      }
 
-     item = D_CALLOC( 1, sizeof(EventBufferItem) );
+     if (!num)
+          return RS_OK;
+
+     direct_mutex_lock( &data->events_mutex );
 
-     item->evt.input = *evt;
-     item->evt.clazz = DFEC_INPUT;
+     for (i=0; i<num; i++) {
+          event.input = events[i];
+          event.clazz = DFEC_INPUT;
 
-     IDirectFBEventBuffer_AddItem( data, item );
+          IDirectFBEventBuffer_QueueEvent( data, &event );
+     }
+
+     direct_waitqueue_broadcast( &data->wait_condition );
+
+     direct_mutex_unlock( &data->events_mutex );
 
      return RS_OK;
 }
 
+/*
+ * Queues a window event without waking up waiters, called with events_mutex locked.
+ */
+static void
+queue_window_event( IDirectFBEventBuffer_data *data,
+                    const DFBWindowEvent      *evt )
+{
+     DFBEvent event;
+
+     if (dfb_config->discard_repeat_events && (evt->flags & DWEF_REPEAT)) {
+          D_DEBUG_AT( IDFBEvBuf, "  -> discarding repeat event!\n" );
+          return;
+     }
+
+     /* The window core keeps the time of the input event when tracing. */
+     if (dfb_config->latency_trace && (evt->type & CORE_WINDOW_INPUT_EVENTS))
+          dfb_core_trace_latency( core_dfb, DLTS_WINDOW, dfb_core_latency_origin( &evt->timestamp ) );
+
+     event.window = *evt;
+     event.clazz  = DFEC_WINDOW;
+
+     if (data->filter && data->filter( &event, data->filter_ctx ))
+          return;
+
+     IDirectFBEventBuffer_QueueEvent( data, &event );
+}
+
+/*
+ * Releases the window after its last event, 'reaction' is set when called from the reaction of the window.
+ */
+static void
+window_destroyed( IDirectFBEventBuffer_data *data,
+                  DFBWindowID                window_id,
+                  bool                       reaction )
+{
+     AttachedWindow *window;
+
+     direct_list_foreach (window, data->windows) {
+          if (!window->window)
+               continue;
+
+          if (dfb_window_id( window->window ) == window_id) {
+               if (window->ring) {
+                    dfb_window_detach_event_ring( window->window, data->ring );
+
+                    /* The overflow reaction removes itself when it sees the event. */
+                    if (!reaction)
+                         dfb_window_detach( window->window, &window->reaction );
+               }
+
+               /* FIXME: free memory later, because reactor writes to it
+                  after we return RS_REMOVE */
+               dfb_window_unref( window->window );
+               window->window = NULL;
+          }
+     }
+}
+
 static ReactionResult IDirectFBEventBuffer_WindowReact( const void *msg_data,
                                                         void       *ctx )
 {
      const DFBWindowEvent      *evt  = msg_data;
      IDirectFBEventBuffer_data *data = ctx;
-     EventBufferItem           *item;
 
      D_DEBUG_AT( IDFBEvBuf, "%s( %p, %p ) <- type %06x\n", __FUNCTION__, evt, data, evt->type );
 
-     if (dfb_config->discard_repeat_events && (evt->flags & DWEF_REPEAT)) {
-          D_DEBUG_AT( IDFBEvBuf, "  -> discarding repeat event!\n" );
-          return DFB_OK;
-     }
+     direct_mutex_lock( &data->events_mutex );
 
-     item = D_CALLOC( 1, sizeof(EventBufferItem) );
+     queue_window_event( data, evt );
 
-     item->evt.window = *evt;
-     item->evt.clazz  = DFEC_WINDOW;
+     direct_waitqueue_broadcast( &data->wait_condition );
 
-     IDirectFBEventBuffer_AddItem( data, item );
+     direct_mutex_unlock( &data->events_mutex );
 
      if (evt->type == DWET_DESTROYED) {
-          AttachedWindow *window;
+          window_destroyed( data, evt->window_id, true );
 
-          direct_list_foreach (window, data->windows) {
-               if (!window->window)
-                    continue;
+          return RS_REMOVE;
+     }
 
-               if (dfb_window_id( window->window ) == evt->window_id) {
-                    /* FIXME: free memory later, because reactor writes to it
-                       after we return RS_REMOVE */
-                    dfb_window_unref( window->window );
-                    window->window = NULL;
-               }
-          }
+     return RS_OK;
+}
+
+/*
+ * Queues a lifecycle event that did not fit into the event ring of this buffer.
+ */
+static ReactionResult IDirectFBEventBuffer_RingOverflowReact( const void *msg_data,
+                                                              void       *ctx )
+{
+     const CoreWindowEventRingOverflow *overflow = msg_data;
+     IDirectFBEventBuffer_data         *data     = ctx;
+
+     if (overflow->ring != data->ring)
+          return RS_OK;
+
+     D_DEBUG_AT( IDFBEvBuf, "%s( %p, %p ) <- type %06x\n", __FUNCTION__, overflow, data, overflow->event.type );
+
+     direct_mutex_lock( &data->events_mutex );
+
+     queue_window_event( data, &overflow->event );
+
+     direct_waitqueue_broadcast( &data->wait_condition );
+
+     direct_mutex_unlock( &data->events_mutex );
+
+     if (overflow->event.type == DWET_DESTROYED) {
+          window_destroyed( data, overflow->event.window_id, true );
 
           return RS_REMOVE;
      }
@@ -1071,12 +1403,46 @@ static ReactionResult IDirectFBEventBuffer_WindowReact( const void *msg_data,
      return RS_OK;
 }
 
+/*
+ * Queues the window events from the ring in batches, waking up waiters once per batch.
+ */
+static void *
+IDirectFBEventBuffer_RingThread( DirectThread *thread,
+                                 void         *arg )
+{
+     IDirectFBEventBuffer_data *data = arg;
+     DFBWindowEvent             events[32];
+     int                        i, num;
+
+     D_DEBUG_AT( IDFBEvBuf, "%s( %p )\n", __FUNCTION__, data );
+
+     while ((num = dfb_window_event_ring_read( data->ring, events, D_ARRAY_SIZE(events) )) > 0) {
+          D_DEBUG_AT( IDFBEvBuf, "  -> %d events from ring\n", num );
+
+          direct_mutex_lock( &data->events_mutex );
+
+          for (i=0; i<num; i++)
+               queue_window_event( data, &events[i] );
+
+          direct_waitqueue_broadcast( &data->wait_condition );
+
+          direct_mutex_unlock( &data->events_mutex );
+
+          for (i=0; i<num; i++) {
+               if (events[i].type == DWET_DESTROYED)
+                    window_destroyed( data, events[i].window_id, false );
+          }
+     }
+
+     return NULL;
+}
+
 static ReactionResult IDirectFBEventBuffer_SurfaceReact( const void *msg_data,
                                                          void       *ctx )
 {
      const DFBSurfaceEvent     *evt  = msg_data;
      IDirectFBEventBuffer_data *data = ctx;
-     EventBufferItem           *item;
+     DFBEvent                   event;
 
      D_DEBUG_AT( IDFBEvBuf_Surface, "%s( %p, %p ) <- type %06x\n", __FUNCTION__, evt, data, evt->type );
      D_DEBUG_AT( IDFBEvBuf_Surface, "  -> surface id %u\n", evt->surface_id );
@@ -1090,12 +1456,10 @@ static ReactionResult IDirectFBEventBuffer_SurfaceReact( const void *msg_data,
           D_DEBUG_AT( IDFBEvBuf_Surface, "  -> time stamp %lld\n", evt->time_stamp );
      }
 
-     item = D_CALLOC( 1, sizeof(EventBufferItem) );
-
-     item->evt.surface = *evt;
-     item->evt.clazz   = DFEC_SURFACE;
+     event.surface = *evt;
+     event.clazz   = DFEC_SURFACE;
 
-     IDirectFBEventBuffer_AddItem( data, item );
+     IDirectFBEventBuffer_AddEvent( data, &event );
 
      if (evt->type == DSEVT_DESTROYED) {
           AttachedSurface *surface;
@@ -1128,16 +1492,13 @@ IDirectFBEventBuffer_Feed( DirectThread *thread, void *arg )
      direct_mutex_lock( &data->events_mutex );
 
      while (data->pipe) {
-          while (data->events && data->pipe) {
-               int              ret;
-               EventBufferItem *item = (EventBufferItem*) data->events;
+          while (data->events_count && data->pipe) {
+               int      ret;
+               DFBEvent event;
 
-               if (data->stats_enabled)
-                    CollectEventStatistics( &data->stats, &item->evt, -1 );
+               IDirectFBEventBuffer_TakeEvent( data, &event );
 
-               direct_list_remove( &data->events, &item->link );
-
-               if (item->evt.clazz == DFEC_UNIVERSAL) {
+               if (event.clazz == DFEC_UNIVERSAL) {
                     D_WARN( "universal events not supported in pipe mode" );
                     continue;
                }
@@ -1147,15 +1508,13 @@ IDirectFBEventBuffer_Feed( DirectThread *thread, void *arg )
                D_DEBUG_AT( IDFBEvBuf, "Going to write %zu bytes to file descriptor %d...\n",
                            sizeof(DFBEvent), data->pipe_fds[1] );
 
-               ret = write( data->pipe_fds[1], &item->evt, sizeof(DFBEvent) );
+               ret = write( data->pipe_fds[1], &event, sizeof(DFBEvent) );
 
                (void)ret;
 
                D_DEBUG_AT( IDFBEvBuf, "...wrote %d bytes to file descriptor %d.\n",
                            ret, data->pipe_fds[1] );
 
-               D_FREE( item );
-
                direct_mutex_lock( &data->events_mutex );
           }
 
@@ -65,6 +65,10 @@ static ReactionResult
 IDirectFBInputDevice_React( const void *msg_data,
                             void       *ctx );
 
+static ReactionResult
+IDirectFBInputDevice_FrameReact( const void *msg_data,
+                                 void       *ctx );
+
 /*
  * private data struct of IDirectFBInputDevice
  */
@@ -96,7 +100,7 @@ IDirectFBInputDevice_Destruct( IDirectFBInputDevice *thiz )
 {
      IDirectFBInputDevice_data *data = (IDirectFBInputDevice_data*)thiz->priv;
 
-     dfb_input_detach( data->device, &data->reaction );
+     dfb_input_detach_frame( data->device, &data->reaction );
 
      DIRECT_DEALLOCATE_INTERFACE( thiz );
 }
@@ -394,8 +398,8 @@ IDirectFBInputDevice_Construct( IDirectFBInputDevice *thiz,
 
      dfb_input_device_description( device, &data->desc );
 
-     dfb_input_attach( data->device, IDirectFBInputDevice_React,
-                       data, &data->reaction );
+     dfb_input_attach_frame( data->device, IDirectFBInputDevice_FrameReact,
+                             data, &data->reaction );
 
      thiz->AddRef = IDirectFBInputDevice_AddRef;
      thiz->Release = IDirectFBInputDevice_Release;
@@ -464,3 +468,15 @@ IDirectFBInputDevice_React( const void *msg_data,
      return RS_OK;
 }
 
+static ReactionResult
+IDirectFBInputDevice_FrameReact( const void *msg_data,
+                                 void       *ctx )
+{
+     const CoreInputFrame *frame = msg_data;
+     int                   i;
+
+     for (i=0; i<frame->num; i++)
+          IDirectFBInputDevice_React( &frame->events[i], ctx );
+
+     return RS_OK;
+}
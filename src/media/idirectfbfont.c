@@ -305,43 +305,20 @@ IDirectFBFont_GetStringExtents( IDirectFBFont *thiz,
      dfb_font_lock( font );
 
      if (bytes > 0) {
-          int          i, num;
-          unsigned int prev  = 0;
-          unsigned int indices[bytes];
+          CoreFontRun *run;
 
-          /* Decode string to character indices. */
-          ret = dfb_font_decode_text( font, data->encoding, text, bytes, indices, &num );
+          /* Get the laid out string, cached for repeated measuring and drawing. */
+          ret = dfb_font_get_run( font, data->encoding, text, bytes, &run );   // FIXME: support font layers
           if (ret) {
                dfb_font_unlock( font );
                return ret;
           }
 
-          for (i=0; i<num; i++) {
-               unsigned int   current = indices[i];
-               CoreGlyphData *glyph;
+          if (ink_rect)
+               *ink_rect = run->ink;
 
-               if (dfb_font_get_glyph_data( font, current, 0, &glyph ) == DFB_OK) {  // FIXME: support font layers
-                    int kx, ky = 0;
-
-                    if (prev && font->GetKerning &&
-                        font->GetKerning( font, prev, current, &kx, &ky ) == DFB_OK) {
-                         xbaseline += kx << 8;
-                         ybaseline += ky << 8;
-                    }
-
-                    if (ink_rect) {
-                         DFBRectangle glyph_rect = { xbaseline + (glyph->left << 8),
-                              ybaseline + (glyph->top << 8),
-                              glyph->width << 8, glyph->height << 8};
-                         dfb_rectangle_union (ink_rect, &glyph_rect);
-                    }
-
-                    xbaseline += glyph->xadvance;
-                    ybaseline += glyph->yadvance;
-               }
-
-               prev = current;
-          }
+          xbaseline = run->xadvance;
+          ybaseline = run->yadvance;
      }
 
      if (logical_rect) {
@@ -414,38 +391,20 @@ IDirectFBFont_GetStringWidth( IDirectFBFont *thiz,
           bytes = strlen (text);
 
      if (bytes > 0) {
-          int           i, num, kx, ky;
-          unsigned int  prev = 0;
-          unsigned int  indices[bytes];
-          CoreFont     *font = data->font;
+          CoreFontRun *run;
+          CoreFont    *font = data->font;
 
           dfb_font_lock( font );
 
-          /* Decode string to character indices. */
-          ret = dfb_font_decode_text( font, data->encoding, text, bytes, indices, &num );
+          /* Get the laid out string, cached for repeated measuring and drawing. */
+          ret = dfb_font_get_run( font, data->encoding, text, bytes, &run );   // FIXME: support font layers
           if (ret) {
                dfb_font_unlock( font );
                return ret;
           }
 
-          /* Calculate string width. */
-          for (i=0; i<num; i++) {
-               unsigned int   current = indices[i];
-               CoreGlyphData *glyph;
-
-               if (dfb_font_get_glyph_data( font, current, 0, &glyph ) == DFB_OK) {  // FIXME: support font layers
-                    xsize += glyph->xadvance;
-                    ysize += glyph->yadvance;
-
-                    if (prev && font->GetKerning &&
-                        font->GetKerning( font, prev, current, &kx, &ky ) == DFB_OK) {
-                         xsize += kx << 8;
-                         ysize += ky << 8;
-                    }
-               }
-
-               prev = current;
-          }
+          xsize = run->xadvance;
+          ysize = run->yadvance;
 
           dfb_font_unlock( font );
      }
@@ -542,6 +501,7 @@ IDirectFBFont_GetStringBreak( IDirectFBFont *thiz,
      unichar        current;
      unsigned int   index;
      unsigned int   prev  = 0;
+     CoreFontRun   *run   = NULL;
 
      DIRECT_INTERFACE_GET_DATA(IDirectFBFont)
 
@@ -570,6 +530,24 @@ IDirectFBFont_GetStringBreak( IDirectFBFont *thiz,
 
      dfb_font_lock( font );
 
+     /* Use a layout cached by drawing or measuring the text if it has exactly one glyph per character.
+        Laying out the remaining text just for this would cost more than measuring up to the break. */
+     if (dfb_font_lookup_run( font, data->encoding, text, bytes, &run ) == DFB_OK && !run->retry) {
+          int chars = 0;
+
+          while (string < end) {
+               string += DIRECT_UTF8_SKIP( string[0] );
+               chars++;
+          }
+
+          string = (const u8*) text;
+
+          if (chars != run->num)
+               run = NULL;
+     }
+     else
+          run = NULL;
+
      do {
           *ret_width = width >> 8;
 
@@ -586,23 +564,31 @@ IDirectFBFont_GetStringBreak( IDirectFBFont *thiz,
 
           length++;
 
-          ret = dfb_font_decode_character( font, data->encoding, current, &index );
-          if (ret)
-               continue;
+          if (run) {
+               xsize = run->ends[length-1].x;
+               ysize = run->ends[length-1].y;
+          }
+          else {
+               ret = dfb_font_decode_character( font, data->encoding, current, &index );
+               if (ret)
+                    continue;
 
-          ret = dfb_font_get_glyph_data( font, index, 0, &glyph );    // FIXME: support font layers
-          if (ret)
-               continue;
+               ret = dfb_font_get_glyph_data( font, index, 0, &glyph );    // FIXME: support font layers
+               if (ret)
+                    continue;
 
-          xsize += glyph->xadvance;
-          ysize += glyph->yadvance;
+               xsize += glyph->xadvance;
+               ysize += glyph->yadvance;
 
-          if (prev && font->GetKerning && font->GetKerning( font, prev, index, &kern_x, NULL ) == DFB_OK)
-               width += kern_x << 8;
+               if (prev && font->GetKerning && font->GetKerning( font, prev, index, &kern_x, NULL ) == DFB_OK)
+                    width += kern_x << 8;
 
-          if (prev && font->GetKerning && font->GetKerning( font, prev, index, &kern_x, &kern_y) == DFB_OK) {
-               xsize += kern_x << 8;
-               ysize += kern_y << 8;
+               if (prev && font->GetKerning && font->GetKerning( font, prev, index, &kern_x, &kern_y) == DFB_OK) {
+                    xsize += kern_x << 8;
+                    ysize += kern_y << 8;
+               }
+
+               prev = index;
           }
 
           if (!ysize) {
@@ -614,8 +600,6 @@ IDirectFBFont_GetStringBreak( IDirectFBFont *thiz,
           else {
                width = sqrt(xsize * (xsize >> 8) + ysize * (ysize >> 8));
           }
-
-          prev = index;
      } while ((width >> 8) < max_width && string < end && current != 0x0a);
 
      dfb_font_unlock( font );
@@ -827,6 +811,49 @@ IDirectFBFont_GetDescription( IDirectFBFont      *thiz,
      return DFB_OK;
 }
 
+/*
+ * Load the glyphs of a string into the glyph cache.
+ */
+static DFBResult
+IDirectFBFont_PrefetchGlyphs( IDirectFBFont *thiz,
+                              const char    *text,
+                              int            bytes )
+{
+     DFBResult     ret;
+     int           num;
+     unsigned int *indices;
+
+     DIRECT_INTERFACE_GET_DATA(IDirectFBFont)
+
+     D_DEBUG_AT( Font, "%s( %p, %d )\n", __FUNCTION__, thiz, bytes );
+
+     if (!text)
+          return DFB_INVARG;
+
+     if (bytes < 0)
+          bytes = strlen (text);
+
+     if (bytes == 0)
+          return DFB_OK;
+
+     indices = D_MALLOC( bytes * sizeof(unsigned int) );
+     if (!indices)
+          return D_OOM();
+
+     dfb_font_lock( data->font );
+
+     ret = dfb_font_decode_text( data->font, data->encoding, text, bytes, indices, &num );
+
+     dfb_font_unlock( data->font );
+
+     if (ret == DFB_OK)
+          ret = dfb_font_prefetch( data->font, indices, num );
+
+     D_FREE( indices );
+
+     return ret;
+}
+
 /**********************************************************************************************************************/
 
 DFBResult
@@ -856,6 +883,7 @@ IDirectFBFont_Construct( IDirectFBFont *thiz, CoreFont *font )
      thiz->GetGlyphExtentsXY = IDirectFBFont_GetGlyphExtentsXY;
      thiz->GetUnderline = IDirectFBFont_GetUnderline;
      thiz->GetDescription = IDirectFBFont_GetDescription;
+     thiz->PrefetchGlyphs = IDirectFBFont_PrefetchGlyphs;
 
      return DFB_OK;
 }
@@ -1029,6 +1057,8 @@ IDirectFBFont_CreateFromBuffer( IDirectFBDataBuffer       *buffer,
           data->content = ctx.content;
           data->content_size = ctx.content_size;
           data->content_type = ctx.content_type;
+
+          dfb_font_set_content( data->font, ctx.filename, ctx.content, ctx.content_size );
      }
 
      *interface = ifont;
@@ -33,21 +33,36 @@
 #include <config.h>
 
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
+#include <sys/stat.h>
+
 #include <directfb.h>
 
 #include <core/core.h>
+#include <core/image_cache.h>
+#include <core/surface.h>
 
+#include <direct/debug.h>
 #include <direct/interface.h>
 #include <direct/mem.h>
 
+#include <display/idirectfbsurface.h>
+
 #include <fusion/conf.h>
 
+#include <gfx/util.h>
+
+#include <idirectfb.h>
+
 #include <media/idirectfbimageprovider.h>
+#include <media/idirectfbimageprovider_async.h>
 #include <media/idirectfbimageprovider_client.h>
 #include <media/idirectfbdatabuffer.h>
 
+D_DEBUG_DOMAIN( ImageProvider_Cache, "ImageProvider/Cache", "Image Provider Cache" );
+
 
 static DirectResult
 IDirectFBImageProvider_AddRef( IDirectFBImageProvider *thiz )
@@ -72,6 +87,9 @@ IDirectFBImageProvider_Release( IDirectFBImageProvider *thiz )
           if (data->buffer)
                data->buffer->Release( data->buffer );
 
+          if (data->cache_buffer)
+               data->cache_buffer->Release( data->cache_buffer );
+
           DIRECT_DEALLOCATE_INTERFACE( thiz );
      }
 
@@ -150,7 +168,203 @@ IDirectFBImageProvider_Construct( IDirectFBImageProvider *thiz )
      thiz->SetRenderCallback     = IDirectFBImageProvider_SetRenderCallback;
      thiz->SetRenderFlags        = IDirectFBImageProvider_SetRenderFlags;
      thiz->WriteBack             = IDirectFBImageProvider_WriteBack;
+     thiz->RenderToAsync         = IDirectFBImageProvider_Async_RenderTo;
+     thiz->CancelRenderAsync     = IDirectFBImageProvider_Async_Cancel;
+}
+
+/**********************************************************************************************************************/
+
+/* memory buffers larger than this are not hashed for the image cache */
+#define CACHE_HASH_MAX (16 * 1024 * 1024)
+
+/*
+ * Identifies the image data across processes, by the file or by a memory buffer to be hashed with cache_hash().
+ * Called before the implementation reads from the buffer. Returns false if the data can't be identified.
+ */
+static bool
+cache_identify( IDirectFBDataBuffer *buffer,
+                char                *ret_id,
+                size_t               size )
+{
+     IDirectFBDataBuffer_data *buffer_data = buffer->priv;
+     struct stat               st;
+
+     if (buffer_data->filename) {
+          if (stat( buffer_data->filename, &st ))
+               return false;
+
+          snprintf( ret_id, size, "file:%llx:%llx:%llx:%llx.%09lx",
+                    (unsigned long long) st.st_dev, (unsigned long long) st.st_ino,
+                    (unsigned long long) st.st_size, (unsigned long long) st.st_mtim.tv_sec,
+                    (unsigned long) st.st_mtim.tv_nsec );
+
+          return true;
+     }
+
+     if (!buffer_data->is_memory || ((IDirectFBDataBuffer_Memory_data*) buffer_data)->length > CACHE_HASH_MAX)
+          return false;
+
+     /* Not hashed before the image is rendered. */
+     ret_id[0] = 0;
+
+     return true;
+}
+
+/*
+ * Identifies the contents of a memory buffer by their hash.
+ */
+static void
+cache_hash( IDirectFBDataBuffer *buffer,
+            char                *ret_id,
+            size_t               size )
+{
+     IDirectFBDataBuffer_Memory_data *mem_data = buffer->priv;
+     const u8                        *bytes    = mem_data->buffer;
+     unsigned int                     i;
+     unsigned long long               hash     = 0xcbf29ce484222325ULL;
+
+     D_ASSERT( mem_data->base.is_memory );
+
+     /* FNV-1a */
+     for (i=0; i<mem_data->length; i++)
+          hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+
+     snprintf( ret_id, size, "data:%016llx:%x", hash, mem_data->length );
 }
+
+static DFBResult
+IDirectFBImageProvider_Cache_SetRenderFlags( IDirectFBImageProvider *thiz,
+                                             DIRenderFlags           flags )
+{
+     DFBResult ret;
+
+     DIRECT_INTERFACE_GET_DATA( IDirectFBImageProvider )
+
+     ret = data->SetRenderFlags( thiz, flags );
+     if (ret == DFB_OK)
+          data->render_flags = flags;
+
+     return ret;
+}
+
+/*
+ * Blits the image from the cache, decoding it into a new cache entry first if needed.
+ */
+static DFBResult
+IDirectFBImageProvider_Cache_RenderTo( IDirectFBImageProvider *thiz,
+                                       IDirectFBSurface       *destination,
+                                       const DFBRectangle     *destination_rect )
+{
+     DFBResult               ret;
+     IDirectFBSurface_data  *dst_data;
+     CoreSurface            *dst_surface;
+     CoreSurface            *surface;
+     CoreImageCache         *cache;
+     IDirectFB              *idirectfb;
+     DFBRegion               clip;
+     DFBRectangle            rect;
+     DFBRectangle            clipped;
+     char                    key[128];
+
+     DIRECT_INTERFACE_GET_DATA( IDirectFBImageProvider )
+
+     cache     = dfb_core_image_cache( data->core );
+     idirectfb = data->idirectfb ? data->idirectfb : idirectfb_singleton;
+
+     /* Progressive rendering needs the callback to be called while decoding. */
+     if (!cache || !idirectfb || data->render_callback)
+          return data->RenderTo( thiz, destination, destination_rect );
+
+     dst_data = destination->priv;
+     if (!dst_data)
+          return DFB_DEAD;
+
+     dst_surface = dst_data->surface;
+     if (!dst_surface)
+          return DFB_DESTROYED;
+
+     /* The result of indexed formats depends on the palette. */
+     if (DFB_PIXELFORMAT_IS_INDEXED( dst_surface->config.format ))
+          return data->RenderTo( thiz, destination, destination_rect );
+
+     dfb_region_from_rectangle( &clip, &dst_data->area.current );
+
+     if (destination_rect) {
+          if (destination_rect->w < 1 || destination_rect->h < 1)
+               return DFB_INVARG;
+
+          rect    = *destination_rect;
+          rect.x += dst_data->area.wanted.x;
+          rect.y += dst_data->area.wanted.y;
+     }
+     else
+          rect = dst_data->area.wanted;
+
+     if (!data->cache_id[0]) {
+          char cache_id[64];
+
+          D_ASSERT( data->cache_buffer != NULL );
+
+          /* Concurrent renderings write the same identity. */
+          cache_hash( data->cache_buffer, cache_id, sizeof(cache_id) );
+
+          direct_snputs( data->cache_id, cache_id, sizeof(data->cache_id) );
+     }
+
+     snprintf( key, sizeof(key), "%s:%dx%d:%x:%x:%x:%x", data->cache_id, rect.w, rect.h,
+               dst_surface->config.format, dst_surface->config.colorspace,
+               dst_surface->config.caps & DSCAPS_PREMULTIPLIED, data->render_flags );
+
+     ret = dfb_image_cache_lookup( cache, key, &surface );
+     if (ret) {
+          DFBSurfaceDescription  desc;
+          IDirectFBSurface      *decoded;
+
+          D_DEBUG_AT( ImageProvider_Cache, "  -> decoding '%s'\n", key );
+
+          desc.flags       = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT | DSDESC_COLORSPACE | DSDESC_CAPS;
+          desc.width       = rect.w;
+          desc.height      = rect.h;
+          desc.pixelformat = dst_surface->config.format;
+          desc.colorspace  = dst_surface->config.colorspace;
+          desc.caps        = dst_surface->config.caps & DSCAPS_PREMULTIPLIED;
+
+          if (idirectfb->CreateSurface( idirectfb, &desc, &decoded ))
+               return data->RenderTo( thiz, destination, destination_rect );
+
+          ret = data->RenderTo( thiz, decoded, NULL );
+          if (ret) {
+               decoded->Release( decoded );
+
+               /* Let the implementation handle errors and incomplete images as usual. */
+               return data->RenderTo( thiz, destination, destination_rect );
+          }
+
+          surface = ((IDirectFBSurface_data*) decoded->priv)->surface;
+
+          dfb_surface_ref( surface );
+
+          dfb_image_cache_insert( cache, key, surface );
+
+          decoded->Release( decoded );
+     }
+
+     clipped = rect;
+
+     if (dfb_rectangle_intersect_by_region( &clipped, &clip )) {
+          DFBRectangle source = { clipped.x - rect.x, clipped.y - rect.y, clipped.w, clipped.h };
+
+          dfb_gfx_copy_to( surface, dst_surface, &source, clipped.x, clipped.y, false );
+     }
+     else
+          ret = DFB_INVAREA;
+
+     dfb_surface_unref( surface );
+
+     return ret;
+}
+
+/**********************************************************************************************************************/
      
 DFBResult
 IDirectFBImageProvider_CreateFromBuffer( IDirectFBDataBuffer     *buffer,
@@ -164,6 +378,8 @@ IDirectFBImageProvider_CreateFromBuffer( IDirectFBDataBuffer     *buffer,
      IDirectFBImageProvider              *imageprovider;
      IDirectFBImageProvider_ProbeContext  ctx;
      IDirectFBImageProvider_data         *data;
+     char                                 cache_id[64] = "";
+     bool                                 cached       = false;
 
      /* Get the private information of the data buffer. */
      buffer_data = (IDirectFBDataBuffer_data*) buffer->priv;
@@ -210,6 +426,10 @@ IDirectFBImageProvider_CreateFromBuffer( IDirectFBDataBuffer     *buffer,
      if (ret)
           return ret;
 
+     /* Identify the data while the buffer is still at its start. Secure slaves can't write to the shared cache. */
+     if (dfb_core_image_cache( core ) && !(fusion_config->secure_fusion && !dfb_core_is_master( core )))
+          cached = cache_identify( buffer, cache_id, sizeof(cache_id) );
+
      DIRECT_ALLOCATE_INTERFACE( imageprovider, IDirectFBImageProvider );
      
      /* Initialize interface pointers. */
@@ -224,6 +444,23 @@ IDirectFBImageProvider_CreateFromBuffer( IDirectFBDataBuffer     *buffer,
 
      data->idirectfb = idirectfb;
 
+     /* Serve RenderTo() from the image cache if the data can be identified. */
+     if (cached) {
+          direct_snputs( data->cache_id, cache_id, sizeof(data->cache_id) );
+
+          if (!cache_id[0]) {
+               buffer->AddRef( buffer );
+
+               data->cache_buffer = buffer;
+          }
+
+          data->RenderTo       = imageprovider->RenderTo;
+          data->SetRenderFlags = imageprovider->SetRenderFlags;
+
+          imageprovider->RenderTo       = IDirectFBImageProvider_Cache_RenderTo;
+          imageprovider->SetRenderFlags = IDirectFBImageProvider_Cache_SetRenderFlags;
+     }
+
      *interface = imageprovider;
 
      return DFB_OK;
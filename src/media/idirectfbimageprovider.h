@@ -68,6 +68,18 @@ typedef struct {
      void                *render_callback_context;
 
      void (*Destruct)( IDirectFBImageProvider *thiz );
+
+     /* Implementation wrapped to use the image cache, see dfb_core_image_cache(). */
+     DFBResult (*RenderTo)( IDirectFBImageProvider *thiz,
+                            IDirectFBSurface       *destination,
+                            const DFBRectangle     *destination_rect );
+
+     DFBResult (*SetRenderFlags)( IDirectFBImageProvider *thiz,
+                                  DIRenderFlags           flags );
+
+     DIRenderFlags        render_flags;
+     char                 cache_id[64];  /* identity of the image data, see cache_identify() */
+     IDirectFBDataBuffer *cache_buffer;  /* memory buffer hashed on the first cached RenderTo() */
 } IDirectFBImageProvider_data;
 
 
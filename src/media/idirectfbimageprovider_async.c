@@ -0,0 +1,444 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#include <config.h>
+
+#include <string.h>
+
+#include <directfb.h>
+
+#include <direct/debug.h>
+#include <direct/list.h>
+#include <direct/mem.h>
+#include <direct/messages.h>
+#include <direct/thread.h>
+#include <direct/util.h>
+
+#include <misc/conf.h>
+
+#include <media/idirectfbimageprovider_async.h>
+
+D_DEBUG_DOMAIN( ImageProvider_Async, "ImageProvider/Async", "Image Provider Asynchronous Rendering" );
+
+/**********************************************************************************************************************/
+
+typedef struct {
+     DirectLink                link;
+
+     int                       magic;
+
+     IDirectFBImageProvider   *provider;
+     IDirectFBSurface         *destination;
+
+     DFBRectangle              rect;
+     bool                      has_rect;
+
+     DIRenderAsyncDescription  desc;
+
+     DirectThread             *thread;       /* decoder rendering the job, NULL while queued */
+} AsyncJob;
+
+typedef struct {
+     bool                      started;
+     bool                      shutdown;
+
+     DirectWaitQueue           wq;           /* signalled for queued and finished jobs */
+
+     DirectLink               *queued;       /* highest priority first, in order of submission within a priority */
+     DirectLink               *running;
+
+     DirectThread            **threads;
+     int                       num_threads;
+} AsyncPool;
+
+static DirectMutex pool_lock = DIRECT_MUTEX_INITIALIZER(pool_lock);
+static AsyncPool   pool;
+
+/**********************************************************************************************************************/
+
+static void
+job_signal( AsyncJob  *job,
+            DFBResult  result )
+{
+     D_MAGIC_ASSERT( job, AsyncJob );
+
+     if (job->desc.flags & DIRAF_CALLBACK)
+          job->desc.callback( result, job->desc.callback_ctx );
+
+     if (job->desc.flags & DIRAF_EVENT) {
+          DFBUserEvent event;
+
+          event.clazz = DFEC_USER;
+          event.type  = job->desc.event_type;
+          event.data  = job->desc.event_data;
+
+          job->desc.buffer->PostEvent( job->desc.buffer, DFB_EVENT(&event) );
+     }
+}
+
+static void
+job_render( AsyncJob *job )
+{
+     DFBResult ret;
+
+     D_MAGIC_ASSERT( job, AsyncJob );
+
+     D_DEBUG_AT( ImageProvider_Async, "%s( %p ) <- provider %p, priority %d\n", __FUNCTION__,
+                 job, job->provider, job->desc.priority );
+
+     ret = job->provider->RenderTo( job->provider, job->destination, job->has_rect ? &job->rect : NULL );
+
+     D_DEBUG_AT( ImageProvider_Async, "  -> %s\n", DirectFBErrorString( ret ) );
+
+     job_signal( job, ret );
+}
+
+static void
+job_cancel( AsyncJob *job )
+{
+     D_MAGIC_ASSERT( job, AsyncJob );
+
+     D_DEBUG_AT( ImageProvider_Async, "%s( %p ) <- provider %p\n", __FUNCTION__, job, job->provider );
+
+     job_signal( job, DFB_INTERRUPTED );
+}
+
+/*
+ * Drops the references of the job, which may destroy the provider, so the pool must not be locked.
+ */
+static void
+job_release( AsyncJob *job )
+{
+     D_MAGIC_ASSERT( job, AsyncJob );
+
+     if (job->desc.flags & DIRAF_EVENT)
+          job->desc.buffer->Release( job->desc.buffer );
+
+     job->destination->Release( job->destination );
+     job->provider->Release( job->provider );
+
+     D_MAGIC_CLEAR( job );
+
+     D_FREE( job );
+}
+
+/*
+ * Checks if a job of the provider is rendered by another thread than the given one, called with the pool locked.
+ */
+static bool
+provider_busy( IDirectFBImageProvider *provider,
+               DirectThread           *self )
+{
+     AsyncJob *job;
+
+     direct_list_foreach (job, pool.running) {
+          if (job->provider == provider && job->thread != self)
+               return true;
+     }
+
+     return false;
+}
+
+/**********************************************************************************************************************/
+
+static void *
+ImageProvider_Async_Thread( DirectThread *thread,
+                            void         *arg )
+{
+     AsyncJob *job;
+
+     D_DEBUG_AT( ImageProvider_Async, "%s()\n", __FUNCTION__ );
+
+     direct_mutex_lock( &pool_lock );
+
+     while (!pool.shutdown) {
+          /* Providers are not thread safe, take the first job of a provider that is not rendering already. */
+          direct_list_foreach (job, pool.queued) {
+               if (!provider_busy( job->provider, NULL ))
+                    break;
+          }
+
+          if (!job) {
+               direct_waitqueue_wait( &pool.wq, &pool_lock );
+               continue;
+          }
+
+          direct_list_remove( &pool.queued, &job->link );
+          direct_list_append( &pool.running, &job->link );
+
+          job->thread = thread;
+
+          direct_mutex_unlock( &pool_lock );
+
+          job_render( job );
+
+          direct_mutex_lock( &pool_lock );
+
+          direct_list_remove( &pool.running, &job->link );
+
+          /* Wake up decoders waiting for the provider and threads cancelling its renderings. */
+          direct_waitqueue_broadcast( &pool.wq );
+
+          direct_mutex_unlock( &pool_lock );
+
+          job_release( job );
+
+          direct_mutex_lock( &pool_lock );
+     }
+
+     direct_mutex_unlock( &pool_lock );
+
+     return NULL;
+}
+
+/*
+ * Creates the decoder threads on first use, called with the pool locked.
+ */
+static DFBResult
+pool_start( void )
+{
+     int i;
+
+     D_DEBUG_AT( ImageProvider_Async, "%s() <- %u threads\n", __FUNCTION__, dfb_config->image_decode_threads );
+
+     D_ASSERT( !pool.started );
+
+     pool.threads = D_CALLOC( dfb_config->image_decode_threads, sizeof(DirectThread*) );
+     if (!pool.threads)
+          return D_OOM();
+
+     direct_waitqueue_init( &pool.wq );
+
+     for (i=0; i<dfb_config->image_decode_threads; i++) {
+          pool.threads[i] = direct_thread_create( DTT_DEFAULT, ImageProvider_Async_Thread, NULL, "Image Decoder" );
+          if (!pool.threads[i]) {
+               D_ERROR( "ImageProvider/Async: Could not create decoder thread!\n" );
+               break;
+          }
+
+          pool.num_threads++;
+     }
+
+     /* Without any decoder, try again with the next job instead of queueing jobs nobody renders. */
+     if (!pool.num_threads) {
+          direct_waitqueue_deinit( &pool.wq );
+
+          D_FREE( pool.threads );
+
+          pool.threads = NULL;
+
+          return DFB_FAILURE;
+     }
+
+     pool.started = true;
+
+     return DFB_OK;
+}
+
+/**********************************************************************************************************************/
+
+DFBResult
+IDirectFBImageProvider_Async_RenderTo( IDirectFBImageProvider         *thiz,
+                                       IDirectFBSurface               *destination,
+                                       const DFBRectangle             *destination_rect,
+                                       const DIRenderAsyncDescription *desc )
+{
+     DFBResult  ret;
+     AsyncJob  *job;
+     AsyncJob  *pos;
+
+     D_DEBUG_AT( ImageProvider_Async, "%s( %p, %p )\n", __FUNCTION__, thiz, destination );
+
+     if (!destination)
+          return DFB_INVARG;
+
+     if (desc) {
+          if ((desc->flags & ~DIRAF_ALL) ||
+              ((desc->flags & DIRAF_CALLBACK) && !desc->callback) ||
+              ((desc->flags & DIRAF_EVENT) && !desc->buffer))
+               return DFB_INVARG;
+     }
+
+     job = D_CALLOC( 1, sizeof(AsyncJob) );
+     if (!job)
+          return D_OOM();
+
+     job->provider    = thiz;
+     job->destination = destination;
+
+     if (destination_rect) {
+          job->rect     = *destination_rect;
+          job->has_rect = true;
+     }
+
+     if (desc) {
+          job->desc = *desc;
+
+          if (!(desc->flags & DIRAF_PRIORITY))
+               job->desc.priority = 0;
+     }
+
+     thiz->AddRef( thiz );
+     destination->AddRef( destination );
+
+     if (job->desc.flags & DIRAF_EVENT)
+          job->desc.buffer->AddRef( job->desc.buffer );
+
+     D_MAGIC_SET( job, AsyncJob );
+
+     /* Without decoder threads render right away. */
+     if (!dfb_config->image_decode_threads) {
+          job_render( job );
+          job_release( job );
+
+          return DFB_OK;
+     }
+
+     direct_mutex_lock( &pool_lock );
+
+     if (pool.shutdown) {
+          direct_mutex_unlock( &pool_lock );
+          job_release( job );
+          return DFB_DESTROYED;
+     }
+
+     if (!pool.started) {
+          ret = pool_start();
+          if (ret) {
+               direct_mutex_unlock( &pool_lock );
+               job_release( job );
+               return ret;
+          }
+     }
+
+     direct_list_foreach (pos, pool.queued) {
+          if (pos->desc.priority < job->desc.priority)
+               break;
+     }
+
+     direct_list_insert( &pool.queued, &job->link, pos ? &pos->link : NULL );
+
+     direct_waitqueue_broadcast( &pool.wq );
+
+     direct_mutex_unlock( &pool_lock );
+
+     return DFB_OK;
+}
+
+DFBResult
+IDirectFBImageProvider_Async_Cancel( IDirectFBImageProvider *thiz )
+{
+     AsyncJob     *job;
+     AsyncJob     *next;
+     DirectLink   *cancelled = NULL;
+     DirectThread *self      = direct_thread_self();
+
+     D_DEBUG_AT( ImageProvider_Async, "%s( %p )\n", __FUNCTION__, thiz );
+
+     direct_mutex_lock( &pool_lock );
+
+     if (!pool.started) {
+          direct_mutex_unlock( &pool_lock );
+          return DFB_OK;
+     }
+
+     direct_list_foreach_safe (job, next, pool.queued) {
+          if (job->provider == thiz) {
+               direct_list_remove( &pool.queued, &job->link );
+               direct_list_append( &cancelled, &job->link );
+          }
+     }
+
+     /* Wait for the rendering in progress, unless called from its completion callback. */
+     while (provider_busy( thiz, self ))
+          direct_waitqueue_wait( &pool.wq, &pool_lock );
+
+     direct_mutex_unlock( &pool_lock );
+
+     direct_list_foreach_safe (job, next, cancelled) {
+          job_cancel( job );
+          job_release( job );
+     }
+
+     return DFB_OK;
+}
+
+void
+IDirectFBImageProvider_Async_Shutdown( void )
+{
+     int         i;
+     AsyncJob   *job;
+     AsyncJob   *next;
+     DirectLink *cancelled;
+
+     D_DEBUG_AT( ImageProvider_Async, "%s()\n", __FUNCTION__ );
+
+     direct_mutex_lock( &pool_lock );
+
+     if (!pool.started) {
+          direct_mutex_unlock( &pool_lock );
+          return;
+     }
+
+     cancelled   = pool.queued;
+     pool.queued = NULL;
+
+     /* Decoders finish the job they are rendering. */
+     pool.shutdown = true;
+
+     direct_waitqueue_broadcast( &pool.wq );
+
+     direct_mutex_unlock( &pool_lock );
+
+     for (i=0; i<pool.num_threads; i++) {
+          direct_thread_join( pool.threads[i] );
+          direct_thread_destroy( pool.threads[i] );
+     }
+
+     direct_list_foreach_safe (job, next, cancelled) {
+          job_cancel( job );
+          job_release( job );
+     }
+
+     direct_mutex_lock( &pool_lock );
+
+     D_ASSERT( pool.running == NULL );
+
+     direct_waitqueue_deinit( &pool.wq );
+
+     D_FREE( pool.threads );
+
+     memset( &pool, 0, sizeof(pool) );
+
+     direct_mutex_unlock( &pool_lock );
+}
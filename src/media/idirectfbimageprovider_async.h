@@ -0,0 +1,59 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+
+
+
+#ifndef __IDIRECTFBIMAGEPROVIDER_ASYNC_H__
+#define __IDIRECTFBIMAGEPROVIDER_ASYNC_H__
+
+#include <directfb.h>
+
+/*
+ * Generic implementation of IDirectFBImageProvider::RenderToAsync(),
+ * calling RenderTo() of the provider in a pool of decoder threads.
+ */
+DFBResult IDirectFBImageProvider_Async_RenderTo( IDirectFBImageProvider         *thiz,
+                                                 IDirectFBSurface               *destination,
+                                                 const DFBRectangle             *destination_rect,
+                                                 const DIRenderAsyncDescription *desc );
+
+/*
+ * Generic implementation of IDirectFBImageProvider::CancelRenderAsync().
+ */
+DFBResult IDirectFBImageProvider_Async_Cancel  ( IDirectFBImageProvider         *thiz );
+
+/*
+ * Cancel all pending renderings and stop the decoder threads, done when the IDirectFB is destroyed.
+ */
+void      IDirectFBImageProvider_Async_Shutdown( void );
+
+
+#endif
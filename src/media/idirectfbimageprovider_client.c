@@ -50,6 +50,7 @@
 
 #include <media/ImageProvider.h>
 
+#include <media/idirectfbimageprovider_async.h>
 #include <media/idirectfbimageprovider_client.h>
 #include <media/idirectfbdatabuffer.h>
 
@@ -174,6 +175,8 @@ IDirectFBImageProvider_Client_Construct( IDirectFBImageProvider *thiz,
      thiz->RenderTo              = IDirectFBImageProvider_Client_RenderTo;
      thiz->SetRenderCallback     = IDirectFBImageProvider_Client_SetRenderCallback;
      thiz->WriteBack             = IDirectFBImageProvider_Client_WriteBack;
+     thiz->RenderToAsync         = IDirectFBImageProvider_Async_RenderTo;
+     thiz->CancelRenderAsync     = IDirectFBImageProvider_Async_Cancel;
 
      return DFB_OK;
 }
@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <unistd.h>
 
 #include <directfb.h>
 #include <directfb_util.h>
@@ -119,6 +120,23 @@ static const char *config_usage_strings[]  = {
      "  screen-frame-interval=<us>     Set default value for screen refresh interval if not encoder defined (default 16666)\n"
      "  max-frame-advance=<us>         Set default value for maximum time ahead for rendering frames (default 100000)\n"
      "  max-render-tasks=<num>         Set maximum number of rendering tasks per Renderer (gfx context) before blocking client\n"
+     "  [no-]frame-pacing              Align display tasks with the screen refresh, dropping late timed frames (default: yes)\n"
+     "  [no-]frame-pacing-stats=[<ms>] Print frame pacing statistics periodically (default 1000)\n"
+     "  [no-]latency-trace             Collect input to display latency histograms, see IDirectFB::GetLatencyStats()\n"
+     "  [no-]input-resample[=<us>]     Resample pointer motion per display frame, <us> before the retrace (default 5000)\n"
+     "  [no-]window-event-ring[=<num>] Pass window events to slaves via a ring in shared memory (default 256 events)\n"
+     "  input-replay=<file>            Play an input recording of dfbrecordinput via the 'replay' input driver\n"
+     "  input-replay-speed=<percent>   Playback speed of the input recording, 0 for no delays (default 100)\n"
+     "  [no-]input-replay-loop         Play the input recording again and again\n"
+     "  image-cache=<kb>               Share decoded images between processes up to the given size (default 0 = off)\n"
+     "  image-decode-threads=<num>     Number of threads decoding images rendered asynchronously (default online CPUs)\n"
+     "  [no-]flip-mailbox              Let triple buffered surfaces replace frames not displayed yet instead of waiting\n"
+     "  [no-]window-update-throttle    Merge window updates coming in faster than the screen refresh (default: yes)\n"
+     "  window-max-update-rate=<hz>    Limit window updates per second unless set per window (default: none)\n"
+     "  [no-]hw-cursor                 Show the cursor on a cursor layer, e.g. a DRM cursor plane (default: yes)\n"
+     "  cursor-layer=<id>              Use the given layer for the cursor instead of looking for a cursor layer\n"
+     "  event-buffer-size=<num>        Number of events preallocated per event buffer (default 256)\n"
+     "  event-buffer-overflow=<policy> Full event buffers grow, drop-oldest or coalesce-motion (default grow)\n"
      "  [no-]dma                       Enable DMA acceleration\n"
      "  [no-]sync                      Do `sync()' (default=no)\n",
 #ifdef USE_MMX
@@ -145,6 +163,7 @@ static const char *config_usage_strings[]  = {
      "  linux-input-ir-only            Ignore all non-IR Linux Input devices\n"
      "  [no-]linux-input-grab          Grab Linux Input devices?\n"
      "  [no-]linux-input-force         Force using linux-input with all system modules\n"
+     "  [no-]linux-input-epoll         Serve all Linux Input devices and hotplug from one thread\n"
      "  [no-]cursor                    Never create a cursor or handle it\n"
      "  [no-]cursor-automation         Automated cursor show/hide for windowed primary surfaces\n"
      "  [no-]cursor-updates            Never show a cursor, but still handle it\n"
@@ -214,6 +233,9 @@ static const char *config_usage_strings[]  = {
      "\n"
      "  max-font-rows=<number>         Maximum number of glyph cache rows (total for all fonts)\n"
      "  max-font-row-width=<pixels>    Maximum width of glyph cache row surface\n"
+     "  max-font-runs=<number>         Maximum number of laid out strings cached per font\n"
+     "  font-prefetch-threads=<number> Number of threads per font rasterizing prefetched glyphs\n"
+     "  font-cache-dir=<directory>     Keep rendered glyphs in files within this directory\n"
      "  graphics-state-call-limit=<n>  Set FusionCall quota for graphics state object (default 5000)\n"
      "\n",
      " Window surface swapping policy:\n"
@@ -428,6 +450,7 @@ static void config_cleanup( void )
 static void config_allocate( void )
 {
     int i, usage_length = 0;
+    long num;
 
      if (dfb_config)
           return;
@@ -519,6 +542,9 @@ static void config_allocate( void )
 
      dfb_config->max_font_rows      = 99;
      dfb_config->max_font_row_width = 2048;
+     dfb_config->max_font_runs      = 64;
+
+     dfb_config->font_prefetch_threads = 2;
 
      dfb_config->core_sighandler    = true;
 
@@ -531,6 +557,25 @@ static void config_allocate( void )
      dfb_config->max_frame_advance         = 100000;
 
      dfb_config->ownership_check           = true;
+
+     dfb_config->frame_pacing              = true;
+
+     dfb_config->window_update_throttle    = true;
+
+     dfb_config->hw_cursor                 = true;
+     dfb_config->cursor_layer              = -1;
+
+     dfb_config->event_buffer_size         = 256;
+     dfb_config->event_buffer_overflow     = DCEO_GROW;
+
+     dfb_config->input_resample_offset     = 5000;
+
+     dfb_config->input_replay_speed        = 100;
+
+     /* Decode on all cores. */
+     num = sysconf( _SC_NPROCESSORS_ONLN );
+
+     dfb_config->image_decode_threads      = num > 0 ? num : 2;
 }
 
 const char *dfb_config_usage( void )
@@ -1056,6 +1101,12 @@ DFBResult dfb_config_set( const char *name, const char *value )
      if (strcmp (name, "no-cursor-updates" ) == 0) {
           dfb_config->no_cursor_updates = true;
      } else
+     if (strcmp (name, "linux-input-epoll" ) == 0) {
+          dfb_config->linux_input_epoll = true;
+     } else
+     if (strcmp (name, "no-linux-input-epoll" ) == 0) {
+          dfb_config->linux_input_epoll = false;
+     } else
      if (strcmp (name, "linux-input-ir-only" ) == 0) {
           dfb_config->linux_input_ir_only = true;
      } else
@@ -1857,6 +1908,55 @@ DFBResult dfb_config_set( const char *name, const char *value )
                return DFB_INVARG;
           }
      } else
+     if (strcmp (name, "max-font-runs" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long num;
+
+               num = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->max_font_runs = num;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "font-prefetch-threads" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long num;
+
+               num = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->font_prefetch_threads = num;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "font-cache-dir" ) == 0) {
+          if (value) {
+               if (dfb_config->font_cache_dir)
+                    D_FREE( dfb_config->font_cache_dir );
+               dfb_config->font_cache_dir = D_STRDUP( value );
+          }
+          else {
+               D_ERROR("DirectFB/Config 'font-cache-dir': No directory name specified!\n");
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp (name, "graphics-state-call-limit" ) == 0) {
           if (value) {
                char *error;
@@ -1934,6 +2034,11 @@ DFBResult dfb_config_set( const char *name, const char *value )
                     return DFB_INVARG;
                }
 
+               if (interval <= 0) {
+                    D_ERROR( "DirectFB/Config '%s': Interval must be positive!\n", name );
+                    return DFB_INVARG;
+               }
+
                dfb_config->screen_frame_interval = interval;
           }
           else {
@@ -1960,6 +2065,244 @@ DFBResult dfb_config_set( const char *name, const char *value )
                return DFB_INVARG;
           }
      } else
+     if (strcmp (name, "frame-pacing" ) == 0) {
+          dfb_config->frame_pacing = true;
+     } else
+     if (strcmp (name, "no-frame-pacing" ) == 0) {
+          dfb_config->frame_pacing = false;
+     } else
+     if (strcmp (name, "frame-pacing-stats" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long interval;
+
+               interval = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->frame_pacing_stats = interval;
+          }
+          else
+               dfb_config->frame_pacing_stats = 1000;
+     } else
+     if (strcmp (name, "no-frame-pacing-stats" ) == 0) {
+          dfb_config->frame_pacing_stats = 0;
+     } else
+     if (strcmp (name, "latency-trace" ) == 0) {
+          dfb_config->latency_trace = true;
+     } else
+     if (strcmp (name, "no-latency-trace" ) == 0) {
+          dfb_config->latency_trace = false;
+     } else
+     if (strcmp (name, "input-resample" ) == 0) {
+          if (value) {
+               char *error;
+               long  offset;
+
+               offset = strtol( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->input_resample_offset = offset;
+          }
+
+          dfb_config->input_resample = true;
+     } else
+     if (strcmp (name, "no-input-resample" ) == 0) {
+          dfb_config->input_resample = false;
+     } else
+     if (strcmp (name, "window-event-ring" ) == 0) {
+          if (value) {
+               char          *error;
+               unsigned long  size;
+
+               size = strtoul( value, &error, 10 );
+
+               if (*error || !size) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->window_event_ring = size;
+          }
+          else
+               dfb_config->window_event_ring = 256;
+     } else
+     if (strcmp (name, "no-window-event-ring" ) == 0) {
+          dfb_config->window_event_ring = 0;
+     } else
+     if (strcmp (name, "input-replay" ) == 0) {
+          if (value) {
+               if (dfb_config->input_replay)
+                    D_FREE( dfb_config->input_replay );
+               dfb_config->input_replay = D_STRDUP( value );
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No file specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "input-replay-speed" ) == 0) {
+          if (value) {
+               char          *error;
+               unsigned long  speed;
+
+               speed = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->input_replay_speed = speed;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "input-replay-loop" ) == 0) {
+          dfb_config->input_replay_loop = true;
+     } else
+     if (strcmp (name, "no-input-replay-loop" ) == 0) {
+          dfb_config->input_replay_loop = false;
+     } else
+     if (strcmp (name, "image-cache" ) == 0) {
+          if (value) {
+               char          *error;
+               unsigned long  size;
+
+               size = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->image_cache = size;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No size specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "image-decode-threads" ) == 0) {
+          if (value) {
+               char          *error;
+               unsigned long  num;
+
+               num = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->image_decode_threads = num;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "flip-mailbox" ) == 0) {
+          dfb_config->flip_mailbox = true;
+     } else
+     if (strcmp (name, "no-flip-mailbox" ) == 0) {
+          dfb_config->flip_mailbox = false;
+     } else
+     if (strcmp (name, "window-update-throttle" ) == 0) {
+          dfb_config->window_update_throttle = true;
+     } else
+     if (strcmp (name, "no-window-update-throttle" ) == 0) {
+          dfb_config->window_update_throttle = false;
+     } else
+     if (strcmp (name, "window-max-update-rate" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long rate;
+
+               rate = strtoul( value, &error, 10 );
+
+               if (*error) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, error );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->window_max_update_rate = rate;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "hw-cursor" ) == 0) {
+          dfb_config->hw_cursor = true;
+     } else
+     if (strcmp (name, "no-hw-cursor" ) == 0) {
+          dfb_config->hw_cursor = false;
+     } else
+     if (strcmp (name, "cursor-layer" ) == 0) {
+          if (value) {
+               int id;
+
+               if (direct_sscanf( value, "%d", &id ) < 1) {
+                    D_ERROR("DirectFB/Config 'cursor-layer': Could not parse id!\n");
+                    return DFB_INVARG;
+               }
+
+               dfb_config->cursor_layer = id;
+          }
+          else {
+               D_ERROR("DirectFB/Config 'cursor-layer': No id specified!\n");
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "event-buffer-size" ) == 0) {
+          if (value) {
+               char *error;
+               unsigned long size;
+
+               size = strtoul( value, &error, 10 );
+
+               if (*error || !size) {
+                    D_ERROR( "DirectFB/Config '%s': Error in value '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->event_buffer_size = size;
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp (name, "event-buffer-overflow" ) == 0) {
+          if (value) {
+               if (strcmp( value, "grow" ) == 0) {
+                    dfb_config->event_buffer_overflow = DCEO_GROW;
+               } else
+               if (strcmp( value, "drop-oldest" ) == 0) {
+                    dfb_config->event_buffer_overflow = DCEO_DROP_OLDEST;
+               } else
+               if (strcmp( value, "coalesce-motion" ) == 0) {
+                    dfb_config->event_buffer_overflow = DCEO_COALESCE_MOTION;
+               } else {
+                    D_ERROR( "DirectFB/Config '%s': Unknown policy '%s'!\n", name, value );
+                    return DFB_INVARG;
+               }
+          }
+          else {
+               D_ERROR( "DirectFB/Config '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp (name, "max-render-tasks" ) == 0) {
           if (value) {
                char *error;
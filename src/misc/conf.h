@@ -75,6 +75,12 @@ typedef enum {
      DCWF_ALL                           = 0x00000013
 } DFBConfigWarnFlags;
 
+typedef enum {
+     DCEO_GROW                          = 0,      /* enlarge the event ring */
+     DCEO_DROP_OLDEST                   = 1,      /* drop the oldest queued event */
+     DCEO_COALESCE_MOTION               = 2       /* merge into a queued motion event, else drop the oldest */
+} DFBConfigEventOverflow;
+
 typedef struct
 {
      bool      mouse_motion_compression;          /* use motion compression? */
@@ -330,6 +336,41 @@ typedef struct
      bool          ownership_check;
 
      bool          force_frametime;
+
+     unsigned int  max_font_runs;                 /* Maximum number of cached text runs per font */
+     unsigned int  font_prefetch_threads;         /* Glyph rasterization threads per font for prefetching */
+     char         *font_cache_dir;                /* Directory for persistent glyph cache files */
+
+     bool          frame_pacing;                  /* Schedule display tasks on the vertical retrace grid */
+     unsigned int  frame_pacing_stats;            /* Interval in ms for printing pacing statistics, 0 for none */
+
+     bool          flip_mailbox;                  /* Flip triple buffered surfaces in mailbox mode (DSFLIP_MAILBOX) */
+
+     bool          window_update_throttle;        /* Forward window updates to the window manager at screen refresh rate at most */
+     unsigned int  window_max_update_rate;        /* Default limit of window updates per second, 0 for none */
+
+     bool          hw_cursor;                     /* Show the cursor on a dedicated layer if there is one */
+     int           cursor_layer;                  /* Layer for the cursor, -1 to look for a DLTF_CURSOR layer */
+
+     unsigned int           event_buffer_size;      /* Number of events preallocated per event buffer */
+     DFBConfigEventOverflow event_buffer_overflow;  /* What to do when an event buffer is full */
+
+     bool          linux_input_epoll;             /* Serve all Linux Input devices from one epoll thread */
+
+     bool          latency_trace;                 /* Collect input to display latency histograms */
+
+     bool          input_resample;                /* Deliver pointer motion once per display frame */
+     int           input_resample_offset;         /* Time before the retrace to resample at (us), negative to predict */
+
+     unsigned int  window_event_ring;             /* Size of the shared window event ring of slaves, 0 to disable */
+
+     char         *input_replay;                  /* Input recording played by the 'replay' input driver */
+     unsigned int  input_replay_speed;            /* Playback speed in percent, 0 for no delays */
+     bool          input_replay_loop;             /* Play the recording again and again */
+
+     unsigned int  image_cache;                   /* Budget of the decoded image cache in kB, 0 to disable */
+
+     unsigned int  image_decode_threads;          /* Threads for IDirectFBImageProvider::RenderToAsync(), 0 to render synchronously */
 } DFBConfig;
 
 extern DFBConfig DIRECTFB_API *dfb_config;
@@ -56,6 +56,12 @@
 
 D_DEBUG_DOMAIN( DFB_Updates, "DirectFB/Updates", "DirectFB Updates" );
 
+/*
+ * Estimated cost of each update rectangle in addition to its pixels,
+ * e.g. for setting up the blits and flips of the repaint.
+ */
+#define DFB_UPDATES_RECT_COST  4096
+
 /**********************************************************************************************************************/
 
 const DirectFBPixelFormatNames( dfb_pixelformat_names )
@@ -288,6 +294,97 @@ dfb_updates_init( DFBUpdates *updates,
      D_MAGIC_SET( updates, DFBUpdates );
 }
 
+static __inline__ long long
+updates_region_area( const DFBRegion *region )
+{
+     return (long long) (region->x2 - region->x1 + 1) * (region->y2 - region->y1 + 1);
+}
+
+/*
+ * Merges other regions touching the one at 'index' into it, until none is left.
+ */
+static void
+updates_absorb( DFBUpdates *updates,
+                int         index )
+{
+     int  i;
+     bool merged;
+
+     do {
+          merged = false;
+
+          for (i=0; i<updates->num_regions; i++) {
+               if (i == index)
+                    continue;
+
+               if (dfb_region_region_extends( &updates->regions[index], &updates->regions[i] ) ||
+                   dfb_region_region_intersects( &updates->regions[index], &updates->regions[i] ))
+               {
+                    D_DEBUG_AT( DFB_Updates, "  -> absorbing  [%d] %4d,%4d-%4dx%4d\n", i,
+                                DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[i]) );
+
+                    dfb_region_region_union( &updates->regions[index], &updates->regions[i] );
+
+                    /* Move last region into the free slot. */
+                    updates->regions[i] = updates->regions[--updates->num_regions];
+
+                    if (index == updates->num_regions)
+                         index = i;
+
+                    merged = true;
+                    break;
+               }
+          }
+     } while (merged);
+}
+
+/*
+ * Makes room for the new region by merging the pair of regions (including the new one)
+ * which adds the least pixels to the repaint, instead of collapsing into the bounding box.
+ */
+static void
+updates_merge_cheapest( DFBUpdates      *updates,
+                        const DFBRegion *region )
+{
+     int        i, j;
+     int        best_i = 0, best_j = 0;
+     int        num    = updates->num_regions;
+     long long  best   = -1;
+     DFBRegion  merged;
+
+     /* Index 'num' stands for the new region. */
+     for (i=0; i<num; i++) {
+          for (j=i+1; j<=num; j++) {
+               const DFBRegion *b = (j < num) ? &updates->regions[j] : region;
+               long long        cost;
+
+               merged = updates->regions[i];
+
+               dfb_region_region_union( &merged, b );
+
+               cost = updates_region_area( &merged ) - updates_region_area( &updates->regions[i] ) - updates_region_area( b );
+
+               if (best < 0 || cost < best) {
+                    best   = cost;
+                    best_i = i;
+                    best_j = j;
+               }
+          }
+     }
+
+     D_DEBUG_AT( DFB_Updates, "  -> merging [%d] and [%d] adding %lld pixels\n", best_i, best_j, best );
+
+     if (best_j < num) {
+          dfb_region_region_union( &updates->regions[best_i], &updates->regions[best_j] );
+
+          updates->regions[best_j] = *region;
+     }
+     else
+          dfb_region_region_union( &updates->regions[best_i], region );
+
+     updates_absorb( updates, best_i );
+}
+
 void
 dfb_updates_add( DFBUpdates      *updates,
                  const DFBRegion *region )
@@ -312,6 +409,8 @@ dfb_updates_add( DFBUpdates      *updates,
           return;
      }
 
+     dfb_region_region_union( &updates->bounding, region );
+
      for (i=0; i<updates->num_regions; i++) {
           if (dfb_region_region_extends( &updates->regions[i], region ) ||
               dfb_region_region_intersects( &updates->regions[i], region ))
@@ -321,29 +420,29 @@ dfb_updates_add( DFBUpdates      *updates,
 
                dfb_region_region_union( &updates->regions[i], region );
 
-               dfb_region_region_union( &updates->bounding, region );
-
                D_DEBUG_AT( DFB_Updates, "  -> resulting in  [%d] %4d,%4d-%4dx%4d\n", i,
                            DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[i]) );
 
+               /* The grown region may touch others now. */
+               updates_absorb( updates, i );
+
                return;
           }
      }
 
      if (updates->num_regions == updates->max_regions) {
-          dfb_region_region_union( &updates->bounding, region );
+          if (updates->max_regions == 1) {
+               updates->regions[0] = updates->bounding;
 
-          updates->regions[0]  = updates->bounding;
-          updates->num_regions = 1;
-
-          D_DEBUG_AT( DFB_Updates, "  -> collapsing to [0] %4d,%4d-%4dx%4d\n",
-                      DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[0]) );
+               D_DEBUG_AT( DFB_Updates, "  -> collapsing to [0] %4d,%4d-%4dx%4d\n",
+                           DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[0]) );
+          }
+          else
+               updates_merge_cheapest( updates, region );
      }
      else {
           updates->regions[updates->num_regions++] = *region;
 
-          dfb_region_region_union( &updates->bounding, region );
-
           D_DEBUG_AT( DFB_Updates, "  -> added as      [%d] %4d,%4d-%4dx%4d\n", updates->num_regions - 1,
                       DFB_RECTANGLE_VALS_FROM_REGION(&updates->regions[updates->num_regions - 1]) );
      }
@@ -404,15 +503,12 @@ dfb_updates_get_rectangles( DFBUpdates   *updates,
                break;
 
           default: {
-               int n, d, total, bounding;
+               int n, total, bounding;
 
                dfb_updates_stat( updates, &total, &bounding );
 
-               n = updates->max_regions - updates->num_regions + 1;
-               d = n + 1;
-
-               /* Try to optimize updates. Use individual regions only if not too much overhead. */
-               if (total < bounding * n / d) {
+               /* Use individual regions only if cheaper than repainting the bounding box. */
+               if ((long long) total + (updates->num_regions - 1) * DFB_UPDATES_RECT_COST < bounding) {
                     *ret_num = updates->num_regions;
 
                     for (n=0; n<updates->num_regions; n++) {
@@ -121,7 +121,7 @@ IDirectFBWindow_Destruct( IDirectFBWindow *thiz )
      if (!data->detached) {
           D_DEBUG_AT( IDirectFB_Window, "  -> detaching...\n" );
 
-          dfb_window_detach( data->window, &data->reaction );
+          dfb_window_detach_listener( data->window, &data->reaction );
      }
 
      if (data->created) {
@@ -1467,6 +1467,24 @@ IDirectFBWindow_SetGeometry( IDirectFBWindow         *thiz,
      return CoreWindow_SetConfig( data->window, &config, NULL, 0, CWCF_SRC_GEOMETRY | CWCF_DST_GEOMETRY );
 }
 
+static DFBResult
+IDirectFBWindow_SetMaxUpdateRate( IDirectFBWindow *thiz,
+                                  unsigned int     rate )
+{
+     CoreWindowConfig config;
+
+     DIRECT_INTERFACE_GET_DATA(IDirectFBWindow)
+
+     D_DEBUG_AT( IDirectFB_Window, "%s( %u )\n", __FUNCTION__, rate );
+
+     if (data->destroyed)
+          return DFB_DESTROYED;
+
+     config.max_update_rate = rate;
+
+     return CoreWindow_SetConfig( data->window, &config, NULL, 0, CWCF_MAX_UPDATE_RATE );
+}
+
 DFBResult
 IDirectFBWindow_Construct( IDirectFBWindow *thiz,
                            CoreWindow      *window,
@@ -1488,7 +1506,7 @@ IDirectFBWindow_Construct( IDirectFBWindow *thiz,
      data->created   = created;
      data->cursor_flags = DWCF_INVISIBLE;
 
-     dfb_window_attach( window, IDirectFBWindow_React, data, &data->reaction );
+     dfb_window_attach_listener( window, IDirectFBWindow_React, data, &data->reaction );
 
      thiz->AddRef = IDirectFBWindow_AddRef;
      thiz->Release = IDirectFBWindow_Release;
@@ -1553,6 +1571,7 @@ IDirectFBWindow_Construct( IDirectFBWindow *thiz,
      thiz->GetStereoDepth = IDirectFBWindow_GetStereoDepth;
      thiz->SetStereoDepth = IDirectFBWindow_SetStereoDepth;
      thiz->SetGeometry = IDirectFBWindow_SetGeometry;
+     thiz->SetMaxUpdateRate = IDirectFBWindow_SetMaxUpdateRate;
 
      return DFB_OK;
 }
@@ -380,6 +380,11 @@ drmkmsPlaneInitLayer( CoreLayer                  *layer,
                     data->alpha_propid = prop->prop_id;
                     D_INFO( "     alpha\n" );
                }
+               else if (!strcmp(prop->name, "type") && props->prop_values[i] == DRM_PLANE_TYPE_CURSOR) {
+                    description->type = DLTF_CURSOR;
+                    snprintf( description->name, DFB_DISPLAY_LAYER_DESC_NAME_LENGTH, "DRMKMS Cursor Plane %d", data->plane_index );
+                    D_INFO( "     cursor plane\n" );
+               }
 
                drmModeFreeProperty( prop );
           }
@@ -36,6 +36,7 @@
 #include <config.h>
 
 #include <fcntl.h>
+#include <string.h>
 #include <sys/mman.h>
 
 #include <directfb.h>
@@ -113,6 +114,44 @@ DRMKMS_BufferThread_Main( DirectThread *thread, void *arg )
      return NULL;
 }
 
+/*
+ * With universal planes the kernel also lists the primary planes, which are driven via the CRTC already.
+ * Drop them from the plane resources, so that only overlay and cursor planes become plane layers.
+ */
+static void
+drop_primary_planes( DRMKMSData *drmkms )
+{
+     int i, num = 0;
+
+     for (i = 0; i < drmkms->plane_resources->count_planes; i++) {
+          u32                        plane_id = drmkms->plane_resources->planes[i];
+          bool                       primary  = false;
+          drmModeObjectPropertiesPtr props;
+
+          props = drmModeObjectGetProperties( drmkms->fd, plane_id, DRM_MODE_OBJECT_PLANE );
+          if (props) {
+               int                j;
+               drmModePropertyPtr prop;
+
+               for (j = 0; j < props->count_props; j++) {
+                    prop = drmModeGetProperty( drmkms->fd, props->props[j] );
+                    if (!prop)
+                         continue;
+
+                    if (!strcmp( prop->name, "type" ) && props->prop_values[j] == DRM_PLANE_TYPE_PRIMARY)
+                         primary = true;
+
+                    drmModeFreeProperty( prop );
+               }
+               drmModeFreeObjectProperties( props );
+          }
+
+          if (!primary)
+               drmkms->plane_resources->planes[num++] = plane_id;
+     }
+
+     drmkms->plane_resources->count_planes = num;
+}
 
 static DFBResult
 InitLocal( DRMKMSData *drmkms )
@@ -151,7 +190,15 @@ InitLocal( DRMKMSData *drmkms )
                return DFB_INIT;
           }
 
+          if (shared->cursor_plane && drmSetClientCap( drmkms->fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1 )) {
+               D_WARN( "DirectFB/DRMKMS: universal planes not supported, no cursor plane available\n" );
+               shared->cursor_plane = false;
+          }
+
           drmkms->plane_resources = drmModeGetPlaneResources( drmkms->fd );
+
+          if (drmkms->plane_resources && shared->cursor_plane)
+               drop_primary_planes( drmkms );
      }
 
      drmkms->screen = dfb_screens_register( NULL, drmkms, drmkmsScreenFuncs );
@@ -281,6 +328,11 @@ system_initialize( CoreDFB *core, void **ret_data )
      else
           D_INFO("DRMKMS/Init: limiting possible overlay planes to %d\n", shared->plane_limit);
 
+     if (direct_config_get("drmkms-cursor-plane", &optionbuffer, 1, &ret_num) == DR_OK) {
+          shared->cursor_plane = 1;
+          D_INFO("DRMKMS/Init: exposing cursor planes as layers\n");
+     }
+
      if (direct_config_get("drmkms-use-prime-fd", &optionbuffer, 1, &ret_num) == DR_OK) {
           shared->use_prime_fd = 1;
           D_INFO("DRMKMS/Init: using prime fd\n");
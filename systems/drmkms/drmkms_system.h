@@ -100,6 +100,7 @@ typedef struct {
      bool                 clone_outputs;
      bool                 multihead;
      int                  plane_limit;
+     bool                 cursor_plane;
 
      char                 device_name[256];
 
@@ -0,0 +1,239 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <config.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <direct/messages.h>
+
+#include <directfb.h>
+
+/*
+ * A slave attaching an event buffer to a window of this process is killed, leaving its window event ring
+ * behind. The master has to dispose the ring, this process keeps receiving the events of its window.
+ *
+ * Run it as a slave with multi application core and window-event-ring enabled, e.g. with
+ * "--dfb:debug=Core/Windows" to see the master destroying the ring of the killed slave.
+ */
+
+#define NUM_MOVES  1024   /* several times the default ring size */
+
+
+static int
+run_slave( DFBWindowID window_id,
+           int         fd )
+{
+     DFBResult              ret;
+     IDirectFB             *dfb;
+     IDirectFBDisplayLayer *layer;
+     IDirectFBWindow       *window;
+     IDirectFBEventBuffer  *buffer;
+     char                   ready = 1;
+
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: DirectFBCreate() failed in slave!\n" );
+          return ret;
+     }
+
+     dfb->GetDisplayLayer( dfb, DLID_PRIMARY, &layer );
+
+     ret = layer->GetWindow( layer, window_id, &window );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: GetWindow( %u ) failed in slave!\n", window_id );
+          return ret;
+     }
+
+     ret = window->CreateEventBuffer( window, &buffer );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: CreateEventBuffer() failed in slave!\n" );
+          return ret;
+     }
+
+     if (write( fd, &ready, 1 ) != 1)
+          return DFB_IO;
+
+     /* Never reads the events, waiting to be killed. */
+     while (true)
+          pause();
+
+     return DFB_OK;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult              ret;
+     int                    i;
+     int                    fds[2];
+     int                    moves = 0;
+     int                    last  = -1;
+     pid_t                  pid;
+     char                   ready;
+     char                   arg[32];
+     const char            *slave;
+     IDirectFB             *dfb;
+     IDirectFBDisplayLayer *layer;
+     IDirectFBWindow       *window;
+     IDirectFBEventBuffer  *buffer;
+     DFBWindowDescription   desc;
+     DFBWindowID            window_id;
+     DFBWindowEvent         event;
+
+     /* Initialize DirectFB. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: DirectFBInit() failed!\n" );
+          return ret;
+     }
+
+     slave = getenv( "DFBTEST_WINDOW_EVENT_RING" );
+     if (slave) {
+          unsigned int id, fd;
+
+          if (sscanf( slave, "%u:%u", &id, &fd ) != 2)
+               return DFB_INVARG;
+
+          return run_slave( id, fd );
+     }
+
+     /* Create super interface. */
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: DirectFBCreate() failed!\n" );
+          return ret;
+     }
+
+     dfb->GetDisplayLayer( dfb, DLID_PRIMARY, &layer );
+
+     desc.flags  = DWDESC_POSX | DWDESC_POSY | DWDESC_WIDTH | DWDESC_HEIGHT;
+     desc.posx   = 0;
+     desc.posy   = 0;
+     desc.width  = 64;
+     desc.height = 64;
+
+     ret = layer->CreateWindow( layer, &desc, &window );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: CreateWindow() failed!\n" );
+          return ret;
+     }
+
+     window->GetID( window, &window_id );
+
+     ret = window->CreateEventBuffer( window, &buffer );
+     if (ret) {
+          D_DERROR( ret, "DFBTest/WindowEventRing: CreateEventBuffer() failed!\n" );
+          return ret;
+     }
+
+     if (pipe( fds )) {
+          D_PERROR( "DFBTest/WindowEventRing: pipe() failed!\n" );
+          return DFB_IO;
+     }
+
+     pid = fork();
+     if (pid < 0) {
+          D_PERROR( "DFBTest/WindowEventRing: fork() failed!\n" );
+          return DFB_IO;
+     }
+
+     if (!pid) {
+          close( fds[0] );
+
+          snprintf( arg, sizeof(arg), "%u:%d", window_id, fds[1] );
+
+          setenv( "DFBTEST_WINDOW_EVENT_RING", arg, 1 );
+
+          execv( "/proc/self/exe", argv );
+
+          _exit( 1 );
+     }
+
+     close( fds[1] );
+
+     if (read( fds[0], &ready, 1 ) != 1) {
+          D_ERROR( "DFBTest/WindowEventRing: Slave failed to attach!\n" );
+          return DFB_FAILURE;
+     }
+
+     D_INFO( "DFBTest/WindowEventRing: Killing slave %d\n", pid );
+
+     kill( pid, SIGKILL );
+     waitpid( pid, NULL, 0 );
+
+     /* Give the master time to handle the leaving slave. */
+     sleep( 1 );
+
+     buffer->Reset( buffer );
+
+     for (i=1; i<=NUM_MOVES; i++)
+          window->MoveTo( window, i % 256, 0 );
+
+     while (buffer->WaitForEventWithTimeout( buffer, 1, 0 ) == DFB_OK) {
+          while (buffer->GetEvent( buffer, DFB_EVENT(&event) ) == DFB_OK) {
+               if (event.type & DWET_POSITION) {
+                    moves++;
+                    last = event.x;
+               }
+          }
+     }
+
+     D_INFO( "DFBTest/WindowEventRing: %d position events, last at %d\n", moves, last );
+
+     buffer->Release( buffer );
+     window->Release( window );
+     layer->Release( layer );
+
+     /* Shutdown DirectFB. */
+     dfb->Release( dfb );
+
+     if (!moves || last != NUM_MOVES % 256) {
+          D_ERROR( "DFBTest/WindowEventRing: FAILED, events of the window were lost!\n" );
+          return DFB_FAILURE;
+     }
+
+     D_INFO( "DFBTest/WindowEventRing: PASSED\n" );
+
+     return DFB_OK;
+}
@@ -0,0 +1,366 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <direct/clock.h>
+#include <direct/messages.h>
+
+#include <region.h>
+
+
+/*
+ * Times the region operations SaWMan uses for its updates.
+ *
+ * Each test runs twice, once with the inline storage of small regions and once with every region
+ * forced onto the heap as before. The results of both are checked to be equal before timing.
+ */
+
+static int num_loops = 200000;
+
+/**********************************************************************************************************************/
+
+static int parse_cmdline ( int argc, char *argv[] );
+static int show_usage    ( void );
+
+/**********************************************************************************************************************/
+
+static void
+region_prepare( misc_region_t *region,
+                bool           use_inline )
+{
+     region->inline_ok = use_inline;
+}
+
+static void
+region_init_regions( misc_region_t   *region,
+                     const DFBRegion *regions,
+                     int              num,
+                     bool             use_inline )
+{
+     int i;
+
+     if (use_inline) {
+          misc_region_init_regions( region, NULL, regions, num );
+          return;
+     }
+
+     misc_region_init( region, NULL );
+     region_prepare( region, false );
+
+     /* Regions are inclusive, like in misc_region_init_regions(). */
+     for (i=0; i<num; i++)
+          misc_region_union_rect( region, region, regions[i].x1, regions[i].y1,
+                                  regions[i].x2 - regions[i].x1 + 1, regions[i].y2 - regions[i].y1 + 1 );
+}
+
+static long long
+loops_per_sec( DirectClock *clock,
+               int          loops )
+{
+     long long diff = direct_clock_diff( clock );
+
+     return loops * 1000000LL / (diff ? diff : 1);
+}
+
+/*
+ * Mimics one window of update_region2(): clip the dirty region by the visible parts, split it into
+ * opaque and blended areas and subtract what has been rendered. The results are left to the caller.
+ */
+static void
+window_updates( const DFBRegion *visible_regions,
+                int              num_visible,
+                bool             use_inline,
+                misc_region_t   *ret_dirty,
+                misc_region_t   *ret_opt,
+                misc_region_t   *ret_blend )
+{
+     misc_box_t    extents = { 0, 0, 1920, 1080 };
+     misc_region_t visible;
+     misc_region_t render;
+
+     misc_region_init_with_extents( ret_dirty, NULL, &extents );
+     region_prepare( ret_dirty, use_inline );
+
+     region_init_regions( &visible, visible_regions, num_visible, use_inline );
+
+     misc_region_init_with_extents( &render, NULL, &extents );
+     region_prepare( &render, use_inline );
+
+     misc_region_init( ret_opt, NULL );
+     region_prepare( ret_opt, use_inline );
+
+     misc_region_init( ret_blend, NULL );
+     region_prepare( ret_blend, use_inline );
+
+     misc_region_intersect( &render, &visible, &render );
+     misc_region_intersect( ret_opt, &render, ret_dirty );
+     misc_region_subtract( ret_blend, &render, ret_opt );
+     misc_region_subtract( ret_dirty, ret_dirty, &render );
+
+     misc_region_deinit( &render );
+     misc_region_deinit( &visible );
+}
+
+static void
+run_window_updates( const DFBRegion *visible_regions,
+                    int              num_visible,
+                    bool             use_inline )
+{
+     misc_region_t dirty;
+     misc_region_t opt;
+     misc_region_t blend;
+
+     window_updates( visible_regions, num_visible, use_inline, &dirty, &opt, &blend );
+
+     misc_region_deinit( &blend );
+     misc_region_deinit( &opt );
+     misc_region_deinit( &dirty );
+}
+
+/*
+ * Builds two interleaved grids of boxes and merges them, which spends its time in band coalescing.
+ * The union and the union minus the second grid are left to the caller.
+ */
+static void
+large_union( const DFBBox  *boxes1,
+             const DFBBox  *boxes2,
+             int            num,
+             bool           use_inline,
+             misc_region_t *ret_union,
+             misc_region_t *ret_subtract )
+{
+     misc_region_t region1;
+     misc_region_t region2;
+
+     misc_region_init_boxes( &region1, NULL, boxes1, num );
+     misc_region_init_boxes( &region2, NULL, boxes2, num );
+
+     misc_region_init( ret_union, NULL );
+     region_prepare( ret_union, use_inline );
+
+     misc_region_init( ret_subtract, NULL );
+     region_prepare( ret_subtract, use_inline );
+
+     misc_region_union( ret_union, &region1, &region2 );
+     misc_region_subtract( ret_subtract, ret_union, &region2 );
+
+     misc_region_deinit( &region2 );
+     misc_region_deinit( &region1 );
+}
+
+static void
+run_large_union( const DFBBox *boxes1,
+                 const DFBBox *boxes2,
+                 int           num,
+                 bool          use_inline )
+{
+     misc_region_t result;
+     misc_region_t subtract;
+
+     large_union( boxes1, boxes2, num, use_inline, &result, &subtract );
+
+     misc_region_deinit( &subtract );
+     misc_region_deinit( &result );
+}
+
+/**********************************************************************************************************************/
+
+static bool
+check_equal( const char    *name,
+             misc_region_t *inline_region,
+             misc_region_t *heap_region )
+{
+     bool equal = misc_region_equal( inline_region, heap_region );
+
+     if (!equal)
+          D_ERROR( "Region/Bench: %s differs, %d boxes inline vs. %d on the heap!\n", name,
+                   misc_region_n_rects( inline_region ), misc_region_n_rects( heap_region ) );
+
+     misc_region_deinit( inline_region );
+     misc_region_deinit( heap_region );
+
+     return equal;
+}
+
+/*
+ * Compares the boxes of intersections, subtractions and unions computed with inline storage and on the heap.
+ */
+static bool
+check_results( DFBRegion     visible[4][4],
+               const DFBBox *grid1,
+               const DFBBox *grid2,
+               int           num )
+{
+     int           n;
+     bool          ok = true;
+     misc_region_t dirty[2];
+     misc_region_t opt[2];
+     misc_region_t blend[2];
+
+     for (n=0; n<4; n++) {
+          window_updates( visible[n], n + 1, true,  &dirty[0], &opt[0], &blend[0] );
+          window_updates( visible[n], n + 1, false, &dirty[1], &opt[1], &blend[1] );
+
+          ok &= check_equal( "intersection", &opt[0], &opt[1] );
+          ok &= check_equal( "subtraction of the opaque part", &blend[0], &blend[1] );
+          ok &= check_equal( "subtraction of the rendered part", &dirty[0], &dirty[1] );
+     }
+
+     large_union( grid1, grid2, num, true,  &opt[0], &blend[0] );
+     large_union( grid1, grid2, num, false, &opt[1], &blend[1] );
+
+     ok &= check_equal( "union", &opt[0], &opt[1] );
+     ok &= check_equal( "subtraction from the union", &blend[0], &blend[1] );
+
+     return ok;
+}
+
+/**********************************************************************************************************************/
+
+#define GRID_SIZE 16
+
+int
+main( int argc, char *argv[] )
+{
+     DirectClock  clock;
+     int          i, n, mode;
+     DFBRegion    visible[4][4];
+     DFBBox       grid1[GRID_SIZE * GRID_SIZE];
+     DFBBox       grid2[GRID_SIZE * GRID_SIZE];
+
+     if (parse_cmdline( argc, argv ))
+          return -1;
+
+     /* Visible regions of 1 to 4 rectangles, as left over by windows above */
+     for (n=0; n<4; n++) {
+          for (i=0; i<=n; i++) {
+               visible[n][i].x1 = 100 + i * 300;
+               visible[n][i].y1 = 100 + i * 40;
+               visible[n][i].x2 = 100 + i * 300 + 250;
+               visible[n][i].y2 = 700 + i * 40;
+          }
+     }
+
+     /* Grids whose columns line up, so that bands coalesce */
+     for (i=0; i<GRID_SIZE * GRID_SIZE; i++) {
+          int x = (i % GRID_SIZE) * 64;
+          int y = (i / GRID_SIZE) * 32;
+
+          grid1[i].x1 = x;
+          grid1[i].y1 = y;
+          grid1[i].x2 = x + 32;
+          grid1[i].y2 = y + 16;
+
+          grid2[i].x1 = x + 32;
+          grid2[i].y1 = y;
+          grid2[i].x2 = x + 48;
+          grid2[i].y2 = y + 32;
+     }
+
+     if (!check_results( visible, grid1, grid2, GRID_SIZE * GRID_SIZE ))
+          return 1;
+
+     D_INFO( "Region/Bench: Results with inline storage match the heap\n" );
+
+     for (mode=0; mode<2; mode++) {
+          bool        use_inline = !mode;
+          const char *name       = use_inline ? "inline" : "heap";
+
+          for (n=0; n<4; n++) {
+               direct_clock_start( &clock );
+
+               for (i=0; i<num_loops; i++)
+                    run_window_updates( visible[n], n + 1, use_inline );
+
+               direct_clock_stop( &clock );
+
+               D_INFO( "Region/Bench: %-6s window updates with %d visible: %lld.%03lld sec (%lld loops/sec)\n",
+                       name, n + 1, DIRECT_CLOCK_DIFF_SEC_MS( &clock ), loops_per_sec( &clock, num_loops ) );
+          }
+
+          direct_clock_start( &clock );
+
+          for (i=0; i<num_loops / 100; i++)
+               run_large_union( grid1, grid2, GRID_SIZE * GRID_SIZE, use_inline );
+
+          direct_clock_stop( &clock );
+
+          D_INFO( "Region/Bench: %-6s union of %d boxes:            %lld.%03lld sec (%lld loops/sec)\n",
+                  name, GRID_SIZE * GRID_SIZE, DIRECT_CLOCK_DIFF_SEC_MS( &clock ), loops_per_sec( &clock, num_loops / 100 ) );
+     }
+
+     return 0;
+}
+
+/**********************************************************************************************************************/
+
+static int
+parse_cmdline( int argc, char *argv[] )
+{
+     int i;
+
+     for (i=1; i<argc; i++) {
+          if (!strcmp( argv[i], "-n" ) && i + 1 < argc)
+               num_loops = atoi( argv[++i] );
+          else
+               return show_usage();
+     }
+
+     if (num_loops < 100)
+          num_loops = 100;
+
+     return 0;
+}
+
+static int
+show_usage( void )
+{
+     fprintf( stderr, "\n"
+                      "Usage:\n"
+                      "   sawman_region_bench [options]\n"
+                      "\n"
+                      "Options:\n"
+                      "   -n <loops>  Number of loops per test (default 200000)\n"
+                      "\n"
+              );
+
+     return -1;
+}
@@ -667,6 +667,13 @@ window_callback( CoreWindow *window,
      if (window->config.rotation)
           printf( "ROTATED %d     ", window->config.rotation);
 
+     if (config->max_update_rate)
+          printf( "MAX %u Hz      ", config->max_update_rate );
+
+     if (window->updates.merged || window->updates.dropped)
+          printf( "UPDATES %lu (%lu merged, %lu dropped)  ",
+                  window->updates.forwarded, window->updates.merged, window->updates.dropped );
+
      printf( "\n" );
 
      return DFENUM_OK;
@@ -19,8 +19,10 @@ static const DirectFBAccelerationMaskNames(accelerationmask_names);
 /**********************************************************************************************************************/
 
 typedef enum {
-     NONE         = 0x00000000,
-     CREATE_FILES = 0x00000001
+     NONE          = 0x00000000,
+     CREATE_FILES  = 0x00000001,
+     SHOW_LATENCY  = 0x00000002,
+     RESET_LATENCY = 0x00000004
 } Options;
 
 typedef struct {
@@ -58,6 +60,10 @@ Inspector_Init( Inspector *inspector, int argc, char *argv[] )
                inspector->directory  = argv[i];
                inspector->options   |= CREATE_FILES;
           }
+          else if (!strcmp( argv[i], "-l" ))
+               inspector->options |= SHOW_LATENCY;
+          else if (!strcmp( argv[i], "-r" ))
+               inspector->options |= SHOW_LATENCY | RESET_LATENCY;
      }
 
      ret = DirectFBCreate( &inspector->dfb );
@@ -273,6 +279,50 @@ Inspector_Run( Inspector *inspector )
      return DFB_OK;
 }
 
+/*
+ * Prints the input latency histograms collected with the "latency-trace" option.
+ */
+static DFBResult
+Inspector_ShowLatency( Inspector *inspector )
+{
+     static const char *stage_names[DLTS_NUM] = {
+          "input", "wm", "window", "flip", "display"
+     };
+
+     DFBResult       ret;
+     DFBLatencyStats stats;
+     int             i, n;
+
+     ret = inspector->dfb->GetLatencyStats( inspector->dfb, &stats, (inspector->options & RESET_LATENCY) ? DFB_TRUE : DFB_FALSE );
+     if (ret) {
+          D_DERROR( ret, "Inspector/Latency: GetLatencyStats() failed, is 'latency-trace' set?\n" );
+          return ret;
+     }
+
+     printf( "\n%-8s %8s %10s %10s ", "stage", "count", "avg us", "max us" );
+
+     for (n=0; n<DFB_LATENCY_BUCKETS - 1; n++)
+          printf( " <%-6d", 128 << n );
+
+     printf( " more\n" );
+
+     for (i=0; i<DLTS_NUM; i++) {
+          const DFBLatencyHistogram *histogram = &stats.stages[i];
+
+          printf( "%-8s %8u %10lld %10lld ", stage_names[i], histogram->count,
+                  histogram->count ? histogram->total / histogram->count : 0, histogram->max );
+
+          for (n=0; n<DFB_LATENCY_BUCKETS; n++)
+               printf( " %7u", histogram->buckets[n] );
+
+          printf( "\n" );
+     }
+
+     printf( "\n" );
+
+     return DFB_OK;
+}
+
 /**********************************************************************************************************************/
 
 int
@@ -290,6 +340,9 @@ main( int argc, char *argv[] )
      ret = Inspector_Init( &inspector, argc, argv );
      if (ret)
           return ret;
+
+     if (inspector.options & SHOW_LATENCY)
+          return Inspector_ShowLatency( &inspector );
           
      return Inspector_Run( &inspector );
 }
@@ -0,0 +1,362 @@
+/*
+   (c) Copyright 2012-2013  DirectFB integrated media GmbH
+   (c) Copyright 2001-2013  The world wide DirectFB Open Source Community (directfb.org)
+   (c) Copyright 2000-2004  Convergence (integrated media) GmbH
+
+   All rights reserved.
+
+   Written by Denis Oliver Kropp <dok@directfb.org>,
+              Andreas Shimokawa <andi@directfb.org>,
+              Marek Pikarski <mass@directfb.org>,
+              Sven Neumann <neo@directfb.org>,
+              Ville Syrjälä <syrjala@sci.fi> and
+              Claudio Ciccani <klan@users.sf.net>.
+
+   This file is subject to the terms and conditions of the MIT License:
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation
+   files (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <config.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <direct/messages.h>
+#include <direct/util.h>
+
+#include <core/input_recording.h>
+
+#include <directfb.h>
+
+
+/*
+ * Records the events of all input devices with their timing into a file, to be played
+ * by the 'replay' input driver, e.g. with "--dfb:system=dummy,input-replay=<file>".
+ */
+
+/**************************************************************************************************/
+
+static IDirectFB            *dfb;
+static IDirectFBEventBuffer *events;
+
+static const char           *filename;
+static bool                  print_recording;
+static int                   max_seconds;
+static int                   max_events;
+
+static volatile bool         quit;
+
+/**************************************************************************************************/
+
+static bool parse_command_line( int argc, char *argv[] );
+
+/**************************************************************************************************/
+
+static long long
+event_time( const DFBInputEvent *event )
+{
+     return event->timestamp.tv_sec * 1000000LL + event->timestamp.tv_usec;
+}
+
+static const char *
+event_type_name( DFBInputEventType type )
+{
+     switch (type) {
+          case DIET_KEYPRESS:
+               return "KEYPRESS";
+          case DIET_KEYRELEASE:
+               return "KEYRELEASE";
+          case DIET_BUTTONPRESS:
+               return "BUTTONPRESS";
+          case DIET_BUTTONRELEASE:
+               return "BUTTONRELEASE";
+          case DIET_AXISMOTION:
+               return "AXISMOTION";
+          default:
+               return "UNKNOWN";
+     }
+}
+
+static void
+signal_handler( int num )
+{
+     quit = true;
+}
+
+static int
+record( FILE *file )
+{
+     DFBResult               ret;
+     DFBInputRecordingHeader header;
+     DFBInputRecord          record;
+     long long               first = 0;
+     int                     num   = 0;
+
+     memset( &header, 0, sizeof(header) );
+
+     memcpy( header.magic, DFB_INPUT_RECORDING_MAGIC, sizeof(header.magic) );
+
+     header.version    = DFB_INPUT_RECORDING_VERSION;
+     header.event_size = sizeof(DFBInputEvent);
+
+     /* Write the header now, the number of records is filled in when done. */
+     if (fwrite( &header, sizeof(header), 1, file ) != 1) {
+          perror( "Tools/RecordInput: Writing header" );
+          return -1;
+     }
+
+     memset( &record, 0, sizeof(record) );
+
+     while (!quit) {
+          ret = events->WaitForEventWithTimeout( events, 0, 100 );
+          if (ret && ret != DFB_TIMEOUT && ret != DFB_INTERRUPTED) {
+               D_DERROR( ret, "Tools/RecordInput: IDirectFBEventBuffer::WaitForEventWithTimeout() failed!\n" );
+               break;
+          }
+
+          while (!quit && events->GetEvent( events, DFB_EVENT(&record.event) ) == DFB_OK) {
+               if (!num)
+                    first = event_time( &record.event );
+
+               record.time = event_time( &record.event ) - first;
+
+               if (fwrite( &record, sizeof(record), 1, file ) != 1) {
+                    perror( "Tools/RecordInput: Writing event" );
+                    quit = true;
+                    break;
+               }
+
+               if (++num == max_events)
+                    quit = true;
+          }
+
+          if (max_seconds && num && event_time( &record.event ) - first >= max_seconds * 1000000LL)
+               quit = true;
+     }
+
+     header.num_records = num;
+
+     if (fseek( file, 0, SEEK_SET ) || fwrite( &header, sizeof(header), 1, file ) != 1)
+          perror( "Tools/RecordInput: Updating header" );
+
+     fprintf( stderr, "Recorded %d events in %lld ms.\n", num, (long long) record.time / 1000 );
+
+     return 0;
+}
+
+static int
+print( FILE *file )
+{
+     DFBInputRecordingHeader header;
+     DFBInputRecord          record;
+     int                     num = 0;
+
+     if (fread( &header, sizeof(header), 1, file ) != 1 ||
+         memcmp( header.magic, DFB_INPUT_RECORDING_MAGIC, sizeof(header.magic) ))
+     {
+          fprintf( stderr, "Tools/RecordInput: '%s' is no input recording!\n", filename );
+          return -1;
+     }
+
+     if (header.version != DFB_INPUT_RECORDING_VERSION || header.event_size != sizeof(DFBInputEvent)) {
+          fprintf( stderr, "Tools/RecordInput: '%s' has version %u and event size %u, expected %u and %zu!\n",
+                   filename, header.version, header.event_size, DFB_INPUT_RECORDING_VERSION, sizeof(DFBInputEvent) );
+          return -1;
+     }
+
+     while (fread( &record, sizeof(record), 1, file ) == 1) {
+          const DFBInputEvent *event = &record.event;
+
+          printf( "%6lld.%06lld  device %2u  %-16s", (long long) record.time / 1000000, (long long) record.time % 1000000,
+                  event->device_id, event_type_name( event->type ) );
+
+          switch (event->type) {
+               case DIET_KEYPRESS:
+               case DIET_KEYRELEASE:
+                    printf( "  symbol 0x%04x  code %d", event->key_symbol, event->key_code );
+                    break;
+
+               case DIET_BUTTONPRESS:
+               case DIET_BUTTONRELEASE:
+                    printf( "  button %d", event->button );
+                    break;
+
+               case DIET_AXISMOTION:
+                    if (event->flags & DIEF_AXISABS)
+                         printf( "  axis %d  abs %d", event->axis, event->axisabs );
+                    else
+                         printf( "  axis %d  rel %d", event->axis, event->axisrel );
+                    break;
+
+               default:
+                    break;
+          }
+
+          printf( "%s\n", (event->flags & DIEF_FOLLOW) ? "  (follow)" : "" );
+
+          num++;
+     }
+
+     if (header.num_records && header.num_records != num)
+          fprintf( stderr, "Tools/RecordInput: Expected %u events, read %d!\n", header.num_records, num );
+
+     return 0;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult  ret;
+     FILE      *file;
+     int        result = -1;
+
+     /* Initialize DirectFB including command line parsing. */
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          D_DERROR( ret, "Tools/RecordInput: DirectFBInit() failed!\n" );
+          return -1;
+     }
+
+     /* Parse the command line. */
+     if (!parse_command_line( argc, argv ))
+          return -1;
+
+     if (print_recording) {
+          file = fopen( filename, "rb" );
+          if (!file) {
+               perror( filename );
+               return -1;
+          }
+
+          result = print( file );
+
+          fclose( file );
+
+          return result;
+     }
+
+     file = fopen( filename, "wb" );
+     if (!file) {
+          perror( filename );
+          return -1;
+     }
+
+     /* Create the super interface. */
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          D_DERROR( ret, "Tools/RecordInput: DirectFBCreate() failed!\n" );
+          goto error;
+     }
+
+     /* Create an event buffer for all input devices. */
+     ret = dfb->CreateInputEventBuffer( dfb, DICAPS_ALL, DFB_TRUE, &events );
+     if (ret) {
+          D_DERROR( ret, "Tools/RecordInput: IDirectFB::CreateInputEventBuffer() failed!\n" );
+          goto error;
+     }
+
+     signal( SIGINT, signal_handler );
+     signal( SIGTERM, signal_handler );
+
+     result = record( file );
+
+error:
+     fclose( file );
+
+     /* Release the buffer. */
+     if (events)
+          events->Release( events );
+
+     /* Release the super interface. */
+     if (dfb)
+          dfb->Release( dfb );
+
+     return result;
+}
+
+/**************************************************************************************************/
+
+static void
+print_usage( const char *prg_name )
+{
+     fprintf( stderr, "\nDirectFB Input Recorder (version %s)\n\n", DIRECTFB_VERSION );
+     fprintf( stderr, "Usage: %s [options] <file>\n\n", prg_name );
+     fprintf( stderr, "Records the events of all input devices until interrupted.\n" );
+     fprintf( stderr, "Play the recording with '--dfb:input-replay=<file>[,input-replay-speed=<percent>]'.\n\n" );
+     fprintf( stderr, "Options:\n" );
+     fprintf( stderr, "   -h   --help                             Show this help message\n" );
+     fprintf( stderr, "   -v   --version                          Print version information\n" );
+     fprintf( stderr, "   -t   --time           <seconds>         Stop recording after the given time\n" );
+     fprintf( stderr, "   -n   --events         <number>          Stop recording after the given number of events\n" );
+     fprintf( stderr, "   -p   --print                            Print the events of a recording\n" );
+     fprintf( stderr, "\n" );
+}
+
+static bool
+parse_command_line( int argc, char *argv[] )
+{
+     int n;
+
+     for (n = 1; n < argc; n++) {
+          const char *arg = argv[n];
+
+          if (strcmp( arg, "-h" ) == 0 || strcmp( arg, "--help" ) == 0) {
+               print_usage( argv[0] );
+               return false;
+          }
+
+          if (strcmp( arg, "-v" ) == 0 || strcmp( arg, "--version" ) == 0) {
+               fprintf( stderr, "dfbrecordinput version %s\n", DIRECTFB_VERSION );
+               return false;
+          }
+
+          if ((strcmp( arg, "-t" ) == 0 || strcmp( arg, "--time" ) == 0) && n + 1 < argc) {
+               max_seconds = atoi( argv[++n] );
+               continue;
+          }
+
+          if ((strcmp( arg, "-n" ) == 0 || strcmp( arg, "--events" ) == 0) && n + 1 < argc) {
+               max_events = atoi( argv[++n] );
+               continue;
+          }
+
+          if (strcmp( arg, "-p" ) == 0 || strcmp( arg, "--print" ) == 0) {
+               print_recording = true;
+               continue;
+          }
+
+          if (arg[0] == '-' || filename) {
+               print_usage( argv[0] );
+               return false;
+          }
+
+          filename = arg;
+     }
+
+     if (!filename) {
+          print_usage( argv[0] );
+          return false;
+     }
+
+     return true;
+}
@@ -59,6 +59,7 @@
 #include <isawman.h>
 
 static DFBBoolean show_geometry = DFB_FALSE;
+static DFBBoolean show_updates  = DFB_FALSE;
 static DFBBoolean m_listen      = DFB_FALSE;
 static DFBBoolean m_performance = DFB_FALSE;
 
@@ -188,6 +189,21 @@ dump_window( SaWMan       *sawman,
           printf( "%4dx%4d - %3d,%3d   ", sawwin->src.w, sawwin->src.h, sawwin->src.x, sawwin->src.y );
 
 
+          printf( "\n" );
+     }
+
+     if (show_updates) {
+          printf( "                      " );
+
+          printf( "%lu updates, %lu merged, %lu dropped", window->updates.forwarded,
+                  window->updates.merged, window->updates.dropped );
+
+          if (config->max_update_rate)
+               printf( ", max %u Hz", config->max_update_rate );
+
+          if (window->updates.deadline)
+               printf( ", pending" );
+
           printf( "\n" );
      }
 }
@@ -540,6 +556,7 @@ print_usage (const char *prg_name)
      fprintf (stderr, "   -g, --geometry     Show advanced geometry settings\n");
      fprintf (stderr, "   -l, --listen       Register listener and print events\n");
      fprintf (stderr, "   -p, --performance  Show performance counters\n");
+     fprintf (stderr, "   -u, --updates      Show throttled window update counters\n");
      fprintf (stderr, "   -h, --help         Show this help message\n");
      fprintf (stderr, "   -v, --version      Print version information\n");
      fprintf (stderr, "\n");
@@ -578,6 +595,11 @@ parse_command_line( int argc, char *argv[] )
                continue;
           }
 
+          if (strcmp (arg, "-u") == 0 || strcmp (arg, "--updates") == 0) {
+               show_updates = true;
+               continue;
+          }
+
           print_usage (argv[0]);
 
           return DFB_FALSE;
@@ -54,10 +54,12 @@
 #include <core/core.h>
 #include <core/gfxcard.h>
 #include <core/layer_context.h>
+#include <core/layer_control.h>
 #include <core/layer_region.h>
 #include <core/layers_internal.h>
 #include <core/surface.h>
 #include <core/palette.h>
+#include <core/screen.h>
 #include <core/windows.h>
 #include <core/windows_internal.h>
 #include <core/windowstack.h>
@@ -67,6 +69,7 @@
 #include <core/CoreLayerRegion.h>
 #include <core/Task.h>
 
+#include <gfx/clip.h>
 #include <gfx/util.h>
 
 #include <misc/conf.h>
@@ -97,6 +100,11 @@ typedef struct {
 #define MAX_UPDATING_REGIONS       8    /* updated region to be scheduled for display */
 #define MAX_UPDATED_REGIONS        8    /* updated region scheduled for display */
 
+#define HIT_GRID_SHIFT             7    /* hit-test grid cells of 128x128 pixels */
+#define HIT_MASK_BAND             32    /* lines of a hit mask built at once */
+
+#define HIT_WINDOW(w)  ((w)->config.opacity && !((w)->config.options & DWOP_GHOST))
+
 typedef struct {
      CoreDFB                      *core;
 
@@ -108,6 +116,35 @@ typedef struct {
      FusionSkirmish                update_skirmish;
 } WMData;
 
+/*
+ * Visibility of a window in the stack, see update_visibility().
+ */
+typedef struct {
+     CoreWindow                   *window;
+
+     DFBRegion                     bounds;             /* in stack coordinates */
+     DFBRegion                     opaque;             /* part hiding everything below, if solid */
+
+     bool                          solid;              /* opaque part is valid */
+     bool                          visible;            /* visible and not hidden by solid windows above */
+} VisibilityEntry;
+
+/*
+ * Windows that can be hit per cell of a grid over the stack, see update_hit_grid().
+ */
+typedef struct {
+     int                           cols;
+     int                           rows;
+
+     int                          *cells;              /* start of each cell in indices, plus the end */
+     int                           cells_size;
+
+     int                          *indices;            /* window indices in stacking order, cell by cell */
+     int                           indices_size;
+
+     bool                          valid;              /* cleared along with the visibility */
+} HitGrid;
+
 typedef struct {
      int                           magic;
 
@@ -156,10 +193,22 @@ typedef struct {
      int                           cursor_dx;
      int                           cursor_dy;
 
+     struct {
+          bool                     checked;            /* looked for a cursor layer already */
+          CoreLayerContext        *context;            /* context on the cursor layer, if any */
+          CoreLayerRegion         *region;             /* region showing the cursor surface */
+     } hw_cursor;
+
      CoreLayerRegion              *region;
      CoreSurface                  *surface;
      Reaction                      surface_reaction;
      DFB_Task                     *last_notify_task;
+
+     VisibilityEntry              *visibility;         /* one per window in stacking order */
+     int                           visibility_size;    /* number of allocated entries */
+     int                           visibility_dirty;   /* highest index to recalculate, -1 if all entries are valid */
+
+     HitGrid                       hit_grid;
 } StackData;
 
 typedef struct {
@@ -172,6 +221,14 @@ typedef struct {
      int                           priority;           /* derived from stacking class */
 
      CoreLayerRegionConfig         config;
+
+     u8                           *hit_mask;           /* one bit per pixel of a shaped window that can be hit */
+     u8                           *hit_mask_bands;     /* per band of HIT_MASK_BAND lines, non-zero if built */
+     int                           hit_mask_size;
+     int                           hit_mask_pitch;
+     int                           hit_mask_width;
+     int                           hit_mask_height;
+     bool                          hit_mask_valid;     /* allocated for the surface size, cleared on config changes */
 } WindowData;
 
 /**************************************************************************************************/
@@ -197,6 +254,9 @@ update_window( CoreWindow          *window,
 static void
 flush_updating( StackData *data );
 
+static void
+deinit_hw_cursor( StackData *data );
+
 /**************************************************************************************************/
 
 static int keys_compare( const void *key1,
@@ -482,6 +542,450 @@ get_keyboard_window( CoreWindowStack     *stack,
      return NULL;
 }
 
+/*
+ * Returns true if the pixel read from the surface of a shaped window can be hit by the pointer.
+ */
+static bool
+shape_pixel_hit( const CoreWindow  *window,
+                 const CoreSurface *surface,
+                 const u8          *buf )
+{
+     DFBWindowOptions      options = window->config.options;
+     DFBSurfacePixelFormat format  = surface->config.format;
+
+     if (options & DWOP_ALPHACHANNEL) {
+          int alpha = -1;
+
+          D_ASSERT( DFB_PIXELFORMAT_HAS_ALPHA( format ) );
+
+          switch (format) {
+               case DSPF_AiRGB:
+                    alpha = 0xff - (*(const u32*)(buf) >> 24);
+                    break;
+               case DSPF_ARGB:
+               case DSPF_ABGR:
+               case DSPF_AYUV:
+               case DSPF_AVYU:
+                    alpha = *(const u32*)(buf) >> 24;
+                    break;
+               case DSPF_ARGB8565:
+#ifdef WORDS_BIGENDIAN
+                    alpha = buf[0];
+#else
+                    alpha = buf[2];
+#endif
+                    break;
+               case DSPF_RGBA5551:
+                    alpha = *(const u16*)(buf) & 0x1;
+                    alpha = alpha ? 0xff : 0x00;
+                    break;
+               case DSPF_ARGB1555:
+               case DSPF_ARGB2554:
+               case DSPF_ARGB4444:
+                    alpha = *(const u16*)(buf) & 0x8000;
+                    alpha = alpha ? 0xff : 0x00;
+                    break;
+               case DSPF_RGBA4444:
+                    alpha = *(const u16*)(buf) & 0x0008;
+                    alpha = alpha ? 0xff : 0x00;
+                    break;
+               case DSPF_RGBAF88871:
+                    alpha = *(const u32*)(buf) & 0x000000fe;
+                    alpha |= alpha >> 7;
+                    break;
+               case DSPF_ALUT44:
+                    alpha = *(buf) & 0xf0;
+                    alpha |= alpha >> 4;
+                    break;
+               case DSPF_LUT1:
+               case DSPF_LUT2:
+               case DSPF_LUT8: {
+                    CorePalette *palette = surface->palette;
+                    u8           pix     = *buf;
+
+                    if (palette && pix < palette->num_entries) {
+                         alpha = palette->entries[pix].a;
+                         break;
+                    }
+
+
+                    /* fall through */
+               }
+
+               default:
+                    D_ONCE( "unknown format 0x%x", surface->config.format );
+                    break;
+          }
+
+          if (alpha) /* alpha == -1 on error */
+               return true;
+     }
+     if (options & DWOP_COLORKEYING) {
+          int pixel = 0;
+          const u8 *p;
+          switch (format) {
+               case DSPF_ARGB:
+               case DSPF_ABGR:
+               case DSPF_AiRGB:
+               case DSPF_RGB32:
+                    pixel = *(const u32*)(buf) & 0x00ffffff;
+                    break;
+
+               case DSPF_RGBAF88871:
+                    pixel = *(const u32*)(buf) & 0xffffff00;
+                    break;
+
+               case DSPF_RGB24:
+                    p = (buf);
+#ifdef WORDS_BIGENDIAN
+                    pixel = (p[0] << 16) | (p[1] << 8) | p[2];
+#else
+                    pixel = (p[2] << 16) | (p[1] << 8) | p[0];
+#endif
+                    break;
+
+               case DSPF_RGB16:
+                    pixel = *(const u16*)(buf);
+                    break;
+
+               case DSPF_ARGB4444:
+               case DSPF_RGB444:
+                    pixel = *(const u16*)(buf)
+                            & 0x0fff;
+                    break;
+
+               case DSPF_RGBA4444:
+                    pixel = *(const u16*)(buf)
+                            & 0xfff0;
+                    break;
+
+               case DSPF_ARGB8565:
+                    p = (buf);
+#ifdef WORDS_BIGENDIAN
+                    pixel = p[1] << 8 | p[2];
+#else
+                    pixel = p[1] << 8 | p[0];
+#endif
+                    break;
+
+               case DSPF_ARGB1555:
+               case DSPF_RGB555:
+               case DSPF_BGR555:
+                    pixel = *(const u16*)(buf)
+                            & 0x7fff;
+                    break;
+
+               case DSPF_RGBA5551:
+                    pixel = *(const u16*)(buf)
+                            & 0xfffe;
+                    break;
+
+               case DSPF_RGB332:
+               case DSPF_LUT8:
+                    pixel = *(buf);
+                    break;
+
+               case DSPF_ALUT44:
+                    pixel = *(buf)
+                            & 0x0f;
+                    break;
+
+               default:
+                    D_ONCE( "unknown format 0x%x", surface->config.format );
+                    break;
+          }
+
+          if (pixel != window->config.color_key)
+               return true;
+     }
+
+     return false;
+}
+
+/*
+ * Allocates a bitmap of the pixels of a shaped window that can be hit, built lazily per band.
+ */
+static DFBResult
+alloc_hit_mask( CoreWindow *window,
+                WindowData *data )
+{
+     CoreSurface           *surface = window->surface;
+     DFBSurfacePixelFormat  format  = surface->config.format;
+     int                    width   = surface->config.size.w;
+     int                    height  = surface->config.size.h;
+     int                    pitch   = (width + 7) / 8;
+     int                    bands   = (height + HIT_MASK_BAND - 1) / HIT_MASK_BAND;
+
+     /* Sub-byte and planar formats are still checked pixel by pixel. */
+     if (!DFB_BYTES_PER_PIXEL( format ) || DFB_PLANAR_PIXELFORMAT( format ))
+          return DFB_UNSUPPORTED;
+
+     if (pitch * height + bands > data->hit_mask_size) {
+          if (data->hit_mask)
+               SHFREE( window->stack->shmpool, data->hit_mask );
+
+          data->hit_mask_size = 0;
+
+          data->hit_mask = SHMALLOC( window->stack->shmpool, pitch * height + bands );
+          if (!data->hit_mask)
+               return D_OOSHM();
+
+          data->hit_mask_size = pitch * height + bands;
+     }
+
+     data->hit_mask_bands  = data->hit_mask + pitch * height;
+     data->hit_mask_pitch  = pitch;
+     data->hit_mask_width  = width;
+     data->hit_mask_height = height;
+     data->hit_mask_valid  = true;
+
+     memset( data->hit_mask_bands, 0, bands );
+
+     return DFB_OK;
+}
+
+/*
+ * Builds one band of the hit mask by reading it from the surface.
+ */
+static DFBResult
+update_hit_band( CoreWindow *window,
+                 WindowData *data,
+                 int         index )
+{
+     DFBResult     ret;
+     int           x, n;
+     CoreSurface  *surface = window->surface;
+     int           width   = data->hit_mask_width;
+     int           bpp     = DFB_BYTES_PER_PIXEL( surface->config.format );
+     u8           *band;
+     DFBRectangle  rect;
+
+     rect.x = 0;
+     rect.y = index * HIT_MASK_BAND;
+     rect.w = width;
+     rect.h = MIN( HIT_MASK_BAND, data->hit_mask_height - rect.y );
+
+     band = D_MALLOC( width * bpp * rect.h );
+     if (!band)
+          return D_OOM();
+
+     ret = dfb_surface_read_buffer( surface, CSBR_FRONT, band, width * bpp, &rect );
+     if (ret) {
+          D_FREE( band );
+          return ret;
+     }
+
+     for (n=0; n<rect.h; n++) {
+          const u8 *src  = band + n * width * bpp;
+          u8       *mask = data->hit_mask + (rect.y + n) * data->hit_mask_pitch;
+
+          memset( mask, 0, data->hit_mask_pitch );
+
+          for (x=0; x<width; x++, src += bpp) {
+               if (shape_pixel_hit( window, surface, src ))
+                    mask[x >> 3] |= 0x80 >> (x & 7);
+          }
+     }
+
+     D_FREE( band );
+
+     D_DEBUG_AT( WM_Default, "  -> hit mask of window %p (%dx%d) updated at %d,%d\n",
+                 window, width, data->hit_mask_height, rect.y, rect.h );
+
+     data->hit_mask_bands[index] = 1;
+
+     return DFB_OK;
+}
+
+/*
+ * Invalidates the bands of the hit mask touched by an update of the surface, all if the region is NULL.
+ */
+static void
+invalidate_hit_mask( WindowData      *data,
+                     const DFBRegion *region )
+{
+     int y;
+
+     if (!data->hit_mask_valid)
+          return;
+
+     if (!region) {
+          memset( data->hit_mask_bands, 0, (data->hit_mask_height + HIT_MASK_BAND - 1) / HIT_MASK_BAND );
+          return;
+     }
+
+     for (y=MAX( region->y1, 0 ); y<=region->y2 && y<data->hit_mask_height; y+=HIT_MASK_BAND - y % HIT_MASK_BAND)
+          data->hit_mask_bands[y / HIT_MASK_BAND] = 0;
+}
+
+static bool
+shape_hit( CoreWindow *window,
+           int         wx,
+           int         wy )
+{
+     WindowData  *data    = window->window_data;
+     CoreSurface *surface = window->surface;
+     u8           buf[8];
+     DFBRectangle rect    = { wx, wy, 1, 1 };
+
+     D_MAGIC_ASSERT( data, WindowData );
+
+     if (data->hit_mask_valid && (data->hit_mask_width  != surface->config.size.w ||
+                                  data->hit_mask_height != surface->config.size.h))
+          data->hit_mask_valid = false;
+
+     if (data->hit_mask_valid || alloc_hit_mask( window, data ) == DFB_OK) {
+          if (wx >= data->hit_mask_width || wy >= data->hit_mask_height)
+               return false;
+
+          /* Only the band being hit is read after an update. */
+          if (data->hit_mask_bands[wy / HIT_MASK_BAND] || update_hit_band( window, data, wy / HIT_MASK_BAND ) == DFB_OK)
+               return data->hit_mask[wy * data->hit_mask_pitch + (wx >> 3)] & (0x80 >> (wx & 7));
+     }
+
+     if (dfb_surface_read_buffer( surface, CSBR_FRONT, buf, 8, &rect ))
+          return false;
+
+     return shape_pixel_hit( window, surface, buf );
+}
+
+static bool
+window_hit( CoreWindow *window,
+            int         x,
+            int         y )
+{
+     CoreWindowConfig *config  = &window->config;
+     DFBWindowOptions  options = config->options;
+     DFBRectangle      bounds;
+     int               wx, wy;
+
+     if (!HIT_WINDOW( window ))
+          return false;
+
+     transform_window_to_stack( window, &config->bounds, &bounds );
+
+     if (x < bounds.x || x >= bounds.x + bounds.w || y < bounds.y || y >= bounds.y + bounds.h)
+          return false;
+
+     wx = x - bounds.x;
+     wy = y - bounds.y;
+
+     if (!(options & DWOP_SHAPED) || !(options & (DWOP_ALPHACHANNEL | DWOP_COLORKEYING)) || !window->surface ||
+         ((options & DWOP_OPAQUE_REGION) &&
+          (wx >= config->opaque.x1  &&  wx <= config->opaque.x2 &&
+           wy >= config->opaque.y1  &&  wy <= config->opaque.y2)))
+          return true;
+
+     return shape_hit( window, wx, wy );
+}
+
+/*
+ * Returns the cells of the hit-test grid covered by a window.
+ */
+static bool
+hit_grid_cells( CoreWindowStack *stack,
+                CoreWindow      *window,
+                DFBRegion       *ret_cells )
+{
+     DFBRectangle bounds;
+     DFBRegion    region;
+
+     if (!HIT_WINDOW( window ))
+          return false;
+
+     transform_window_to_stack( window, &window->config.bounds, &bounds );
+
+     region = DFB_REGION_INIT_FROM_RECTANGLE( &bounds );
+
+     if (!dfb_region_intersect( &region, 0, 0, stack->width - 1, stack->height - 1 ))
+          return false;
+
+     ret_cells->x1 = region.x1 >> HIT_GRID_SHIFT;
+     ret_cells->y1 = region.y1 >> HIT_GRID_SHIFT;
+     ret_cells->x2 = region.x2 >> HIT_GRID_SHIFT;
+     ret_cells->y2 = region.y2 >> HIT_GRID_SHIFT;
+
+     return true;
+}
+
+/*
+ * Sorts the windows that can be hit into the cells of a grid over the stack, keeping their stacking order.
+ */
+static DFBResult
+update_hit_grid( CoreWindowStack *stack,
+                 StackData       *data )
+{
+     int         i, k;
+     int         row, col;
+     int         num;
+     DFBRegion   cells;
+     CoreWindow *window;
+     HitGrid    *grid = &data->hit_grid;
+     int         cols = (stack->width  + (1 << HIT_GRID_SHIFT) - 1) >> HIT_GRID_SHIFT;
+     int         rows = (stack->height + (1 << HIT_GRID_SHIFT) - 1) >> HIT_GRID_SHIFT;
+
+     if (cols * rows + 1 > grid->cells_size) {
+          int *entries = SHREALLOC( stack->shmpool, grid->cells, (cols * rows + 1) * sizeof(int) );
+          if (!entries)
+               return D_OOSHM();
+
+          grid->cells      = entries;
+          grid->cells_size = cols * rows + 1;
+     }
+
+     memset( grid->cells, 0, (cols * rows + 1) * sizeof(int) );
+
+     /* Count the windows of each cell, stored one cell ahead. */
+     fusion_vector_foreach (window, i, data->windows) {
+          if (!hit_grid_cells( stack, window, &cells ))
+               continue;
+
+          for (row=cells.y1; row<=cells.y2; row++) {
+               for (col=cells.x1; col<=cells.x2; col++)
+                    grid->cells[row * cols + col + 1]++;
+          }
+     }
+
+     /* Turn the counts into the start of each cell. */
+     for (k=0; k<cols * rows; k++)
+          grid->cells[k+1] += grid->cells[k];
+
+     num = grid->cells[cols * rows];
+
+     if (num > grid->indices_size) {
+          int *entries = SHREALLOC( stack->shmpool, grid->indices, num * sizeof(int) );
+          if (!entries)
+               return D_OOSHM();
+
+          grid->indices      = entries;
+          grid->indices_size = num;
+     }
+
+     /* Fill the cells from bottom to top, moving each start to the end of its cell. */
+     fusion_vector_foreach (window, i, data->windows) {
+          if (!hit_grid_cells( stack, window, &cells ))
+               continue;
+
+          for (row=cells.y1; row<=cells.y2; row++) {
+               for (col=cells.x1; col<=cells.x2; col++)
+                    grid->indices[grid->cells[row * cols + col]++] = i;
+          }
+     }
+
+     for (k=cols * rows; k>0; k--)
+          grid->cells[k] = grid->cells[k-1];
+
+     grid->cells[0] = 0;
+
+     grid->cols  = cols;
+     grid->rows  = rows;
+     grid->valid = true;
+
+     D_DEBUG_AT( WM_Default, "  -> hit grid %dx%d with %d entries\n", cols, rows, num );
+
+     return DFB_OK;
+}
+
 static CoreWindow*
 window_at_pointer( CoreWindowStack *stack,
                    StackData       *data,
@@ -497,7 +1001,7 @@ window_at_pointer( CoreWindowStack *stack,
 
      if (!stack->cursor.enabled) {
           fusion_vector_foreach_reverse (window, i, data->windows)
-               if (window->config.opacity && !(window->config.options & DWOP_GHOST))
+               if (HIT_WINDOW( window ))
                     return window;
 
           return NULL;
@@ -508,185 +1012,26 @@ window_at_pointer( CoreWindowStack *stack,
      if (y < 0)
           y = stack->cursor.y;
 
-     fusion_vector_foreach_reverse (window, i, data->windows) {
-          CoreWindowConfig *config  = &window->config;
-          DFBWindowOptions  options = config->options;
-          DFBRectangle      rotated;
-          DFBRectangle     *bounds  = &rotated;
+     /* Only check the windows in the grid cell of the pointer. */
+     if (x < stack->width && y < stack->height &&
+         (data->hit_grid.valid || update_hit_grid( stack, data ) == DFB_OK))
+     {
+          const HitGrid *grid = &data->hit_grid;
+          int            cell = (y >> HIT_GRID_SHIFT) * grid->cols + (x >> HIT_GRID_SHIFT);
 
-          transform_window_to_stack( window, &config->bounds, &rotated );
+          for (i=grid->cells[cell+1]-1; i>=grid->cells[cell]; i--) {
+               window = fusion_vector_at( &data->windows, grid->indices[i] );
 
-          if (!(options & DWOP_GHOST) && config->opacity &&
-              x >= bounds->x  &&  x < bounds->x + bounds->w &&
-              y >= bounds->y  &&  y < bounds->y + bounds->h)
-          {
-               int wx = x - bounds->x;
-               int wy = y - bounds->y;
-
-               if ( !(options & DWOP_SHAPED)  ||
-                    !(options &(DWOP_ALPHACHANNEL|DWOP_COLORKEYING))
-                    || !window->surface ||
-                    ((options & DWOP_OPAQUE_REGION) &&
-                     (wx >= config->opaque.x1  &&  wx <= config->opaque.x2 &&
-                      wy >= config->opaque.y1  &&  wy <= config->opaque.y2)))
-               {
+               if (window_hit( window, x, y ))
                     return window;
-               }
-               else {
-                    u8                     buf[8];
-                    CoreSurface           *surface = window->surface;
-                    DFBSurfacePixelFormat  format  = surface->config.format;
-                    DFBRectangle           rect    = { wx, wy, 1, 1 };
-
-                    if (dfb_surface_read_buffer( surface, CSBR_FRONT, buf, 8, &rect ) == DFB_OK) {
-                         if (options & DWOP_ALPHACHANNEL) {
-                              int alpha = -1;
-
-                              D_ASSERT( DFB_PIXELFORMAT_HAS_ALPHA( format ) );
-
-                              switch (format) {
-                                   case DSPF_AiRGB:
-                                        alpha = 0xff - (*(u32*)(buf) >> 24);
-                                        break;
-                                   case DSPF_ARGB:
-                                   case DSPF_ABGR:
-                                   case DSPF_AYUV:
-                                   case DSPF_AVYU:
-                                        alpha = *(u32*)(buf) >> 24;
-                                        break;
-                                   case DSPF_ARGB8565:
-#ifdef WORDS_BIGENDIAN
-                                        alpha = buf[0];
-#else
-                                        alpha = buf[2];
-#endif
-                                        break;
-                                   case DSPF_RGBA5551:
-                                        alpha = *(u16*)(buf) & 0x1;
-                                        alpha = alpha ? 0xff : 0x00;
-                                        break;
-                                   case DSPF_ARGB1555:
-                                   case DSPF_ARGB2554:
-                                   case DSPF_ARGB4444:
-                                        alpha = *(u16*)(buf) & 0x8000;
-                                        alpha = alpha ? 0xff : 0x00;
-                                        break;
-                                   case DSPF_RGBA4444:
-                                        alpha = *(u16*)(buf) & 0x0008;
-                                        alpha = alpha ? 0xff : 0x00;
-                                        break;
-                                   case DSPF_RGBAF88871:
-                                        alpha = *(u32*)(buf) & 0x000000fe;
-                                        alpha |= alpha >> 7;
-                                        break;
-                                   case DSPF_ALUT44:
-                                        alpha = *(u8*)(buf) & 0xf0;
-                                        alpha |= alpha >> 4;
-                                        break;
-                                   case DSPF_LUT1:
-                                   case DSPF_LUT2:
-                                   case DSPF_LUT8: {
-                                        CorePalette *palette = surface->palette;
-                                        u8           pix     = *((u8*) buf);
-
-                                        if (palette && pix < palette->num_entries) {
-                                             alpha = palette->entries[pix].a;
-                                             break;
-                                        }
-
-
-                                        /* fall through */
-                                   }
-
-                                   default:
-                                        D_ONCE( "unknown format 0x%x", surface->config.format );
-                                        break;
-                              }
-
-                              if (alpha) /* alpha == -1 on error */
-                                   return window;
-                         }
-                         if (options & DWOP_COLORKEYING) {
-                              int pixel = 0;
-                              u8 *p;
-                              switch (format) {
-                                   case DSPF_ARGB:
-                                   case DSPF_ABGR:
-                                   case DSPF_AiRGB:
-                                   case DSPF_RGB32:
-                                        pixel = *(u32*)(buf) & 0x00ffffff;
-                                        break;
-
-                                   case DSPF_RGBAF88871:
-                                        pixel = *(u32*)(buf) & 0xffffff00;
-                                        break;
-
-                                   case DSPF_RGB24:
-                                        p = (buf);
-#ifdef WORDS_BIGENDIAN
-                                        pixel = (p[0] << 16) | (p[1] << 8) | p[2];
-#else
-                                        pixel = (p[2] << 16) | (p[1] << 8) | p[0];
-#endif
-                                        break;
-
-                                   case DSPF_RGB16:
-                                        pixel = *(u16*)(buf);
-                                        break;
-
-                                   case DSPF_ARGB4444:
-                                   case DSPF_RGB444:
-                                        pixel = *(u16*)(buf)
-                                                & 0x0fff;
-                                        break;
-
-                                   case DSPF_RGBA4444:
-                                        pixel = *(u16*)(buf)
-                                                & 0xfff0;
-                                        break;
+          }
 
-                                   case DSPF_ARGB8565:
-                                        p = (buf);
-#ifdef WORDS_BIGENDIAN
-                                        pixel = p[1] << 8 | p[2];
-#else
-                                        pixel = p[1] << 8 | p[0];
-#endif
-                                        break;
-
-                                   case DSPF_ARGB1555:
-                                   case DSPF_RGB555:
-                                   case DSPF_BGR555:
-                                        pixel = *(u16*)(buf)
-                                                & 0x7fff;
-                                        break;
-
-                                   case DSPF_RGBA5551:
-                                        pixel = *(u16*)(buf)
-                                                & 0xfffe;
-                                        break;
-
-                                   case DSPF_RGB332:
-                                   case DSPF_LUT8:
-                                        pixel = *(u8*)(buf);
-                                        break;
-
-                                   case DSPF_ALUT44:
-                                        pixel = *(u8*)(buf)
-                                                & 0x0f;
-                                        break;
-
-                                   default:
-                                        D_ONCE( "unknown format 0x%x", surface->config.format );
-                                        break;
-                              }
+          return NULL;
+     }
 
-                              if (pixel != config->color_key)
-                                   return window;
-                         }
-                    }
-               }
-          }
+     fusion_vector_foreach_reverse (window, i, data->windows) {
+          if (window_hit( window, x, y ))
+               return window;
      }
 
      return NULL;
@@ -1253,6 +1598,162 @@ draw_background( CoreWindowStack *stack, CardState *state, const DFBRegion *regi
      }
 }
 
+static inline void
+invalidate_visibility( StackData *data )
+{
+     data->visibility_dirty = INT_MAX;
+     data->hit_grid.valid   = false;
+}
+
+/*
+ * Invalidates the visibility of the windows up to the given index, e.g. after a change of the window at the index,
+ * which does not affect the windows above.
+ */
+static inline void
+invalidate_visibility_below( StackData *data,
+                             int        index )
+{
+     data->visibility_dirty = MAX( data->visibility_dirty, index );
+     data->hit_grid.valid   = false;
+}
+
+static inline void
+invalidate_window_visibility( StackData  *data,
+                              CoreWindow *window )
+{
+     int index = fusion_vector_index_of( &data->windows, window );
+
+     if (index < 0)
+          invalidate_visibility( data );
+     else
+          invalidate_visibility_below( data, index );
+}
+
+/*
+ * Calculates the opaque part of a window in stack coordinates, rotated like the window content.
+ */
+static void
+transform_opaque_to_stack( CoreWindow *window,
+                           DFBRegion  *ret_region )
+{
+     const CoreWindowConfig *config = &window->config;
+     const DFBRegion        *opaque = &config->opaque;
+     int                     w      = config->bounds.w;
+     int                     h      = config->bounds.h;
+
+     /* Inverse of transform_point_in_window(). */
+     switch (config->rotation) {
+          default:
+               D_BUG( "invalid rotation %d", config->rotation );
+          case 0:
+               *ret_region = *opaque;
+               break;
+
+          case 90:
+               ret_region->x1 = opaque->y1;
+               ret_region->y1 = w - opaque->x2 - 1;
+               ret_region->x2 = opaque->y2;
+               ret_region->y2 = w - opaque->x1 - 1;
+               break;
+
+          case 180:
+               ret_region->x1 = w - opaque->x2 - 1;
+               ret_region->y1 = h - opaque->y2 - 1;
+               ret_region->x2 = w - opaque->x1 - 1;
+               ret_region->y2 = h - opaque->y1 - 1;
+               break;
+
+          case 270:
+               ret_region->x1 = h - opaque->y2 - 1;
+               ret_region->y1 = opaque->x1;
+               ret_region->x2 = h - opaque->y1 - 1;
+               ret_region->y2 = opaque->x2;
+               break;
+     }
+
+     dfb_region_translate( ret_region, config->bounds.x, config->bounds.y );
+}
+
+/*
+ * Calculates bounds and opaque parts of the windows in stack coordinates,
+ * marking windows that are completely hidden by a solid window above as invisible.
+ *
+ * Only windows up to the highest invalidated index are recalculated.
+ */
+static DFBResult
+update_visibility( CoreWindowStack *stack,
+                   StackData       *data )
+{
+     int i, n, top;
+
+     D_ASSERT( stack != NULL );
+     D_ASSERT( data != NULL );
+
+     n = fusion_vector_size( &data->windows );
+
+     if (n > data->visibility_size) {
+          VisibilityEntry *entries;
+          int              size = MAX( n, 16 );
+
+          entries = SHREALLOC( stack->shmpool, data->visibility, size * sizeof(VisibilityEntry) );
+          if (!entries)
+               return D_OOSHM();
+
+          data->visibility      = entries;
+          data->visibility_size = size;
+     }
+
+     top = MIN( data->visibility_dirty, n - 1 );
+
+     for (i=top; i>=0; i--) {
+          int               j;
+          CoreWindow       *window = fusion_vector_at( &data->windows, i );
+          CoreWindowConfig *config = &window->config;
+          VisibilityEntry  *entry  = &data->visibility[i];
+          DFBRectangle      rotated;
+
+          transform_window_to_stack( window, &config->bounds, &rotated );
+
+          entry->window  = window;
+          entry->bounds  = DFB_REGION_INIT_FROM_RECTANGLE( &rotated );
+          entry->solid   = false;
+          entry->visible = VISIBLE_WINDOW( window );
+
+          if (!entry->visible)
+               continue;
+
+          /* Same rules as in update_region() for culling below a window. */
+          if (!TRANSLUCENT_WINDOW( window )) {
+               entry->opaque = entry->bounds;
+               entry->solid  = true;
+          }
+          else if (D_FLAGS_ARE_SET( config->options, DWOP_ALPHACHANNEL | DWOP_OPAQUE_REGION ) &&
+                   config->opacity == 0xff && !(config->options & DWOP_COLORKEYING))
+          {
+               transform_opaque_to_stack( window, &entry->opaque );
+
+               entry->solid = dfb_region_region_intersect( &entry->opaque, &entry->bounds );
+          }
+
+          /* Check coverage by solid windows above. */
+          for (j=i+1; j<n; j++) {
+               const VisibilityEntry *above = &data->visibility[j];
+
+               if (above->solid && dfb_region_region_contains( &above->opaque, &entry->bounds )) {
+                    D_DEBUG_AT( WM_Default, "  -> window %p hidden by %p\n", window, above->window );
+
+                    entry->visible = false;
+                    entry->solid   = false;
+                    break;
+               }
+          }
+     }
+
+     data->visibility_dirty = -1;
+
+     return DFB_OK;
+}
+
 static void
 update_region( CoreWindowStack *stack,
                StackData       *data,
@@ -1272,20 +1773,16 @@ update_region( CoreWindowStack *stack,
      D_ASSERT( start < fusion_vector_size( &data->windows ) );
      D_ASSERT( x1 <= x2 );
      D_ASSERT( y1 <= y2 );
+     D_ASSERT( data->visibility_dirty < 0 );
 
      /* Find next intersecting window. */
      while (i >= 0) {
-          CoreWindow *window = fusion_vector_at( &data->windows, i );
-
-          if (VISIBLE_WINDOW( window )) {
-               DFBRectangle rotated;
+          const VisibilityEntry *entry = &data->visibility[i];
 
-               transform_window_to_stack( window, &window->config.bounds, &rotated );
+          D_ASSERT( entry->window == fusion_vector_at( &data->windows, i ) );
 
-               if (dfb_region_intersect( &region,
-                                         DFB_REGION_VALS_FROM_RECTANGLE( &rotated )))
-                    break;
-          }
+          if (entry->visible && dfb_region_intersect( &region, DFB_REGION_VALS( &entry->bounds ) ))
+               break;
 
           i--;
      }
@@ -1595,6 +2092,9 @@ repaint_stack( CoreWindowStack     *stack,
 
      D_DEBUG_AT( WM_Default, "repaint_stack( %d region(s), flags %x )\n", num_updates, flags );
 
+     if (data->visibility_dirty >= 0 && update_visibility( stack, data ))
+          return;
+
      fusion_skirmish_prevail( &wmdata->update_skirmish );
 
      /* Set destination. */
@@ -2010,6 +2510,8 @@ insert_window( WMData          *wmdata,
      /* Insert the window at the acquired position. */
      fusion_vector_insert( &data->windows, window, index );
 
+     invalidate_visibility( data );
+
      window->flags |= CWF_INSERTED;
 
      dfb_wm_dispatch_WindowState( wmdata->core, window );
@@ -2106,6 +2608,8 @@ remove_window( WMData          *wmdata,
 
      fusion_vector_remove( &data->windows, fusion_vector_index_of( &data->windows, window ) );
 
+     invalidate_visibility( data );
+
      window->flags &= ~CWF_INSERTED;
 
      dfb_wm_dispatch_WindowState( wmdata->core, window );
@@ -2137,6 +2641,8 @@ move_window( CoreWindow *window,
 
           bounds->x += dx;
           bounds->y += dy;
+
+          invalidate_window_visibility( data->stack_data, window );
      }
      else {
           update_window( window, data, NULL, 0, false, false, false );
@@ -2144,6 +2650,8 @@ move_window( CoreWindow *window,
           bounds->x += dx;
           bounds->y += dy;
 
+          invalidate_window_visibility( data->stack_data, window );
+
           update_window( window, data, NULL, 0, false, false, false );
      }
 
@@ -2212,6 +2720,8 @@ resize_window( CoreWindow *window,
      else {
           dfb_region_intersect( &window->config.opaque, 0, 0, width - 1, height - 1 );
 
+          invalidate_window_visibility( data->stack_data, window );
+
           if (VISIBLE_WINDOW (window)) {
                if (ow > width) {
                     DFBRegion region = { width, 0, ow - 1, MIN(height, oh) - 1 };
@@ -2230,6 +2740,8 @@ resize_window( CoreWindow *window,
      bounds->w = width;
      bounds->h = height;
 
+     invalidate_window_visibility( data->stack_data, window );
+
      /* Send new size */
      evt.type = DWET_SIZE;
      evt.w    = bounds->w;
@@ -2294,6 +2806,8 @@ set_window_bounds( CoreWindow *window,
      if (!dfb_region_region_intersect( &window->config.opaque, &new_region ))
           window->config.opaque = new_region;
 
+     invalidate_window_visibility( data->stack_data, window );
+
      /* Update exposed area. */
      if (VISIBLE_WINDOW( window )) {
           if (dfb_region_region_intersect( &new_region, &old_region )) {
@@ -2444,6 +2958,9 @@ restack_window( WMData                 *wmdata,
      /* Actually change the stacking order now. */
      fusion_vector_move( &data->windows, old, index );
 
+     /* Windows above both positions keep their index. */
+     invalidate_visibility_below( data, MAX( old, index ) );
+
      dfb_wm_dispatch_WindowRestack( wmdata->core, window, index );
 
      update_window( window, window_data, NULL, DSFLIP_NONE, (index < old), false, false );
@@ -2479,6 +2996,8 @@ set_opacity( CoreWindow *window,
 
           window->config.opacity = opacity;
 
+          invalidate_window_visibility( data, window );
+
           if (window->region && window->stack->context->config.buffermode == DLBM_WINDOWS) {
                window_data->config.opacity = opacity;
 
@@ -3592,6 +4111,8 @@ wm_init_stack( CoreWindowStack *stack,
 
      fusion_vector_init( &data->windows, 64, stack->shmpool );
 
+     data->visibility_dirty = INT_MAX;
+
      for (i=0; i<MAX_KEYS; i++)
           data->keys[i].code = -1;
 
@@ -3660,10 +4181,22 @@ wm_close_stack( CoreWindowStack *stack,
      if (data->cursor_bs)
           dfb_surface_unlink( &data->cursor_bs );
 
+     /* Release the cursor layer. */
+     deinit_hw_cursor( data );
+
      /* Free grabbed keys. */
      direct_list_foreach_safe (l, next, data->grabbed_keys)
           SHFREE( stack->shmpool, l );
 
+     if (data->visibility)
+          SHFREE( stack->shmpool, data->visibility );
+
+     if (data->hit_grid.cells)
+          SHFREE( stack->shmpool, data->hit_grid.cells );
+
+     if (data->hit_grid.indices)
+          SHFREE( stack->shmpool, data->hit_grid.indices );
+
      while (data->last_notify_task != NULL) {
           ret = fusion_skirmish_wait( &wmdata->update_skirmish, 2000 );
           if (ret) {
@@ -3721,6 +4254,8 @@ wm_resize_stack( CoreWindowStack *stack,
      D_ASSERT( wm_data != NULL );
      D_ASSERT( stack_data != NULL );
 
+     invalidate_visibility( stack_data );
+
      return DFB_OK;
 }
 
@@ -4066,6 +4601,9 @@ wm_remove_window( CoreWindowStack *stack,
           window->config.num_keys = 0;
      }
 
+     if (data->hit_mask)
+          SHFREE( stack->shmpool, data->hit_mask );
+
      D_MAGIC_CLEAR( data );
 
      return DFB_OK;
@@ -4081,6 +4619,7 @@ wm_set_window_config( CoreWindow             *window,
      DFBResult        ret;
      CoreWindowStack *stack;
      WMData          *wmdata = wm_data;
+     StackData       *data;
 
      D_ASSERT( window != NULL );
      D_ASSERT( window->stack != NULL );
@@ -4091,6 +4630,11 @@ wm_set_window_config( CoreWindow             *window,
      stack = window->stack;
      D_ASSERT( stack != NULL );
 
+     data = ((WindowData*) window_data)->stack_data;
+
+     if (flags & (CWCF_OPTIONS | CWCF_COLOR_KEY))
+          ((WindowData*) window_data)->hit_mask_valid = false;
+
      if (flags & CWCF_OPTIONS) {
           if ((window->config.options & DWOP_SCALE) && !(config->options & DWOP_SCALE) && window->surface) {
                if (window->config.bounds.w != window->surface->config.size.w ||
@@ -4113,6 +4657,8 @@ wm_set_window_config( CoreWindow             *window,
           }
 
           window->config.options = config->options;
+
+          invalidate_window_visibility( data, window );
      }
 
      if (flags & CWCF_EVENTS)
@@ -4124,9 +4670,12 @@ wm_set_window_config( CoreWindow             *window,
      if (flags & CWCF_COLOR_KEY)
           window->config.color_key = config->color_key;
 
-     if (flags & CWCF_OPAQUE)
+     if (flags & CWCF_OPAQUE) {
           window->config.opaque = config->opaque;
 
+          invalidate_window_visibility( data, window );
+     }
+
      if (flags & CWCF_OPACITY && !config->opacity)
           set_opacity( window, window_data, wm_data, config->opacity );
 
@@ -4158,6 +4707,8 @@ wm_set_window_config( CoreWindow             *window,
 
           window->config.rotation = config->rotation;
 
+          invalidate_window_visibility( data, window );
+
           update_window( window, window_data, NULL, DSFLIP_NONE, false, false, false );
      }
 
@@ -4419,6 +4970,8 @@ wm_update_window( CoreWindow          *window,
 
      send_update_event( window, stack->stack_data, left_region );
 
+     invalidate_hit_mask( window_data, left_region );
+
      update_window( window, window_data, left_region, flags, false, false, true );
 
      process_updates( stack->stack_data, wm_data, stack, flags );
@@ -4426,6 +4979,228 @@ wm_update_window( CoreWindow          *window,
      return DFB_OK;
 }
 
+/*
+ * Looks for a layer to show the cursor on, either the configured one or a cursor layer of the same screen.
+ */
+static CoreLayer *
+find_cursor_layer( CoreWindowStack *stack )
+{
+     int        i;
+     CoreLayer *layer = dfb_layer_at( stack->context->layer_id );
+
+     if (dfb_config->cursor_layer >= 0) {
+          if (dfb_config->cursor_layer >= dfb_layer_num() || dfb_config->cursor_layer == stack->context->layer_id) {
+               D_ERROR( "WM/Default: Invalid cursor layer (id %d)!\n", dfb_config->cursor_layer );
+               return NULL;
+          }
+
+          return dfb_layer_at( dfb_config->cursor_layer );
+     }
+
+     for (i=0; i<dfb_layer_num(); i++) {
+          DFBDisplayLayerDescription  desc;
+          CoreLayer                  *cursor = dfb_layer_at( i );
+
+          if (cursor == layer || dfb_layer_screen( cursor ) != dfb_layer_screen( layer ))
+               continue;
+
+          dfb_layer_get_description( cursor, &desc );
+
+          if (desc.type & DLTF_CURSOR)
+               return cursor;
+     }
+
+     return NULL;
+}
+
+static void
+init_hw_cursor( CoreWindowStack *stack,
+                StackData       *data )
+{
+     DFBResult  ret;
+     CoreLayer *layer;
+
+     D_DEBUG_AT( WM_Default, "%s( %p )\n", __FUNCTION__, stack );
+
+     data->hw_cursor.checked = true;
+
+     layer = find_cursor_layer( stack );
+     if (!layer)
+          return;
+
+     ret = dfb_layer_create_context( layer, false, &data->hw_cursor.context );
+     if (ret) {
+          D_DERROR( ret, "WM/Default: Could not create context at cursor layer (id %u)!\n", dfb_layer_id( layer ) );
+          return;
+     }
+
+     ret = dfb_layer_region_create( data->hw_cursor.context, &data->hw_cursor.region );
+     if (ret) {
+          D_DERROR( ret, "WM/Default: Could not create region at cursor layer (id %u)!\n", dfb_layer_id( layer ) );
+          dfb_layer_context_unref( data->hw_cursor.context );
+          data->hw_cursor.context = NULL;
+          return;
+     }
+
+     dfb_layer_context_globalize( data->hw_cursor.context );
+     dfb_layer_region_globalize( data->hw_cursor.region );
+
+     dfb_layer_activate_context( layer, data->hw_cursor.context );
+
+     D_INFO( "WM/Default: Using layer %u for the cursor\n", dfb_layer_id( layer ) );
+}
+
+static void
+deinit_hw_cursor( StackData *data )
+{
+     if (data->hw_cursor.region) {
+          dfb_layer_region_disable( data->hw_cursor.region );
+
+          dfb_layer_region_unlink( &data->hw_cursor.region );
+     }
+
+     if (data->hw_cursor.context)
+          dfb_layer_context_unlink( &data->hw_cursor.context );
+}
+
+/*
+ * Shows the cursor surface on the cursor layer, so that moving it never touches the stack's surface.
+ */
+static DFBResult
+update_hw_cursor( CoreWindowStack       *stack,
+                  StackData             *data,
+                  CoreCursorUpdateFlags  flags )
+{
+     DFBResult                   ret;
+     int                         x, y;
+     int                         mx, my;
+     CoreLayer                  *layer;
+     CoreLayerRegion            *region = data->hw_cursor.region;
+     CoreLayerRegionConfig       config;
+     CoreLayerRegionConfigFlags  config_flags = CLRCF_NONE;
+
+     D_DEBUG_AT( WM_Default, "%s( %p, 0x%08x )\n", __FUNCTION__, stack, flags );
+
+     layer = dfb_layer_at( stack->context->layer_id );
+
+     dfb_screen_get_layer_dimension( dfb_layer_screen( layer ), layer, &mx, &my );
+
+     x = (s64) stack->cursor.x * (s64) mx / (s64) stack->width;
+     y = (s64) stack->cursor.y * (s64) my / (s64) stack->height;
+
+     /* Configure everything when showing the cursor for the first time. */
+     if (!region->surface) {
+          flags |= CCUF_POSITION | CCUF_SIZE | CCUF_SHAPE | CCUF_OPACITY;
+
+          config_flags = CLRCF_ALL;
+     }
+
+     /* Hide the region while the cursor is invisible, bring it up to date when showing it again. */
+     if (!stack->cursor.enabled || !stack->cursor.opacity) {
+          if (!(region->state & CLRSF_ENABLED))
+               return DFB_OK;
+
+          D_DEBUG_AT( WM_Default, "  -> disable\n" );
+
+          return dfb_layer_region_disable( region );
+     }
+
+     if (!(region->state & CLRSF_ENABLED))
+          flags |= CCUF_ENABLE | CCUF_POSITION | CCUF_SIZE | CCUF_SHAPE | CCUF_OPACITY;
+
+     config = data->hw_cursor.context->primary.config;
+
+     if (flags & (CCUF_POSITION | CCUF_SIZE | CCUF_SHAPE)) {
+          DFBRegion clip = { 0, 0, mx - 1, my - 1 };
+
+          config_flags |= CLRCF_DEST | CLRCF_SOURCE;
+
+          config.dest.x = x - stack->cursor.hot.x;
+          config.dest.y = y - stack->cursor.hot.y;
+          config.dest.w = stack->cursor.size.w;
+          config.dest.h = stack->cursor.size.h;
+
+          config.source.x = 0;
+          config.source.y = 0;
+          config.source.w = stack->cursor.surface->config.size.w;
+          config.source.h = stack->cursor.surface->config.size.h;
+
+          /* Completely off screen, hide it until it comes back. */
+          if (!dfb_clip_blit_precheck( &clip, config.dest.w, config.dest.h, config.dest.x, config.dest.y )) {
+               if (!(region->state & CLRSF_ENABLED))
+                    return DFB_OK;
+
+               D_DEBUG_AT( WM_Default, "  -> off screen, disable\n" );
+
+               return dfb_layer_region_disable( region );
+          }
+
+          dfb_clip_blit( &clip, &config.source, &config.dest.x, &config.dest.y );
+
+          config.dest.w = config.source.w;
+          config.dest.h = config.source.h;
+
+          D_DEBUG_AT( WM_Default, "  -> %4d,%4d-%4dx%4d -> %4d,%4d\n",
+                      DFB_RECTANGLE_VALS( &config.source ), config.dest.x, config.dest.y );
+     }
+
+     if (flags & CCUF_OPACITY) {
+          if (stack->cursor.opacity != 0xff) {
+               config_flags   |= CLRCF_OPTIONS | CLRCF_OPACITY;
+               config.options |= DLOP_OPACITY;
+               config.opacity  = stack->cursor.opacity;
+          }
+          else if (config.options & DLOP_OPACITY) {
+               config_flags   |= CLRCF_OPTIONS;
+               config.options &= ~DLOP_OPACITY;
+          }
+     }
+
+     if (flags & CCUF_SHAPE) {
+          config_flags |= CLRCF_WIDTH | CLRCF_HEIGHT | CLRCF_FORMAT | CLRCF_SURFACE_CAPS | CLRCF_OPTIONS;
+
+          /* The whole surface, the source is clipped to the screen. */
+          config.width        = stack->cursor.surface->config.size.w;
+          config.height       = stack->cursor.surface->config.size.h;
+          config.format       = stack->cursor.surface->config.format;
+          config.surface_caps = stack->cursor.surface->config.caps;
+
+          if (DFB_PIXELFORMAT_HAS_ALPHA( stack->cursor.surface->config.format ))
+               config.options |= DLOP_ALPHACHANNEL;
+          else
+               config.options &= ~DLOP_ALPHACHANNEL;
+     }
+
+     if (config_flags) {
+          ret = dfb_layer_region_set_configuration( region, &config, config_flags | CLRCF_FREEZE );
+          if (ret) {
+               D_DERROR( ret, "WM/Default: Failed to reconfigure cursor layer region!\n" );
+               return ret;
+          }
+
+          region->config.keep_buffers = true;
+     }
+
+     if (flags & CCUF_SHAPE) {
+          ret = dfb_layer_region_set_surface( region, stack->cursor.surface, false );
+          if (ret) {
+               D_DERROR( ret, "WM/Default: Failed to set cursor layer surface!\n" );
+               return ret;
+          }
+     }
+
+     if (flags & CCUF_ENABLE) {
+          D_DEBUG_AT( WM_Default, "  -> enable\n" );
+
+          dfb_layer_region_enable( region );
+     }
+
+     if ((flags & (CCUF_SHAPE | CCUF_ENABLE)) || config_flags)
+          dfb_layer_region_flip_update( region, NULL, DSFLIP_NONE );
+
+     return DFB_OK;
+}
+
 static DFBResult
 wm_update_cursor( CoreWindowStack       *stack,
                   void                  *wm_data,
@@ -4470,6 +5245,41 @@ wm_update_cursor( CoreWindowStack       *stack,
           }
      }
 
+     if ((flags & CCUF_ENABLE) && dfb_config->hw_cursor && !data->hw_cursor.checked)
+          init_hw_cursor( stack, data );
+
+     /* Leave the stack's surface alone if the cursor is on its own layer. */
+     if (data->hw_cursor.region) {
+          if (!stack->rotation) {
+               /* Repaint the area of the software cursor that was drawn while the stack was rotated. */
+               if (data->cursor_drawn) {
+                    data->cursor_drawn    = false;
+                    data->cursor_bs_valid = false;
+
+                    wm_update_stack( stack, wm_data, stack_data, &old_region, DSFLIP_NONE );
+               }
+
+               ret = update_hw_cursor( stack, data, flags );
+               if (ret == DFB_OK)
+                    return DFB_OK;
+
+               /* The layer doesn't support this cursor, e.g. its size or format, draw it in software from now on. */
+               D_ERROR( "WM/Default: Falling back to software cursor!\n" );
+
+               deinit_hw_cursor( data );
+
+               if (!stack->cursor.enabled)
+                    return DFB_OK;
+
+               return wm_update_cursor( stack, wm_data, stack_data,
+                                        flags | CCUF_ENABLE | CCUF_POSITION | CCUF_SIZE | CCUF_SHAPE | CCUF_OPACITY );
+          }
+
+          /* The layer can't rotate the cursor, draw it in software. */
+          if (data->hw_cursor.region->state & CLRSF_ENABLED)
+               dfb_layer_region_disable( data->hw_cursor.region );
+     }
+
      /* Optimize case of invisible cursor moving. */
      if (!(flags & ~(CCUF_POSITION | CCUF_SHAPE)) && (!stack->cursor.opacity || !stack->cursor.enabled))
           return DFB_OK;
@@ -1232,6 +1232,8 @@ local_unref( WMData *wmdata )
      fusion_skirmish_prevail( &wmdata->update_skirmish );
 
      if (!--wmdata->refs) {
+          sawman_compositor_destroy( wmdata );
+
           CoreGraphicsStateClient_Deinit( &wmdata->client );
 
           dfb_state_destroy( &wmdata->state );
@@ -1642,6 +1644,9 @@ wm_close_stack( CoreWindowStack *stack,
      if (tier->cursor_bs_right)
           dfb_surface_unlink( &tier->cursor_bs_right );
 
+     if (tier->backdrop)
+          dfb_surface_unlink( &tier->backdrop );
+
      direct_list_remove( &sawman->tiers, &tier->link );
      D_MAGIC_CLEAR( tier );
      SHFREE( sawman->shmpool, tier );
@@ -2434,6 +2439,8 @@ wm_add_window( CoreWindowStack *stack,
           config->options          |= DLOP_STEREO;
           config->surface_caps     |= DSCAPS_STEREO;
           dfb_layer_context_set_configuration( tier->context, config );
+
+          tier->single_rejected_id = 0;
      }
 
      sawman_update_geometry( sawwin );
@@ -2592,6 +2599,8 @@ wm_remove_window( CoreWindowStack *stack,
           config->options          &= ~DLOP_STEREO;
           config->surface_caps     &= ~DSCAPS_STEREO;
           dfb_layer_context_set_configuration( tier->context, config );
+
+          tier->single_rejected_id = 0;
      }
 
      /* Send notification to windows watchers */
@@ -2704,6 +2713,10 @@ wm_set_window_config( CoreWindow             *window,
           return DFB_UNSUPPORTED;
      }
 
+     /* Ask the application manager and driver again about single mode for the changed window. */
+     if (tier->single_rejected_id == sawwin->id)
+          tier->single_rejected_id = 0;
+
      reconfig = &sawman->callback.reconfig;
 
      reconfig->caps   = sawwin->caps;
@@ -3479,6 +3492,8 @@ wm_update_stack( CoreWindowStack     *stack,
      if (!tier->single_mode) {
           dfb_updates_add( &tier->left.updates, region );
 
+          sawman_backdrop_invalidate( sawman, tier, 0 );
+
           ret = sawman_process_updates( sawman, flags, wm_data );
      }
 